@@ -0,0 +1,163 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "ComputeHistogram.h"
+#include "ImageTestUtilities.h"
+
+using namespace tomviz;
+using ImageTestUtilities::fill;
+using ImageTestUtilities::value;
+
+namespace {
+
+// Enough slices for several slabs per thread, and sizes that aren't multiples
+// of the strides.
+const int Dims[3] = { 23, 19, 61 };
+// Fewer gradient bins than value bins, so mixing up the two axes shows.
+const int Bins[2] = { 64, 32 };
+const double Range[2] = { 10, 250 };
+
+double sample(int x, int y, int z, int c)
+{
+  // Sharp steps give gradients past the clamp, and a few values fall outside
+  // of Range.
+  return 120 + 80 * std::sin(0.4 * x + c) * std::cos(0.3 * y) +
+         ((x + 2 * y + 3 * z) % 7) * 9 + (z % 5 == 0 ? 40 : 0) - 15 * c;
+}
+
+// The 2D histogram of a serial loop over every stride'th interior voxel along
+// each axis, starting from the first one. The value is the one at the center
+// of the central differences.
+template <typename T>
+std::vector<double> serial2DHistogram(vtkImageData* image, int stride)
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  double spacing[3];
+  image->GetSpacing(spacing);
+  const double avgSpacing = (spacing[0] + spacing[1] + spacing[2]) / 3.0;
+  const double maxGradMag = Range[1] * 0.25;
+  const double gradScale = (Bins[1] - 1) / maxGradMag;
+  const double valueScale = (Bins[0] - 1) / (Range[1] - Range[0]);
+  const double weight = static_cast<double>(stride) * stride * stride;
+
+  std::vector<double> counts(Bins[0] * Bins[1], 0.0);
+  for (int k = 1; k < dims[2] - 1; k += stride) {
+    for (int j = 1; j < dims[1] - 1; j += stride) {
+      for (int i = 1; i < dims[0] - 1; i += stride) {
+        double dx = static_cast<double>(value<T>(image, i + 1, j, k) -
+                                        value<T>(image, i - 1, j, k)) /
+                    (spacing[0] * 2 / avgSpacing);
+        double dy = static_cast<double>(value<T>(image, i, j + 1, k) -
+                                        value<T>(image, i, j - 1, k)) /
+                    (spacing[1] * 2 / avgSpacing);
+        double dz = static_cast<double>(value<T>(image, i, j, k + 1) -
+                                        value<T>(image, i, j, k - 1)) /
+                    (spacing[2] * 2 / avgSpacing);
+        double gradMag =
+          std::floor(std::sqrt(dx * dx + dy * dy + dz * dz) + 0.5);
+        double center = value<T>(image, i, j, k);
+        if (!std::isfinite(gradMag) || !std::isfinite(center)) {
+          continue;
+        }
+        gradMag = std::min(std::max(gradMag, 0.0), maxGradMag);
+        int gradIndex = static_cast<int>(gradMag * gradScale);
+        int valueIndex = static_cast<int>((center - Range[0]) * valueScale);
+        valueIndex = std::min(std::max(valueIndex, 0), Bins[0] - 1);
+        counts[gradIndex * Bins[0] + valueIndex] += weight;
+      }
+    }
+  }
+  return counts;
+}
+
+template <typename T>
+void expectMatchesSerial(vtkImageData* image, int stride)
+{
+  vtkNew<vtkImageData> histogram;
+  histogram->SetDimensions(Bins[0], Bins[1], 1);
+  histogram->AllocateScalars(VTK_DOUBLE, 1);
+  int dims[3];
+  image->GetDimensions(dims);
+  double spacing[3];
+  image->GetSpacing(spacing);
+  auto scalars = image->GetPointData()->GetScalars();
+  Calculate2DHistogram(static_cast<T*>(scalars->GetVoidPointer(0)), dims,
+                       scalars->GetNumberOfComponents(), Range, histogram,
+                       spacing, stride);
+
+  auto expected = serial2DHistogram<T>(image, stride);
+  auto actual = static_cast<double*>(histogram->GetScalarPointer());
+  double total = 0;
+  for (size_t b = 0; b < expected.size(); ++b) {
+    // Counts are whole numbers times stride^3, the sums are exact.
+    ASSERT_EQ(actual[b], expected[b]) << "stride " << stride << ", bin " << b;
+    total += actual[b];
+  }
+  EXPECT_GT(total, 0);
+}
+} // namespace
+
+class ComputeHistogramTest : public ::testing::Test
+{
+};
+
+TEST_F(ComputeHistogramTest, histogram2DMatchesSerial)
+{
+  vtkNew<vtkImageData> image;
+  fill<float>(image, Dims, 1, sample);
+  const double spacing[3] = { 1.0, 1.5, 0.75 };
+  image->SetSpacing(spacing);
+  // Non-finite voxels are skipped, and so are their neighbors' gradients.
+  auto data = static_cast<float*>(image->GetScalarPointer());
+  data[(5 * Dims[1] + 7) * Dims[0] + 9] =
+    std::numeric_limits<float>::quiet_NaN();
+  data[(30 * Dims[1] + 2) * Dims[0] + 4] =
+    std::numeric_limits<float>::infinity();
+
+  for (int stride : { 1, 2, 3, 4 }) {
+    expectMatchesSerial<float>(image, stride);
+  }
+}
+
+TEST_F(ComputeHistogramTest, histogram2DOfFirstComponent)
+{
+  vtkNew<vtkImageData> image;
+  fill<unsigned short>(image, Dims, 2, sample);
+  for (int stride : { 1, 3 }) {
+    expectMatchesSerial<unsigned short>(image, stride);
+  }
+}
+
+TEST_F(ComputeHistogramTest, preview2DHistogram)
+{
+  const vtkIdType previewVoxels = 1000;
+  EXPECT_EQ(preview2DHistogramStride(8 * previewVoxels, previewVoxels), 1);
+  const vtkIdType sizes[] = { 8 * previewVoxels + 1, 50000, 1234567 };
+  for (vtkIdType n : sizes) {
+    int stride = preview2DHistogramStride(n, previewVoxels);
+    // The smallest stride that brings the volume down to the preview size.
+    EXPECT_LE(n, previewVoxels * stride * stride * stride) << n;
+    EXPECT_GT(n, previewVoxels * (stride - 1) * (stride - 1) * (stride - 1))
+      << n;
+  }
+
+  // The preview is binned like a serial loop with the same stride.
+  vtkNew<vtkImageData> image;
+  fill<float>(image, Dims, 1, sample);
+  int stride = preview2DHistogramStride(image->GetNumberOfPoints(),
+                                        image->GetNumberOfPoints() / 30);
+  ASSERT_EQ(stride, 4);
+  expectMatchesSerial<float>(image, stride);
+}
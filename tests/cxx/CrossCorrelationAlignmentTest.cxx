@@ -0,0 +1,129 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+#include <cmath>
+#include <vector>
+
+#include "CrossCorrelationAlignment.h"
+
+using namespace tomviz;
+using namespace tomviz::CrossCorrelationAlignment;
+
+namespace {
+
+const int Width = 96;
+const int Height = 80;
+const int NumberOfImages = 7;
+const int ReferenceImage = 3;
+
+// Where the features of each image have been moved to.
+const double Displacements[NumberOfImages][2] = {
+  { -5.3, 2.6 }, { -2.4, -1.2 }, { 4.0, 3.0 },   { 0, 0 },
+  { 1.7, -4.4 }, { 6.2, 0.8 },   { -3.5, -6.1 }
+};
+
+// A few Gaussian blobs, evaluated anywhere so they can be moved by fractions
+// of a pixel.
+double features(double x, double y)
+{
+  const double blobs[5][4] = { { 30, 25, 4, 1.0 },
+                               { 60, 35, 6, 0.7 },
+                               { 45, 55, 3, 1.5 },
+                               { 70, 60, 5, 0.5 },
+                               { 25, 50, 7, 0.8 } };
+  double value = 10;
+  for (auto& blob : blobs) {
+    double dx = x - blob[0];
+    double dy = y - blob[1];
+    value += 100 * blob[3] * std::exp(-(dx * dx + dy * dy) /
+                                      (2 * blob[2] * blob[2]));
+  }
+  return value;
+}
+} // namespace
+
+class CrossCorrelationAlignmentTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    tiltSeries->SetExtent(0, Width - 1, 0, Height - 1, 0, NumberOfImages - 1);
+    tiltSeries->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+    auto data = static_cast<unsigned short*>(tiltSeries->GetScalarPointer());
+    for (int i = 0; i < NumberOfImages; ++i) {
+      for (int y = 0; y < Height; ++y) {
+        for (int x = 0; x < Width; ++x) {
+          *data++ = static_cast<unsigned short>(
+            100 * features(x - Displacements[i][0], y - Displacements[i][1]));
+        }
+      }
+    }
+  }
+
+  // The shift that undoes the displacement of image i relative to the
+  // reference.
+  double expected(int i, int axis)
+  {
+    return Displacements[ReferenceImage][axis] - Displacements[i][axis];
+  }
+
+  vtkNew<vtkImageData> tiltSeries;
+};
+
+TEST_F(CrossCorrelationAlignmentTest, neighbors)
+{
+  Options options;
+  options.referenceImage = ReferenceImage;
+  std::vector<vtkVector2d> shifts;
+  ASSERT_TRUE(alignImages(tiltSeries, options, shifts, nullptr, 3));
+  ASSERT_EQ(shifts.size(), static_cast<size_t>(NumberOfImages));
+  for (int i = 0; i < NumberOfImages; ++i) {
+    // Errors accumulate along the chain of neighbors.
+    EXPECT_NEAR(shifts[i][0], expected(i, 0), 0.5) << "image " << i;
+    EXPECT_NEAR(shifts[i][1], expected(i, 1), 0.5) << "image " << i;
+  }
+}
+
+TEST_F(CrossCorrelationAlignmentTest, staticReference)
+{
+  Options options;
+  options.reference = Reference::Static;
+  options.referenceImage = ReferenceImage;
+  std::vector<vtkVector2d> shifts;
+  ASSERT_TRUE(alignImages(tiltSeries, options, shifts, nullptr, 3));
+  for (int i = 0; i < NumberOfImages; ++i) {
+    // Both images are windowed in place, which biases large shifts a little
+    // towards zero.
+    EXPECT_NEAR(shifts[i][0], expected(i, 0), 0.4) << "image " << i;
+    EXPECT_NEAR(shifts[i][1], expected(i, 1), 0.4) << "image " << i;
+  }
+
+  // Without refinement the shifts are the nearest whole pixels.
+  options.subpixel = false;
+  ASSERT_TRUE(alignImages(tiltSeries, options, shifts, nullptr, 3));
+  for (int i = 0; i < NumberOfImages; ++i) {
+    EXPECT_EQ(shifts[i][0], std::round(shifts[i][0]));
+    EXPECT_NEAR(shifts[i][0], expected(i, 0), 1) << "image " << i;
+    EXPECT_NEAR(shifts[i][1], expected(i, 1), 1) << "image " << i;
+  }
+}
+
+TEST_F(CrossCorrelationAlignmentTest, cancel)
+{
+  Options options;
+  int calls = 0;
+  std::vector<vtkVector2d> shifts;
+  auto progress = [&calls](int completed, int total) {
+    EXPECT_EQ(total, NumberOfImages);
+    EXPECT_TRUE(completed <= total);
+    ++calls;
+    return false;
+  };
+  ASSERT_FALSE(alignImages(tiltSeries, options, shifts, progress, 2));
+  EXPECT_TRUE(calls > 0);
+}
@@ -0,0 +1,277 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <QByteArray>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTypeTraits.h>
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+extern "C" {
+#include "vtk_tiff.h"
+}
+
+#include "FrameDecoder.h"
+#include "ImageTestUtilities.h"
+
+using namespace tomviz;
+using ImageTestUtilities::value;
+
+namespace {
+
+// Neither size is a multiple of the tile size, so the last tiles overhang.
+const int Width = 37;
+const int Height = 21;
+const int TileSize = 16;
+
+// Component c of the pixel in column x of row of the frame, row 0 is the top.
+// The values fit in every sample type.
+double sample(int x, int row, int c)
+{
+  return (3 * x + 101 * row + 17 * c + 1) % 127;
+}
+
+template <typename T>
+std::vector<T> frameData(int components)
+{
+  std::vector<T> data;
+  for (int row = 0; row < Height; ++row) {
+    for (int x = 0; x < Width; ++x) {
+      for (int c = 0; c < components; ++c) {
+        data.push_back(static_cast<T>(sample(x, row, c)));
+      }
+    }
+  }
+  return data;
+}
+
+template <typename T>
+unsigned short sampleFormat()
+{
+  if (std::is_floating_point<T>::value) {
+    return SAMPLEFORMAT_IEEEFP;
+  }
+  return std::is_signed<T>::value ? SAMPLEFORMAT_INT : SAMPLEFORMAT_UINT;
+}
+
+// Writes the frame to a TIFF file, in strips or in tiles, and returns the
+// bytes of the file.
+template <typename T>
+QByteArray tiffFrame(bool tiled, unsigned short compression)
+{
+  QTemporaryDir dir;
+  auto path = dir.filePath("frame.tiff");
+  TIFF* tiff = TIFFOpen(path.toLocal8Bit().constData(), "w");
+  if (!tiff) {
+    return QByteArray();
+  }
+
+  TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, Width);
+  TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, Height);
+  TIFFSetField(tiff, TIFFTAG_SAMPLESPERPIXEL, 1);
+  TIFFSetField(tiff, TIFFTAG_BITSPERSAMPLE,
+               static_cast<int>(8 * sizeof(T)));
+  TIFFSetField(tiff, TIFFTAG_SAMPLEFORMAT, sampleFormat<T>());
+  TIFFSetField(tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+  TIFFSetField(tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_MINISBLACK);
+  TIFFSetField(tiff, TIFFTAG_COMPRESSION, compression);
+
+  auto data = frameData<T>(1);
+  bool ok = true;
+  if (tiled) {
+    TIFFSetField(tiff, TIFFTAG_TILEWIDTH, TileSize);
+    TIFFSetField(tiff, TIFFTAG_TILELENGTH, TileSize);
+    std::vector<T> tile(TileSize * TileSize);
+    for (int y = 0; y < Height; y += TileSize) {
+      for (int x = 0; x < Width; x += TileSize) {
+        std::fill(tile.begin(), tile.end(), T(0));
+        for (int r = 0; r < TileSize && y + r < Height; ++r) {
+          for (int i = 0; i < TileSize && x + i < Width; ++i) {
+            tile[r * TileSize + i] = data[(y + r) * Width + x + i];
+          }
+        }
+        ok = ok && TIFFWriteTile(tiff, tile.data(), x, y, 0, 0) >= 0;
+      }
+    }
+  } else {
+    // Several rows per strip, the last strip is short.
+    TIFFSetField(tiff, TIFFTAG_ROWSPERSTRIP, 4);
+    for (int row = 0; row < Height; ++row) {
+      ok = ok && TIFFWriteScanline(tiff, &data[row * Width], row, 0) >= 0;
+    }
+  }
+  TIFFClose(tiff);
+
+  QFile file(path);
+  if (!ok || !file.open(QIODevice::ReadOnly)) {
+    return QByteArray();
+  }
+  return file.readAll();
+}
+
+template <typename T>
+QByteArray rawFrame(int components)
+{
+  auto data = frameData<T>(components);
+  return QByteArray(reinterpret_cast<const char*>(data.data()),
+                    static_cast<int>(data.size() * sizeof(T)));
+}
+
+QJsonObject rawMeta(const QString& dtype, int components = 1)
+{
+  QJsonArray shape = { Height, Width };
+  if (components > 1) {
+    shape.append(components);
+  }
+  return QJsonObject{ { "shape", shape }, { "dtype", dtype } };
+}
+
+// The frame is a single slice with the first row of the frame at the top.
+template <typename T>
+void expectFrame(vtkImageData* image, int components)
+{
+  ASSERT_NE(image, nullptr);
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[0], Width);
+  EXPECT_EQ(dims[1], Height);
+  EXPECT_EQ(dims[2], 1);
+  auto scalars = image->GetPointData()->GetScalars();
+  ASSERT_EQ(scalars->GetDataType(), vtkTypeTraits<T>::VTKTypeID());
+  ASSERT_EQ(scalars->GetNumberOfComponents(), components);
+  for (int row = 0; row < Height; ++row) {
+    for (int x = 0; x < Width; ++x) {
+      for (int c = 0; c < components; ++c) {
+        ASSERT_EQ(value<T>(image, x, Height - 1 - row, 0, c),
+                  static_cast<T>(sample(x, row, c)))
+          << "column " << x << ", row " << row << ", component " << c;
+      }
+    }
+  }
+}
+} // namespace
+
+class FrameDecoderTest : public ::testing::Test
+{
+};
+
+TEST_F(FrameDecoderTest, strippedTiff)
+{
+  for (auto compression : { COMPRESSION_NONE, COMPRESSION_LZW }) {
+    auto data = tiffFrame<unsigned short>(false, compression);
+    ASSERT_FALSE(data.isEmpty());
+    QString error;
+    auto image = FrameDecoder::decodeTiff(data, &error);
+    EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+    expectFrame<unsigned short>(image, 1);
+  }
+
+  auto data = tiffFrame<float>(false, COMPRESSION_NONE);
+  ASSERT_FALSE(data.isEmpty());
+  expectFrame<float>(FrameDecoder::decodeTiff(data), 1);
+}
+
+TEST_F(FrameDecoderTest, tiledTiff)
+{
+  auto data = tiffFrame<short>(true, COMPRESSION_NONE);
+  ASSERT_FALSE(data.isEmpty());
+  QString error;
+  auto image = FrameDecoder::decodeTiff(data, &error);
+  EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+  expectFrame<short>(image, 1);
+
+  data = tiffFrame<float>(true, COMPRESSION_LZW);
+  ASSERT_FALSE(data.isEmpty());
+  expectFrame<float>(FrameDecoder::decodeTiff(data), 1);
+}
+
+TEST_F(FrameDecoderTest, tiffByMimeType)
+{
+  auto data = tiffFrame<unsigned char>(false, COMPRESSION_NONE);
+  ASSERT_FALSE(data.isEmpty());
+  expectFrame<unsigned char>(
+    FrameDecoder::decode("image/tiff; name=frame.tiff", data, QJsonObject()),
+    1);
+
+  QString error;
+  EXPECT_FALSE(
+    FrameDecoder::decode("image/png", data, QJsonObject(), &error));
+  EXPECT_FALSE(error.isEmpty());
+}
+
+TEST_F(FrameDecoderTest, invalidTiff)
+{
+  QString error;
+  EXPECT_FALSE(FrameDecoder::decodeTiff(QByteArray("not a tiff"), &error));
+  EXPECT_FALSE(error.isEmpty());
+}
+
+TEST_F(FrameDecoderTest, rawFrame)
+{
+  expectFrame<unsigned short>(
+    FrameDecoder::decodeRaw(rawFrame<unsigned short>(1), rawMeta("uint16")),
+    1);
+  expectFrame<unsigned short>(
+    FrameDecoder::decodeRaw(rawFrame<unsigned short>(1), rawMeta("<u2")), 1);
+  expectFrame<double>(
+    FrameDecoder::decodeRaw(rawFrame<double>(1), rawMeta("float64")), 1);
+
+  // A third dimension in the shape is the number of components.
+  QString error;
+  auto image =
+    FrameDecoder::decode("application/octet-stream", rawFrame<float>(3),
+                         rawMeta("<f4", 3), &error);
+  EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+  expectFrame<float>(image, 3);
+}
+
+TEST_F(FrameDecoderTest, rawFrameSizeMismatch)
+{
+  auto data = rawFrame<unsigned short>(1);
+  for (auto size : { data.size() - 1, data.size() - 2 * Width }) {
+    QString error;
+    EXPECT_FALSE(
+      FrameDecoder::decodeRaw(data.left(size), rawMeta("uint16"), &error))
+      << size;
+    EXPECT_FALSE(error.isEmpty());
+  }
+
+  // The shape says more components than there are.
+  QString error;
+  EXPECT_FALSE(FrameDecoder::decodeRaw(data, rawMeta("uint16", 2), &error));
+  EXPECT_FALSE(error.isEmpty());
+}
+
+TEST_F(FrameDecoderTest, rawFrameRejected)
+{
+  auto data = rawFrame<unsigned short>(1);
+  // Only native byte order is supported.
+  for (auto dtype : { ">u2", ">i2", ">f4" }) {
+    QString error;
+    EXPECT_FALSE(FrameDecoder::decodeRaw(data, rawMeta(dtype), &error))
+      << dtype;
+    EXPECT_FALSE(error.isEmpty());
+  }
+
+  QString error;
+  EXPECT_FALSE(FrameDecoder::decodeRaw(data, rawMeta("complex64"), &error));
+  EXPECT_FALSE(error.isEmpty());
+
+  QJsonObject meta = rawMeta("uint16");
+  meta["shape"] = QJsonArray{ Height * Width };
+  EXPECT_FALSE(FrameDecoder::decodeRaw(data, meta, &error));
+
+  meta["shape"] = QJsonArray{ Height, -Width };
+  EXPECT_FALSE(FrameDecoder::decodeRaw(data, meta, &error));
+}
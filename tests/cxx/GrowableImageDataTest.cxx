@@ -0,0 +1,134 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include "GrowableImageData.h"
+#include "ImageTestUtilities.h"
+
+using namespace tomviz;
+
+namespace {
+
+const int Width = 6;
+const int Height = 5;
+const int Components = 2;
+
+float sample(int x, int y, int z, int c)
+{
+  return static_cast<float>(((z * Height + y) * Width + x) * Components + c);
+}
+
+vtkSmartPointer<vtkImageData> slice(int z)
+{
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  const int dims[3] = { Width, Height, 1 };
+  ImageTestUtilities::fill<float>(
+    image, dims, Components,
+    [z](int x, int y, int, int c) { return sample(x, y, z, c); });
+  return image;
+}
+
+// Checks that the first slices of the array hold the expected values.
+void expectSlices(vtkDataArray* scalars, int slices)
+{
+  ASSERT_EQ(scalars->GetNumberOfTuples(),
+            static_cast<vtkIdType>(slices) * Width * Height);
+  auto data = static_cast<float*>(scalars->GetVoidPointer(0));
+  for (int z = 0; z < slices; ++z) {
+    for (int y = 0; y < Height; ++y) {
+      for (int x = 0; x < Width; ++x) {
+        for (int c = 0; c < Components; ++c) {
+          ASSERT_EQ(*data++, sample(x, y, z, c))
+            << x << ", " << y << ", " << z << ", " << c;
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+class GrowableImageDataTest : public ::testing::Test
+{
+};
+
+TEST_F(GrowableImageDataTest, append)
+{
+  auto image = slice(0);
+  image->GetPointData()->GetScalars()->SetName("scalars");
+  GrowableImageData growable(image);
+  EXPECT_EQ(growable.numberOfSlices(), 1);
+
+  for (int z = 1; z < 20; ++z) {
+    ASSERT_TRUE(growable.append(slice(z)));
+    EXPECT_EQ(growable.numberOfSlices(), z + 1);
+    EXPECT_GE(growable.capacity(), z + 1);
+  }
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[2], 20);
+  auto scalars = image->GetPointData()->GetScalars();
+  EXPECT_STREQ(scalars->GetName(), "scalars");
+  EXPECT_EQ(image->GetPointData()->GetNumberOfArrays(), 1);
+  expectSlices(scalars, 20);
+}
+
+TEST_F(GrowableImageDataTest, reserve)
+{
+  auto image = slice(0);
+  GrowableImageData growable(image);
+  growable.reserve(10);
+  EXPECT_GE(growable.capacity(), 10);
+  expectSlices(image->GetPointData()->GetScalars(), 1);
+
+  // Appending within the capacity never reallocates.
+  void* data = image->GetPointData()->GetScalars()->GetVoidPointer(0);
+  for (int z = 1; z < 10; ++z) {
+    ASSERT_TRUE(growable.append(slice(z)));
+    EXPECT_EQ(image->GetPointData()->GetScalars()->GetVoidPointer(0), data);
+  }
+  EXPECT_GE(growable.capacity(), 10);
+  expectSlices(image->GetPointData()->GetScalars(), 10);
+}
+
+TEST_F(GrowableImageDataTest, publishedArraysAreUnchanged)
+{
+  // An array handed out earlier, e.g. to a running pipeline, keeps its
+  // values and length as slices are appended and the capacity grows.
+  auto image = slice(0);
+  GrowableImageData growable(image);
+  ASSERT_TRUE(growable.append(slice(1)));
+  vtkSmartPointer<vtkDataArray> earlier = image->GetPointData()->GetScalars();
+  for (int z = 2; z < 9; ++z) {
+    ASSERT_TRUE(growable.append(slice(z)));
+  }
+  EXPECT_NE(image->GetPointData()->GetScalars(), earlier);
+  expectSlices(earlier, 2);
+  expectSlices(image->GetPointData()->GetScalars(), 9);
+}
+
+TEST_F(GrowableImageDataTest, mismatch)
+{
+  auto image = slice(0);
+  GrowableImageData growable(image);
+
+  vtkNew<vtkImageData> wider;
+  wider->SetExtent(0, Width, 0, Height - 1, 0, 0);
+  wider->AllocateScalars(VTK_FLOAT, Components);
+  EXPECT_FALSE(growable.append(wider));
+
+  vtkNew<vtkImageData> otherType;
+  otherType->SetExtent(0, Width - 1, 0, Height - 1, 0, 0);
+  otherType->AllocateScalars(VTK_DOUBLE, Components);
+  EXPECT_FALSE(growable.append(otherType));
+
+  EXPECT_FALSE(growable.append(nullptr));
+  EXPECT_EQ(growable.numberOfSlices(), 1);
+  expectSlices(image->GetPointData()->GetScalars(), 1);
+}
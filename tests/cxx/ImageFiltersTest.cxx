@@ -0,0 +1,378 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ImageFilters.h"
+#include "ImageTestUtilities.h"
+
+using namespace tomviz;
+using ImageTestUtilities::fill;
+using ImageTestUtilities::value;
+
+namespace {
+
+// Odd sizes leave partial tiles along x.
+const int Dims[3] = { 70, 37, 9 };
+
+double sample(int x, int y, int z, int c)
+{
+  return 100 + 50 * std::sin(0.3 * x + c) + 30 * std::cos(0.2 * y) +
+         20 * std::sin(0.7 * z) + (x * 7 + y * 3 + z * 11) % 13;
+}
+
+// scipy.ndimage's "reflect" border mode.
+int reflect(int i, int n)
+{
+  if (n == 1) {
+    return 0;
+  }
+  i %= 2 * n;
+  i = i < 0 ? i + 2 * n : i;
+  return i < n ? i : 2 * n - 1 - i;
+}
+} // namespace
+
+class ImageFiltersTest : public ::testing::Test
+{
+};
+
+TEST_F(ImageFiltersTest, gaussian)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<float>(input, Dims, 2, sample);
+  fill<float>(image, Dims, 2, sample);
+  const double sigma = 1.3;
+  ASSERT_TRUE(ImageFilters::gaussian(image, sigma, 3));
+
+  int radius = static_cast<int>(4 * sigma + 0.5);
+  std::vector<double> weights;
+  double sum = 0;
+  for (int k = -radius; k <= radius; ++k) {
+    weights.push_back(std::exp(-0.5 * k * k / (sigma * sigma)));
+    sum += weights.back();
+  }
+  for (auto& weight : weights) {
+    weight /= sum;
+  }
+  for (int z = 0; z < Dims[2]; ++z) {
+    for (int y = 0; y < Dims[1]; y += 3) {
+      for (int x = 0; x < Dims[0]; x += 5) {
+        for (int c = 0; c < 2; ++c) {
+          double expected = 0;
+          for (int i = -radius; i <= radius; ++i) {
+            for (int j = -radius; j <= radius; ++j) {
+              for (int k = -radius; k <= radius; ++k) {
+                expected += weights[i + radius] * weights[j + radius] *
+                            weights[k + radius] *
+                            value<float>(input, reflect(x + i, Dims[0]),
+                                         reflect(y + j, Dims[1]),
+                                         reflect(z + k, Dims[2]), c);
+              }
+            }
+          }
+          EXPECT_NEAR(value<float>(image, x, y, z, c), expected, 1e-3);
+        }
+      }
+    }
+  }
+}
+
+TEST_F(ImageFiltersTest, median)
+{
+  for (int size : { 2, 3 }) {
+    vtkNew<vtkImageData> input;
+    vtkNew<vtkImageData> image;
+    fill<unsigned short>(input, Dims, 1, sample);
+    fill<unsigned short>(image, Dims, 1, sample);
+    ASSERT_TRUE(ImageFilters::median(image, size, 3));
+    ASSERT_EQ(image->GetScalarType(), VTK_UNSIGNED_SHORT);
+
+    int mismatches = 0;
+    for (int z = 0; z < Dims[2]; ++z) {
+      for (int y = 0; y < Dims[1]; ++y) {
+        for (int x = 0; x < Dims[0]; ++x) {
+          std::vector<unsigned short> window;
+          for (int i = 0; i < size; ++i) {
+            for (int j = 0; j < size; ++j) {
+              for (int k = 0; k < size; ++k) {
+                window.push_back(value<unsigned short>(
+                  input, reflect(x + i - size / 2, Dims[0]),
+                  reflect(y + j - size / 2, Dims[1]),
+                  reflect(z + k - size / 2, Dims[2])));
+              }
+            }
+          }
+          std::nth_element(window.begin(), window.begin() + window.size() / 2,
+                           window.end());
+          if (value<unsigned short>(image, x, y, z) !=
+              window[window.size() / 2]) {
+            ++mismatches;
+          }
+        }
+      }
+    }
+    EXPECT_EQ(mismatches, 0) << "size " << size;
+  }
+}
+
+TEST_F(ImageFiltersTest, laplace)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<double>(input, Dims, 1, sample);
+  fill<double>(image, Dims, 1, sample);
+  ASSERT_TRUE(ImageFilters::laplace(image, 3));
+
+  for (int z = 0; z < Dims[2]; ++z) {
+    for (int y = 0; y < Dims[1]; ++y) {
+      for (int x = 0; x < Dims[0]; ++x) {
+        double expected =
+          value<double>(input, reflect(x - 1, Dims[0]), y, z) +
+          value<double>(input, reflect(x + 1, Dims[0]), y, z) +
+          value<double>(input, x, reflect(y - 1, Dims[1]), z) +
+          value<double>(input, x, reflect(y + 1, Dims[1]), z) +
+          value<double>(input, x, y, reflect(z - 1, Dims[2])) +
+          value<double>(input, x, y, reflect(z + 1, Dims[2])) -
+          6 * value<double>(input, x, y, z);
+        EXPECT_NEAR(value<double>(image, x, y, z), expected, 1e-9);
+      }
+    }
+  }
+}
+
+TEST_F(ImageFiltersTest, gaussianTruncatesEachAxis)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<unsigned char>(input, Dims, 1, sample);
+  fill<unsigned char>(image, Dims, 1, sample);
+  ASSERT_TRUE(ImageFilters::gaussian(image, 1.0, 3));
+
+  // scipy.ndimage.gaussian_filter with an integer output: every axis is
+  // correlated in double, the center sample first and then the pairs from
+  // the outside in, and stored in the output with a C cast. The nine weights
+  // are normalized by numpy's pairwise sum.
+  const int radius = 4;
+  std::vector<double> weights;
+  for (int k = -radius; k <= radius; ++k) {
+    weights.push_back(std::exp(-0.5 * (k * k)));
+  }
+  double sum = ((weights[0] + weights[1]) + (weights[2] + weights[3])) +
+               ((weights[4] + weights[5]) + (weights[6] + weights[7]));
+  sum += weights[8];
+  for (auto& weight : weights) {
+    weight /= sum;
+  }
+
+  std::vector<unsigned char> expected(
+    static_cast<unsigned char*>(input->GetScalarPointer()),
+    static_cast<unsigned char*>(input->GetScalarPointer()) +
+      Dims[0] * Dims[1] * Dims[2]);
+  const int strides[3] = { 1, Dims[0], Dims[0] * Dims[1] };
+  for (int axis = 0; axis < 3; ++axis) {
+    auto previous = expected;
+    for (size_t i = 0; i < expected.size(); ++i) {
+      int position[3] = { static_cast<int>(i % Dims[0]),
+                          static_cast<int>(i / Dims[0] % Dims[1]),
+                          static_cast<int>(i / strides[2]) };
+      auto at = [&](int offset) {
+        int p = reflect(position[axis] + offset, Dims[axis]);
+        return static_cast<double>(
+          previous[i + (p - position[axis]) * strides[axis]]);
+      };
+      double result = at(0) * weights[radius];
+      for (int k = -radius; k < 0; ++k) {
+        result += (at(k) + at(-k)) * weights[k + radius];
+      }
+      expected[i] = static_cast<unsigned char>(result);
+    }
+  }
+
+  auto data = static_cast<unsigned char*>(image->GetScalarPointer());
+  int mismatches = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    if (data[i] != expected[i]) {
+      ++mismatches;
+    }
+  }
+  EXPECT_EQ(mismatches, 0);
+}
+
+TEST_F(ImageFiltersTest, laplaceWrapsIntegers)
+{
+  // numpy adds up the second differences of scipy.ndimage.laplace in the
+  // output type, so unsigned results wrap around rather than clamp.
+  vtkNew<vtkImageData> image;
+  image->SetExtent(0, 4, 0, 4, 0, 4);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  auto data = static_cast<unsigned char*>(image->GetScalarPointer());
+  std::fill(data, data + 125, 0);
+  data[62] = 100;
+  ASSERT_TRUE(ImageFilters::laplace(image, 2));
+
+  EXPECT_EQ(value<unsigned char>(image, 2, 2, 2), (3 * (256 - 200)) % 256);
+  EXPECT_EQ(value<unsigned char>(image, 1, 2, 2), 100);
+  EXPECT_EQ(value<unsigned char>(image, 2, 3, 2), 100);
+  EXPECT_EQ(value<unsigned char>(image, 0, 0, 0), 0);
+}
+
+TEST_F(ImageFiltersTest, sobelMagnitude2D)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<unsigned short>(input, Dims, 1, sample);
+  fill<unsigned short>(image, Dims, 1, sample);
+  ASSERT_TRUE(ImageFilters::sobelMagnitude2D(image, 3));
+  ASSERT_EQ(image->GetScalarType(), VTK_FLOAT);
+
+  const double derivative[3] = { -1, 0, 1 };
+  const double smoothing[3] = { 1, 2, 1 };
+  for (int z = 0; z < Dims[2]; ++z) {
+    for (int y = 0; y < Dims[1]; ++y) {
+      for (int x = 0; x < Dims[0]; ++x) {
+        double dx = 0;
+        double dy = 0;
+        for (int i = -1; i <= 1; ++i) {
+          for (int j = -1; j <= 1; ++j) {
+            for (int k = -1; k <= 1; ++k) {
+              double v = value<unsigned short>(input, reflect(x + i, Dims[0]),
+                                               reflect(y + j, Dims[1]),
+                                               reflect(z + k, Dims[2]));
+              dx += derivative[i + 1] * smoothing[j + 1] * smoothing[k + 1] * v;
+              dy += smoothing[i + 1] * derivative[j + 1] * smoothing[k + 1] * v;
+            }
+          }
+        }
+        EXPECT_NEAR(value<float>(image, x, y, z), std::hypot(dx, dy), 1e-2);
+      }
+    }
+  }
+}
+
+TEST_F(ImageFiltersTest, zoomLinear)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<float>(input, Dims, 1, sample);
+  fill<float>(image, Dims, 1, sample);
+  const double factors[3] = { 0.5, 0.5, 0.5 };
+  ASSERT_TRUE(ImageFilters::zoom(image, factors, 1, 3));
+
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[0], 35);
+  EXPECT_EQ(dims[1], 18);
+  EXPECT_EQ(dims[2], 4);
+
+  // The first and last samples stay aligned, the rest are trilinear.
+  for (int z = 0; z < dims[2]; ++z) {
+    for (int y = 0; y < dims[1]; ++y) {
+      for (int x = 0; x < dims[0]; ++x) {
+        int out[3] = { x, y, z };
+        int lower[3];
+        double t[3];
+        for (int i = 0; i < 3; ++i) {
+          double position = out[i] * (Dims[i] - 1.0) / (dims[i] - 1);
+          lower[i] = std::min(static_cast<int>(position), Dims[i] - 2);
+          t[i] = position - lower[i];
+        }
+        double expected = 0;
+        for (int i = 0; i < 8; ++i) {
+          int a = i & 1, b = (i >> 1) & 1, c = i >> 2;
+          expected += (a ? t[0] : 1 - t[0]) * (b ? t[1] : 1 - t[1]) *
+                      (c ? t[2] : 1 - t[2]) *
+                      value<float>(input, lower[0] + a, lower[1] + b,
+                                   lower[2] + c);
+        }
+        EXPECT_NEAR(value<float>(image, x, y, z), expected, 1e-3);
+      }
+    }
+  }
+}
+
+TEST_F(ImageFiltersTest, zoomCubic)
+{
+  vtkNew<vtkImageData> input;
+  vtkNew<vtkImageData> image;
+  fill<double>(input, Dims, 1, sample);
+  fill<double>(image, Dims, 1, sample);
+  // Doubling n - 1 puts every input sample on an output sample, where the
+  // interpolating spline has to reproduce it.
+  const double factors[3] = { (2.0 * Dims[0] - 1) / Dims[0],
+                              (2.0 * Dims[1] - 1) / Dims[1], 1 };
+  ASSERT_TRUE(ImageFilters::zoom(image, factors, 3, 2));
+
+  int dims[3];
+  image->GetDimensions(dims);
+  EXPECT_EQ(dims[0], 2 * Dims[0] - 1);
+  EXPECT_EQ(dims[1], 2 * Dims[1] - 1);
+  EXPECT_EQ(dims[2], Dims[2]);
+  for (int z = 0; z < Dims[2]; ++z) {
+    for (int y = 0; y < Dims[1]; ++y) {
+      for (int x = 0; x < Dims[0]; ++x) {
+        EXPECT_NEAR(value<double>(image, 2 * x, 2 * y, z),
+                    value<double>(input, x, y, z), 1e-6);
+      }
+    }
+  }
+}
+
+TEST_F(ImageFiltersTest, zoomRoundsIntegers)
+{
+  // scipy.ndimage.zoom rounds halves away from zero and clamps unsigned
+  // results to the range of the type.
+  vtkNew<vtkImageData> image;
+  image->SetExtent(0, 3, 0, 0, 0, 0);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  auto data = static_cast<unsigned char*>(image->GetScalarPointer());
+  const unsigned char step[4] = { 0, 1, 255, 255 };
+  std::copy(step, step + 4, data);
+  const double factors[3] = { 7.0 / 4, 1, 1 };
+  ASSERT_TRUE(ImageFilters::zoom(image, factors, 1, 1));
+  // Samples at 0, 0.5, 1, ... of the input.
+  EXPECT_EQ(value<unsigned char>(image, 0, 0, 0), 0);
+  EXPECT_EQ(value<unsigned char>(image, 1, 0, 0), 1);
+  EXPECT_EQ(value<unsigned char>(image, 2, 0, 0), 1);
+  EXPECT_EQ(value<unsigned char>(image, 3, 0, 0), 128);
+
+  vtkNew<vtkImageData> cubic;
+  cubic->SetExtent(0, 7, 0, 0, 0, 0);
+  cubic->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  data = static_cast<unsigned char*>(cubic->GetScalarPointer());
+  std::fill(data, data + 4, 0);
+  std::fill(data + 4, data + 8, 255);
+  const double cubicFactors[3] = { 4, 1, 1 };
+  ASSERT_TRUE(ImageFilters::zoom(cubic, cubicFactors, 3, 1));
+  // The spline overshoots on both sides of the step, the results are clamped
+  // rather than wrapped.
+  int dims[3];
+  cubic->GetDimensions(dims);
+  ASSERT_EQ(dims[0], 32);
+  for (int x = 0; x < 14; ++x) {
+    EXPECT_LT(value<unsigned char>(cubic, x, 0, 0), 128) << x;
+  }
+  for (int x = 18; x < 32; ++x) {
+    EXPECT_GT(value<unsigned char>(cubic, x, 0, 0), 128) << x;
+  }
+}
+
+TEST_F(ImageFiltersTest, zoomTiltAngles)
+{
+  const double angles[5] = { -60, -30, 0, 30, 60 };
+  ASSERT_EQ(ImageFilters::zoomLength(5, 0.5), 2);
+  ASSERT_EQ(ImageFilters::zoomLength(6, 0.5), 3);
+  double binned[3];
+  ImageFilters::zoom(angles, 5, binned, 3, 3);
+  EXPECT_NEAR(binned[0], -60, 1e-9);
+  EXPECT_NEAR(binned[1], 0, 1e-9);
+  EXPECT_NEAR(binned[2], 60, 1e-9);
+}
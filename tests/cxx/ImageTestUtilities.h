@@ -0,0 +1,55 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageTestUtilities_h
+#define tomvizImageTestUtilities_h
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkTypeTraits.h>
+
+#include <cstddef>
+
+namespace tomviz {
+namespace ImageTestUtilities {
+
+/// Allocates scalars of type T over dims, with the given number of
+/// components, and sets component c of the point (x, y, z) to
+/// sample(x, y, z, c).
+template <typename T, typename Sample>
+void fill(vtkImageData* image, const int dims[3], int components,
+          const Sample& sample)
+{
+  image->SetExtent(0, dims[0] - 1, 0, dims[1] - 1, 0, dims[2] - 1);
+  image->AllocateScalars(vtkTypeTraits<T>::VTKTypeID(), components);
+  auto data = static_cast<T*>(image->GetScalarPointer());
+  for (int z = 0; z < dims[2]; ++z) {
+    for (int y = 0; y < dims[1]; ++y) {
+      for (int x = 0; x < dims[0]; ++x) {
+        for (int c = 0; c < components; ++c) {
+          *data++ = static_cast<T>(sample(x, y, z, c));
+        }
+      }
+    }
+  }
+}
+
+/// Component c of the scalars of image at the point (x, y, z), the scalars
+/// must be of type T.
+template <typename T>
+T value(vtkImageData* image, int x, int y, int z, int c = 0)
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  auto scalars = image->GetPointData()->GetScalars();
+  int components = scalars->GetNumberOfComponents();
+  auto data = static_cast<T*>(scalars->GetVoidPointer(0));
+  return data[((static_cast<size_t>(z) * dims[1] + y) * dims[0] + x) *
+                components +
+              c];
+}
+} // namespace ImageTestUtilities
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,163 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <cmath>
+#include <vector>
+
+#include "ImageTestUtilities.h"
+#include "ImageTranslation.h"
+
+using namespace tomviz;
+using ImageTestUtilities::fill;
+using ImageTestUtilities::value;
+using ImageTranslation::Interpolation;
+
+namespace {
+
+const int Dims[3] = { 45, 31, 8 };
+
+// Whole pixel shifts, including none at all and shifts moving the slice out
+// of the image.
+const std::vector<vtkVector2d> Shifts = {
+  { 3, -2 }, { -5, 4 }, { 0, 0 }, { 100, 0 }, { -1, -31 }, { 7, 9 }, { -44, 1 }
+};
+
+double sample(int x, int y, int z, int c)
+{
+  return 1 + (x * 7 + y * 13 + z * 5 + c * 3) % 97;
+}
+
+// A Gaussian blob centered at (cx, cy).
+double blob(double x, double y, double cx, double cy)
+{
+  double dx = x - cx;
+  double dy = y - cy;
+  return 100 * std::exp(-(dx * dx + dy * dy) / (2 * 3.0 * 3.0));
+}
+
+// Checks that every slice moved by its whole pixel shift.
+template <typename T>
+void expectShifted(vtkImageData* image, int components)
+{
+  for (int z = 0; z < Dims[2]; ++z) {
+    vtkVector2d shift =
+      z < static_cast<int>(Shifts.size()) ? Shifts[z] : vtkVector2d(0, 0);
+    for (int y = 0; y < Dims[1]; ++y) {
+      for (int x = 0; x < Dims[0]; ++x) {
+        int sx = x - static_cast<int>(shift[0]);
+        int sy = y - static_cast<int>(shift[1]);
+        bool inside = sx >= 0 && sx < Dims[0] && sy >= 0 && sy < Dims[1];
+        for (int c = 0; c < components; ++c) {
+          T expected = inside ? static_cast<T>(sample(sx, sy, z, c)) : 0;
+          ASSERT_EQ(value<T>(image, x, y, z, c), expected)
+            << x << ", " << y << ", " << z << ", " << c;
+        }
+      }
+    }
+  }
+}
+} // namespace
+
+class ImageTranslationTest : public ::testing::Test
+{
+};
+
+TEST_F(ImageTranslationTest, wholePixels)
+{
+  // Fewer shifts than slices, the last slice stays put.
+  vtkNew<vtkImageData> image;
+  fill<unsigned char>(image, Dims, 3, sample);
+  auto input = image->GetPointData()->GetScalars();
+  ASSERT_TRUE(ImageTranslation::translate(image, Shifts));
+  EXPECT_NE(image->GetPointData()->GetScalars(), input);
+  EXPECT_EQ(image->GetPointData()->GetNumberOfArrays(), 1);
+  expectShifted<unsigned char>(image, 3);
+
+  vtkNew<vtkImageData> inPlace;
+  fill<float>(inPlace, Dims, 1, sample);
+  input = inPlace->GetPointData()->GetScalars();
+  ASSERT_TRUE(ImageTranslation::translate(inPlace, Shifts,
+                                          Interpolation::Nearest, true));
+  EXPECT_EQ(inPlace->GetPointData()->GetScalars(), input);
+  expectShifted<float>(inPlace, 1);
+}
+
+TEST_F(ImageTranslationTest, linear)
+{
+  // Whole pixels take the same path as Nearest.
+  vtkNew<vtkImageData> image;
+  fill<short>(image, Dims, 2, sample);
+  ASSERT_TRUE(
+    ImageTranslation::translate(image, Shifts, Interpolation::Linear, true));
+  expectShifted<short>(image, 2);
+
+  // Half a pixel along x averages neighbors, a quarter along y weighs them.
+  vtkNew<vtkImageData> half;
+  fill<float>(half, Dims, 1, sample);
+  std::vector<vtkVector2d> shifts(Dims[2], vtkVector2d(1.5, -0.25));
+  for (bool inPlace : { false, true }) {
+    vtkNew<vtkImageData> moved;
+    fill<float>(moved, Dims, 1, sample);
+    ASSERT_TRUE(ImageTranslation::translate(moved, shifts,
+                                            Interpolation::Linear, inPlace));
+    for (int z = 0; z < Dims[2]; ++z) {
+      for (int y = 0; y < Dims[1] - 1; ++y) {
+        for (int x = 2; x < Dims[0]; ++x) {
+          double expected = 0.375 * value<float>(half, x - 2, y, z) +
+                            0.375 * value<float>(half, x - 1, y, z) +
+                            0.125 * value<float>(half, x - 2, y + 1, z) +
+                            0.125 * value<float>(half, x - 1, y + 1, z);
+          ASSERT_NEAR(value<float>(moved, x, y, z), expected, 1e-4);
+        }
+        EXPECT_EQ(value<float>(moved, 0, y, z), 0);
+      }
+    }
+  }
+}
+
+TEST_F(ImageTranslationTest, fourier)
+{
+  vtkNew<vtkImageData> image;
+  const int dims[3] = { Dims[0], Dims[1], 2 };
+  fill<double>(image, dims, 1,
+               [](int x, int y, int, int) { return blob(x, y, 20, 14); });
+
+  std::vector<vtkVector2d> shifts = { { 2.3, -1.6 }, { -4.5, 3.25 } };
+  ASSERT_TRUE(ImageTranslation::translate(image, shifts,
+                                          Interpolation::Fourier, false, {},
+                                          2));
+  for (int z = 0; z < 2; ++z) {
+    for (int y = 0; y < Dims[1]; ++y) {
+      for (int x = 0; x < Dims[0]; ++x) {
+        double expected = blob(x, y, 20 + shifts[z][0], 14 + shifts[z][1]);
+        ASSERT_NEAR(value<double>(image, x, y, z), expected, 0.05)
+          << x << ", " << y << ", " << z;
+      }
+    }
+  }
+}
+
+TEST_F(ImageTranslationTest, cancel)
+{
+  vtkNew<vtkImageData> image;
+  fill<float>(image, Dims, 1, sample);
+  auto input = image->GetPointData()->GetScalars();
+  int calls = 0;
+  auto progress = [&calls](int completed, int total) {
+    EXPECT_EQ(total, Dims[2]);
+    EXPECT_TRUE(completed <= total);
+    return ++calls < 2;
+  };
+  EXPECT_FALSE(ImageTranslation::translate(
+    image, Shifts, Interpolation::Linear, false, progress, 1));
+  EXPECT_EQ(calls, 2);
+  // The input is left alone.
+  EXPECT_EQ(image->GetPointData()->GetScalars(), input);
+  EXPECT_EQ(value<float>(image, 5, 5, 0), sample(5, 5, 0, 0));
+}
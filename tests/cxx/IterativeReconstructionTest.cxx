@@ -0,0 +1,191 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <cmath>
+#include <vector>
+
+#include "IterativeReconstruction.h"
+
+using namespace tomviz;
+using namespace tomviz::IterativeReconstruction;
+
+class IterativeReconstructionTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    for (int i = 0; i < numberOfTilts; ++i) {
+      angles.push_back(-72.0 + 4.0 * i + 0.001);
+    }
+    Projector projector(angles.data(), numberOfTilts, numberOfRays);
+
+    // Discs of increasing size and density, one per slice, projected with the
+    // engine's own projector.
+    const int n = numberOfRays;
+    phantom.resize(numberOfSlices, std::vector<float>(n * n));
+    tiltSeries->SetExtent(0, numberOfSlices - 1, 0, n - 1, 0,
+                          numberOfTilts - 1);
+    tiltSeries->AllocateScalars(VTK_FLOAT, 1);
+    auto data = static_cast<float*>(tiltSeries->GetScalarPointer());
+    std::vector<float> sinogram(projector.numberOfRows());
+    for (int s = 0; s < numberOfSlices; ++s) {
+      for (int iy = 0; iy < n; ++iy) {
+        for (int iz = 0; iz < n; ++iz) {
+          double y = iy + 0.5 - n / 2.0;
+          double z = iz + 0.5 - n / 2.0;
+          double radius = 8 + s;
+          phantom[s][iy * n + iz] =
+            y * y + z * z < radius * radius ? 1.0f + 0.1f * s : 0.0f;
+        }
+      }
+      projector.forward(phantom[s].data(), sinogram.data());
+      for (int i = 0; i < projector.numberOfRows(); ++i) {
+        data[i * numberOfSlices + s] = sinogram[i];
+      }
+    }
+
+    vtkNew<vtkDoubleArray> tiltAngles;
+    tiltAngles->SetName("tilt_angles");
+    tiltAngles->SetNumberOfTuples(numberOfTilts);
+    for (int i = 0; i < numberOfTilts; ++i) {
+      tiltAngles->SetValue(i, angles[i]);
+    }
+    tiltSeries->GetFieldData()->AddArray(tiltAngles);
+  }
+
+  // Relative error of the reconstruction with respect to the phantom.
+  double error(vtkImageData* recon)
+  {
+    const int n = numberOfRays;
+    auto data = static_cast<float*>(recon->GetScalarPointer());
+    double difference = 0;
+    double norm = 0;
+    for (int s = 0; s < numberOfSlices; ++s) {
+      for (int iy = 0; iy < n; ++iy) {
+        for (int iz = 0; iz < n; ++iz) {
+          double expected = phantom[s][iy * n + iz];
+          double actual = data[(iz * n + iy) * numberOfSlices + s];
+          difference += (expected - actual) * (expected - actual);
+          norm += expected * expected;
+        }
+      }
+    }
+    return std::sqrt(difference / norm);
+  }
+
+  // Odd sizes so a partial block of slices is exercised.
+  const int numberOfSlices = 11;
+  const int numberOfRays = 32;
+  const int numberOfTilts = 37;
+  std::vector<double> angles;
+  std::vector<std::vector<float>> phantom;
+  vtkNew<vtkImageData> tiltSeries;
+};
+
+TEST_F(IterativeReconstructionTest, projector)
+{
+  const int n = numberOfRays;
+  Projector projector(angles.data(), numberOfTilts, n);
+  ASSERT_EQ(projector.numberOfRows(), numberOfTilts * n);
+  ASSERT_EQ(projector.numberOfColumns(), n * n);
+
+  // Rays of the (almost) zero degree projection cross the whole grid.
+  int zeroTilt = numberOfTilts / 2;
+  ASSERT_NEAR(projector.rowSums()[zeroTilt * n + n / 2], n, 1e-3);
+
+  // The back projection is the adjoint of the projection.
+  std::vector<float> image(projector.numberOfColumns());
+  std::vector<float> sinogram(projector.numberOfRows());
+  for (size_t i = 0; i < image.size(); ++i) {
+    image[i] = static_cast<float>(std::sin(0.37 * i));
+  }
+  for (size_t i = 0; i < sinogram.size(); ++i) {
+    sinogram[i] = static_cast<float>(std::cos(0.11 * i));
+  }
+  std::vector<float> projected(sinogram.size());
+  std::vector<float> backProjected(image.size());
+  projector.forward(image.data(), projected.data());
+  projector.backward(sinogram.data(), backProjected.data());
+  double a = 0;
+  double b = 0;
+  for (size_t i = 0; i < sinogram.size(); ++i) {
+    a += projected[i] * sinogram[i];
+  }
+  for (size_t i = 0; i < image.size(); ++i) {
+    b += image[i] * backProjected[i];
+  }
+  ASSERT_NEAR(a, b, 1e-4 * std::abs(a));
+}
+
+TEST_F(IterativeReconstructionTest, methodsConverge)
+{
+  Options landweber;
+  landweber.method = Method::Landweber;
+  landweber.iterations = 50;
+  landweber.stepSize = 0.001;
+
+  Options cimmino = landweber;
+  cimmino.method = Method::Cimmino;
+  cimmino.stepSize = 0.05 * numberOfTilts * numberOfRays;
+
+  Options componentAveraging = landweber;
+  componentAveraging.method = Method::ComponentAveraging;
+  componentAveraging.stepSize = 0.5;
+
+  Options art;
+  art.method = Method::ART;
+  art.iterations = 5;
+
+  Options sart = art;
+  sart.method = Method::SART;
+
+  for (auto& options :
+       { landweber, cimmino, componentAveraging, art, sart }) {
+    vtkNew<vtkImageData> serial;
+    ASSERT_TRUE(reconstruct3(tiltSeries, serial, options, 1));
+    // One iteration leaves a large error, all of them improve on it.
+    Options first = options;
+    first.iterations = 1;
+    vtkNew<vtkImageData> initial;
+    ASSERT_TRUE(reconstruct3(tiltSeries, initial, first, 1));
+    ASSERT_LT(error(serial), error(initial));
+    ASSERT_LT(error(serial), 0.3);
+
+    // Slices are independent, so threading doesn't change the result.
+    vtkNew<vtkImageData> parallel;
+    ASSERT_TRUE(reconstruct3(tiltSeries, parallel, options, 3));
+    auto expected = static_cast<float*>(serial->GetScalarPointer());
+    auto actual = static_cast<float*>(parallel->GetScalarPointer());
+    for (vtkIdType i = 0; i < serial->GetNumberOfPoints(); ++i) {
+      ASSERT_EQ(expected[i], actual[i]) << "at index " << i;
+      ASSERT_GE(actual[i], 0);
+    }
+  }
+}
+
+TEST_F(IterativeReconstructionTest, cancel)
+{
+  std::vector<float> recon(numberOfSlices * numberOfRays * numberOfRays);
+  Options options;
+  options.iterations = 3;
+
+  int calls = 0;
+  int lastCompleted = 0;
+  auto progress = [&](int completed, int) {
+    lastCompleted = completed;
+    return ++calls < 2;
+  };
+  bool completed = reconstruct(tiltSeries, angles.data(), recon.data(),
+                               options, progress, 1);
+  ASSERT_FALSE(completed);
+  ASSERT_EQ(calls, 2);
+  ASSERT_LT(lastCompleted, numberOfSlices * options.iterations);
+}
@@ -0,0 +1,76 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+// Times the tiled, multithreaded axis permutations against the naive loops
+// they replace. Run as permuteAxesBenchmark [nx ny nz [element size]].
+
+#include "PermuteAxes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace tomviz;
+
+namespace {
+
+template <typename Function>
+double bestOf(int runs, Function f)
+{
+  double best = 0.0;
+  for (int i = 0; i < runs; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+    best = i == 0 ? elapsed.count() : std::min(best, elapsed.count());
+  }
+  return best;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  int dims[3] = { 512, 512, 512 };
+  size_t elementSize = 4;
+  if (argc >= 4) {
+    for (int i = 0; i < 3; ++i) {
+      dims[i] = std::atoi(argv[i + 1]);
+    }
+  }
+  if (argc >= 5) {
+    elementSize = std::atoi(argv[4]);
+  }
+
+  size_t bytes =
+    static_cast<size_t>(dims[0]) * dims[1] * dims[2] * elementSize;
+  std::vector<char> in(bytes, 1);
+  std::vector<char> out(bytes);
+  double gigabytes = bytes / 1e9;
+
+  std::cout << dims[0] << " x " << dims[1] << " x " << dims[2] << ", "
+            << elementSize << " byte elements\n";
+  const int permutations[5][3] = {
+    { 2, 1, 0 }, { 1, 0, 2 }, { 0, 2, 1 }, { 1, 2, 0 }, { 2, 0, 1 }
+  };
+  for (auto& axes : permutations) {
+    double naive = bestOf(2, [&]() {
+      permuteAxesNaive(in.data(), out.data(), dims, axes, elementSize);
+    });
+    double single = bestOf(3, [&]() {
+      permuteAxes(in.data(), out.data(), dims, axes, elementSize, 1);
+    });
+    double tiled = bestOf(3, [&]() {
+      permuteAxes(in.data(), out.data(), dims, axes, elementSize);
+    });
+    std::cout << "axes " << axes[0] << axes[1] << axes[2] << ": naive "
+              << gigabytes / naive << " GB/s, tiled " << gigabytes / single
+              << " GB/s, tiled and threaded " << gigabytes / tiled
+              << " GB/s (" << naive / tiled << "x)\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,94 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include "PermuteAxes.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace tomviz;
+
+namespace {
+
+const int Permutations[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 },
+                                 { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+std::vector<unsigned char> ramp(const int dims[3], size_t elementSize)
+{
+  std::vector<unsigned char> data(static_cast<size_t>(dims[0]) * dims[1] *
+                                  dims[2] * elementSize);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<unsigned char>(i * 7 + i / 251);
+  }
+  return data;
+}
+} // namespace
+
+class PermuteAxesTest : public ::testing::Test
+{
+};
+
+TEST_F(PermuteAxesTest, allPermutations)
+{
+  // Odd sizes leave partial tiles on every edge.
+  const int dims[3] = { 67, 35, 41 };
+  for (size_t elementSize : { 1, 2, 4, 8, 12, 16, 3, 6 }) {
+    auto in = ramp(dims, elementSize);
+    for (auto& axes : Permutations) {
+      std::vector<unsigned char> expected(in.size());
+      std::vector<unsigned char> out(in.size());
+      permuteAxesNaive(in.data(), expected.data(), dims, axes, elementSize);
+      permuteAxes(in.data(), out.data(), dims, axes, elementSize, 3);
+      ASSERT_EQ(out, expected) << "element size " << elementSize << ", axes "
+                               << axes[0] << axes[1] << axes[2];
+    }
+  }
+}
+
+TEST_F(PermuteAxesTest, reverseAxes)
+{
+  // Reversing the axes twice gets back to where we started.
+  const int dims[3] = { 40, 3, 70 };
+  const int reversed[3] = { 70, 3, 40 };
+  auto in = ramp(dims, sizeof(float));
+  std::vector<unsigned char> c(in.size());
+  std::vector<unsigned char> fortran(in.size());
+  reverseAxes(in.data(), c.data(), dims, sizeof(float));
+  reverseAxes(c.data(), fortran.data(), reversed, sizeof(float));
+  ASSERT_EQ(fortran, in);
+
+  // Element (x, y, z) of the input is element (z, y, x) of the output.
+  auto* fIn = reinterpret_cast<const uint32_t*>(in.data());
+  auto* fC = reinterpret_cast<const uint32_t*>(c.data());
+  int x = 13, y = 2, z = 55;
+  ASSERT_EQ(fC[(x * dims[1] + y) * dims[2] + z],
+            fIn[(z * dims[1] + y) * dims[0] + x]);
+}
+
+TEST_F(PermuteAxesTest, inPlace)
+{
+  const int cube[3] = { 37, 37, 37 };
+  for (auto& axes : Permutations) {
+    ASSERT_TRUE(canPermuteAxesInPlace(cube, axes) ==
+                (axes[0] == 0 || axes[1] == 1 || axes[2] == 2));
+  }
+
+  const int dims[3] = { 45, 9, 45 };
+  const int axes[3] = { 2, 1, 0 };
+  ASSERT_TRUE(canPermuteAxesInPlace(dims, axes));
+  for (size_t elementSize : { 2, 8, 3 }) {
+    auto data = ramp(dims, elementSize);
+    std::vector<unsigned char> expected(data.size());
+    permuteAxesNaive(data.data(), expected.data(), dims, axes, elementSize);
+    ASSERT_TRUE(permuteAxesInPlace(data.data(), dims, axes, elementSize, 4));
+    ASSERT_EQ(data, expected);
+  }
+
+  const int notSquare[3] = { 45, 9, 44 };
+  auto data = ramp(notSquare, 1);
+  auto original = data;
+  ASSERT_FALSE(permuteAxesInPlace(data.data(), notSquare, axes, 1));
+  ASSERT_EQ(data, original);
+}
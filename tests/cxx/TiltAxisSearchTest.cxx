@@ -0,0 +1,166 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+#include <cmath>
+#include <vector>
+
+#include "TiltAxisSearch.h"
+#include "TomographyTiltSeries.h"
+
+using namespace tomviz;
+
+namespace {
+
+const int NumberOfSlices = 160;
+const int NumberOfRays = 80;
+const int NumberOfTilts = 61;
+const double Shift = 6;
+const double Angle = 3;
+const double Pi = 3.14159265358979323846;
+
+// Gaussian blobs in the plane of each slice, in reconstruction coordinates
+// relative to the center: y, z, standard deviation and amplitude. They drift a
+// little from slice to slice. There are many slices so that the rotation of
+// the tilt axis shifts the slices at the ends by several pixels.
+double blobs[4][4] = { { -20, 10, 2.5, 1.0 },
+                       { 15, -5, 3.5, 0.8 },
+                       { 5, 25, 2, 1.2 },
+                       { -8, -22, 3, 0.6 } };
+
+// The line integral through the blobs of slice at ray coordinate t and angle.
+double projection(int slice, double t, double angle)
+{
+  double value = 0;
+  for (auto& blob : blobs) {
+    double y = blob[0] + 0.02 * slice;
+    double z = blob[1] - 0.01 * slice;
+    double center = y * std::cos(angle) + z * std::sin(angle);
+    double d = t - center;
+    value += blob[3] * blob[2] * std::sqrt(2 * Pi) *
+             std::exp(-d * d / (2 * blob[2] * blob[2]));
+  }
+  return value;
+}
+} // namespace
+
+class TiltAxisSearchTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Slices along x and rays along y, with the tilt axis offset from the
+    // center of the rays and rotated as modeled by the search.
+    tiltSeries->SetExtent(0, NumberOfSlices - 1, 0, NumberOfRays - 1, 0,
+                          NumberOfTilts - 1);
+    tiltSeries->AllocateScalars(VTK_FLOAT, 1);
+    auto data = static_cast<float*>(tiltSeries->GetScalarPointer());
+    for (int t = 0; t < NumberOfTilts; ++t) {
+      tiltAngles.push_back(-60.0 + 120.0 * t / (NumberOfTilts - 1));
+      double angle = tiltAngles.back() * Pi / 180;
+      for (int r = 0; r < NumberOfRays; ++r) {
+        for (int s = 0; s < NumberOfSlices; ++s) {
+          double axis =
+            TiltAxisSearch::axisPosition(Shift, Angle, s, NumberOfSlices);
+          *data++ = static_cast<float>(
+            projection(s, r - NumberOfRays / 2 - axis, angle));
+        }
+      }
+    }
+  }
+
+  std::vector<int> representativeSlices(int count)
+  {
+    return TiltAxisSearch::representativeSlices(
+      TomographyTiltSeries::sliceIntensities(tiltSeries, 0), count);
+  }
+
+  vtkNew<vtkImageData> tiltSeries;
+  std::vector<double> tiltAngles;
+};
+
+TEST_F(TiltAxisSearchTest, representativeSlices)
+{
+  auto slices = representativeSlices(4);
+  ASSERT_EQ(slices.size(), static_cast<size_t>(4));
+  for (size_t i = 1; i < slices.size(); ++i) {
+    EXPECT_TRUE(slices[i] > slices[i - 1]);
+  }
+
+  // Only the sinograms of the slices are copied, the same as a full cache's.
+  TomographyTiltSeries::SinogramCache full(tiltSeries, 0, 2);
+  TomographyTiltSeries::SinogramCache sinograms(tiltSeries, 0, slices, 2);
+  ASSERT_EQ(sinograms.slices(), slices);
+  EXPECT_EQ(sinograms.numberOfSlices(), NumberOfSlices);
+  const int sinogramSize = NumberOfRays * NumberOfTilts;
+  for (int slice : slices) {
+    std::vector<float> expected(full.sinogram(slice),
+                                full.sinogram(slice) + sinogramSize);
+    std::vector<float> actual(sinograms.sinogram(slice),
+                              sinograms.sinogram(slice) + sinogramSize);
+    EXPECT_EQ(expected, actual) << "slice " << slice;
+  }
+}
+
+TEST_F(TiltAxisSearchTest, scorePeaksAtTiltAxis)
+{
+  auto slices = representativeSlices(3);
+  TomographyTiltSeries::SinogramCache sinograms(tiltSeries, 0, slices, 2);
+  double best = TiltAxisSearch::score(sinograms, tiltAngles.data(), slices,
+                                      Shift, Angle, NumberOfRays);
+  for (double shift : { Shift - 4, Shift - 1, Shift + 1, Shift + 4 }) {
+    EXPECT_TRUE(TiltAxisSearch::score(sinograms, tiltAngles.data(), slices,
+                                      shift, Angle, NumberOfRays) < best)
+      << "shift " << shift;
+  }
+  for (double angle : { Angle - 2, Angle + 2 }) {
+    EXPECT_TRUE(TiltAxisSearch::score(sinograms, tiltAngles.data(), slices,
+                                      Shift, angle, NumberOfRays) < best)
+      << "angle " << angle;
+  }
+}
+
+TEST_F(TiltAxisSearchTest, search)
+{
+  TiltAxisSearch::Options options;
+  options.numberOfSlices = 4;
+  TomographyTiltSeries::SinogramCache sinograms(
+    tiltSeries, 0, representativeSlices(options.numberOfSlices), 2);
+  options.reconstructionSize = 64;
+  int total = 0;
+  auto progress = [&total](int completed, int candidates) {
+    EXPECT_TRUE(completed <= candidates);
+    total = candidates;
+    return true;
+  };
+  TiltAxisSearch::Result result;
+  ASSERT_TRUE(TiltAxisSearch::search(sinograms, tiltAngles.data(), options,
+                                     result, progress, 3));
+  EXPECT_EQ(total, 11 * 11 + 2 * 25);
+  EXPECT_NEAR(result.shift, Shift, 1);
+  EXPECT_NEAR(result.angle, Angle, 0.5);
+
+  // The rotation alone.
+  options.shiftRange = 0;
+  ASSERT_TRUE(
+    TiltAxisSearch::search(sinograms, tiltAngles.data(), options, result));
+  EXPECT_EQ(result.shift, 0);
+}
+
+TEST_F(TiltAxisSearchTest, cancel)
+{
+  TiltAxisSearch::Options options;
+  TomographyTiltSeries::SinogramCache sinograms(
+    tiltSeries, 0, representativeSlices(options.numberOfSlices), 2);
+  options.reconstructionSize = 32;
+  int calls = 0;
+  auto progress = [&calls](int, int) { return ++calls < 2; };
+  TiltAxisSearch::Result result;
+  ASSERT_FALSE(TiltAxisSearch::search(sinograms, tiltAngles.data(), options,
+                                      result, progress, 1));
+  EXPECT_EQ(calls, 2);
+}
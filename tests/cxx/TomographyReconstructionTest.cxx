@@ -0,0 +1,312 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "TomographyReconstruction.h"
+#include "TomographyTiltSeries.h"
+
+using namespace tomviz;
+
+class TomographyReconstructionTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    // Odd sizes so partial slice blocks and partial tiles are exercised.
+    const int xDim = 13;
+    const int yDim = 45;
+    const int zDim = 31;
+    tiltSeries->SetExtent(0, xDim - 1, 0, yDim - 1, 0, zDim - 1);
+    tiltSeries->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+    auto data =
+      static_cast<unsigned short*>(tiltSeries->GetScalarPointer(0, 0, 0));
+    for (int z = 0; z < zDim; ++z) {
+      for (int y = 0; y < yDim; ++y) {
+        for (int x = 0; x < xDim; ++x) {
+          data[(z * yDim + y) * xDim + x] = (x * 7 + y * 13 + z * 3) % 251;
+        }
+      }
+    }
+
+    vtkNew<vtkDoubleArray> angles;
+    angles->SetName("tilt_angles");
+    angles->SetNumberOfTuples(zDim);
+    for (int z = 0; z < zDim; ++z) {
+      angles->SetValue(z, -75.0 + 150.0 * z / (zDim - 1));
+    }
+    tiltSeries->GetFieldData()->AddArray(angles);
+  }
+
+  vtkNew<vtkImageData> tiltSeries;
+};
+
+namespace {
+
+void compareReconstructions(vtkImageData* expectedImage,
+                            vtkImageData* actualImage)
+{
+  int expectedDims[3];
+  int actualDims[3];
+  expectedImage->GetDimensions(expectedDims);
+  actualImage->GetDimensions(actualDims);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(expectedDims[i], actualDims[i]);
+  }
+
+  auto expected = static_cast<float*>(expectedImage->GetScalarPointer());
+  auto actual = static_cast<float*>(actualImage->GetScalarPointer());
+  vtkIdType n = expectedImage->GetNumberOfPoints();
+  float maxValue = 0;
+  for (vtkIdType i = 0; i < n; ++i) {
+    maxValue = std::max(maxValue, std::abs(expected[i]));
+  }
+  ASSERT_GT(maxValue, 0);
+  for (vtkIdType i = 0; i < n; ++i) {
+    ASSERT_NEAR(expected[i], actual[i], 1e-5 * maxValue) << "at index " << i;
+  }
+}
+} // namespace
+
+TEST_F(TomographyReconstructionTest, parallelMatchesSerial)
+{
+  using TomographyReconstruction::FilterType;
+  vtkNew<vtkImageData> serial;
+  TomographyReconstruction::weightedBackProjection3(tiltSeries, serial);
+
+  for (int threads : { 1, 3 }) {
+    vtkNew<vtkImageData> parallel;
+    TomographyReconstruction::parallelWeightedBackProjection3(
+      tiltSeries, parallel, FilterType::None, threads);
+    compareReconstructions(serial, parallel);
+  }
+}
+
+TEST_F(TomographyReconstructionTest, filteredParallelMatchesSerial)
+{
+  using TomographyReconstruction::FilterType;
+  for (auto filter : { FilterType::Ramp, FilterType::SheppLogan,
+                       FilterType::Cosine, FilterType::Hann }) {
+    vtkNew<vtkImageData> serial;
+    TomographyReconstruction::weightedBackProjection3(tiltSeries, serial,
+                                                      filter);
+    vtkNew<vtkImageData> parallel;
+    TomographyReconstruction::parallelWeightedBackProjection3(
+      tiltSeries, parallel, filter, 3);
+    compareReconstructions(serial, parallel);
+  }
+}
+
+TEST_F(TomographyReconstructionTest, filterResponseMatchesReconWBP)
+{
+  using TomographyReconstruction::FilterType;
+  const double Pi = 3.14159265358979323846;
+  // makeFilter() of Recon_WBP.py: the ramp 2|f|, f in cycles per pixel,
+  // apodized with omega = 2 pi f.
+  auto expected = [Pi](FilterType filter, double f) {
+    double ramp = 2 * f;
+    double omega = 2 * Pi * f;
+    if (f == 0) {
+      return ramp;
+    }
+    switch (filter) {
+      case FilterType::SheppLogan:
+        return ramp * std::sin(omega) / omega;
+      case FilterType::Cosine:
+        return ramp * std::cos(ramp);
+      case FilterType::Hamming:
+        return ramp * (0.54 + 0.46 * std::cos(omega / 2));
+      case FilterType::Hann:
+        return ramp * (1 + std::cos(omega / 2)) / 2;
+      default:
+        return ramp;
+    }
+  };
+
+  for (int numOfRays : { 45, 64 }) {
+    auto none = TomographyReconstruction::filterResponse(FilterType::None,
+                                                         numOfRays);
+    ASSERT_GE(static_cast<int>(none.size()), 2 * numOfRays);
+    EXPECT_EQ(none, std::vector<float>(none.size(), 1.0f));
+
+    for (auto filter : { FilterType::Ramp, FilterType::SheppLogan,
+                         FilterType::Cosine, FilterType::Hamming,
+                         FilterType::Hann }) {
+      auto response =
+        TomographyReconstruction::filterResponse(filter, numOfRays);
+      const int size = static_cast<int>(response.size());
+      ASSERT_EQ(size, static_cast<int>(none.size()));
+      // The ramp comes from its band limited kernel, truncated to the padded
+      // length. It is within about 1 / (pi^2 size) of 2|f|.
+      const double tolerance = 1.0 / size;
+      for (int k = 0; k < size; ++k) {
+        double f = static_cast<double>(std::min(k, size - k)) / size;
+        EXPECT_NEAR(response[k], expected(filter, f), tolerance)
+          << "filter " << static_cast<int>(filter) << ", " << numOfRays
+          << " rays, frequency " << k;
+      }
+    }
+  }
+}
+
+TEST_F(TomographyReconstructionTest, cancel)
+{
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  std::vector<float> recon(dims[0] * dims[1] * dims[1]);
+  auto angles = static_cast<double*>(
+    tiltSeries->GetFieldData()->GetArray("tilt_angles")->GetVoidPointer(0));
+
+  int calls = 0;
+  auto progress = [&calls](int, int) { return ++calls < 1; };
+  bool completed = TomographyReconstruction::parallelBackProjection3(
+    tiltSeries, angles, recon.data(),
+    TomographyReconstruction::FilterType::None, progress, 1);
+  ASSERT_FALSE(completed);
+  ASSERT_EQ(calls, 1);
+}
+
+TEST_F(TomographyReconstructionTest, sinogramCacheMatchesTiltSeries)
+{
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  for (int tiltAxis : { 0, 1 }) {
+    TomographyTiltSeries::SinogramCache cache(tiltSeries, tiltAxis, 3);
+    int numberOfSlices = dims[tiltAxis];
+    ASSERT_EQ(cache.numberOfSlices(), numberOfSlices);
+    ASSERT_EQ(cache.numberOfRays(), dims[1 - tiltAxis]);
+    ASSERT_EQ(cache.numberOfTilts(), dims[2]);
+    for (int Nray : { 16, 64 }) {
+      for (double axisPosition : { 0.0, -3.25 }) {
+        std::vector<float> expected(Nray * dims[2]);
+        std::vector<float> actual(Nray * dims[2]);
+        for (int slice = 0; slice < numberOfSlices; slice += 4) {
+          TomographyTiltSeries::getSinogram(tiltSeries, slice, expected.data(),
+                                            Nray, axisPosition, tiltAxis);
+          cache.interpolate(slice, actual.data(), Nray, axisPosition);
+          ASSERT_EQ(expected, actual) << "tilt axis " << tiltAxis;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TomographyReconstructionTest, interpolatedSinogramIsLinear)
+{
+  // Every ray holds its index, so resampling with the axis moved by a
+  // fraction of a ray gives the index plus that fraction.
+  const int numberOfRays = 16;
+  vtkNew<vtkImageData> ramp;
+  ramp->SetExtent(0, 1, 0, numberOfRays - 1, 0, 2);
+  ramp->AllocateScalars(VTK_FLOAT, 1);
+  auto data = static_cast<float*>(ramp->GetScalarPointer());
+  for (int z = 0; z < 3; ++z) {
+    for (int y = 0; y < numberOfRays; ++y) {
+      for (int x = 0; x < 2; ++x) {
+        *data++ = static_cast<float>(y);
+      }
+    }
+  }
+
+  std::vector<float> sinogram(numberOfRays * 3);
+  for (double axisPosition : { 0.25, -0.25, 2.6 }) {
+    TomographyTiltSeries::getSinogram(ramp, 1, sinogram.data(), numberOfRays,
+                                      axisPosition);
+    for (int z = 0; z < 3; ++z) {
+      for (int r = 1; r < numberOfRays - 3; ++r) {
+        EXPECT_NEAR(sinogram[z * numberOfRays + r], r + axisPosition, 1e-5)
+          << "axis position " << axisPosition << ", ray " << r;
+      }
+    }
+  }
+}
+
+TEST_F(TomographyReconstructionTest, sinogramCacheOfSomeSlices)
+{
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  for (int tiltAxis : { 0, 1 }) {
+    int numberOfSlices = dims[tiltAxis];
+    std::vector<int> slices = { numberOfSlices - 1, 0, numberOfSlices / 2 };
+    TomographyTiltSeries::SinogramCache full(tiltSeries, tiltAxis, 2);
+    TomographyTiltSeries::SinogramCache cache(tiltSeries, tiltAxis, slices, 2);
+    ASSERT_EQ(cache.slices(), slices);
+    ASSERT_EQ(cache.numberOfSlices(), numberOfSlices);
+    const int sinogramSize = cache.numberOfRays() * cache.numberOfTilts();
+    for (int slice : slices) {
+      std::vector<float> expected(full.sinogram(slice),
+                                  full.sinogram(slice) + sinogramSize);
+      std::vector<float> actual(cache.sinogram(slice),
+                                cache.sinogram(slice) + sinogramSize);
+      ASSERT_EQ(expected, actual) << "tilt axis " << tiltAxis;
+    }
+
+    auto intensities =
+      TomographyTiltSeries::sliceIntensities(tiltSeries, tiltAxis);
+    ASSERT_EQ(static_cast<int>(intensities.size()), numberOfSlices);
+    for (int slice = 0; slice < numberOfSlices; ++slice) {
+      double sum = 0;
+      for (int i = 0; i < sinogramSize; ++i) {
+        sum += full.sinogram(slice)[i];
+      }
+      EXPECT_NEAR(intensities[slice], sum, 1e-6 * std::abs(sum) + 1e-6);
+    }
+  }
+}
+
+TEST_F(TomographyReconstructionTest, sinogramCacheCancel)
+{
+  int calls = 0;
+  auto canceled = [&calls]() { return ++calls > 1; };
+  TomographyTiltSeries::SinogramCache cache(tiltSeries, 0, 1, canceled);
+  EXPECT_TRUE(cache.empty());
+  EXPECT_EQ(cache.numberOfSlices(), 0);
+  EXPECT_EQ(calls, 2);
+
+  TomographyTiltSeries::SinogramCache complete(tiltSeries, 0, 1,
+                                               []() { return false; });
+  EXPECT_FALSE(complete.empty());
+}
+
+TEST_F(TomographyReconstructionTest, parallelSliceMatchesSerial)
+{
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  const int Nray = 50;
+  std::vector<float> sinogram(Nray * dims[2]);
+  TomographyTiltSeries::getSinogram(tiltSeries, 6, sinogram.data(), Nray, 1.5);
+  auto angles = static_cast<double*>(
+    tiltSeries->GetFieldData()->GetArray("tilt_angles")->GetVoidPointer(0));
+
+  std::vector<float> serial(Nray * Nray);
+  TomographyReconstruction::unweightedBackProjection2(
+    sinogram.data(), angles, serial.data(), dims[2], Nray);
+  float maxValue = 0;
+  for (float value : serial) {
+    maxValue = std::max(maxValue, std::abs(value));
+  }
+  ASSERT_GT(maxValue, 0);
+
+  std::vector<float> parallel(Nray * Nray, -1.0f);
+  int rows = 0;
+  auto progress = [&rows](int completed, int) {
+    rows = completed;
+    return true;
+  };
+  ASSERT_TRUE(TomographyReconstruction::parallelBackProjection2(
+    sinogram.data(), angles, parallel.data(), dims[2], Nray, progress, 3));
+  ASSERT_EQ(rows, Nray);
+  for (int i = 0; i < Nray * Nray; ++i) {
+    ASSERT_NEAR(serial[i], parallel[i], 1e-5 * maxValue) << "at index " << i;
+  }
+}
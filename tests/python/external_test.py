@@ -23,3 +23,138 @@ def test_external_pipeline(test_state_file, tmpdir):
 
     # assert that we have the right output
     assert sha.hexdigest() == expected_sha
+
+
+def test_shared_volume_round_trip(tmpdir):
+    import numpy as np
+    from tomviz import executor
+    from tomviz.external_dataset import Dataset
+
+    data = np.asfortranarray(np.arange(4 * 5 * 6, dtype=np.float32)
+                             .reshape((4, 5, 6)))
+    mask = np.asfortranarray(data > 30)
+    dataset = Dataset({'data': data, 'mask': mask}, 'data')
+    dataset.spacing = [1.0, 2.0, 3.0]
+    dataset.tilt_angles = np.linspace(-60.0, 60.0, 6)
+
+    path = tmpdir.join('volume' + executor.SHARED_VOLUME_EXTENSION).strpath
+    executor._write_shared_volume(path, dataset)
+    output = executor._read_shared_volume(path)
+
+    [(active_name, active), (mask_name, mask_read)] = output['arrays']
+    assert active_name == 'data'
+    assert mask_name == 'mask'
+    assert np.array_equal(active, data)
+    # Masks come back as bytes, which VTK can hold
+    assert mask_read.dtype == np.uint8
+    assert np.array_equal(mask_read, mask)
+    assert output['spacing'] == [1.0, 2.0, 3.0]
+    assert np.allclose(output['tilt_angles'], dataset.tilt_angles)
+    assert output['tilt_axis'] == 2
+
+
+def test_shared_volume_fallback(tmpdir, monkeypatch):
+    import numpy as np
+    from tomviz import executor
+    from tomviz.external_dataset import Dataset
+
+    data = np.asfortranarray(np.arange(4 * 5 * 6, dtype=np.float32)
+                             .reshape((4, 5, 6)))
+    dataset = Dataset({'data': data}, 'data')
+    path = tmpdir.join('volume' + executor.SHARED_VOLUME_EXTENSION).strpath
+
+    # Just enough room
+    monkeypatch.setattr(executor, '_free_bytes', lambda d: data.nbytes + 1)
+    assert executor._write_data(path, dataset) == path
+    output = executor._read_shared_volume(path)
+    assert np.array_equal(output['arrays'][0][1], data)
+    tmpdir.remove()
+    tmpdir.mkdir()
+
+    # Not enough room to map the output, nothing is mapped and an EMD file is
+    # written instead
+    monkeypatch.setattr(executor, '_free_bytes', lambda d: data.nbytes)
+    emd_path = tmpdir.join('volume.emd').strpath
+    assert executor._write_data(path, dataset) == emd_path
+    assert sorted(tmpdir.listdir()) == [tmpdir.join('volume.emd')]
+    with h5py.File(emd_path, 'r') as f:
+        assert np.array_equal(f['data/tomography/data'][:], data)
+
+
+def test_progress_preview():
+    import numpy as np
+    from tomviz import executor
+    from tomviz.external_dataset import Dataset
+
+    data = np.zeros((100, 40, 7), dtype=np.float32, order='F')
+    dataset = Dataset({'data': data}, 'data')
+    dataset.spacing = [0.5, 0.5, 2.0]
+
+    # Full resolution unless asked otherwise
+    assert executor._preview(dataset, 0) is dataset
+    assert executor._preview(dataset, 100) is dataset
+
+    preview = executor._preview(dataset, 32)
+    assert preview.active_scalars.shape == (25, 10, 2)
+    assert preview.spacing == [2.0, 2.0, 8.0]
+
+
+def test_progress_data_throttling(tmpdir, monkeypatch):
+    import numpy as np
+    from tomviz import executor
+    from tomviz.external_dataset import Dataset
+
+    class RecordingProgress(executor.WriteToFileMixin, executor.JsonProgress):
+        def __init__(self, path):
+            self._path = path
+            self._sequence_number = 0
+            self._operator_index = 0
+            self.messages = []
+
+        def write(self, data):
+            self.messages.append(data)
+
+    def sent():
+        return [m['value'] for m in progress.messages
+                if m['type'] == 'progress.data']
+
+    def dataset(value):
+        data = np.full((4, 3, 2), value, dtype=np.float32, order='F')
+        return Dataset({'data': data}, 'data')
+
+    now = [100.0]
+    monkeypatch.setattr(executor.time, 'monotonic', lambda: now[0])
+
+    progress = RecordingProgress(tmpdir.join('progress').strpath)
+    progress.data_interval = 1.0
+
+    progress.data = dataset(1)
+    assert sent() == ['0.emd']
+
+    # Held back until the interval has passed, then only the latest is sent
+    tmpdir.join('0.emd').remove()
+    now[0] += 0.5
+    progress.data = dataset(2)
+    progress.data = dataset(3)
+    assert sent() == ['0.emd']
+    now[0] += 0.5
+    progress.data = dataset(4)
+    assert sent() == ['0.emd', '1.emd']
+    with h5py.File(tmpdir.join('1.emd').strpath, 'r') as f:
+        assert np.all(f['data/tomography/data'][:] == 4)
+
+    # Held back while the application hasn't loaded the last file
+    now[0] += 5
+    progress.data = dataset(5)
+    assert sent() == ['0.emd', '1.emd']
+
+    # The pending update is flushed when the operator finishes
+    progress.finished(0)
+    assert sent() == ['0.emd', '1.emd', '2.emd']
+    assert progress.messages[-1] == {'type': 'finished', 'operator': 0}
+
+    # Nothing is left to flush
+    tmpdir.join('1.emd').remove()
+    tmpdir.join('2.emd').remove()
+    progress.finished(1)
+    assert sent() == ['0.emd', '1.emd', '2.emd']
@@ -14,8 +14,8 @@
 
 namespace tomviz {
 
-AddAlignReaction::AddAlignReaction(QAction* parentObject)
-  : Reaction(parentObject)
+AddAlignReaction::AddAlignReaction(QAction* parentObject, bool autoAlign)
+  : Reaction(parentObject), m_autoAlign(autoAlign)
 {
 }
 
@@ -28,10 +28,12 @@ void AddAlignReaction::align(DataSource* source)
   }
 
   auto Op = new TranslateAlignOperator(source);
+  Op->setAlignOnEdit(m_autoAlign);
   auto dialog = new EditOperatorDialog(Op, source, true, tomviz::mainWidget());
 
   dialog->setAttribute(Qt::WA_DeleteOnClose);
-  dialog->setWindowTitle("Manual Image Alignment");
+  dialog->setWindowTitle(m_autoAlign ? "Automatic Image Alignment"
+                                     : "Manual Image Alignment");
   dialog->show();
   connect(Op, SIGNAL(destroyed()), dialog, SLOT(reject()));
 }
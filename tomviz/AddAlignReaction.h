@@ -14,7 +14,9 @@ class AddAlignReaction : public Reaction
   Q_OBJECT
 
 public:
-  AddAlignReaction(QAction* parent);
+  /// With autoAlign the alignment is computed by cross-correlation as soon as
+  /// the editor opens, and can then be adjusted by hand.
+  AddAlignReaction(QAction* parent, bool autoAlign = false);
 
   void align(DataSource* source = nullptr);
 
@@ -23,6 +25,7 @@ protected:
 
 private:
   Q_DISABLE_COPY(AddAlignReaction)
+  bool m_autoAlign;
 };
 } // namespace tomviz
 
@@ -5,6 +5,7 @@
 
 #include "ActiveObjects.h"
 #include "ColorMap.h"
+#include "CrossCorrelationAlignment.h"
 #include "DataSource.h"
 #include "LoadDataReaction.h"
 #include "PresetDialog.h"
@@ -49,6 +50,7 @@
 #include <QDebug>
 #include <QFileDialog>
 #include <QFormLayout>
+#include <QFutureWatcher>
 #include <QGridLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -67,6 +69,9 @@
 #include <QTimer>
 #include <QToolButton>
 #include <QVBoxLayout>
+#include <QtConcurrent>
+
+#include <cmath>
 
 namespace tomviz {
 
@@ -348,7 +353,7 @@ private:
 
 AlignWidget::AlignWidget(TranslateAlignOperator* op,
                          vtkSmartPointer<vtkImageData> imageData, QWidget* p)
-  : EditOperatorWidget(p)
+  : EditOperatorWidget(p), m_autoAlignCanceled(false)
 {
   m_timer = new QTimer(this);
   m_operator = op;
@@ -495,6 +500,7 @@ AlignWidget::AlignWidget(TranslateAlignOperator* op,
   if (startRef == -1) {
     startRef = (m_minSliceNum + m_maxSliceNum) / 2;
   }
+  m_defaultReference = startRef;
 
   QLabel* keyGuide = new QLabel;
   keyGuide->setWordWrap(true);
@@ -585,16 +591,78 @@ AlignWidget::AlignWidget(TranslateAlignOperator* op,
   buttonLayout->addStretch();
   v->addLayout(buttonLayout);
 
+  // Automatic alignment, which can be rerun at any time to replace the
+  // offsets. The combo box indices match CrossCorrelationAlignment::Reference.
+  QHBoxLayout* autoAlignLayout = new QHBoxLayout;
+  autoAlignLayout->addWidget(new QLabel("Cross-correlate:"));
+  m_autoAlignMode = new QComboBox;
+  m_autoAlignMode->insertItem(
+    static_cast<int>(CrossCorrelationAlignment::Reference::Neighbors),
+    "Each image to its neighbor");
+  m_autoAlignMode->insertItem(
+    static_cast<int>(CrossCorrelationAlignment::Reference::Static),
+    "Each image to the reference");
+  m_autoAlignMode->setToolTip(
+    "Images are aligned outwards from the zero degree image, or from the "
+    "reference image when Static is selected.");
+  autoAlignLayout->addWidget(m_autoAlignMode);
+  m_autoAlignButton = new QPushButton("Auto Align");
+  connect(m_autoAlignButton, &QPushButton::clicked, this,
+          &AlignWidget::autoAlign);
+  autoAlignLayout->addWidget(m_autoAlignButton);
+  v->addLayout(autoAlignLayout);
+  m_autoAlignStatus = new QLabel;
+  v->addWidget(m_autoAlignStatus);
+
+  // The combo box indices match ImageTranslation::Interpolation.
+  QHBoxLayout* interpolationLayout = new QHBoxLayout;
+  interpolationLayout->addWidget(new QLabel("Subpixel shifts:"));
+  m_interpolation = new QComboBox;
+  m_interpolation->insertItem(
+    static_cast<int>(ImageTranslation::Interpolation::Nearest),
+    "None (whole pixels)");
+  m_interpolation->insertItem(
+    static_cast<int>(ImageTranslation::Interpolation::Linear), "Bilinear");
+  m_interpolation->insertItem(
+    static_cast<int>(ImageTranslation::Interpolation::Fourier), "Fourier");
+  m_interpolation->setCurrentIndex(
+    static_cast<int>(m_operator->interpolation()));
+  m_interpolation->setToolTip(
+    "Cross-correlation finds shifts to a fraction of a pixel. The fractions "
+    "are applied with the selected interpolation, offsets entered by hand "
+    "stay whole pixels.");
+  interpolationLayout->addWidget(m_interpolation);
+  v->addLayout(interpolationLayout);
+
+  m_autoAlignWatcher = new QFutureWatcher<bool>(this);
+  connect(m_autoAlignWatcher, &QFutureWatcherBase::finished, this,
+          &AlignWidget::autoAlignFinished);
+  connect(this, &AlignWidget::autoAlignProgress, this,
+          [this](int completed, int total) {
+            m_autoAlignStatus->setText(QString("Correlated %1 of %2 images")
+                                         .arg(completed)
+                                         .arg(total));
+          });
+
   m_offsetTable = new QTableWidget(this);
   m_offsetTable->verticalHeader()->setVisible(false);
   v->addWidget(m_offsetTable, 2);
   m_offsets.fill(vtkVector2i(0, 0), m_maxSliceNum + 1);
+  m_subpixelOffsets.fill(vtkVector2d(0, 0), m_offsets.size());
+  auto oldSubpixelOffsets = m_operator->getSubpixelOffsets();
+  for (int i = 0; i < oldSubpixelOffsets.size() && i < m_offsets.size();
+       ++i) {
+    m_subpixelOffsets[i] = oldSubpixelOffsets[i];
+  }
 
   QVector<vtkVector2i> oldOffsets = m_operator->getDraftAlignOffsets();
   if (oldOffsets.size() > 0) {
     int answer = restoreDraftDialog();
     if (answer != QMessageBox::Yes) {
       oldOffsets = m_operator->getAlignOffsets();
+    } else {
+      // The fractions belong to the saved offsets, the draft is whole pixels.
+      m_subpixelOffsets.fill(vtkVector2d(0, 0));
     }
   } else {
     oldOffsets = m_operator->getAlignOffsets();
@@ -659,10 +727,18 @@ AlignWidget::AlignWidget(TranslateAlignOperator* op,
           SLOT(sliceOffsetEdited(int, int)));
   changeSlice(0);
   m_timer->start(200);
+
+  if (m_operator->alignOnEdit()) {
+    m_operator->setAlignOnEdit(false);
+    autoAlign();
+  }
 }
 
 AlignWidget::~AlignWidget()
 {
+  // The worker reads the input data, let it stop first.
+  m_autoAlignCanceled = true;
+  m_autoAlignWatcher->waitForFinished();
   qDeleteAll(m_modes);
   m_modes.clear();
 }
@@ -841,6 +917,7 @@ void AlignWidget::widgetKeyPress(QKeyEvent* key)
   }
   if (updateTable) {
     int sliceNumber = m_currentSlice->value();
+    m_subpixelOffsets[sliceNumber] = vtkVector2d(0, 0);
     QTableWidgetItem* item = m_offsetTable->item(sliceNumber, 1);
     item->setData(Qt::DisplayRole, QString::number(offset[0]));
     item = m_offsetTable->item(sliceNumber, 2);
@@ -993,6 +1070,7 @@ void AlignWidget::onLoadClicked()
   }
   m_operator->setDraftAlignOffsets(offsets);
   m_offsets = offsets;
+  m_subpixelOffsets.fill(vtkVector2d(0, 0));
 
   for (int i = 0; i < m_offsets.size(); ++i) {
     m_offsetTable->item(i, 1)->setText(QString::number(m_offsets[i][0]));
@@ -1021,9 +1099,77 @@ void AlignWidget::loadAlignError(QString msg) const
                         QMessageBox::Ok, QMessageBox::Ok);
 }
 
+void AlignWidget::autoAlign()
+{
+  if (m_autoAlignWatcher->isRunning()) {
+    m_autoAlignCanceled = true;
+    return;
+  }
+  if (!m_inputData) {
+    return;
+  }
+
+  CrossCorrelationAlignment::Options options;
+  options.reference = static_cast<CrossCorrelationAlignment::Reference>(
+    m_autoAlignMode->currentIndex());
+  int reference = m_statButton->isChecked() ? m_refNum->value()
+                                            : m_defaultReference;
+  options.referenceImage = reference - m_minSliceNum;
+
+  m_autoAlignCanceled = false;
+  m_autoAlignButton->setText("Cancel");
+  m_autoAlignMode->setEnabled(false);
+  m_autoAlignStatus->setText("Correlating images...");
+  vtkSmartPointer<vtkImageData> image = m_inputData;
+  auto future = QtConcurrent::run([this, image, options]() {
+    auto progress = [this](int completed, int total) {
+      emit autoAlignProgress(completed, total);
+      return !m_autoAlignCanceled;
+    };
+    return CrossCorrelationAlignment::alignImages(
+      image, options, m_autoAlignShifts, progress);
+  });
+  m_autoAlignWatcher->setFuture(future);
+}
+
+void AlignWidget::autoAlignFinished()
+{
+  m_autoAlignButton->setText("Auto Align");
+  m_autoAlignMode->setEnabled(true);
+  if (!m_autoAlignWatcher->result()) {
+    m_autoAlignStatus->setText("Automatic alignment canceled");
+    return;
+  }
+
+  // The offsets are whole pixels, the rest is only applied when a subpixel
+  // interpolation is selected.
+  int count = std::min(m_offsets.size(),
+                       static_cast<int>(m_autoAlignShifts.size()));
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      m_offsets[i][j] = static_cast<int>(std::lround(m_autoAlignShifts[i][j]));
+      m_subpixelOffsets[i][j] = m_autoAlignShifts[i][j] - m_offsets[i][j];
+    }
+  }
+  if (m_operator) {
+    m_operator->setDraftAlignOffsets(m_offsets);
+  }
+  for (int i = 0; i < m_offsets.size(); ++i) {
+    m_offsetTable->item(i, 1)->setText(QString::number(m_offsets[i][0]));
+    m_offsetTable->item(i, 2)->setText(QString::number(m_offsets[i][1]));
+  }
+  applySliceOffset();
+  applySliceOffset(m_referenceSlice);
+  m_autoAlignStatus->setText(
+    QString("Aligned %1 images by cross-correlation").arg(count));
+}
+
 void AlignWidget::applyChangesToOperator()
 {
   if (m_operator) {
+    m_operator->setSubpixelOffsets(m_subpixelOffsets);
+    m_operator->setInterpolation(static_cast<ImageTranslation::Interpolation>(
+      m_interpolation->currentIndex()));
     m_operator->setAlignOffsets(m_offsets);
     // When the operator is saved, the draft is discarded
     m_operator->setDraftAlignOffsets(QVector<vtkVector2i>());
@@ -1066,6 +1212,11 @@ void AlignWidget::sliceOffsetEdited(int slice, int offsetComponent)
   bool ok;
   int offset = str.toInt(&ok);
   if (ok) {
+    // The table is also updated with the offsets found by cross-correlation,
+    // which keep their fractions.
+    if (offset != m_offsets[slice][offsetComponent - 1]) {
+      m_subpixelOffsets[slice] = vtkVector2d(0, 0);
+    }
     m_offsets[slice][offsetComponent - 1] = offset;
     if (m_operator) {
       m_operator->setDraftAlignOffsets(m_offsets);
@@ -13,6 +13,9 @@
 #include <QPointer>
 #include <QVector>
 
+#include <atomic>
+#include <vector>
+
 class QLabel;
 class QComboBox;
 class QFileDialog;
@@ -23,6 +26,8 @@ class QButtonGroup;
 class QPushButton;
 class QRadioButton;
 class QTableWidget;
+template <typename T>
+class QFutureWatcher;
 
 class vtkImageData;
 class vtkImageSlice;
@@ -53,6 +58,10 @@ public:
 
   void applyChangesToOperator() override;
 
+signals:
+  // Emitted from the worker thread as the automatic alignment progresses.
+  void autoAlignProgress(int completed, int total);
+
 protected:
   void changeSlice(int delta);
   void setSlice(int slice, bool resetInc = true);
@@ -83,6 +92,11 @@ protected slots:
   void onSaveClicked();
   void onLoadClicked();
 
+  // Computes the offsets of every image by cross-correlation in the
+  // background, or cancels the computation if one is running.
+  void autoAlign();
+  void autoAlignFinished();
+
 protected:
   vtkNew<vtkRenderer> m_renderer;
   vtkNew<vtkInteractorStyleRubberBand2D> m_defaultInteractorStyle;
@@ -103,6 +117,10 @@ protected:
   QPushButton* m_startButton;
   QPushButton* m_stopButton;
   QTableWidget* m_offsetTable;
+  QComboBox* m_autoAlignMode;
+  QPushButton* m_autoAlignButton;
+  QLabel* m_autoAlignStatus;
+  QComboBox* m_interpolation;
 
   int m_frameRate = 5;
   int m_referenceSlice = 0;
@@ -115,8 +133,17 @@ protected:
   int m_currentMode = 0;
 
   QVector<vtkVector2i> m_offsets;
+  // The fractions of a pixel cross-correlation found on top of m_offsets,
+  // dropped for an image once its offset is edited by hand.
+  QVector<vtkVector2d> m_subpixelOffsets;
   QPointer<TranslateAlignOperator> m_operator;
 
+  // The zero degree image, or the middle one without tilt angles.
+  int m_defaultReference = 0;
+  QFutureWatcher<bool>* m_autoAlignWatcher;
+  std::vector<vtkVector2d> m_autoAlignShifts;
+  std::atomic<bool> m_autoAlignCanceled;
+
 private:
   int restoreDraftDialog() const;
   QString dialogToFileName(QFileDialog*) const;
@@ -4,11 +4,18 @@
 #ifndef tomvizComputeHistogram_h
 #define tomvizComputeHistogram_h
 
+#include "ParallelUtilities.h"
+
 #include <vtkDoubleArray.h>
 #include <vtkImageData.h>
 #include <vtkMath.h>
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 namespace tomviz {
 
@@ -105,10 +112,353 @@ void CalculateHistogram(T* values, const vtkIdType numTuples,
   }
 }
 
+/** Number of values handed to each task of a parallel histogram. */
+inline vtkIdType histogramChunkSize(vtkIdType numValues)
+{
+  const vtkIdType minChunk = 1 << 20;
+  vtkIdType chunk = numValues / (4 * parallelThreadCount());
+  return std::max(chunk, minChunk);
+}
+
+/**
+ * Types with few enough distinct values to be counted exactly by value. Their
+ * range and histogram come out of a single pass over the data.
+ */
+template <typename T>
+struct HistogramByValue
+{
+  static const bool value = std::is_integral<T>::value && sizeof(T) <= 2;
+};
+
+/** Branch free finite min/max of a chunk of floating point values. */
+template <typename T,
+          typename std::enable_if<!std::is_integral<T>::value>::type* = nullptr>
+void chunkRange(const T* values, const vtkIdType n, T& min, T& max)
+{
+  T lo = std::numeric_limits<T>::infinity();
+  T hi = -std::numeric_limits<T>::infinity();
+  for (vtkIdType j = 0; j < n; ++j) {
+    const T value = values[j];
+    // inf - inf and nan - nan are both nan, so this is false for them.
+    const bool finite = (value - value) == 0;
+    lo = std::min(lo, finite ? value : lo);
+    hi = std::max(hi, finite ? value : hi);
+  }
+  min = lo;
+  max = hi;
+}
+
+/** Min/max of a chunk of integral values. */
+template <typename T,
+          typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
+void chunkRange(const T* values, const vtkIdType n, T& min, T& max)
+{
+  T lo = std::numeric_limits<T>::max();
+  T hi = std::numeric_limits<T>::lowest();
+  for (vtkIdType j = 0; j < n; ++j) {
+    lo = std::min(lo, values[j]);
+    hi = std::max(hi, values[j]);
+  }
+  min = lo;
+  max = hi;
+}
+
+/**
+ * Branch free binning of a chunk of single component values. Non-finite values
+ * are counted in the extra bin pops[numberOfBins], so the loop has no data
+ * dependent branches.
+ */
+template <typename T>
+void binChunk(const T* values, const vtkIdType n, const float min,
+              const float inv, const int numberOfBins, uint64_t* pops)
+{
+  const int last = numberOfBins - 1;
+  for (vtkIdType j = 0; j < n; ++j) {
+    const T value = values[j];
+    const bool finite = (value - value) == 0;
+    const T safeValue = finite ? value : static_cast<T>(min);
+    int index = static_cast<int>((safeValue - min) * inv);
+    index = std::min(std::max(index, 0), last);
+    ++pops[finite ? index : numberOfBins];
+  }
+}
+
+/**
+ * Single pass range and histogram for types counted by value: every thread
+ * counts its chunks into a private table with one entry per possible value,
+ * the tables are merged, and the range and the binned histogram are read off
+ * the merged table. The result is identical to binning every value.
+ */
+template <typename T, typename std::enable_if<
+                        HistogramByValue<T>::value>::type* = nullptr>
+void calcHistogramByValue(const T* values, const vtkIdType numValues,
+                          const int numberOfBins, double range[2],
+                          uint64_t* pops)
+{
+  const int numberOfValues = 1 << (8 * sizeof(T));
+  const int offset = -static_cast<int>(std::numeric_limits<T>::lowest());
+  std::vector<uint64_t> counts(numberOfValues, 0);
+  std::mutex mutex;
+
+  const vtkIdType chunk = histogramChunkSize(numValues);
+  const int numChunks = static_cast<int>((numValues + chunk - 1) / chunk);
+  parallelFor(0, numChunks, [&](int c) {
+    const vtkIdType begin = c * chunk;
+    const vtkIdType end = std::min(begin + chunk, numValues);
+    std::vector<uint64_t> local(numberOfValues, 0);
+    for (vtkIdType j = begin; j < end; ++j) {
+      ++local[values[j] + offset];
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int k = 0; k < numberOfValues; ++k) {
+      counts[k] += local[k];
+    }
+  });
+
+  int first = 0;
+  while (first < numberOfValues - 1 && counts[first] == 0) {
+    ++first;
+  }
+  int last = numberOfValues - 1;
+  while (last > first && counts[last] == 0) {
+    --last;
+  }
+  range[0] = first - offset;
+  range[1] = last - offset;
+  if (range[0] == range[1]) {
+    range[1] = range[0] + 1.0;
+  }
+
+  const float min = range[0];
+  const float inv = 1.0 / ((range[1] - range[0]) / (numberOfBins - 1));
+  for (int k = first; k <= last; ++k) {
+    if (counts[k]) {
+      const T value = static_cast<T>(k - offset);
+      int index = static_cast<int>((value - min) * inv);
+      pops[std::min(index, numberOfBins - 1)] += counts[k];
+    }
+  }
+}
+
+/** Needs to be present, should never be called. */
+template <typename T, typename std::enable_if<
+                        !HistogramByValue<T>::value>::type* = nullptr>
+void calcHistogramByValue(const T*, const vtkIdType, const int, double*,
+                          uint64_t*)
+{
+}
+
+/**
+ * Computes the finite range of an array with a parallel, branch free pass,
+ * like vtkDataArray::GetFiniteRange(range, -1) but without reading or writing
+ * the range cached in the array's information, so it can be called on any
+ * thread. range is set to [inf, -inf] if there are no finite values.
+ * \param numComponents Number of components in each tuple, the range of the
+ * magnitude is computed for multi-component arrays.
+ */
+template <typename T>
+void CalculateFiniteRangeParallel(const T* values, const vtkIdType numTuples,
+                                  const int numComponents, double range[2])
+{
+  const vtkIdType chunk = histogramChunkSize(numTuples);
+  const int numChunks = static_cast<int>((numTuples + chunk - 1) / chunk);
+  std::mutex mutex;
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+  parallelFor(0, numChunks, [&](int c) {
+    const vtkIdType begin = c * chunk;
+    const vtkIdType end = std::min(begin + chunk, numTuples);
+    double chunkMin = std::numeric_limits<double>::infinity();
+    double chunkMax = -std::numeric_limits<double>::infinity();
+    if (numComponents == 1) {
+      T min, max;
+      chunkRange(values + begin, end - begin, min, max);
+      if (min <= max) {
+        chunkMin = min;
+        chunkMax = max;
+      }
+    } else {
+      for (vtkIdType j = begin; j < end; ++j) {
+        double squaredSum = 0.0;
+        for (int k = 0; k < numComponents; ++k) {
+          double value = values[j * numComponents + k];
+          squaredSum += value * value;
+        }
+        if (vtkMath::IsFinite(squaredSum)) {
+          double magnitude = sqrt(squaredSum);
+          chunkMin = std::min(chunkMin, magnitude);
+          chunkMax = std::max(chunkMax, magnitude);
+        }
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    lo = std::min(lo, chunkMin);
+    hi = std::max(hi, chunkMax);
+  });
+  range[0] = lo;
+  range[1] = hi;
+}
+
+/**
+ * Computes the finite range of an array together with its histogram, using
+ * every core. Each task bins its chunk of the array into private bins that
+ * are merged at the end. Small integer types are counted by value in a single
+ * pass. Other types are binned in a single pass when the caller already knows
+ * the finite range, e.g. from the range cached by vtkDataArray. Otherwise the
+ * range is found by a parallel, branch free pass before the values are
+ * binned: bin edges depend on the global range, so binning any earlier would
+ * mean rebinning.
+ * \param values The array from which to compute the histogram.
+ * \param numTuples Number of tuples in the array.
+ * \param numComponents Number of components in each tuple, the magnitude is
+ * binned for multi-component arrays.
+ * \param numberOfBins Number of bins, or length of the pops array.
+ * \param range The finite range if rangeKnown is set. Returns the finite range
+ * spanned by the bins, widened to a length of one for constant data.
+ * \param rangeKnown Whether range already holds the finite range of the
+ * values, it is ignored for types counted by value.
+ * \return The number of tuples with a non-finite value.
+ */
+template <typename T>
+vtkIdType CalculateHistogramParallel(T* values, const vtkIdType numTuples,
+                                     const int numComponents,
+                                     const int numberOfBins, double range[2],
+                                     uint64_t* pops, bool rangeKnown = false)
+{
+  std::fill(pops, pops + numberOfBins, 0);
+  if (numComponents == 1 && HistogramByValue<T>::value) {
+    calcHistogramByValue(values, numTuples, numberOfBins, range, pops);
+    return 0;
+  }
+
+  const vtkIdType chunk = histogramChunkSize(numTuples);
+  const int numChunks = static_cast<int>((numTuples + chunk - 1) / chunk);
+  std::mutex mutex;
+
+  // Range pass, skipped when the range is known
+  if (!rangeKnown) {
+    CalculateFiniteRangeParallel(values, numTuples, numComponents, range);
+  }
+  double lo = range[0];
+  double hi = range[1];
+  if (lo > hi) {
+    // No finite values at all
+    lo = hi = 0.0;
+  }
+  if (lo == hi) {
+    hi = lo + 1.0;
+  }
+  range[0] = lo;
+  range[1] = hi;
+
+  // Binning pass
+  const float min = range[0];
+  const float max = range[1];
+  const float inv = 1.0 / ((range[1] - range[0]) / (numberOfBins - 1));
+  vtkIdType invalid = 0;
+  parallelFor(0, numChunks, [&](int c) {
+    const vtkIdType begin = c * chunk;
+    const vtkIdType end = std::min(begin + chunk, numTuples);
+    std::vector<uint64_t> local(numberOfBins + 1, 0);
+    int chunkInvalid = 0;
+    if (numComponents == 1) {
+      binChunk(values + begin, end - begin, min, inv, numberOfBins,
+               local.data());
+      chunkInvalid = static_cast<int>(local[numberOfBins]);
+    } else {
+      CalculateHistogram(values + begin * numComponents, end - begin,
+                         numComponents, min, max, local.data(), inv,
+                         chunkInvalid);
+      // Rounding can push the largest magnitude one bin past the end.
+      local[numberOfBins - 1] += local[numberOfBins];
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int k = 0; k < numberOfBins; ++k) {
+      pops[k] += local[k];
+    }
+    invalid += chunkInvalid;
+  });
+  return invalid;
+}
+
+/**
+ * Accumulates the 2D (value, gradient magnitude) histogram of the center
+ * slices [kBegin, kEnd) into counts. Only every stride'th voxel along each
+ * axis is visited, the gradient itself always uses the adjacent voxels.
+ */
+template <typename T>
+void accumulate2DHistogram(const T* values, const int* dim, const int numComp,
+                           const double* range, const int* bins,
+                           const double* delta, const int stride,
+                           const int kBegin, const int kEnd,
+                           std::vector<vtkIdType>& counts)
+{
+  const vtkIdType sliceStride = static_cast<vtkIdType>(dim[0]) * dim[1];
+  const vtkIdType rowStride = dim[0];
+  const double maxGradMag = range[1] * 0.25;
+  const double gradScale = (bins[1] - 1) / maxGradMag;
+  const double valueScale = (bins[0] - 1) / (range[1] - range[0]);
+
+  for (int k = kBegin; k < kEnd; k += stride) {
+    for (int j = 1; j < dim[1] - 1; j += stride) {
+      const vtkIdType rowIndex = k * sliceStride + j * rowStride;
+      for (int i = 1; i < dim[0] - 1; i += stride) {
+        const vtkIdType center = rowIndex + i;
+        const double Dx = static_cast<double>(values[(center + 1) * numComp] -
+                                              values[(center - 1) * numComp]) /
+                          delta[0];
+        const double Dy =
+          static_cast<double>(values[(center + rowStride) * numComp] -
+                              values[(center - rowStride) * numComp]) /
+          delta[1];
+        const double Dz =
+          static_cast<double>(values[(center + sliceStride) * numComp] -
+                              values[(center - sliceStride) * numComp]) /
+          delta[2];
+
+        // Normalize to RangeMax/4. This is what the gradient computation in
+        // the GPUMapper's fragment shader expects.
+        double gradMag = floor(sqrt(Dx * Dx + Dy * Dy + Dz * Dz) + 0.5);
+        const double value = values[center * numComp];
+        if (!vtkMath::IsFinite(gradMag) || !vtkMath::IsFinite(value)) {
+          continue;
+        }
+        gradMag = vtkMath::ClampValue(gradMag, 0.0, maxGradMag);
+        const int gradIndex = static_cast<int>(gradMag * gradScale);
+        const int valueIndex = vtkMath::ClampValue(
+          static_cast<int>((value - range[0]) * valueScale), 0, bins[0] - 1);
+        ++counts[gradIndex * bins[0] + valueIndex];
+      }
+    }
+  }
+}
+
+/**
+ * Stride along each axis that brings a volume of numberOfPoints voxels down to
+ * about previewVoxels, for a coarse preview of its 2D histogram. Returns 1,
+ * no preview, for volumes of up to eight times previewVoxels.
+ */
+inline int preview2DHistogramStride(vtkIdType numberOfPoints,
+                                    vtkIdType previewVoxels)
+{
+  if (numberOfPoints <= 8 * previewVoxels) {
+    return 1;
+  }
+  double ratio = static_cast<double>(numberOfPoints) / previewVoxels;
+  return static_cast<int>(std::ceil(std::cbrt(ratio)));
+}
+
+/**
+ * Computes the 2D histogram of scalar value against gradient magnitude used by
+ * the 2D transfer function editor. The volume is split into z-slabs that are
+ * accumulated in parallel into private counts, then merged.
+ * \param stride Sample every stride'th voxel along each axis, counts are
+ * scaled by stride^3 so a subsampled histogram approximates the full one.
+ */
 template <typename T>
 void Calculate2DHistogram(T* values, const int* dim, const int numComp,
                           const double* range, vtkImageData* histogram,
-                          double spacing[3])
+                          double spacing[3], int stride = 1)
 {
   // Assumes all inputs are valid
   // Expects histogram image to be 1C double
@@ -126,15 +476,8 @@ void Calculate2DHistogram(T* values, const int* dim, const int numComp,
                            (range[1] * 0.25) / bins[1], 1.0 };
   histogram->SetSpacing(binSpacing);
 
-  memset(histogramArr->GetVoidPointer(0), 0x0, sizeBins * sizeof(double));
-
-  const size_t sizeSlice = static_cast<size_t>(dim[0]) * dim[1] * numComp;
-  std::vector<T> sliceLast(sizeSlice, 0);
-  std::vector<T> sliceCurrent(sizeSlice, 0);
-  std::vector<T> sliceNext(sizeSlice, 0);
-
-  double gradMagMax = std::numeric_limits<double>::min();
-  double gradMagMin = std::numeric_limits<double>::max();
+  double* histogramPtr = histogramArr->GetPointer(0);
+  std::fill(histogramPtr, histogramPtr + sizeBins, 0.0);
 
   // Central differences delta (2 * h)
   const double avgSpacing = (spacing[0] + spacing[1] + spacing[2]) / 3.0;
@@ -142,66 +485,35 @@ void Calculate2DHistogram(T* values, const int* dim, const int numComp,
                             spacing[1] * 2 / avgSpacing,
                             spacing[2] * 2 / avgSpacing };
 
-  for (int kIndex = 0; kIndex < dim[2]; kIndex++) {
-    // Index assumes alignment order in  x -> y -> z.
-    // ( z0 * Dx * Dy + y0 * Dx + x0 ) * numComp
-    const size_t strideSlice =
-      static_cast<size_t>(dim[0]) * dim[1] * kIndex * numComp;
-    memcpy(&(sliceNext[0]), values + strideSlice, sizeSlice * sizeof(T));
-
-    // Fill up temporary slices during the first two iterations
-    if (kIndex >= 2) {
-      for (int jIndex = 1; jIndex < dim[1] - 1; jIndex++) {
-        for (int iIndex = 1; iIndex < dim[0] - 1; iIndex++) {
-          const size_t centerIndex =
-            static_cast<size_t>(dim[0]) * jIndex + iIndex;
-          const size_t deltaXFront = centerIndex + 1;
-          const size_t deltaXBack = centerIndex - 1;
-
-          const double Dx = static_cast<double>(sliceCurrent[deltaXFront] -
-                                                sliceCurrent[deltaXBack]) /
-                            delta[0];
-
-          const size_t deltaYFront =
-            static_cast<size_t>(dim[0]) * (jIndex + 1) + iIndex;
-          const size_t deltaYBack =
-            static_cast<size_t>(dim[0]) * (jIndex - 1) + iIndex;
-          const double Dy = static_cast<double>(sliceCurrent[deltaYFront] -
-                                                sliceCurrent[deltaYBack]) /
-                            delta[1];
-
-          const double Dz = static_cast<double>(sliceNext[centerIndex] -
-                                                sliceLast[centerIndex]) /
-                            delta[2];
-
-          double gradMag = sqrt(Dx * Dx + Dy * Dy + Dz * Dz);
-          gradMagMax = vtkMath::Max(gradMag, gradMagMax);
-          gradMagMin = vtkMath::Min(gradMag, gradMagMin);
-
-          // Normalize to RangeMax/4. This is what the gradient computation in
-          // the
-          // GPUMapper's fragment shader expects.
-          const double maxGradMag = range[1] * 0.25;
-          gradMag = floor(gradMag + 0.5);
-          gradMag = vtkMath::ClampValue(gradMag, 0.0, maxGradMag);
-          const vtkIdType gradIndex =
-            static_cast<vtkIdType>(gradMag * (bins[1] - 1) / maxGradMag);
-
-          const T value = values[strideSlice + centerIndex * numComp];
-          const vtkIdType valueIndex = static_cast<vtkIdType>(
-            (value - range[0]) * (bins[1] - 1) / (range[1] - range[0]));
-
-          // Update histogram array
-          const vtkIdType tupleIndex = gradIndex * bins[0] + valueIndex;
-          double histogramValue = histogramArr->GetValue(tupleIndex);
-          histogramArr->SetValue(tupleIndex, ++histogramValue);
-        }
-      }
+  // Only the interior slices have a central difference along z. Slabs are
+  // whole multiples of the stride so the sampling matches a serial pass.
+  stride = std::max(stride, 1);
+  const int numSlices = dim[2] - 2;
+  if (numSlices <= 0) {
+    return;
+  }
+  const int numSamples = (numSlices + stride - 1) / stride;
+  const int numSlabs = std::min(numSamples, 4 * parallelThreadCount());
+  const int slabSamples = (numSamples + numSlabs - 1) / numSlabs;
+  std::mutex mutex;
+
+  parallelFor(0, numSlabs, [&](int slab) {
+    const int kBegin = 1 + slab * slabSamples * stride;
+    const int kEnd = std::min(kBegin + slabSamples * stride, dim[2] - 1);
+    if (kBegin >= kEnd) {
+      return;
     }
+    std::vector<vtkIdType> counts(sizeBins, 0);
+    accumulate2DHistogram(values, dim, numComp, range, bins, delta, stride,
+                          kBegin, kEnd, counts);
 
-    std::swap(sliceLast, sliceCurrent);
-    std::swap(sliceCurrent, sliceNext);
-  }
+    const double weight = static_cast<double>(stride) * stride * stride;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t b = 0; b < sizeBins; ++b) {
+      histogramPtr[b] += counts[b] * weight;
+    }
+  });
+  histogramArr->Modified();
 }
 
 } // namespace tomviz
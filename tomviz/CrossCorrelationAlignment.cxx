@@ -0,0 +1,332 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "CrossCorrelationAlignment.h"
+
+#include "ParallelUtilities.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace tomviz {
+namespace CrossCorrelationAlignment {
+
+namespace {
+
+typedef FFTPlan::Complex Complex;
+
+const double Pi = 3.14159265358979323846;
+
+// Columns gathered together for the transforms along y, so that every row is
+// read and written in runs of this many values.
+const int ColumnBlockSize = 16;
+
+// numpy.fft.fftfreq(n)[k]
+double frequency(int k, int n)
+{
+  return (k < (n + 1) / 2 ? k : k - n) / static_cast<double>(n);
+}
+
+// Copies the first component of z slice "slice" to image as floats.
+template <typename T>
+void copySlice(const T* data, int components, size_t sliceSize, int slice,
+               float* image)
+{
+  const T* in = data + sliceSize * slice * components;
+  for (size_t i = 0; i < sliceSize; ++i) {
+    image[i] = static_cast<float>(in[i * components]);
+  }
+}
+
+// Wraps a peak index in [0, n) to a shift in (-n / 2, n / 2].
+int wrap(int index, int n)
+{
+  return index > n / 2 ? index - n : index;
+}
+
+// The position of the vertex of the parabola through (-1, left), (0, center)
+// and (1, right), relative to the center.
+double parabolicOffset(double left, double center, double right)
+{
+  double denominator = left - 2 * center + right;
+  if (denominator >= 0) {
+    return 0;
+  }
+  double offset = 0.5 * (left - right) / denominator;
+  return std::max(-0.5, std::min(0.5, offset));
+}
+} // namespace
+
+Correlator::Correlator(int width, int height, double filterCutoff)
+  : m_width(width), m_height(height),
+    m_rowPlan(FFTPlan::nextPowerOfTwo(width)),
+    m_columnPlan(FFTPlan::nextPowerOfTwo(height))
+{
+  // Real space filter, sin^2 falling to zero at the edges of the image.
+  m_window.resize(static_cast<size_t>(width) * height);
+  for (int y = 0; y < height; ++y) {
+    double wy = std::sin(Pi * (y + 1) / height);
+    for (int x = 0; x < width; ++x) {
+      double wx = std::sin(Pi * (x + 1) / width);
+      m_window[static_cast<size_t>(y) * width + x] =
+        static_cast<float>(wx * wx * wy * wy);
+    }
+  }
+
+  // Fourier space band pass filter.
+  int px = m_rowPlan.size();
+  int py = m_columnPlan.size();
+  m_filter.resize(spectrumSize());
+  for (int y = 0; y < py; ++y) {
+    double ky = frequency(y, py);
+    for (int x = 0; x < px; ++x) {
+      double kx = frequency(x, px);
+      double kr = std::sqrt(kx * kx + ky * ky);
+      double value = 0;
+      if (kr <= 0.5 / filterCutoff) {
+        value = std::sin(2 * filterCutoff * Pi * kr);
+        value *= value;
+      }
+      m_filter[static_cast<size_t>(y) * px + x] = static_cast<float>(value);
+    }
+  }
+}
+
+size_t Correlator::spectrumSize() const
+{
+  return static_cast<size_t>(m_rowPlan.size()) * m_columnPlan.size();
+}
+
+void Correlator::load(const float* image, Complex* data, bool imaginary) const
+{
+  size_t size = static_cast<size_t>(m_width) * m_height;
+  double mean = 0;
+  for (size_t i = 0; i < size; ++i) {
+    mean += image[i];
+  }
+  mean /= size;
+
+  int px = m_rowPlan.size();
+  for (int y = 0; y < m_height; ++y) {
+    const float* in = image + static_cast<size_t>(y) * m_width;
+    const float* window = m_window.data() + static_cast<size_t>(y) * m_width;
+    Complex* out = data + static_cast<size_t>(y) * px;
+    for (int x = 0; x < m_width; ++x) {
+      auto value = static_cast<float>((in[x] - mean) * window[x]);
+      if (imaginary) {
+        out[x].imag(value);
+      } else {
+        out[x].real(value);
+      }
+    }
+  }
+}
+
+void Correlator::spectrum(const float* image, Complex* spectrum) const
+{
+  std::fill(spectrum, spectrum + spectrumSize(), Complex(0, 0));
+  load(image, spectrum, false);
+  transform(spectrum, false);
+}
+
+void Correlator::spectra(const float* first, const float* second,
+                         Complex* firstSpectrum, Complex* secondSpectrum) const
+{
+  std::fill(firstSpectrum, firstSpectrum + spectrumSize(), Complex(0, 0));
+  load(first, firstSpectrum, false);
+  load(second, firstSpectrum, true);
+  transform(firstSpectrum, false);
+
+  // With z = first + i * second, the transform of second is
+  // (Z(k) - conj(Z(-k))) / 2i, and the transform of first is Z - i * that.
+  int px = m_rowPlan.size();
+  int py = m_columnPlan.size();
+  const Complex minusHalfI(0, -0.5f);
+  for (int y = 0; y < py; ++y) {
+    const Complex* mirrored =
+      firstSpectrum + static_cast<size_t>((py - y) % py) * px;
+    Complex* z = firstSpectrum + static_cast<size_t>(y) * px;
+    Complex* out = secondSpectrum + static_cast<size_t>(y) * px;
+    for (int x = 0; x < px; ++x) {
+      out[x] = (z[x] - std::conj(mirrored[(px - x) % px])) * minusHalfI;
+    }
+  }
+  for (size_t i = 0; i < spectrumSize(); ++i) {
+    firstSpectrum[i] -= Complex(0, 1) * secondSpectrum[i];
+  }
+}
+
+vtkVector2d Correlator::shift(const Complex* image, const Complex* reference,
+                              Complex* scratch, bool subpixel) const
+{
+  size_t size = spectrumSize();
+  for (size_t i = 0; i < size; ++i) {
+    scratch[i] = std::conj(image[i]) * reference[i] * m_filter[i];
+  }
+  transform(scratch, true);
+
+  int px = m_rowPlan.size();
+  int py = m_columnPlan.size();
+  size_t peak = 0;
+  for (size_t i = 1; i < size; ++i) {
+    if (scratch[i].real() > scratch[peak].real()) {
+      peak = i;
+    }
+  }
+  int x = static_cast<int>(peak % px);
+  int y = static_cast<int>(peak / px);
+  vtkVector2d result(wrap(x, px), wrap(y, py));
+  if (subpixel) {
+    auto value = [scratch, px, py](int i, int j) {
+      return scratch[static_cast<size_t>((j + py) % py) * px + (i + px) % px]
+        .real();
+    };
+    double center = value(x, y);
+    result[0] += parabolicOffset(value(x - 1, y), center, value(x + 1, y));
+    result[1] += parabolicOffset(value(x, y - 1), center, value(x, y + 1));
+  }
+  return result;
+}
+
+void Correlator::transform(Complex* data, bool inverse) const
+{
+  int px = m_rowPlan.size();
+  int py = m_columnPlan.size();
+  for (int y = 0; y < py; ++y) {
+    Complex* row = data + static_cast<size_t>(y) * px;
+    if (inverse) {
+      m_rowPlan.inverse(row);
+    } else {
+      m_rowPlan.forward(row);
+    }
+  }
+
+  // Columns are copied out in blocks, transformed, and copied back.
+  std::vector<Complex> columns(static_cast<size_t>(ColumnBlockSize) * py);
+  for (int x0 = 0; x0 < px; x0 += ColumnBlockSize) {
+    int block = std::min(ColumnBlockSize, px - x0);
+    for (int y = 0; y < py; ++y) {
+      const Complex* row = data + static_cast<size_t>(y) * px + x0;
+      for (int c = 0; c < block; ++c) {
+        columns[static_cast<size_t>(c) * py + y] = row[c];
+      }
+    }
+    for (int c = 0; c < block; ++c) {
+      Complex* column = columns.data() + static_cast<size_t>(c) * py;
+      if (inverse) {
+        m_columnPlan.inverse(column);
+      } else {
+        m_columnPlan.forward(column);
+      }
+    }
+    for (int y = 0; y < py; ++y) {
+      Complex* row = data + static_cast<size_t>(y) * px + x0;
+      for (int c = 0; c < block; ++c) {
+        row[c] = columns[static_cast<size_t>(c) * py + y];
+      }
+    }
+  }
+}
+
+bool alignImages(vtkImageData* tiltSeries, const Options& options,
+                 std::vector<vtkVector2d>& shifts, const Progress& progress,
+                 int numberOfThreads)
+{
+  auto scalars =
+    tiltSeries ? tiltSeries->GetPointData()->GetScalars() : nullptr;
+  if (!scalars) {
+    return false;
+  }
+
+  int dims[3];
+  tiltSeries->GetDimensions(dims);
+  const int numberOfImages = dims[2];
+  const size_t imageSize = static_cast<size_t>(dims[0]) * dims[1];
+  int reference = options.referenceImage;
+  if (reference < 0 || reference >= numberOfImages) {
+    reference = numberOfImages / 2;
+  }
+
+  // Every image is correlated with the one it is aligned to, which is the
+  // reference for Static and the neighbor towards the reference otherwise.
+  auto target = [&options, reference](int i) {
+    if (options.reference == Reference::Static) {
+      return reference;
+    }
+    return i > reference ? i - 1 : i + 1;
+  };
+
+  Correlator correlator(dims[0], dims[1], options.filterCutoff);
+  const size_t spectrumSize = correlator.spectrumSize();
+  auto loadImage = [&](int slice, float* image) {
+    switch (scalars->GetDataType()) {
+      vtkTemplateMacro(
+        copySlice(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+                  scalars->GetNumberOfComponents(), imageSize, slice, image));
+    }
+  };
+
+  // The reference spectrum is shared by every image in Static mode. In
+  // Neighbors mode each image transforms its neighbor as well, which keeps
+  // the memory use at a few images per thread.
+  std::vector<Complex> referenceSpectrum;
+  if (options.reference == Reference::Static) {
+    std::vector<float> image(imageSize);
+    referenceSpectrum.resize(spectrumSize);
+    loadImage(reference, image.data());
+    correlator.spectrum(image.data(), referenceSpectrum.data());
+  }
+
+  std::vector<vtkVector2d> relative(numberOfImages, vtkVector2d(0, 0));
+  auto body = [&](int i) {
+    if (i == reference) {
+      return;
+    }
+    std::vector<float> image(imageSize);
+    std::vector<Complex> spectrum(spectrumSize);
+    std::vector<Complex> scratch(spectrumSize);
+    if (options.reference == Reference::Static) {
+      loadImage(i, image.data());
+      correlator.spectrum(image.data(), spectrum.data());
+      relative[i] = correlator.shift(spectrum.data(), referenceSpectrum.data(),
+                                     scratch.data(), options.subpixel);
+    } else {
+      // Both images of the pair come out of one transform.
+      std::vector<float> neighbor(imageSize);
+      std::vector<Complex> neighborSpectrum(spectrumSize);
+      loadImage(i, image.data());
+      loadImage(target(i), neighbor.data());
+      correlator.spectra(image.data(), neighbor.data(), spectrum.data(),
+                         neighborSpectrum.data());
+      relative[i] = correlator.shift(spectrum.data(), neighborSpectrum.data(),
+                                     scratch.data(), options.subpixel);
+    }
+  };
+  std::function<bool(int, int)> report;
+  if (progress) {
+    report = [&progress, numberOfImages](int completed, int) {
+      return progress(completed, numberOfImages);
+    };
+  }
+  if (!parallelFor(0, numberOfImages, body, report, numberOfThreads)) {
+    return false;
+  }
+
+  // Accumulate the relative shifts outwards from the reference.
+  shifts.assign(numberOfImages, vtkVector2d(0, 0));
+  for (int step : { 1, -1 }) {
+    for (int i = reference + step; i >= 0 && i < numberOfImages; i += step) {
+      const vtkVector2d& base = shifts[target(i)];
+      for (int j = 0; j < 2; ++j) {
+        shifts[i][j] = relative[i][j] + base[j];
+      }
+    }
+  }
+  return true;
+}
+} // namespace CrossCorrelationAlignment
+} // namespace tomviz
@@ -0,0 +1,103 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizCrossCorrelationAlignment_h
+#define tomvizCrossCorrelationAlignment_h
+
+#include "FFTPlan.h"
+
+#include <vtkVector.h>
+
+#include <functional>
+#include <vector>
+
+class vtkImageData;
+
+namespace tomviz {
+
+namespace CrossCorrelationAlignment {
+
+// The native counterpart of AutoCrossCorrelationTiltImageAlignment.py. The
+// shifts it finds use the convention of TranslateAlignOperator: moving image i
+// by shifts[i] lines it up with the reference.
+
+enum class Reference
+{
+  // Every image is aligned to its neighbor towards the reference image, and
+  // the shifts are accumulated outwards from the reference, like the Python
+  // operator.
+  Neighbors,
+  // Every image is aligned to the reference image directly.
+  Static
+};
+
+struct Options
+{
+  Reference reference = Reference::Neighbors;
+  // The image the others are aligned to, the middle one when out of range.
+  int referenceImage = -1;
+  // Low pass cutoff of the band pass filter applied to the correlations, in
+  // the units of the Python operator's filterCutoff.
+  double filterCutoff = 4;
+  // Refine the correlation peaks to a fraction of a pixel.
+  bool subpixel = true;
+};
+
+// Cross-correlates images of a fixed size. The images are mean subtracted and
+// windowed to remove edge discontinuities, then zero padded to powers of two
+// for the transforms. A correlator is immutable once built, so one is shared
+// by every thread, each transforming its own buffers.
+class Correlator
+{
+public:
+  Correlator(int width, int height, double filterCutoff = 4);
+
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+
+  // Number of complex values in a spectrum.
+  size_t spectrumSize() const;
+
+  // The transform of the filtered image, spectrumSize() values with x
+  // fastest.
+  void spectrum(const float* image, FFTPlan::Complex* spectrum) const;
+
+  // The transforms of two filtered images at once, using a single complex
+  // transform since the images are real.
+  void spectra(const float* first, const float* second,
+               FFTPlan::Complex* firstSpectrum,
+               FFTPlan::Complex* secondSpectrum) const;
+
+  // The shift that lines up the image with the reference, given their
+  // spectra. scratch must hold spectrumSize() values.
+  vtkVector2d shift(const FFTPlan::Complex* image,
+                    const FFTPlan::Complex* reference,
+                    FFTPlan::Complex* scratch, bool subpixel = true) const;
+
+private:
+  // Writes the mean subtracted, windowed image to the real or imaginary parts
+  // of the zero padded data.
+  void load(const float* image, FFTPlan::Complex* data, bool imaginary) const;
+  void transform(FFTPlan::Complex* data, bool inverse) const;
+
+  int m_width;
+  int m_height;
+  FFTPlan m_rowPlan;
+  FFTPlan m_columnPlan;
+  std::vector<float> m_window;
+  std::vector<float> m_filter;
+};
+
+// Called with the number of images processed and the total, on the calling
+// thread. Returning false cancels the alignment.
+typedef std::function<bool(int, int)> Progress;
+
+// Computes the shift of every z slice of the active scalars of tiltSeries.
+// All the correlations run concurrently. Returns false if canceled.
+bool alignImages(vtkImageData* tiltSeries, const Options& options,
+                 std::vector<vtkVector2d>& shifts,
+                 const Progress& progress = nullptr, int numberOfThreads = 0);
+} // namespace CrossCorrelationAlignment
+} // namespace tomviz
+
+#endif
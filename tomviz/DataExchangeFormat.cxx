@@ -137,52 +137,44 @@ QVector<double> DataExchangeFormat::readTheta(const std::string& fileName,
 
 namespace {
 
-bool writeData(h5::H5ReadWrite& writer, vtkImageData* image)
+bool writeExtraData(h5::H5ReadWrite& writer, vtkImageData* image,
+                    const std::string& path, const std::string& name,
+                    bool isTiltSeries, const QVariantMap& options)
 {
-  vtkNew<vtkImageData> permutedImage;
-  if (DataSource::hasTiltAngles(image)) {
-    // No deep copies of data needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
-    GenericHDF5Format::relabelXAndZAxes(permutedImage);
-  } else {
-    // Need to re-order to C ordering before writing
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
+  if (!isTiltSeries) {
+    // Re-ordered to C ordering as it is written, without a full copy
+    return GenericHDF5Format::writeReorderedVolume(writer, path, name, image,
+                                                   options);
   }
 
-  // Assume /exchange already exists
-  return GenericHDF5Format::writeVolume(writer, "/exchange", "data",
-                                        permutedImage);
+  // No deep copying needed. Just re-label the axes.
+  vtkNew<vtkImageData> permutedImage;
+  permutedImage->ShallowCopy(image);
+  GenericHDF5Format::relabelXAndZAxes(permutedImage);
+  return GenericHDF5Format::writeVolume(writer, path, name, permutedImage,
+                                        options);
 }
 
-bool writeExtraData(h5::H5ReadWrite& writer, vtkImageData* image,
-                    const std::string& path, const std::string& name,
-                    bool isTiltSeries = false)
+bool writeData(h5::H5ReadWrite& writer, vtkImageData* image,
+               const QVariantMap& options)
 {
-  vtkNew<vtkImageData> permutedImage;
-  if (isTiltSeries) {
-    // No deep copying needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
-    GenericHDF5Format::relabelXAndZAxes(permutedImage);
-  } else {
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
-  }
-
   // Assume /exchange already exists
-  return GenericHDF5Format::writeVolume(writer, path, name, permutedImage);
+  return writeExtraData(writer, image, "/exchange", "data",
+                        DataSource::hasTiltAngles(image), options);
 }
 
 bool writeDark(h5::H5ReadWrite& writer, vtkImageData* image,
-               bool isTiltSeries = false)
+               bool isTiltSeries, const QVariantMap& options)
 {
-  return writeExtraData(writer, image, "/exchange", "data_dark", isTiltSeries);
+  return writeExtraData(writer, image, "/exchange", "data_dark", isTiltSeries,
+                        options);
 }
 
 bool writeWhite(h5::H5ReadWrite& writer, vtkImageData* image,
-                bool isTiltSeries = false)
+                bool isTiltSeries, const QVariantMap& options)
 {
-  return writeExtraData(writer, image, "/exchange", "data_white", isTiltSeries);
+  return writeExtraData(writer, image, "/exchange", "data_white", isTiltSeries,
+                        options);
 }
 
 bool writeTheta(h5::H5ReadWrite& writer, vtkImageData* image)
@@ -199,7 +191,8 @@ bool writeTheta(h5::H5ReadWrite& writer, vtkImageData* image)
 
 } // namespace
 
-bool DataExchangeFormat::write(const std::string& fileName, DataSource* source)
+bool DataExchangeFormat::write(const std::string& fileName, DataSource* source,
+                               const QVariantMap& options)
 {
   using h5::H5ReadWrite;
   H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::WriteOnly;
@@ -210,18 +203,18 @@ bool DataExchangeFormat::write(const std::string& fileName, DataSource* source)
 
   auto t = source->producer();
   auto image = vtkImageData::SafeDownCast(t->GetOutputDataObject(0));
-  if (!writeData(writer, image))
+  if (!writeData(writer, image, options))
     return false;
 
   bool isTiltSeries = source->hasTiltAngles();
 
   if (source->darkData()) {
-    if (!writeDark(writer, source->darkData(), isTiltSeries))
+    if (!writeDark(writer, source->darkData(), isTiltSeries, options))
       return false;
   }
 
   if (source->whiteData()) {
-    if (!writeWhite(writer, source->whiteData(), isTiltSeries))
+    if (!writeWhite(writer, source->whiteData(), isTiltSeries, options))
       return false;
   }
 
@@ -24,8 +24,10 @@ public:
   // theta angles, and it will swap x and z for tilt series.
   bool read(const std::string& fileName, DataSource* source,
             const QVariantMap& options = QVariantMap());
-  // A data source is required for writing
-  bool write(const std::string& fileName, DataSource* source);
+  // A data source is required for writing. See
+  // GenericHDF5Format::writeVolume() for the options.
+  bool write(const std::string& fileName, DataSource* source,
+             const QVariantMap& options = QVariantMap());
 
 private:
   // Read the dark dataset into the image data
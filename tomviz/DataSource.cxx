@@ -10,12 +10,16 @@
 #include "DataExchangeFormat.h"
 #include "EmdFormat.h"
 #include "GenericHDF5Format.h"
+#include "GrowableImageData.h"
 #include "ModuleFactory.h"
 #include "ModuleManager.h"
 #include "Operator.h"
 #include "OperatorFactory.h"
 #include "Pipeline.h"
 #include "Utilities.h"
+#include "VolumePyramid.h"
+
+#include <h5cpp/h5readwrite.h>
 
 #include <vtkDataObject.h>
 #include <vtkDoubleArray.h>
@@ -45,10 +49,10 @@
 #include <QDebug>
 #include <QJsonArray>
 #include <QMap>
+#include <QScopedPointer>
 #include <QTimer>
 
 #include <cmath>
-#include <cstring>
 #include <sstream>
 
 namespace {
@@ -96,6 +100,13 @@ public:
   bool Forkable = true;
   // Track data array renames
   QMap<QString, QString> CurrentToOriginal;
+  // Growth of the data as slices are appended, and the coalesced update
+  QScopedPointer<GrowableImageData> Growable;
+  QTimer* AppendTimer = nullptr;
+  // The HDF5 file and data set the data was read from. It is taken out of
+  // the field data so that it isn't copied into the data derived from it.
+  QString Hdf5FileName;
+  QString Hdf5Path;
 
   // Checks if the tilt angles data array exists on the given VTK data
   // and creates it if it does not exist.
@@ -177,80 +188,68 @@ DataSource::~DataSource()
   delete m_pythonProxy;
 }
 
-// Simple templated function to extend the image data.
-template <typename T>
-void appendImageData(vtkImageData* data, vtkImageData* slice, T* originalPtr)
-{
-  auto dataArray = data->GetPointData()->GetScalars();
-  int extents[6];
-  data->GetExtent(extents);
-
-  // Figure out the number of bytes in the original data, and allocate a buffer.
-  int bufferSize = dataArray->GetNumberOfTuples() *
-                   dataArray->GetNumberOfComponents() * sizeof(T);
-  unsigned char* buffer = new unsigned char[bufferSize];
-  // Copy the original image data, as the allocate scalars will erase it.
-  std::memcpy(buffer, originalPtr, bufferSize);
-  // Now increment the z extent, and reallocate the scalar array (destructive).
-  ++extents[5];
-  data->SetExtent(extents);
-  data->AllocateScalars(data->GetScalarType(),
-                        data->GetNumberOfScalarComponents());
-  // Copy the old data back into the new memory location, delete the buffer.
-  auto ptr = data->GetScalarPointer();
-  std::memcpy(ptr, buffer, bufferSize);
-  delete[] buffer;
-  buffer = 0;
-
-  // Now copy the new slice into the array.
-  void* imagePtr = data->GetScalarPointer(0, 0, extents[5]);
-  auto sliceArray = slice->GetPointData()->GetScalars();
-  void* slicePtr = sliceArray->GetVoidPointer(0);
-  int sliceSize = sliceArray->GetNumberOfTuples() *
-                  sliceArray->GetNumberOfComponents() * sizeof(T);
-  std::memcpy(imagePtr, slicePtr, sliceSize);
-
-  // Let everyone know the data has changed, then re-execute the pipeline.
-  data->Modified();
-}
-
 bool DataSource::appendSlice(vtkImageData* slice)
 {
   if (!slice) {
     return false;
   }
 
-  int sliceExtents[6];
-  slice->GetExtent(sliceExtents);
   auto tp = algorithm();
-  if (tp) {
-    auto data = vtkImageData::SafeDownCast(tp->GetOutputDataObject(0));
-    if (data) {
-      int extents[6];
-      data->GetExtent(extents);
-      cout << "The data is ";
-      for (int i = 0; i < 6; ++i)
-        cout << extents[i] << ", ";
-      cout << endl;
-      for (int i = 0; i < 4; ++i) {
-        if (extents[i] != sliceExtents[i]) {
-          cout << "Mismatch: " << extents[i] << " != " << sliceExtents[i]
-               << endl;
-          return false;
-        }
-      }
+  if (!tp) {
+    return true;
+  }
+  auto data = vtkImageData::SafeDownCast(tp->GetOutputDataObject(0));
+  if (!data) {
+    return true;
+  }
 
-      // Now to append the slice onto our image data.
-      switch (data->GetScalarType()) {
-        vtkTemplateMacro(appendImageData(
-          data, slice, static_cast<VTK_TT*>(data->GetScalarPointer())));
+  // Appending grows the scalars geometrically, rather than reallocating and
+  // copying the whole volume for every new slice. Each append sets a new
+  // scalars array, so a running pipeline that shares the previous one is
+  // unaffected and picks up the new slices the next time it runs.
+  auto& growable = this->Internals->Growable;
+  if (growable.isNull() || growable->image() != data) {
+    growable.reset(new GrowableImageData(data));
+  }
+  if (!growable->append(slice)) {
+    int extents[6], sliceExtents[6];
+    data->GetExtent(extents);
+    slice->GetExtent(sliceExtents);
+    for (int i = 0; i < 4; ++i) {
+      if (extents[i] != sliceExtents[i]) {
+        qWarning() << "Mismatch:" << extents[i] << "!=" << sliceExtents[i];
+        break;
       }
+    }
+    return false;
+  }
 
+  // Slices can arrive faster than the views and the pipeline can keep up,
+  // coalesce the updates so that a burst of slices costs a single update.
+  if (!this->Internals->AppendTimer) {
+    auto timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setInterval(100);
+    connect(timer, &QTimer::timeout, this, [this, timer]() {
+      auto p = pipeline();
+      if (p && p->isRunning()) {
+        // Let the current run finish, it will be picked up next time.
+        timer->start();
+        return;
+      }
+      dataModified();
       emit dataChanged();
       emit dataPropertiesChanged();
-      pipeline()->execute()->deleteWhenFinished();
-    }
+      if (p) {
+        p->execute()->deleteWhenFinished();
+      }
+    });
+    this->Internals->AppendTimer = timer;
   }
+  if (!this->Internals->AppendTimer->isActive()) {
+    this->Internals->AppendTimer->start();
+  }
+
   return true;
 }
 
@@ -366,7 +365,8 @@ bool DataSource::reloadAndResample()
   auto image = vtkImageData::SafeDownCast(data);
 
   bool success;
-  QVariantMap options{ { "askForSubsample", true } };
+  // Resampling always starts from the full resolution data.
+  QVariantMap options{ { "askForSubsample", true }, { "pyramidLevel", 0 } };
   if (file.endsWith("emd", Qt::CaseInsensitive)) {
     EmdFormat format;
     success = format.read(file.toLatin1().data(), image, options);
@@ -376,6 +376,7 @@ bool DataSource::reloadAndResample()
   } else {
     success = GenericHDF5Format::read(file.toLatin1().data(), image, options);
   }
+  takeHdf5Source(image);
 
   // If there are operators, re-run the pipeline
   if (!operators().empty())
@@ -387,6 +388,43 @@ bool DataSource::reloadAndResample()
   return success;
 }
 
+int DataSource::numberOfResolutionLevels()
+{
+  if (this->Internals->Hdf5FileName.isEmpty() || hasTiltAngles())
+    return 1;
+
+  using h5::H5ReadWrite;
+  H5ReadWrite reader(this->Internals->Hdf5FileName.toStdString(),
+                     H5ReadWrite::OpenMode::ReadOnly);
+  return VolumePyramid::numberOfLevels(
+    reader, this->Internals->Hdf5Path.toStdString());
+}
+
+bool DataSource::loadResolutionLevel(int level)
+{
+  if (this->Internals->Hdf5FileName.isEmpty() || hasTiltAngles())
+    return false;
+
+  using h5::H5ReadWrite;
+  H5ReadWrite reader(this->Internals->Hdf5FileName.toStdString(),
+                     H5ReadWrite::OpenMode::ReadOnly);
+  bool success = VolumePyramid::readLevel(
+    reader, this->Internals->Hdf5Path.toStdString(), level, imageData());
+  takeHdf5Source(imageData());
+  if (!success) {
+    return false;
+  }
+
+  // If there are operators, re-run the pipeline
+  if (!operators().empty())
+    pipeline()->execute(this, operators().first())->deleteWhenFinished();
+
+  dataModified();
+  emit activeScalarsChanged();
+  emit dataPropertiesChanged();
+  return true;
+}
+
 bool DataSource::isImageStack() const
 {
   auto reader = m_json.value("reader").toObject(QJsonObject());
@@ -633,6 +671,8 @@ DataSource* DataSource::clone() const
                                  this->Internals->Type, this->pipeline());
   newClone->setLabel(this->label());
   newClone->setPersistenceState(PersistenceState::Modified);
+  newClone->Internals->Hdf5FileName = this->Internals->Hdf5FileName;
+  newClone->Internals->Hdf5Path = this->Internals->Hdf5Path;
 
   if (this->Internals->Type == TiltSeries) {
     newClone->setTiltAngles(getTiltAngles());
@@ -1084,6 +1124,7 @@ void DataSource::setData(vtkDataObject* newData)
   auto tp = producer();
   Q_ASSERT(tp);
   tp->SetOutput(newData);
+  takeHdf5Source(newData);
   auto fd = newData->GetFieldData();
   vtkSmartPointer<vtkTypeInt8Array> typeArray =
     vtkTypeInt8Array::SafeDownCast(fd->GetArray("tomviz_data_source_type"));
@@ -1267,6 +1308,7 @@ void DataSource::init(vtkImageData* data, DataSourceType dataType,
   if (data) {
     auto tp = vtkTrivialProducer::SafeDownCast(source->GetClientSideObject());
     tp->SetOutput(data);
+    takeHdf5Source(data);
   }
 
   // Initialize maps to track array renames
@@ -1517,4 +1559,71 @@ void DataSource::setSubsampleVolumeBounds(vtkDataObject* image, int bs[6])
   setFieldDataArray<ArrayType>(fd, arrayName, 6, bs);
 }
 
+int DataSource::resolutionLevel(vtkDataObject* image)
+{
+  int level = 0;
+
+  if (!image)
+    return level;
+
+  const char* arrayName = "pyramid_level";
+  using ArrayType = vtkTypeInt32Array;
+
+  vtkFieldData* fd = image->GetFieldData();
+  getFieldDataArray<ArrayType>(fd, arrayName, 1, &level);
+  return level;
+}
+
+void DataSource::setResolutionLevel(vtkDataObject* image, int level)
+{
+  if (!image)
+    return;
+
+  const char* arrayName = "pyramid_level";
+  using ArrayType = vtkTypeInt32Array;
+
+  vtkFieldData* fd = image->GetFieldData();
+  setFieldDataArray<ArrayType>(fd, arrayName, 1, &level);
+}
+
+bool DataSource::hdf5Source(vtkDataObject* image, QString& fileName,
+                            QString& path)
+{
+  if (!image)
+    return false;
+
+  auto array = vtkStringArray::SafeDownCast(
+    image->GetFieldData()->GetAbstractArray("hdf5_source"));
+  if (!array || array->GetNumberOfValues() != 2)
+    return false;
+
+  fileName = QString::fromStdString(array->GetValue(0));
+  path = QString::fromStdString(array->GetValue(1));
+  return true;
+}
+
+void DataSource::setHdf5Source(vtkDataObject* image, const QString& fileName,
+                               const QString& path)
+{
+  if (!image)
+    return;
+
+  vtkNew<vtkStringArray> array;
+  array->SetName("hdf5_source");
+  array->InsertNextValue(fileName.toStdString());
+  array->InsertNextValue(path.toStdString());
+  image->GetFieldData()->AddArray(array);
+}
+
+void DataSource::takeHdf5Source(vtkDataObject* data)
+{
+  QString fileName, path;
+  if (!hdf5Source(data, fileName, path))
+    return;
+
+  this->Internals->Hdf5FileName = fileName;
+  this->Internals->Hdf5Path = path;
+  data->GetFieldData()->RemoveArray("hdf5_source");
+}
+
 } // namespace tomviz
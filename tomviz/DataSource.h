@@ -161,6 +161,18 @@ public:
   /// Set the volume bounds used to generate the subsample
   void setSubsampleVolumeBounds(int bs[6]);
 
+  /// The level of the multiresolution pyramid the data was read from, 0 for
+  /// the full resolution data.
+  int resolutionLevel() const;
+
+  /// The number of levels in the pyramid stored with the data, including the
+  /// full resolution data, or 1 if there is no pyramid.
+  int numberOfResolutionLevels();
+
+  /// Replace the data with another level of its pyramid, and re-run the
+  /// pipeline on it. Returns false if the level can't be read.
+  bool loadResolutionLevel(int level);
+
   /// Can we reload and resample the original dataset?
   bool canReloadAndResample() const;
 
@@ -308,6 +320,20 @@ public:
   /// Set the volume bounds used to generate the subsample
   static void setSubsampleVolumeBounds(vtkDataObject* image, int bs[6]);
 
+  /// Get the HDF5 file and data set path the data was read from
+  static bool hdf5Source(vtkDataObject* image, QString& fileName,
+                         QString& path);
+
+  /// Set the HDF5 file and data set path the data was read from
+  static void setHdf5Source(vtkDataObject* image, const QString& fileName,
+                            const QString& path);
+
+  /// Get the level of the multiresolution pyramid the data was read from
+  static int resolutionLevel(vtkDataObject* image);
+
+  /// Set the level of the multiresolution pyramid the data was read from
+  static void setResolutionLevel(vtkDataObject* image, int level);
+
   /// Get a simple proxy for the data source to simplify Python wrapping.
   DataSourceBase* pythonProxy() const { return m_pythonProxy; }
 
@@ -348,6 +374,9 @@ private:
   void init(vtkImageData* dataSource, DataSourceType dataType,
             PersistenceState persistState);
 
+  /// Move the HDF5 source of the data out of its field data, if it has one.
+  void takeHdf5Source(vtkDataObject* data);
+
   vtkAlgorithm* algorithm() const;
 
   Q_DISABLE_COPY(DataSource)
@@ -386,6 +415,11 @@ inline void DataSource::setSubsampleStrides(int s[3])
   setSubsampleStrides(dataObject(), s);
 }
 
+inline int DataSource::resolutionLevel() const
+{
+  return resolutionLevel(dataObject());
+}
+
 inline void DataSource::subsampleVolumeBounds(int bs[6]) const
 {
   subsampleVolumeBounds(dataObject(), bs);
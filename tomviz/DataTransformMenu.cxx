@@ -14,6 +14,7 @@
 #include "ConvertToFloatReaction.h"
 #include "CropReaction.h"
 #include "DeleteDataReaction.h"
+#include "ImageFilterReaction.h"
 #include "TransposeDataReaction.h"
 #include "Utilities.h"
 
@@ -100,11 +101,8 @@ void DataTransformMenu::buildTransforms()
   new AddPythonTransformReaction(padVolumeAction, "Pad Volume",
                                  readInPythonScript("Pad_Data"), false, false,
                                  false, readInJSONDescription("Pad_Data"));
-  new AddPythonTransformReaction(downsampleByTwoAction, "Bin Volume x2",
-                                 readInPythonScript("BinVolumeByTwo"));
-  new AddPythonTransformReaction(resampleAction, "Resample",
-                                 readInPythonScript("Resample"), false, false,
-                                 false, readInJSONDescription("Resample"));
+  new ImageFilterReaction(downsampleByTwoAction, "BinVolumeByTwo", mainWindow);
+  new ImageFilterReaction(resampleAction, "Resample", mainWindow);
   new AddPythonTransformReaction(rotateAction, "Rotate",
                                  readInPythonScript("Rotate3D"), false, false,
                                  false, readInJSONDescription("Rotate3D"));
@@ -136,25 +134,20 @@ void DataTransformMenu::buildTransforms()
   new AddPythonTransformReaction(
     unsharpMaskAction, "Unsharp Mask", readInPythonScript("UnsharpMask"), false,
     false, false, readInJSONDescription("UnsharpMask"));
-  new AddPythonTransformReaction(laplaceFilterAction, "Laplace Sharpen",
-                                 readInPythonScript("LaplaceFilter"));
+  new ImageFilterReaction(laplaceFilterAction, "LaplaceFilter", mainWindow);
   new AddPythonTransformReaction(
     wienerAction, "Wiener Filter", readInPythonScript("WienerFilter"), false,
     false, false, readInJSONDescription("WienerFilter"));
   new AddPythonTransformReaction(TVminAction, "TV_Filter",
                                  readInPythonScript("TV_Filter"), false, false,
                                  false, readInJSONDescription("TV_Filter"));
-  new AddPythonTransformReaction(
-    gaussianFilterAction, "Gaussian Blur", readInPythonScript("GaussianFilter"),
-    false, false, false, readInJSONDescription("GaussianFilter"));
+  new ImageFilterReaction(gaussianFilterAction, "GaussianFilter", mainWindow);
   new AddPythonTransformReaction(
     peronaMalikeAnisotropicDiffusionAction,
     "Perona-Malik Anisotropic Diffusion",
     readInPythonScript("PeronaMalikAnisotropicDiffusion"), false, false, false,
     readInJSONDescription("PeronaMalikAnisotropicDiffusion"));
-  new AddPythonTransformReaction(
-    medianFilterAction, "Median Filter", readInPythonScript("MedianFilter"),
-    false, false, false, readInJSONDescription("MedianFilter"));
+  new ImageFilterReaction(medianFilterAction, "MedianFilter", mainWindow);
   new AddPythonTransformReaction(
     moleculeAction, "Add Molecule", readInPythonScript("DummyMolecule"), false,
     false, false, readInJSONDescription("DummyMolecule"));
@@ -5,6 +5,8 @@
 
 #include "DataSource.h"
 #include "GenericHDF5Format.h"
+#include "Utilities.h"
+#include "VolumePyramid.h"
 
 #include <h5cpp/h5readwrite.h>
 
@@ -12,6 +14,8 @@
 #include <vtkImageData.h>
 #include <vtkPointData.h>
 
+#include <QMessageBox>
+
 #include <string>
 #include <vector>
 
@@ -26,7 +30,8 @@ namespace tomviz {
 // Forward declarations
 static bool writeExtraScalars(h5::H5ReadWrite& writer,
                               const std::string& groupPath,
-                              vtkImageData* image);
+                              vtkImageData* image, bool reorder,
+                              const QVariantMap& options);
 static void readExtraScalars(h5::H5ReadWrite& reader,
                              const std::string& emdNode, vtkImageData* image);
 
@@ -78,6 +83,8 @@ bool EmdFormat::read(const std::string& fileName, vtkImageData* image,
     return false;
   }
 
+  // The full resolution data is read unless a coarser level of a stored
+  // multiresolution pyramid is asked for with the "pyramidLevel" option.
   return readNode(reader, emdNode, image, options);
 }
 
@@ -101,7 +108,36 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
   if (!reader.isDataSet(emdDataNode))
     return false;
 
-  if (!GenericHDF5Format::readVolume(reader, emdDataNode, image, options)) {
+  int levels = VolumePyramid::numberOfLevels(reader, emdDataNode);
+  int level = options.value("pyramidLevel", 0).toInt();
+  if (levels > 1 && !options.contains("pyramidLevel") &&
+      options.value("askForSubsample", true).toBool()) {
+    // Offer the coarsest level, it is refined from the pipeline view.
+    auto answer = QMessageBox::question(
+      tomviz::mainWidget(), "Load Reduced Resolution",
+      "This file stores reduced resolution copies of the volume. Load the "
+      "coarsest one first? It can be refined later with \"Refine "
+      "Resolution\" in the pipeline view.");
+    if (answer == QMessageBox::Yes) {
+      level = levels - 1;
+    }
+  }
+  if (level < 0 || level >= levels)
+    level = 0;
+
+  if (level > 0) {
+    // The levels are small enough to never need subsampling.
+    QVariantMap levelOptions = { { "askForSubsample", false } };
+    auto levelPath = VolumePyramid::levelPath(emdDataNode, level);
+    if (!GenericHDF5Format::readVolume(reader, levelPath, image,
+                                       levelOptions)) {
+      cerr << "Failed to read the volume at " << levelPath << "\n";
+      return false;
+    }
+    DataSource::setHdf5Source(image, QString::fromStdString(reader.fileName()),
+                              QString::fromStdString(emdDataNode));
+  } else if (!GenericHDF5Format::readVolume(reader, emdDataNode, image,
+                                            options)) {
     cerr << "Failed to read the volume at " << emdDataNode << "\n";
     return false;
   }
@@ -129,6 +165,13 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
     image->SetSpacing(spacing);
   }
 
+  if (level > 0) {
+    VolumePyramid::scaleToLevel(image, level);
+  } else if (DataSource::resolutionLevel(image) != 0) {
+    // The image is being reloaded at full resolution.
+    DataSource::setResolutionLevel(image, 0);
+  }
+
   // If there are angles, read them in
   QVector<double> angles;
   auto units = reader.attribute<std::string>(emdNode + "/dim1", "units", &ok);
@@ -145,8 +188,11 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
     }
   }
 
-  // Now read in any extra scalars
-  readExtraScalars(reader, emdNode, image);
+  // Now read in any extra scalars. Pyramids are only written for data with
+  // a single array, so there are none at the coarser levels.
+  if (level == 0) {
+    readExtraScalars(reader, emdNode, image);
+  }
 
   if (angles.isEmpty()) {
     // The data has not been re-ordered. Re-order to Fortran.
@@ -161,12 +207,14 @@ bool EmdFormat::readNode(h5::H5ReadWrite& reader, const std::string& emdNode,
   return true;
 }
 
-bool EmdFormat::write(const std::string& fileName, DataSource* source)
+bool EmdFormat::write(const std::string& fileName, DataSource* source,
+                      const QVariantMap& options)
 {
-  return write(fileName, source->imageData());
+  return write(fileName, source->imageData(), options);
 }
 
-bool EmdFormat::write(const std::string& fileName, vtkImageData* image)
+bool EmdFormat::write(const std::string& fileName, vtkImageData* image,
+                      const QVariantMap& options)
 {
   using h5::H5ReadWrite;
   H5ReadWrite::OpenMode mode = H5ReadWrite::OpenMode::WriteOnly;
@@ -180,11 +228,11 @@ bool EmdFormat::write(const std::string& fileName, vtkImageData* image)
   writer.createGroup("/data");
   writer.createGroup("/data/tomography");
 
-  return writeNode(writer, "/data/tomography", image);
+  return writeNode(writer, "/data/tomography", image, options);
 }
 
 bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
-                          vtkImageData* image)
+                          vtkImageData* image, const QVariantMap& options)
 {
   // Create the emd_group_type attribute.
   writer.setAttribute(path, "emd_group_type", 1u);
@@ -192,19 +240,19 @@ bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
   // See if we have tilt angles
   auto hasTiltAngles = DataSource::hasTiltAngles(image);
 
+  // No deep copies of data needed. Tilt series just have their axes
+  // re-labeled, volumes are re-ordered to C ordering as they are written.
   vtkNew<vtkImageData> permutedImage;
-  if (DataSource::hasTiltAngles(image)) {
-    // No deep copies of data needed. Just re-label the axes.
-    permutedImage->ShallowCopy(image);
+  permutedImage->ShallowCopy(image);
+  if (hasTiltAngles) {
     GenericHDF5Format::relabelXAndZAxes(permutedImage);
+    GenericHDF5Format::writeVolume(writer, path, "data", permutedImage,
+                                   options);
   } else {
-    // Need to re-order to C ordering before writing
-    GenericHDF5Format::reorderData(image, permutedImage,
-                                   ReorderMode::FortranToC);
+    GenericHDF5Format::writeReorderedVolume(writer, path, "data",
+                                            permutedImage, options);
   }
 
-  GenericHDF5Format::writeVolume(writer, path, "data", permutedImage);
-
   // Set a "name" attribute on the data so we can remember the
   // scalar name that the user gave it.
   std::string activeName =
@@ -267,7 +315,13 @@ bool EmdFormat::writeNode(h5::H5ReadWrite& writer, const std::string& path,
   }
 
   // Write any extra scalars we might have
-  writeExtraScalars(writer, path, permutedImage);
+  writeExtraScalars(writer, path, permutedImage, !hasTiltAngles, options);
+
+  // Store a multiresolution pyramid next to large volumes, if asked to, so
+  // they can be opened at a coarse level first.
+  if (VolumePyramid::shouldWrite(image, options)) {
+    VolumePyramid::write(writer, path, "data", image, options);
+  }
 
   return true;
 }
@@ -298,7 +352,8 @@ static void readExtraScalars(h5::H5ReadWrite& reader,
 
 static bool writeExtraScalars(h5::H5ReadWrite& writer,
                               const std::string& groupPath,
-                              vtkImageData* image)
+                              vtkImageData* image, bool reorder,
+                              const QVariantMap& options)
 {
   std::string path = groupPath + "/tomviz_scalars";
   writer.createGroup(path);
@@ -320,7 +375,12 @@ static bool writeExtraScalars(h5::H5ReadWrite& writer,
 
     // Make it active and write it
     pointData->SetActiveScalars(arrayName);
-    GenericHDF5Format::writeVolume(writer, path, arrayName, image);
+    if (reorder) {
+      GenericHDF5Format::writeReorderedVolume(writer, path, arrayName, image,
+                                              options);
+    } else {
+      GenericHDF5Format::writeVolume(writer, path, arrayName, image, options);
+    }
   }
 
   // Make the original one active again
@@ -23,8 +23,11 @@ class EmdFormat
 public:
   static bool read(const std::string& fileName, vtkImageData* data,
                    const QVariantMap& options = QVariantMap());
-  static bool write(const std::string& fileName, DataSource* source);
-  static bool write(const std::string& fileName, vtkImageData* image);
+  // See GenericHDF5Format::writeVolume() for the options
+  static bool write(const std::string& fileName, DataSource* source,
+                    const QVariantMap& options = QVariantMap());
+  static bool write(const std::string& fileName, vtkImageData* image,
+                    const QVariantMap& options = QVariantMap());
 
   // Read EMD data from a specified node in the HDF5 file
   static bool readNode(const std::string& fileName, const std::string& path,
@@ -35,7 +38,8 @@ public:
                        const QVariantMap& options = QVariantMap());
   // Write EMD data to a specified node in the HDF5 file
   static bool writeNode(h5::H5ReadWrite& writer, const std::string& path,
-                        vtkImageData* image);
+                        vtkImageData* image,
+                        const QVariantMap& options = QVariantMap());
 };
 } // namespace tomviz
 
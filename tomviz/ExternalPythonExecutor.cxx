@@ -13,6 +13,11 @@
 
 namespace tomviz {
 
+namespace {
+// Progress data is downsampled to at most this many samples along each axis.
+const int ProgressPreviewSize = 256;
+} // namespace
+
 ExternalPythonExecutor::ExternalPythonExecutor(Pipeline* pipeline)
   : ExternalPipelineExecutor(pipeline)
 {
@@ -29,8 +34,12 @@ Pipeline::Future* ExternalPythonExecutor::execute(vtkDataObject* data,
 
   auto future = ExternalPipelineExecutor::execute(data, operators, start, end);
 
-  // We are now ready to run the pipeline
+  // We are now ready to run the pipeline. Operators that stream their data
+  // while they run send previews small enough to load at interactive rates,
+  // the result still comes back at full resolution.
   QStringList args = executorArgs(start);
+  args << "--progress-preview-size";
+  args << QString::number(ProgressPreviewSize);
 
   PipelineSettings settings;
   auto pythonExecutable = settings.externalPythonExecutablePath();
@@ -176,6 +185,12 @@ QString ExternalPythonExecutor::executorWorkingDir()
   return workingDir();
 }
 
+bool ExternalPythonExecutor::useSharedMemory()
+{
+  // The executor runs on this machine, so it can map the working directory.
+  return true;
+}
+
 QString ExternalPythonExecutor::commandLine(QProcess* process)
 {
   return QString("%1 %2")
@@ -35,6 +35,7 @@ public:
 
 protected:
   QString executorWorkingDir() override;
+  bool useSharedMemory() override;
 
 private slots:
   void onStdOutReceived();
@@ -0,0 +1,91 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "FFTPlan.h"
+
+#include <cmath>
+#include <utility>
+
+namespace tomviz {
+
+FFTPlan::FFTPlan(int size) : m_size(size), m_bitReverse(size)
+{
+  int bits = 0;
+  while ((1 << bits) < size) {
+    ++bits;
+  }
+  for (int i = 0; i < size; ++i) {
+    int reversed = 0;
+    for (int b = 0; b < bits; ++b) {
+      reversed |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+    m_bitReverse[i] = reversed;
+  }
+
+  // Twiddles are computed in double precision to keep large transforms
+  // accurate.
+  m_twiddles.resize(size / 2);
+  const double pi = 3.14159265358979323846;
+  for (int k = 0; k < size / 2; ++k) {
+    double angle = -2.0 * pi * k / size;
+    m_twiddles[k] = Complex(static_cast<float>(std::cos(angle)),
+                            static_cast<float>(std::sin(angle)));
+  }
+}
+
+int FFTPlan::nextPowerOfTwo(int n)
+{
+  int size = 1;
+  while (size < n) {
+    size <<= 1;
+  }
+  return size;
+}
+
+void FFTPlan::forward(Complex* data) const
+{
+  transform(data, false);
+}
+
+void FFTPlan::inverse(Complex* data) const
+{
+  transform(data, true);
+  float scale = 1.0f / m_size;
+  for (int i = 0; i < m_size; ++i) {
+    data[i] *= scale;
+  }
+}
+
+void FFTPlan::transform(Complex* data, bool inverse) const
+{
+  for (int i = 0; i < m_size; ++i) {
+    int j = m_bitReverse[i];
+    if (i < j) {
+      std::swap(data[i], data[j]);
+    }
+  }
+
+  // The butterflies are written out on the real and imaginary parts, the
+  // std::complex operator* has to handle inf/nan and is far slower.
+  float sign = inverse ? -1.0f : 1.0f;
+  for (int length = 2; length <= m_size; length <<= 1) {
+    int half = length / 2;
+    int step = m_size / length;
+    for (int start = 0; start < m_size; start += length) {
+      for (int j = 0; j < half; ++j) {
+        const Complex& w = m_twiddles[j * step];
+        float wr = w.real();
+        float wi = sign * w.imag();
+        Complex& a = data[start + j];
+        Complex& b = data[start + j + half];
+        float vr = b.real() * wr - b.imag() * wi;
+        float vi = b.real() * wi + b.imag() * wr;
+        float ur = a.real();
+        float ui = a.imag();
+        a = Complex(ur + vr, ui + vi);
+        b = Complex(ur - vr, ui - vi);
+      }
+    }
+  }
+}
+} // namespace tomviz
@@ -0,0 +1,44 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizFFTPlan_h
+#define tomvizFFTPlan_h
+
+#include <complex>
+#include <vector>
+
+namespace tomviz {
+
+/// Precomputed radix-2 complex FFT of a fixed, power of two length. Building a
+/// plan computes the bit reversal permutation and twiddle factors once; after
+/// that the plan is immutable, so a single plan can be shared by any number of
+/// threads transforming their own buffers.
+class FFTPlan
+{
+public:
+  typedef std::complex<float> Complex;
+
+  /// size must be a power of two.
+  explicit FFTPlan(int size);
+
+  int size() const { return m_size; }
+
+  /// In-place forward transform of size() elements.
+  void forward(Complex* data) const;
+
+  /// In-place inverse transform of size() elements, scaled by 1 / size().
+  void inverse(Complex* data) const;
+
+  /// Smallest power of two greater than or equal to n.
+  static int nextPowerOfTwo(int n);
+
+private:
+  void transform(Complex* data, bool inverse) const;
+
+  int m_size;
+  std::vector<int> m_bitReverse;
+  std::vector<Complex> m_twiddles;
+};
+} // namespace tomviz
+
+#endif
@@ -6,6 +6,7 @@
 #include <DataExchangeFormat.h>
 #include <DataSource.h>
 #include <Hdf5SubsampleWidget.h>
+#include <PermuteAxes.h>
 #include <Utilities.h>
 
 #include <h5cpp/h5readwrite.h>
@@ -21,9 +22,10 @@
 
 #include <vtkDataArray.h>
 #include <vtkImageData.h>
-#include <vtkImagePermute.h>
+#include <vtkNew.h>
 #include <vtkPointData.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -36,48 +38,30 @@ using std::endl;
 
 namespace tomviz {
 
-template <typename T>
-void ReorderArrayC(T* in, T* out, int dim[3])
-{
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(i * dim[1] + j) * dim[2] + k] =
-          in[static_cast<size_t>(k * dim[1] + j) * dim[0] + i];
-      }
-    }
-  }
-}
+namespace {
 
-template <typename T>
-void ReorderArrayF(T* in, T* out, int dim[3])
+size_t elementSize(vtkDataArray* array)
 {
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(k * dim[1] + j) * dim[0] + i] =
-          in[static_cast<size_t>(i * dim[1] + j) * dim[2] + k];
-      }
-    }
-  }
+  return static_cast<size_t>(array->GetNumberOfComponents()) *
+         array->GetDataTypeSize();
 }
 
+} // namespace
+
 void GenericHDF5Format::reorderDataArray(vtkDataArray* in, vtkDataArray* out,
                                          int dim[3], ReorderMode mode)
 {
+  out->SetNumberOfComponents(in->GetNumberOfComponents());
   out->SetNumberOfTuples(in->GetNumberOfTuples());
 
-  auto* inPtr = in->GetVoidPointer(0);
-  auto* outPtr = out->GetVoidPointer(0);
-  switch (in->GetDataType()) {
-    vtkTemplateMacro(auto* func = mode == ReorderMode::CToFortran
-                                    ? ReorderArrayF<VTK_TT>
-                                    : ReorderArrayC<VTK_TT>;
-                     func(reinterpret_cast<VTK_TT*>(inPtr),
-                          reinterpret_cast<VTK_TT*>(outPtr), dim););
-    default:
-      cout << "Generic HDF5 Format: Unknown data type" << endl;
+  // Going to C order reverses the axes of the Fortran array, and going back
+  // reverses the axes of the C array, whose fastest axis is z.
+  int inDims[3] = { dim[0], dim[1], dim[2] };
+  if (mode == ReorderMode::CToFortran) {
+    std::swap(inDims[0], inDims[2]);
   }
+  reverseAxes(in->GetVoidPointer(0), out->GetVoidPointer(0), inDims,
+              elementSize(in));
 }
 
 void GenericHDF5Format::reorderData(vtkImageData* image, ReorderMode mode)
@@ -85,7 +69,23 @@ void GenericHDF5Format::reorderData(vtkImageData* image, ReorderMode mode)
   if (!image)
     return;
 
-  // TODO: Can we re-order this in place, rather than making a copy?
+  int dim[3];
+  image->GetDimensions(dim);
+  const int axes[3] = { 2, 1, 0 };
+  if (canPermuteAxesInPlace(dim, axes)) {
+    // With as many samples along x as along z, reversing the axes is a swap
+    // of x and z in either direction, which doesn't need a copy.
+    auto* pd = image->GetPointData();
+    for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+      auto* array = pd->GetArray(i);
+      permuteAxesInPlace(array->GetVoidPointer(0), dim, axes,
+                         elementSize(array));
+      array->Modified();
+    }
+    image->Modified();
+    return;
+  }
+
   vtkNew<vtkImageData> tmp;
   reorderData(image, tmp, mode);
   image->ShallowCopy(tmp);
@@ -177,45 +177,32 @@ QVector<double> GenericHDF5Format::readAngles(h5::H5ReadWrite& reader,
 
 void GenericHDF5Format::swapXAndZAxes(vtkImageData* image)
 {
-  // TODO: vtkImagePermute currently only swaps the axes of the active
-  // scalars. This can cause some big problems for the other scalars,
-  // since the dimensions of the image also change.
-  // Until this gets fixed in VTK, we have a complicated work-around
-  // that involves swapping the scalars one-by-one and then setting
-  // them back on the original image.
+  // Every array is swapped, not just the active scalars, since the
+  // dimensions of the image change for all of them.
+  int dim[3];
+  image->GetDimensions(dim);
+  const int axes[3] = { 2, 1, 0 };
   auto* pd = image->GetPointData();
-  std::string activeName = pd->GetScalars()->GetName();
-
-  vtkNew<vtkImagePermute> permute;
-  permute->SetFilteredAxes(2, 1, 0);
-
-  // Extract all of the arrays from the image data,
-  // and swap each of their axes.
-  std::vector<vtkSmartPointer<vtkDataArray>> arrays;
-  while (pd->GetNumberOfArrays() != 0) {
-    auto* name = pd->GetArrayName(0);
-    vtkSmartPointer<vtkDataArray> array = pd->GetScalars(name);
-    pd->RemoveArray(name);
-
-    vtkNew<vtkImageData> tmp;
-    tmp->SetDimensions(image->GetDimensions());
-    tmp->GetPointData()->SetScalars(array);
+  for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+    auto* array = pd->GetArray(i);
+    if (permuteAxesInPlace(array->GetVoidPointer(0), dim, axes,
+                           elementSize(array))) {
+      array->Modified();
+      continue;
+    }
 
-    permute->SetInputData(tmp);
-    permute->Update();
-    arrays.push_back(permute->GetOutput()->GetPointData()->GetScalars());
+    vtkSmartPointer<vtkDataArray> swapped;
+    swapped.TakeReference(array->NewInstance());
+    swapped->SetName(array->GetName());
+    swapped->SetNumberOfComponents(array->GetNumberOfComponents());
+    swapped->SetNumberOfTuples(array->GetNumberOfTuples());
+    reverseAxes(array->GetVoidPointer(0), swapped->GetVoidPointer(0), dim,
+                elementSize(array));
+    array->ShallowCopy(swapped);
   }
 
   // Relabel the x and z axes of the image
   relabelXAndZAxes(image);
-
-  // Add them back into the image
-  while (arrays.size() != 0) {
-    pd->AddArray(arrays.back());
-    arrays.pop_back();
-  }
-
-  pd->SetActiveScalars(activeName.c_str());
 }
 
 void GenericHDF5Format::relabelXAndZAxes(vtkImageData* image)
@@ -486,6 +473,11 @@ bool GenericHDF5Format::readVolume(h5::H5ReadWrite& reader,
     return false;
   }
 
+  // Remember where the data came from, so that the full resolution data can
+  // be read back from the file later on.
+  DataSource::setHdf5Source(image, QString::fromStdString(reader.fileName()),
+                            QString::fromStdString(path));
+
   image->Modified();
 
   return true;
@@ -635,10 +627,52 @@ bool GenericHDF5Format::read(const std::string& fileName, vtkImageData* image,
   return true;
 }
 
+namespace {
+
+h5::H5ReadWrite::WriteOptions writeOptions(const QVariantMap& options,
+                                           const std::vector<int>& dims,
+                                           size_t elementSize)
+{
+  h5::H5ReadWrite::WriteOptions result;
+  if (options.value("chunk", false).toBool()) {
+    // Whole slices along the first dimension, which is how the data is read
+    // back when it is subsampled or streamed.
+    result.chunkDimensions =
+      h5::H5ReadWrite::sliceChunkDimensions(dims, elementSize);
+    result.deflateLevel = options.value("deflate", 1).toInt();
+    result.shuffle = options.value("shuffle", true).toBool();
+    result.filterId = options.value("filter", -1).toInt();
+    foreach (const QVariant& value, options.value("filterValues").toList()) {
+      result.filterValues.push_back(value.toUInt());
+    }
+  }
+  return result;
+}
+
+// Copy the block [i0, i0 + ni) x [j0, j0 + nj) x [0, dim[2]) of Fortran
+// ordered data into C order. The innermost loop runs along the contiguous
+// axis of the input, so every cache line of it that is touched is used.
+template <typename T>
+void copyBlockFortranToC(const T* in, T* out, const int dim[3], int i0,
+                         int ni, int j0, int nj)
+{
+  for (int k = 0; k < dim[2]; ++k) {
+    for (int j = 0; j < nj; ++j) {
+      const T* row = in + (static_cast<size_t>(k) * dim[1] + j0 + j) * dim[0];
+      for (int i = 0; i < ni; ++i) {
+        out[(static_cast<size_t>(i) * nj + j) * dim[2] + k] = row[i0 + i];
+      }
+    }
+  }
+}
+
+} // namespace
+
 bool GenericHDF5Format::writeVolume(h5::H5ReadWrite& writer,
                                     const std::string& path,
                                     const std::string& name,
-                                    vtkImageData* image)
+                                    vtkImageData* image,
+                                    const QVariantMap& options)
 {
   int dim[3];
   image->GetDimensions(dim);
@@ -648,7 +682,77 @@ bool GenericHDF5Format::writeVolume(h5::H5ReadWrite& writer,
   h5::H5ReadWrite::DataType type =
     h5::H5VtkTypeMaps::VtkToDataType(arrayPtr->GetDataType());
 
-  return writer.writeData(path, name, dims, type, arrayPtr->GetVoidPointer(0));
+  return writer.writeData(
+    path, name, dims, type, arrayPtr->GetVoidPointer(0),
+    writeOptions(options, dims, arrayPtr->GetDataTypeSize()));
+}
+
+bool GenericHDF5Format::writeReorderedVolume(h5::H5ReadWrite& writer,
+                                             const std::string& path,
+                                             const std::string& name,
+                                             vtkImageData* image,
+                                             const QVariantMap& options)
+{
+  int dim[3];
+  image->GetDimensions(dim);
+  std::vector<int> dims({ dim[0], dim[1], dim[2] });
+
+  auto arrayPtr = image->GetPointData()->GetScalars();
+  h5::H5ReadWrite::DataType type =
+    h5::H5VtkTypeMaps::VtkToDataType(arrayPtr->GetDataType());
+  size_t elementSize = arrayPtr->GetDataTypeSize();
+
+  auto h5Options = writeOptions(options, dims, elementSize);
+  if (!writer.createDataSet(path, name, dims, type, h5Options)) {
+    return false;
+  }
+
+  // The blocks cover whole chunks, so each chunk is compressed once, and
+  // they span at least a cache line along the contiguous axis of the input.
+  const size_t blockBytes = 16 << 20;
+  int block0 = std::max(64 / static_cast<int>(elementSize), 1);
+  int block1 = 0;
+  if (h5Options.chunkDimensions.empty()) {
+    block1 = static_cast<int>(std::max(
+      blockBytes / (block0 * static_cast<size_t>(dim[2]) * elementSize),
+      size_t(1)));
+  } else {
+    auto& chunks = h5Options.chunkDimensions;
+    block0 = (block0 + chunks[0] - 1) / chunks[0] * chunks[0];
+    block1 = chunks[1];
+  }
+  block0 = std::min(block0, dim[0]);
+  block1 = std::min(block1, dim[1]);
+
+  std::vector<char> buffer(static_cast<size_t>(block0) * block1 * dim[2] *
+                           elementSize);
+  auto* inPtr = arrayPtr->GetVoidPointer(0);
+  std::string dataSetPath = path + "/" + name;
+  for (int i0 = 0; i0 < dim[0]; i0 += block0) {
+    int ni = std::min(block0, dim[0] - i0);
+    for (int j0 = 0; j0 < dim[1]; j0 += block1) {
+      int nj = std::min(block1, dim[1] - j0);
+      switch (arrayPtr->GetDataType()) {
+        vtkTemplateMacro(copyBlockFortranToC(
+          static_cast<const VTK_TT*>(inPtr),
+          reinterpret_cast<VTK_TT*>(buffer.data()), dim, i0, ni, j0, nj));
+        default:
+          cerr << "Generic HDF5 Format: Unknown data type" << endl;
+          return false;
+      }
+
+      size_t start[3] = { static_cast<size_t>(i0), static_cast<size_t>(j0),
+                          0 };
+      size_t counts[3] = { static_cast<size_t>(ni), static_cast<size_t>(nj),
+                           static_cast<size_t>(dim[2]) };
+      if (!writer.writeHyperslab(dataSetPath, type, buffer.data(), start,
+                                 counts)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
 }
 
 } // namespace tomviz
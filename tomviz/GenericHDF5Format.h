@@ -84,14 +84,36 @@ public:
    * Write a volume from a vtkImageData object to a path. No memory
    * re-ordering is performed on the data.
    *
+   * The volume is stored contiguously and uncompressed, unless the options
+   * ask for chunks of whole slices along its first dimension:
+   *   "chunk" (bool, default false) chunk and compress the data set.
+   *   "deflate" (int, default 1) the deflate level of chunks, 0 disables it.
+   *   "shuffle" (bool, default true) shuffle the bytes before compressing.
+   *   "filter" (int) a registered HDF5 filter to use in place of deflate.
+   *   "filterValues" (list of int) the client data values for the filter.
+   *
    * @param writer The writer that has already opened the file of interest.
    * @param path The path to the group where the data will be written.
    * @param name The name that the dataset will be given.
    * @param image The vtkImageData from which the volume will be written.
+   * @param options The options controlling the layout of the data set.
    * @return True on success, false on failure.
    */
   static bool writeVolume(h5::H5ReadWrite& writer, const std::string& path,
-                          const std::string& name, vtkImageData* image);
+                          const std::string& name, vtkImageData* image,
+                          const QVariantMap& options = QVariantMap());
+
+  /**
+   * Write a volume from a vtkImageData object to a path, re-ordering it
+   * from Fortran to C ordering on the way. The volume is re-ordered and
+   * written a block at a time, through a small buffer, so no re-ordered
+   * copy of the whole volume is needed. See writeVolume() for the options.
+   */
+  static bool writeReorderedVolume(h5::H5ReadWrite& writer,
+                                   const std::string& path,
+                                   const std::string& name,
+                                   vtkImageData* image,
+                                   const QVariantMap& options = QVariantMap());
 
   /**
    * Swap the X and Z axes for all scalars in the vtkImageData.
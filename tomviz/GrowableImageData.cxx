@@ -0,0 +1,119 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "GrowableImageData.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+
+namespace tomviz {
+
+GrowableImageData::GrowableImageData(vtkImageData* image) : m_image(image)
+{
+}
+
+vtkIdType GrowableImageData::sliceValues() const
+{
+  int dims[3];
+  m_image->GetDimensions(dims);
+  return static_cast<vtkIdType>(dims[0]) * dims[1] *
+         m_image->GetNumberOfScalarComponents();
+}
+
+int GrowableImageData::numberOfSlices() const
+{
+  int dims[3];
+  m_image->GetDimensions(dims);
+  return dims[2];
+}
+
+int GrowableImageData::capacity() const
+{
+  auto scalars = m_image->GetPointData()->GetScalars();
+  vtkIdType values = sliceValues();
+  if (!scalars || values == 0) {
+    return 0;
+  }
+  // Scalars replaced behind our back have no spare capacity we know of.
+  if (!m_storage || scalars != m_published) {
+    return numberOfSlices();
+  }
+  return static_cast<int>(m_storage->GetSize() / values);
+}
+
+void GrowableImageData::reserve(int slices)
+{
+  auto scalars = m_image->GetPointData()->GetScalars();
+  if (!scalars || slices <= capacity()) {
+    return;
+  }
+
+  // Copy into a new buffer, reallocating the current storage would move the
+  // values out from under the arrays that share it.
+  vtkSmartPointer<vtkDataArray> storage;
+  storage.TakeReference(scalars->NewInstance());
+  storage->SetName(scalars->GetName());
+  storage->SetNumberOfComponents(scalars->GetNumberOfComponents());
+  storage->Allocate(slices * sliceValues());
+  storage->InsertTuples(0, scalars->GetNumberOfTuples(), 0, scalars);
+  m_storage = storage;
+  publish();
+}
+
+void GrowableImageData::publish()
+{
+  // Arrays with the standard memory layout share their buffer when shallow
+  // copied, including the spare capacity.
+  vtkSmartPointer<vtkDataArray> scalars;
+  scalars.TakeReference(m_storage->NewInstance());
+  scalars->ShallowCopy(m_storage);
+  m_image->GetPointData()->SetScalars(scalars);
+  m_published = scalars;
+}
+
+bool GrowableImageData::append(vtkImageData* slice)
+{
+  auto scalars = m_image->GetPointData()->GetScalars();
+  auto sliceScalars = slice ? slice->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || !sliceScalars) {
+    return false;
+  }
+
+  int extent[6];
+  int sliceExtent[6];
+  m_image->GetExtent(extent);
+  slice->GetExtent(sliceExtent);
+  for (int i = 0; i < 4; ++i) {
+    if (extent[i] != sliceExtent[i]) {
+      return false;
+    }
+  }
+  if (scalars->GetDataType() != sliceScalars->GetDataType() ||
+      scalars->GetNumberOfComponents() !=
+        sliceScalars->GetNumberOfComponents() ||
+      sliceScalars->GetNumberOfValues() != sliceValues()) {
+    return false;
+  }
+
+  // Double the capacity whenever it runs out.
+  int slices = numberOfSlices();
+  if (slices + 1 > capacity()) {
+    reserve(std::max(2 * slices, slices + 1));
+  }
+
+  // Within the capacity this only moves the end of the storage, the values go
+  // past the end of every array published so far.
+  m_storage->InsertTuples(m_storage->GetNumberOfTuples(),
+                          sliceScalars->GetNumberOfTuples(), 0, sliceScalars);
+  publish();
+
+  ++extent[5];
+  m_image->SetExtent(extent);
+  m_image->Modified();
+
+  return true;
+}
+} // namespace tomviz
@@ -0,0 +1,62 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizGrowableImageData_h
+#define tomvizGrowableImageData_h
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+class vtkDataArray;
+class vtkImageData;
+
+namespace tomviz {
+
+/// Grows an image one z-slice at a time, e.g. as tilts arrive during an
+/// acquisition. The values are kept in storage with spare capacity that grows
+/// geometrically, so appending N slices moves O(N) slices worth of memory in
+/// total instead of reallocating and copying the whole volume for every slice.
+/// The image itself always describes just the slices appended so far, it is
+/// a regular vtkImageData that can be handed to the rest of the application.
+///
+/// Arrays set as the image's scalars are never modified. Every append sets a
+/// new array object, sharing the storage, as the scalars: appended values land
+/// past the end of the arrays handed out before, and growing the capacity
+/// starts a new buffer rather than reallocating the shared one. The pipeline
+/// can therefore keep reading an earlier array on its worker thread while
+/// slices are appended.
+class GrowableImageData
+{
+public:
+  /// The image must have point scalars, it is grown in place.
+  explicit GrowableImageData(vtkImageData* image);
+
+  vtkImageData* image() const { return m_image; }
+
+  /// Append a slice with the same x and y extent, scalar type and number of
+  /// components as the image. Returns false if the slice doesn't match.
+  bool append(vtkImageData* slice);
+
+  /// Number of slices in the image.
+  int numberOfSlices() const;
+
+  /// Number of slices that fit in the current allocation.
+  int capacity() const;
+
+  /// Ensure there is room for at least slices slices without reallocating.
+  void reserve(int slices);
+
+private:
+  vtkIdType sliceValues() const;
+  /// Set a new array sharing the values in m_storage as the image's scalars.
+  void publish();
+
+  vtkSmartPointer<vtkImageData> m_image;
+  /// Holds the values with spare capacity, shared with the published arrays.
+  vtkSmartPointer<vtkDataArray> m_storage;
+  /// The array last set as the image's scalars.
+  vtkSmartPointer<vtkDataArray> m_published;
+};
+} // namespace tomviz
+
+#endif
@@ -5,6 +5,10 @@
 
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationDoubleVectorKey.h>
+#include <vtkInformationInformationVectorKey.h>
+#include <vtkInformationVector.h>
 #include <vtkPointData.h>
 #include <vtkTable.h>
 #include <vtkUnsignedLongLongArray.h>
@@ -19,12 +23,50 @@ Q_DECLARE_METATYPE(vtkSmartPointer<vtkTable>)
 
 namespace {
 
+// The finite range vtkDataArray::GetFiniteRange(range, -1) has cached for the
+// array, if it is still current. It is there when something already asked for
+// the range, e.g. DataSource::getRange(), and saves the histogram a pass.
+// GetFiniteRange() writes these keys on the GUI thread, so they are only read
+// there, never on the worker thread.
+bool cachedFiniteRange(vtkDataArray* array, double range[2])
+{
+  if (!array->HasInformation()) {
+    return false;
+  }
+  vtkInformation* info = array->GetInformation();
+  if (info->GetMTime() < array->GetMTime()) {
+    return false;
+  }
+  if (array->GetNumberOfComponents() > 1) {
+    if (!info->Has(vtkDataArray::L2_NORM_FINITE_RANGE())) {
+      return false;
+    }
+    info->Get(vtkDataArray::L2_NORM_FINITE_RANGE(), range);
+    return true;
+  }
+  // Single component ranges are cached per component.
+  if (!info->Has(vtkDataArray::PER_FINITE_COMPONENT())) {
+    return false;
+  }
+  vtkInformationVector* components =
+    info->Get(vtkDataArray::PER_FINITE_COMPONENT());
+  vtkInformation* component = components->GetNumberOfInformationObjects() > 0
+                                ? components->GetInformationObject(0)
+                                : nullptr;
+  if (!component || !component->Has(vtkDataArray::COMPONENT_RANGE())) {
+    return false;
+  }
+  component->Get(vtkDataArray::COMPONENT_RANGE(), range);
+  return true;
+}
+
 // This is just here for now - quick and dirty historgram calculations...
-void PopulateHistogram(vtkImageData* input, vtkTable* output)
+void PopulateHistogram(vtkImageData* input, vtkTable* output, bool rangeKnown,
+                       const double range[2])
 {
   // The output table will have the twice the number of columns, they will be
   // the x and y for input column. This is the bin centers, and the population.
-  double minmax[2] = { 0.0, 0.0 };
+  double minmax[2] = { range[0], range[1] };
 
   // This number of bins in the 2D histogram will also be used as the number of
   // bins in the 2D transfer function for X (scalar value) and Y (gradient mag.)
@@ -37,12 +79,30 @@ void PopulateHistogram(vtkImageData* input, vtkTable* output)
     return;
   }
 
-  // The bin values are the centers, extending +/- half an inc either side
-  arrayPtr->GetFiniteRange(minmax, -1);
-  if (minmax[0] == minmax[1]) {
-    minmax[1] = minmax[0] + 1.0;
+  // The range and the populations are computed together, in parallel. A
+  // cached range lets floating point data be binned in a single pass.
+  vtkSmartPointer<vtkUnsignedLongLongArray> populations =
+    vtkUnsignedLongLongArray::SafeDownCast(
+      output->GetColumnByName("image_pops"));
+  if (!populations) {
+    populations = vtkSmartPointer<vtkUnsignedLongLongArray>::New();
+    populations->SetName("image_pops");
   }
+  populations->SetNumberOfTuples(numberOfBins);
+  auto pops = static_cast<uint64_t*>(populations->GetVoidPointer(0));
+  vtkIdType invalid = 0;
 
+  switch (arrayPtr->GetDataType()) {
+    vtkTemplateMacro(invalid = tomviz::CalculateHistogramParallel(
+                       reinterpret_cast<VTK_TT*>(arrayPtr->GetVoidPointer(0)),
+                       arrayPtr->GetNumberOfTuples(),
+                       arrayPtr->GetNumberOfComponents(), numberOfBins,
+                       minmax, pops, rangeKnown));
+    default:
+      cout << "UpdateFromFile: Unknown data type" << endl;
+  }
+
+  // The bin values are the centers, extending +/- half an inc either side
   double inc = (minmax[1] - minmax[0]) / (numberOfBins - 1);
   double halfInc = inc / 2.0;
   vtkSmartPointer<vtkFloatArray> extents =
@@ -56,28 +116,6 @@ void PopulateHistogram(vtkImageData* input, vtkTable* output)
   for (int j = 0; j < numberOfBins; ++j) {
     extents->SetValue(j, min + j * inc);
   }
-  vtkSmartPointer<vtkUnsignedLongLongArray> populations =
-    vtkUnsignedLongLongArray::SafeDownCast(
-      output->GetColumnByName("image_pops"));
-  if (!populations) {
-    populations = vtkSmartPointer<vtkUnsignedLongLongArray>::New();
-    populations->SetName("image_pops");
-  }
-  populations->SetNumberOfTuples(numberOfBins);
-  auto pops = static_cast<uint64_t*>(populations->GetVoidPointer(0));
-  for (int k = 0; k < numberOfBins; ++k) {
-    pops[k] = 0;
-  }
-  int invalid = 0;
-
-  switch (arrayPtr->GetDataType()) {
-    vtkTemplateMacro(tomviz::CalculateHistogram(
-      reinterpret_cast<VTK_TT*>(arrayPtr->GetVoidPointer(0)),
-      arrayPtr->GetNumberOfTuples(), arrayPtr->GetNumberOfComponents(),
-      minmax[0], minmax[1], pops, 1.0 / inc, invalid));
-    default:
-      cout << "UpdateFromFile: Unknown data type" << endl;
-  }
 
 #ifndef NDEBUG
   vtkIdType total = invalid;
@@ -93,9 +131,36 @@ void PopulateHistogram(vtkImageData* input, vtkTable* output)
   output->AddColumn(populations);
 }
 
-void Populate2DHistogram(vtkImageData* input, vtkImageData* output)
+// Volumes with more than eight times this many voxels get a subsampled preview
+// of their 2D histogram, of about this many voxels, before the full resolution
+// one is computed.
+const vtkIdType PreviewVoxels = 1 << 21;
+
+// The range the 2D histogram is binned over: the finite range of the array,
+// computed here unless it is known, widened to a length of one for constant
+// data.
+void histogram2DRange(vtkDataArray* array, bool rangeKnown, double range[2])
+{
+  if (!rangeKnown) {
+    switch (array->GetDataType()) {
+      vtkTemplateMacro(tomviz::CalculateFiniteRangeParallel(
+        reinterpret_cast<VTK_TT*>(array->GetVoidPointer(0)),
+        array->GetNumberOfTuples(), array->GetNumberOfComponents(), range));
+    }
+    if (range[0] > range[1]) {
+      // No finite values at all
+      range[0] = range[1] = 0.0;
+    }
+  }
+  if (range[0] == range[1]) {
+    range[1] = range[0] + 1.0;
+  }
+}
+
+void Populate2DHistogram(vtkImageData* input, vtkImageData* output,
+                         const double range[2], int stride = 1)
 {
-  double minmax[2] = { 0.0, 0.0 };
+  double minmax[2] = { range[0], range[1] };
   const int numberOfBins = 256;
 
   // Keep the array we are working on around even if the user shallow copies
@@ -105,12 +170,6 @@ void Populate2DHistogram(vtkImageData* input, vtkImageData* output)
     return;
   }
 
-  // The bin values are the centers, extending +/- half an inc either side
-  arrayPtr->GetFiniteRange(minmax, -1);
-  if (minmax[0] == minmax[1]) {
-    minmax[1] = minmax[0] + 1.0;
-  }
-
   // vtkPlotHistogram2D expects the histogram array to be VTK_DOUBLE
   output->SetDimensions(numberOfBins, numberOfBins, 1);
   output->AllocateScalars(VTK_DOUBLE, 1);
@@ -125,7 +184,7 @@ void Populate2DHistogram(vtkImageData* input, vtkImageData* output)
   switch (arrayPtr->GetDataType()) {
     vtkTemplateMacro(tomviz::Calculate2DHistogram(
       reinterpret_cast<VTK_TT*>(arrayPtr->GetVoidPointer(0)), dim, numComp,
-      minmax, output, spacing));
+      minmax, output, spacing, stride));
     default:
       cout << "UpdateFromFile: Unknown data type" << endl;
   }
@@ -147,11 +206,15 @@ public:
   HistogramMaker(QObject* p = nullptr) : QObject(p) {}
 
 public slots:
+  // rangeKnown tells whether [min, max] is the finite range of the scalars,
+  // looked up on the GUI thread.
   void makeHistogram(vtkSmartPointer<vtkImageData> input,
-                     vtkSmartPointer<vtkTable> output);
+                     vtkSmartPointer<vtkTable> output, bool rangeKnown,
+                     double min, double max);
 
   void makeHistogram2D(vtkSmartPointer<vtkImageData> input,
-                       vtkSmartPointer<vtkImageData> output);
+                       vtkSmartPointer<vtkImageData> output, bool rangeKnown,
+                       double min, double max);
 
 signals:
   void histogramDone(vtkSmartPointer<vtkImageData> image,
@@ -159,24 +222,43 @@ signals:
 
   void histogram2DDone(vtkSmartPointer<vtkImageData> image,
                        vtkSmartPointer<vtkImageData> output);
+
+  void histogram2DPreview(vtkSmartPointer<vtkImageData> image,
+                          vtkSmartPointer<vtkImageData> output);
 };
 
 void HistogramMaker::makeHistogram(vtkSmartPointer<vtkImageData> input,
-                                   vtkSmartPointer<vtkTable> output)
+                                   vtkSmartPointer<vtkTable> output,
+                                   bool rangeKnown, double min, double max)
 {
   // make the histogram and notify observers (the main thread) that it
   // is done.
   if (input && output) {
-    PopulateHistogram(input, output);
+    double range[2] = { min, max };
+    PopulateHistogram(input, output, rangeKnown, range);
   }
   emit histogramDone(input, output);
 }
 
 void HistogramMaker::makeHistogram2D(vtkSmartPointer<vtkImageData> input,
-                                     vtkSmartPointer<vtkImageData> output)
+                                     vtkSmartPointer<vtkImageData> output,
+                                     bool rangeKnown, double min, double max)
 {
-  if (input && output) {
-    Populate2DHistogram(input, output);
+  vtkDataArray* scalars = input ? input->GetPointData()->GetScalars() : nullptr;
+  if (scalars && output) {
+    double range[2] = { min, max };
+    histogram2DRange(scalars, rangeKnown, range);
+
+    // Large volumes get a coarse histogram from a strided subsample first, so
+    // the 2D transfer function can be edited while the full one is computed.
+    int stride = tomviz::preview2DHistogramStride(input->GetNumberOfPoints(),
+                                                  PreviewVoxels);
+    if (stride > 1) {
+      auto preview = vtkSmartPointer<vtkImageData>::New();
+      Populate2DHistogram(input, preview, range, stride);
+      emit histogram2DPreview(input, preview);
+    }
+    Populate2DHistogram(input, output, range);
   }
   emit histogram2DDone(input, output);
 }
@@ -202,6 +284,11 @@ HistogramManager::HistogramManager()
                                  vtkSmartPointer<vtkImageData>)),
           SLOT(histogram2DReadyInternal(vtkSmartPointer<vtkImageData>,
                                         vtkSmartPointer<vtkImageData>)));
+  connect(m_histogramGen,
+          SIGNAL(histogram2DPreview(vtkSmartPointer<vtkImageData>,
+                                    vtkSmartPointer<vtkImageData>)),
+          SLOT(histogram2DPreviewInternal(vtkSmartPointer<vtkImageData>,
+                                          vtkSmartPointer<vtkImageData>)));
 }
 
 HistogramManager::~HistogramManager()
@@ -235,33 +322,147 @@ HistogramManager& HistogramManager::instance()
   return theInstance;
 }
 
+HistogramKey HistogramManager::histogramKey(vtkImageData* image)
+{
+  HistogramKey key;
+  vtkDataArray* scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (scalars) {
+    key.array = scalars;
+    key.mtime = scalars->GetMTime();
+    image->GetDimensions(key.dimensions);
+  }
+  return key;
+}
+
+vtkSmartPointer<vtkImageData> HistogramManager::histogramInput(
+  vtkImageData* image)
+{
+  // Only the structure and the active scalars, the worker then histograms the
+  // array of the key even if the active scalars of image change meanwhile.
+  auto input = vtkSmartPointer<vtkImageData>::New();
+  input->CopyStructure(image);
+  input->GetPointData()->SetScalars(image->GetPointData()->GetScalars());
+  return input;
+}
+
+bool HistogramManager::waitFor(Requests& requests, const HistogramKey& key,
+                               vtkImageData* image)
+{
+  for (auto& request : requests) {
+    if (request.key == key) {
+      if (!request.waiting.contains(image)) {
+        request.waiting.append(image);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+QList<vtkImageData*> HistogramManager::waitingImages(Requests& requests,
+                                                     vtkImageData* input,
+                                                     bool done)
+{
+  QList<vtkImageData*> images;
+  auto it = requests.find(input);
+  if (it == requests.end()) {
+    return images;
+  }
+  // Images whose active scalars changed while the histogram was computed
+  // have requested the histogram of their new scalars.
+  foreach (vtkImageData* image, it->waiting) {
+    if (image && histogramKey(image) == it->key) {
+      images.append(image);
+    }
+  }
+  if (done) {
+    requests.erase(it);
+  }
+  return images;
+}
+
+vtkDataObject* HistogramManager::cachedHistogram(HistogramCache& cache,
+                                                 const HistogramKey& key)
+{
+  auto it = cache.find(key);
+  if (it == cache.end()) {
+    return nullptr;
+  }
+  it->lastUsed = ++m_cacheClock;
+  return it->histogram;
+}
+
+void HistogramManager::cacheHistogram(HistogramCache& cache,
+                                      const HistogramKey& key,
+                                      vtkDataObject* histogram)
+{
+  CacheEntry entry;
+  entry.histogram = histogram;
+  entry.lastUsed = ++m_cacheClock;
+  entry.size = histogram->GetActualMemorySize();
+  cache[key] = entry;
+
+  // Evict the least recently used histograms, from either cache, until we are
+  // back within the memory budget.
+  auto cacheSize = [](const HistogramCache& c) {
+    unsigned long size = 0;
+    foreach (const CacheEntry& e, c) {
+      size += e.size;
+    }
+    return size;
+  };
+  while (cacheSize(m_histogramCache) + cacheSize(m_histogram2DCache) >
+         CacheBudget) {
+    HistogramCache* oldestCache = nullptr;
+    HistogramCache::iterator oldest;
+    for (auto c : { &m_histogramCache, &m_histogram2DCache }) {
+      for (auto it = c->begin(); it != c->end(); ++it) {
+        if (!oldestCache || it->lastUsed < oldest->lastUsed) {
+          oldestCache = c;
+          oldest = it;
+        }
+      }
+    }
+    if (!oldestCache || oldest->histogram == histogram) {
+      // Never evict the histogram that was just computed.
+      break;
+    }
+    oldestCache->erase(oldest);
+  }
+}
+
 vtkSmartPointer<vtkTable> HistogramManager::getHistogram(
   vtkSmartPointer<vtkImageData> image)
 {
-  if (m_histogramCache.contains(image)) {
-    auto cachedTable = m_histogramCache[image];
-    if (cachedTable->GetMTime() > image->GetMTime()) {
-      return cachedTable;
-    } else {
-      // Need to recalculate, clear the plots, and remove the cached data.
-      m_histogramCache.remove(image);
-    }
+  auto key = histogramKey(image);
+  if (!key.array) {
+    return nullptr;
   }
-  if (m_histogramsInProgress.contains(image)) {
-    // it is in progress, don't start a new one
+  if (auto cached = cachedHistogram(m_histogramCache, key)) {
+    return vtkTable::SafeDownCast(cached);
+  }
+  if (waitFor(m_histogramsInProgress, key, image)) {
+    // The same data is already being histogrammed, possibly through another
+    // image.
     return nullptr;
   }
+  auto input = histogramInput(image);
+  m_histogramsInProgress[input].key = key;
+  m_histogramsInProgress[input].waiting.append(image.GetPointer());
   auto table = vtkSmartPointer<vtkTable>::New();
-  m_histogramsInProgress.append(image);
-  vtkSmartPointer<vtkImageData> const imageSP = image;
+  double range[2] = { 0.0, 0.0 };
+  bool rangeKnown =
+    cachedFiniteRange(input->GetPointData()->GetScalars(), range);
 
   // This fakes a Qt signal to the background thread (without exposing the
   // class internals as a signal).  The background thread will then call
   // makeHistogram on the HistogramMaker object with the parameters we
   // gave here.
-  QMetaObject::invokeMethod(m_histogramGen, "makeHistogram",
-                            Q_ARG(vtkSmartPointer<vtkImageData>, imageSP),
-                            Q_ARG(vtkSmartPointer<vtkTable>, table));
+  QMetaObject::invokeMethod(
+    m_histogramGen, "makeHistogram",
+    Q_ARG(vtkSmartPointer<vtkImageData>, input),
+    Q_ARG(vtkSmartPointer<vtkTable>, table), Q_ARG(bool, rangeKnown),
+    Q_ARG(double, range[0]), Q_ARG(double, range[1]));
 
   // The histogram cannot be returned for use while the background thread is
   // populating it.
@@ -271,49 +472,81 @@ vtkSmartPointer<vtkTable> HistogramManager::getHistogram(
 vtkSmartPointer<vtkImageData> HistogramManager::getHistogram2D(
   vtkSmartPointer<vtkImageData> image)
 {
-  if (m_histogram2DCache.contains(image)) {
-    auto cachedHistogram = m_histogram2DCache[image];
-    if (cachedHistogram->GetMTime() > image->GetMTime()) {
-      return cachedHistogram;
-    } else {
-      // Need to recalculate, clear the plots, and remove the cached data.
-      m_histogram2DCache.remove(image);
-    }
+  auto key = histogramKey(image);
+  if (!key.array) {
+    return nullptr;
   }
-  if (m_histogram2DsInProgress.contains(image)) {
-    // it is in progress, don't start a new one
+  if (auto cached = cachedHistogram(m_histogram2DCache, key)) {
+    return vtkImageData::SafeDownCast(cached);
+  }
+  if (waitFor(m_histogram2DsInProgress, key, image)) {
+    // The same data is already being histogrammed, possibly through another
+    // image.
     return nullptr;
   }
+  auto input = histogramInput(image);
+  m_histogram2DsInProgress[input].key = key;
+  m_histogram2DsInProgress[input].waiting.append(image.GetPointer());
   auto histogram = vtkSmartPointer<vtkImageData>::New();
-  m_histogram2DsInProgress.append(image);
-  vtkSmartPointer<vtkImageData> const imageSP = image;
+  double range[2] = { 0.0, 0.0 };
+  bool rangeKnown =
+    cachedFiniteRange(input->GetPointData()->GetScalars(), range);
 
   // This fakes a Qt signal to the background thread (without exposing the
   // class internals as a signal).  The background thread will then call
   // makeHistogram on the HistogramMaker object with the parameters we
   // gave here.
-  QMetaObject::invokeMethod(m_histogramGen, "makeHistogram2D",
-                            Q_ARG(vtkSmartPointer<vtkImageData>, imageSP),
-                            Q_ARG(vtkSmartPointer<vtkImageData>, histogram));
+  QMetaObject::invokeMethod(
+    m_histogramGen, "makeHistogram2D",
+    Q_ARG(vtkSmartPointer<vtkImageData>, input),
+    Q_ARG(vtkSmartPointer<vtkImageData>, histogram), Q_ARG(bool, rangeKnown),
+    Q_ARG(double, range[0]), Q_ARG(double, range[1]));
   // The histogram cannot be returned for use while the background thread is
   // populating it.
   return nullptr;
 }
 
 void HistogramManager::histogramReadyInternal(
-  vtkSmartPointer<vtkImageData> image, vtkSmartPointer<vtkTable> histogram)
+  vtkSmartPointer<vtkImageData> input, vtkSmartPointer<vtkTable> histogram)
 {
-  m_histogramCache[image] = histogram;
-  m_histogramsInProgress.removeAll(image);
-  emit this->histogramReady(image, histogram);
+  if (!m_histogramsInProgress.contains(input)) {
+    return;
+  }
+  cacheHistogram(m_histogramCache, m_histogramsInProgress[input].key,
+                 histogram);
+
+  // Notify for every image that was waiting on this data.
+  foreach (vtkImageData* waiting,
+           waitingImages(m_histogramsInProgress, input, true)) {
+    emit this->histogramReady(waiting, histogram);
+  }
 }
 
 void HistogramManager::histogram2DReadyInternal(
-  vtkSmartPointer<vtkImageData> image, vtkSmartPointer<vtkImageData> histogram)
+  vtkSmartPointer<vtkImageData> input, vtkSmartPointer<vtkImageData> histogram)
 {
-  m_histogram2DCache[image] = histogram;
-  m_histogram2DsInProgress.removeAll(image);
-  emit this->histogram2DReady(image, histogram);
+  if (!m_histogram2DsInProgress.contains(input)) {
+    return;
+  }
+  cacheHistogram(m_histogram2DCache, m_histogram2DsInProgress[input].key,
+                 histogram);
+
+  // Notify for every image that was waiting on this data.
+  foreach (vtkImageData* waiting,
+           waitingImages(m_histogram2DsInProgress, input, true)) {
+    emit this->histogram2DReady(waiting, histogram);
+  }
+}
+
+void HistogramManager::histogram2DPreviewInternal(
+  vtkSmartPointer<vtkImageData> input, vtkSmartPointer<vtkImageData> histogram)
+{
+  // The preview is not cached, the full histogram is still in progress and
+  // will be emitted again through histogram2DReady when it is done.
+  foreach (vtkImageData* waiting,
+           waitingImages(m_histogram2DsInProgress, input, false)) {
+    emit this->histogram2DReady(waiting, histogram);
+  }
 }
 
 } // namespace tomviz
@@ -6,17 +6,47 @@
 #include <QObject>
 
 #include <vtkSmartPointer.h>
+#include <vtkType.h>
+#include <vtkWeakPointer.h>
 
+#include <QList>
 #include <QMap>
 
+#include <tuple>
+
 class QThread;
 
+class vtkDataObject;
 class vtkImageData;
 class vtkTable;
 
 namespace tomviz {
 class HistogramMaker;
 
+/// Identifies the data a histogram was computed from: the scalar array, its
+/// modification time and the image dimensions (the 2D histogram depends on
+/// the layout). Images produced by re-running the pipeline that still share
+/// unchanged arrays reuse the cached histograms, and a new array allocated at
+/// a reused address has a newer modification time.
+struct HistogramKey
+{
+  const void* array = nullptr;
+  vtkMTimeType mtime = 0;
+  int dimensions[3] = { 0, 0, 0 };
+
+  bool operator==(const HistogramKey& other) const
+  {
+    return !(*this < other) && !(other < *this);
+  }
+  bool operator<(const HistogramKey& other) const
+  {
+    return std::tie(array, mtime, dimensions[0], dimensions[1],
+                    dimensions[2]) <
+           std::tie(other.array, other.mtime, other.dimensions[0],
+                    other.dimensions[1], other.dimensions[2]);
+  }
+};
+
 class HistogramManager : public QObject
 {
   Q_OBJECT
@@ -34,23 +64,67 @@ public:
 
 signals:
   void histogramReady(vtkSmartPointer<vtkImageData>, vtkSmartPointer<vtkTable>);
+  /// Emitted when a 2D histogram is ready. For large volumes this is first
+  /// emitted with a coarse preview computed from a subsample, then again with
+  /// the full histogram.
   void histogram2DReady(vtkSmartPointer<vtkImageData> input,
                         vtkSmartPointer<vtkImageData> output);
 
 private slots:
-  void histogramReadyInternal(vtkSmartPointer<vtkImageData>,
-                              vtkSmartPointer<vtkTable>);
+  void histogramReadyInternal(vtkSmartPointer<vtkImageData> input,
+                              vtkSmartPointer<vtkTable> output);
   void histogram2DReadyInternal(vtkSmartPointer<vtkImageData> input,
                                 vtkSmartPointer<vtkImageData> output);
+  void histogram2DPreviewInternal(vtkSmartPointer<vtkImageData> input,
+                                  vtkSmartPointer<vtkImageData> output);
 
 private:
   HistogramManager();
   ~HistogramManager();
 
-  QMap<vtkImageData*, vtkSmartPointer<vtkTable>> m_histogramCache;
-  QMap<vtkImageData*, vtkSmartPointer<vtkImageData>> m_histogram2DCache;
-  QList<vtkImageData*> m_histogramsInProgress;
-  QList<vtkImageData*> m_histogram2DsInProgress;
+  struct CacheEntry
+  {
+    vtkSmartPointer<vtkDataObject> histogram;
+    quint64 lastUsed = 0;
+    /// Size of the histogram in kibibytes.
+    unsigned long size = 0;
+  };
+  typedef QMap<HistogramKey, CacheEntry> HistogramCache;
+
+  /// A histogram being computed on the worker thread, and the images waiting
+  /// for it.
+  struct Request
+  {
+    HistogramKey key;
+    QList<vtkWeakPointer<vtkImageData>> waiting;
+  };
+  /// Requests keyed on the input handed to the worker, which holds the array
+  /// of the key whatever happens to the active scalars of the images.
+  typedef QMap<vtkImageData*, Request> Requests;
+
+  /// Upper bound on the memory used by both caches together, in kibibytes.
+  static const unsigned long CacheBudget = 64 * 1024;
+
+  static HistogramKey histogramKey(vtkImageData* image);
+  static vtkSmartPointer<vtkImageData> histogramInput(vtkImageData* image);
+  /// Adds image to the request for key if there is one, returns false if
+  /// there is none.
+  static bool waitFor(Requests& requests, const HistogramKey& key,
+                      vtkImageData* image);
+  /// The images waiting on the request of input whose active scalars are
+  /// still the data it was computed from. The request is removed if done.
+  static QList<vtkImageData*> waitingImages(Requests& requests,
+                                            vtkImageData* input, bool done);
+  vtkDataObject* cachedHistogram(HistogramCache& cache,
+                                 const HistogramKey& key);
+  void cacheHistogram(HistogramCache& cache, const HistogramKey& key,
+                      vtkDataObject* histogram);
+
+  HistogramCache m_histogramCache;
+  HistogramCache m_histogram2DCache;
+  quint64 m_cacheClock = 0;
+  Requests m_histogramsInProgress;
+  Requests m_histogram2DsInProgress;
   HistogramMaker* m_histogramGen;
   QThread* m_worker;
 };
@@ -0,0 +1,47 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ImageFilterReaction.h"
+
+#include <QDebug>
+#include <QMainWindow>
+
+#include "ActiveObjects.h"
+#include "DataSource.h"
+#include "EditOperatorDialog.h"
+#include "Operator.h"
+#include "OperatorFactory.h"
+
+namespace tomviz {
+
+ImageFilterReaction::ImageFilterReaction(QAction* parentObject,
+                                         const QString& operatorType,
+                                         QMainWindow* mw)
+  : Reaction(parentObject), m_operatorType(operatorType), m_mainWindow(mw)
+{
+}
+
+void ImageFilterReaction::addFilter(DataSource* source)
+{
+  source = source ? source : ActiveObjects::instance().activeParentDataSource();
+  if (!source) {
+    return;
+  }
+
+  Operator* op =
+    OperatorFactory::instance().createOperator(m_operatorType, nullptr);
+  if (!op) {
+    qCritical() << "Unknown operator type" << m_operatorType;
+    return;
+  }
+
+  if (!op->hasCustomUI()) {
+    source->addOperator(op);
+    return;
+  }
+  auto dialog = new EditOperatorDialog(op, source, true, m_mainWindow);
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+  dialog->show();
+  connect(op, SIGNAL(destroyed()), dialog, SLOT(reject()));
+}
+} // namespace tomviz
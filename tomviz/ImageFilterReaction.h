@@ -0,0 +1,37 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageFilterReaction_h
+#define tomvizImageFilterReaction_h
+
+#include <Reaction.h>
+
+class QMainWindow;
+
+namespace tomviz {
+class DataSource;
+
+/// Adds one of the native image filter operators, by its OperatorFactory
+/// type, to the active data source. Operators with parameters are shown in an
+/// editor dialog first.
+class ImageFilterReaction : public Reaction
+{
+  Q_OBJECT
+
+public:
+  ImageFilterReaction(QAction* parent, const QString& operatorType,
+                      QMainWindow* mw);
+
+  void addFilter(DataSource* source = nullptr);
+
+protected:
+  void onTriggered() override { addFilter(); }
+
+private:
+  Q_DISABLE_COPY(ImageFilterReaction)
+  QString m_operatorType;
+  QMainWindow* m_mainWindow;
+};
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,822 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ImageFilters.h"
+
+#include "ParallelUtilities.h"
+
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace tomviz {
+namespace ImageFilters {
+
+namespace {
+
+// Lines along y and z are processed TileWidth x columns at a time.
+const int TileWidth = 64;
+
+template <typename T>
+T clampToScalar(double value)
+{
+  if (value <= static_cast<double>(std::numeric_limits<T>::lowest())) {
+    return std::numeric_limits<T>::lowest();
+  }
+  if (value >= static_cast<double>(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  }
+  return static_cast<T>(value);
+}
+
+// Intermediate results are kept in double, like scipy.ndimage does. Its
+// filters convert them to an integer output type with a C cast, truncating
+// towards zero, while its interpolation rounds them, halves away from zero.
+// Values out of the range of the type, for which the cast is undefined, are
+// clamped.
+template <typename T, bool Integral = std::is_integral<T>::value>
+struct Truncate
+{
+  T operator()(double value) const { return static_cast<T>(value); }
+};
+
+template <typename T>
+struct Truncate<T, true>
+{
+  T operator()(double value) const
+  {
+    return clampToScalar<T>(std::trunc(value));
+  }
+};
+
+template <typename T, bool Integral = std::is_integral<T>::value>
+struct Round
+{
+  T operator()(double value) const { return static_cast<T>(value); }
+};
+
+template <typename T>
+struct Round<T, true>
+{
+  T operator()(double value) const
+  {
+    return clampToScalar<T>(std::round(value));
+  }
+};
+
+// The sum of a and b in numpy's arithmetic, integers wrap around.
+template <typename T>
+T numpyAdd(T a, T b, std::true_type)
+{
+  return static_cast<T>(static_cast<std::uint64_t>(a) +
+                        static_cast<std::uint64_t>(b));
+}
+
+template <typename T>
+T numpyAdd(T a, T b, std::false_type)
+{
+  return a + b;
+}
+
+// The conversion of the whole number value to T, integers wrap around like the
+// C cast does for the types up to 32 bits.
+template <typename T>
+T wrapToScalar(double value, std::true_type)
+{
+  const double limit = 9.2e18;
+  value = std::max(-limit, std::min(value, limit));
+  return static_cast<T>(
+    static_cast<std::uint64_t>(static_cast<std::int64_t>(value)));
+}
+
+template <typename T>
+T wrapToScalar(double value, std::false_type)
+{
+  return static_cast<T>(value);
+}
+
+// numpy's pairwise summation, which ndarray.sum() uses for float64 arrays.
+double pairwiseSum(const double* a, size_t n)
+{
+  if (n < 8) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      sum += a[i];
+    }
+    return sum;
+  } else if (n <= 128) {
+    double r[8];
+    std::copy(a, a + 8, r);
+    size_t i = 8;
+    for (; i < n - n % 8; i += 8) {
+      for (int j = 0; j < 8; ++j) {
+        r[j] += a[i + j];
+      }
+    }
+    double sum =
+      ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+    for (; i < n; ++i) {
+      sum += a[i];
+    }
+    return sum;
+  }
+  size_t half = n / 2;
+  half -= half % 8;
+  return pairwiseSum(a, half) + pairwiseSum(a + half, n - half);
+}
+
+// scipy's "reflect" border, d c b a | a b c d | d c b a.
+int reflect(int i, int n)
+{
+  if (n == 1) {
+    return 0;
+  }
+  int period = 2 * n;
+  i %= period;
+  if (i < 0) {
+    i += period;
+  }
+  return i < n ? i : period - 1 - i;
+}
+
+// The "mirror" border of the spline coefficients, d c b | a b c d | c b a.
+int mirror(int i, int n)
+{
+  if (n == 1) {
+    return 0;
+  }
+  int period = 2 * n - 2;
+  i %= period;
+  if (i < 0) {
+    i += period;
+  }
+  return i < n ? i : period - i;
+}
+
+// Turn width interleaved lines of n samples into cubic B-spline coefficients,
+// in place, with the recursive filter of scipy.ndimage.spline_filter1d and its
+// mirror boundary, in the same order of operations.
+void splinePrefilter(double* c, int n, int width)
+{
+  if (n < 2) {
+    return;
+  }
+  const double z = std::sqrt(3.0) - 2.0;
+  const double gain = (1.0 - z) * (1.0 - 1.0 / z);
+  for (size_t i = 0; i < static_cast<size_t>(n) * width; ++i) {
+    c[i] *= gain;
+  }
+
+  const double zn = std::pow(z, n - 1);
+  for (int b = 0; b < width; ++b) {
+    double first = c[b] + zn * c[(n - 1) * width + b];
+    double zi = z;
+    for (int k = 1; k < n - 1; ++k) {
+      first += zi * (c[k * width + b] + zn * c[(n - 1 - k) * width + b]);
+      zi *= z;
+    }
+    c[b] = first / (1 - zn * zn);
+  }
+
+  for (int k = 1; k < n; ++k) {
+    for (int b = 0; b < width; ++b) {
+      c[k * width + b] += z * c[(k - 1) * width + b];
+    }
+  }
+  for (int b = 0; b < width; ++b) {
+    double* last = c + (n - 1) * width + b;
+    *last = (z * *(last - width) + *last) * z / (z * z - 1);
+  }
+  for (int k = n - 2; k >= 0; --k) {
+    for (int b = 0; b < width; ++b) {
+      c[k * width + b] = z * (c[(k + 1) * width + b] - c[k * width + b]);
+    }
+  }
+}
+
+// Maps a line of n samples to outputLength samples, each a weighted sum of
+// taps input samples, optionally after turning the input into spline
+// coefficients. Convolutions and resampling are both expressed this way, with
+// the border handling folded into the tap indices.
+class LineFilter
+{
+public:
+  int length = 0;
+  int outputLength = 0;
+
+  void operator()(const double* tile, double* result, int width) const
+  {
+    std::vector<double> coefficients;
+    if (m_prefilter) {
+      coefficients.assign(tile, tile + static_cast<size_t>(length) * width);
+      splinePrefilter(coefficients.data(), length, width);
+      tile = coefficients.data();
+    }
+    const int radius = m_taps / 2;
+    for (int j = 0; j < outputLength; ++j) {
+      double* out = result + static_cast<size_t>(j) * width;
+      const int* indices = &m_indices[j * m_taps];
+      const double* weights = &m_weights[j * m_taps];
+      auto line = [&](int m) {
+        return tile + static_cast<size_t>(indices[m]) * width;
+      };
+      if (m_symmetry == 0) {
+        std::fill(out, out + width, 0.0);
+        for (int m = 0; m < m_taps; ++m) {
+          const double* in = line(m);
+          for (int b = 0; b < width; ++b) {
+            out[b] += weights[m] * in[b];
+          }
+        }
+        continue;
+      }
+
+      // scipy's correlate1d adds (anti)symmetric pairs of samples to the
+      // center one, from the outside in.
+      const double* center = line(radius);
+      for (int b = 0; b < width; ++b) {
+        out[b] = center[b] * weights[radius];
+      }
+      for (int m = 0; m < radius; ++m) {
+        const double* left = line(m);
+        const double* right = line(m_taps - 1 - m);
+        const double w = weights[m];
+        if (m_symmetry > 0) {
+          for (int b = 0; b < width; ++b) {
+            out[b] += (left[b] + right[b]) * w;
+          }
+        } else {
+          for (int b = 0; b < width; ++b) {
+            out[b] += (left[b] - right[b]) * w;
+          }
+        }
+      }
+    }
+  }
+
+  /// Correlation with weights centered on each sample, reflected borders.
+  static LineFilter correlation(int n, const std::vector<double>& weights)
+  {
+    LineFilter f(n, n, static_cast<int>(weights.size()));
+    int radius = f.m_taps / 2;
+    for (int i = 0; i < n; ++i) {
+      for (int k = 0; k < f.m_taps; ++k) {
+        f.m_indices[i * f.m_taps + k] = reflect(i + k - radius, n);
+        f.m_weights[i * f.m_taps + k] = weights[k];
+      }
+    }
+
+    // The same test for symmetric and antisymmetric weights as scipy's.
+    if (f.m_taps % 2 == 1) {
+      auto matches = [&](double sign) {
+        for (int k = 1; k <= radius; ++k) {
+          if (std::abs(weights[radius + k] - sign * weights[radius - k]) >
+              std::numeric_limits<double>::epsilon()) {
+            return false;
+          }
+        }
+        return true;
+      };
+      f.m_symmetry = matches(1) ? 1 : (matches(-1) ? -1 : 0);
+    }
+    return f;
+  }
+
+  /// Resampling of n samples to outputLength with a spline of order 1 or 3,
+  /// keeping the first and last samples aligned.
+  static LineFilter zoom(int n, int outputLength, int order)
+  {
+    if (n == outputLength) {
+      return correlation(n, { 1.0 });
+    }
+    int taps = order == 3 ? 4 : 2;
+    LineFilter f(n, outputLength, taps);
+    f.m_prefilter = order == 3;
+    double scale =
+      outputLength > 1 ? static_cast<double>(n - 1) / (outputLength - 1) : 0;
+    for (int j = 0; j < outputLength; ++j) {
+      double position = std::min(j * scale, n - 1.0);
+      int i = static_cast<int>(std::floor(position));
+      double t = position - i;
+      int* indices = &f.m_indices[j * taps];
+      double* weights = &f.m_weights[j * taps];
+      if (order == 3) {
+        double s = 1 - t;
+        weights[0] = s * s * s / 6;
+        weights[1] = (4 - 6 * t * t + 3 * t * t * t) / 6;
+        weights[2] = (1 + 3 * t + 3 * t * t - 3 * t * t * t) / 6;
+        weights[3] = t * t * t / 6;
+        for (int m = 0; m < 4; ++m) {
+          indices[m] = mirror(i - 1 + m, n);
+        }
+      } else {
+        indices[0] = i;
+        indices[1] = std::min(i + 1, n - 1);
+        weights[0] = 1 - t;
+        weights[1] = t;
+      }
+    }
+    return f;
+  }
+
+private:
+  LineFilter(int n, int m, int taps)
+    : length(n), outputLength(m), m_taps(taps),
+      m_indices(static_cast<size_t>(m) * taps),
+      m_weights(static_cast<size_t>(m) * taps)
+  {
+  }
+
+  int m_taps;
+  /// 1 or -1 for correlations with symmetric or antisymmetric weights.
+  int m_symmetry = 0;
+  bool m_prefilter = false;
+  std::vector<int> m_indices;
+  std::vector<double> m_weights;
+};
+
+// Applies filter to every line of in along axis, writing out, whose dims are
+// those of in with dims[axis] replaced by filter.outputLength. The samples of
+// in and out are inComponents and outComponents values apart, so pointers to
+// one component of an interleaved array can be passed. in and out may be the
+// same array when the length doesn't change, every line is read before it is
+// written. The results are stored with convert.
+template <typename In, typename Out, typename Convert>
+void filterAxis(const In* in, Out* out, const int dims[3], int axis,
+                int inComponents, int outComponents, const LineFilter& filter,
+                const Convert& convert, int numberOfThreads)
+{
+  const int n = dims[axis];
+  const int m = filter.outputLength;
+  int outDims[3] = { dims[0], dims[1], dims[2] };
+  outDims[axis] = m;
+  const size_t inStrides[3] = { 1, static_cast<size_t>(dims[0]),
+                                static_cast<size_t>(dims[0]) * dims[1] };
+  const size_t outStrides[3] = { 1, static_cast<size_t>(outDims[0]),
+                                 static_cast<size_t>(outDims[0]) *
+                                   outDims[1] };
+
+  if (axis == 0) {
+    // Rows are contiguous, a slice of them at a time.
+    auto body = [&](int z) {
+      std::vector<double> tile(n);
+      std::vector<double> result(m);
+      for (int y = 0; y < dims[1]; ++y) {
+        const In* src =
+          in + (z * inStrides[2] + y * inStrides[1]) * inComponents;
+        for (int i = 0; i < n; ++i) {
+          tile[i] = static_cast<double>(src[i * inComponents]);
+        }
+        filter(tile.data(), result.data(), 1);
+        Out* dst =
+          out + (z * outStrides[2] + y * outStrides[1]) * outComponents;
+        for (int j = 0; j < m; ++j) {
+          dst[j * outComponents] = convert(result[j]);
+        }
+      }
+    };
+    parallelFor(0, dims[2], body, nullptr, numberOfThreads);
+    return;
+  }
+
+  // Lines along y or z, TileWidth neighboring x columns at a time, for each
+  // position along the remaining axis.
+  const int other = 3 - axis;
+  const int blocks = (dims[0] + TileWidth - 1) / TileWidth;
+  auto body = [&](int index) {
+    const int o = index / blocks;
+    const int x0 = (index % blocks) * TileWidth;
+    const int width = std::min(TileWidth, dims[0] - x0);
+    std::vector<double> tile(static_cast<size_t>(n) * width);
+    std::vector<double> result(static_cast<size_t>(m) * width);
+    for (int i = 0; i < n; ++i) {
+      const In* src =
+        in + (o * inStrides[other] + i * inStrides[axis] + x0) * inComponents;
+      double* dst = tile.data() + static_cast<size_t>(i) * width;
+      for (int b = 0; b < width; ++b) {
+        dst[b] = static_cast<double>(src[b * inComponents]);
+      }
+    }
+    filter(tile.data(), result.data(), width);
+    for (int j = 0; j < m; ++j) {
+      const double* src = result.data() + static_cast<size_t>(j) * width;
+      Out* dst = out + (o * outStrides[other] + j * outStrides[axis] + x0) *
+                         outComponents;
+      for (int b = 0; b < width; ++b) {
+        dst[b * outComponents] = convert(src[b]);
+      }
+    }
+  };
+  parallelFor(0, dims[other] * blocks, body, nullptr, numberOfThreads);
+}
+
+size_t voxelCount(const int dims[3])
+{
+  return static_cast<size_t>(dims[0]) * dims[1] * dims[2];
+}
+
+template <typename T>
+void gaussianT(const T* in, T* out, const int dims[3], int components,
+               double sigma, int numberOfThreads)
+{
+  // The kernel of scipy.ndimage.gaussian_filter1d, computed the same way.
+  int radius = static_cast<int>(4 * sigma + 0.5);
+  const double scale = -0.5 / (sigma * sigma);
+  std::vector<double> weights(2 * radius + 1);
+  for (int k = -radius; k <= radius; ++k) {
+    weights[k + radius] = std::exp(scale * (k * k));
+  }
+  double sum = pairwiseSum(weights.data(), weights.size());
+  for (auto& weight : weights) {
+    weight /= sum;
+  }
+
+  // Like gaussian_filter, every axis is filtered into the output type in
+  // turn, so integer results are truncated after each axis.
+  Truncate<T> convert;
+  for (int c = 0; c < components; ++c) {
+    filterAxis(in + c, out + c, dims, 0, components, components,
+               LineFilter::correlation(dims[0], weights), convert,
+               numberOfThreads);
+    for (int axis = 1; axis < 3; ++axis) {
+      filterAxis(out + c, out + c, dims, axis, components, components,
+                 LineFilter::correlation(dims[axis], weights), convert,
+                 numberOfThreads);
+    }
+  }
+}
+
+template <typename T>
+void medianT(const T* in, T* out, const int dims[3], int components, int size,
+             int numberOfThreads)
+{
+  // indices[axis][i + k] is the k-th sample of the window of sample i.
+  std::vector<int> indices[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    indices[axis].resize(dims[axis] + size - 1);
+    for (size_t m = 0; m < indices[axis].size(); ++m) {
+      indices[axis][m] = reflect(static_cast<int>(m) - size / 2, dims[axis]);
+    }
+  }
+
+  const int windowSize = size * size * size;
+  const size_t sliceSize = static_cast<size_t>(dims[0]) * dims[1];
+  auto body = [&](int z) {
+    std::vector<T> window(windowSize);
+    std::vector<const T*> rows(size * size);
+    for (int y = 0; y < dims[1]; ++y) {
+      // The rows the windows of this row of voxels read from.
+      for (int dz = 0; dz < size; ++dz) {
+        for (int dy = 0; dy < size; ++dy) {
+          rows[dz * size + dy] =
+            in + (indices[2][z + dz] * sliceSize +
+                  static_cast<size_t>(indices[1][y + dy]) * dims[0]) *
+                   components;
+        }
+      }
+      T* dst = out + (z * sliceSize + static_cast<size_t>(y) * dims[0]) *
+                       components;
+      for (int x = 0; x < dims[0]; ++x) {
+        const int* xIndices = &indices[0][x];
+        for (int c = 0; c < components; ++c) {
+          int k = 0;
+          for (const T* row : rows) {
+            for (int dx = 0; dx < size; ++dx) {
+              window[k++] = row[xIndices[dx] * components + c];
+            }
+          }
+          std::nth_element(window.begin(), window.begin() + windowSize / 2,
+                           window.end());
+          dst[x * components + c] = window[windowSize / 2];
+        }
+      }
+    }
+  };
+  parallelFor(0, dims[2], body, nullptr, numberOfThreads);
+}
+
+template <typename T>
+void laplaceT(const T* in, T* out, const int dims[3], int components,
+              int numberOfThreads)
+{
+  const size_t strides[3] = { static_cast<size_t>(components),
+                              static_cast<size_t>(components) * dims[0],
+                              static_cast<size_t>(components) * dims[0] *
+                                dims[1] };
+  // Offsets to the previous and next samples along an axis, reflected at
+  // the borders.
+  auto previous = [&](int i, int axis) -> size_t {
+    return i > 0 ? strides[axis] : 0;
+  };
+  auto next = [&](int i, int axis) -> size_t {
+    return i < dims[axis] - 1 ? strides[axis] : 0;
+  };
+
+  // scipy.ndimage.laplace stores the second difference along each axis in
+  // the output type and adds them up in that type, so integers wrap around.
+  auto body = [&](int z) {
+    for (int y = 0; y < dims[1]; ++y) {
+      size_t offset = z * strides[2] + y * strides[1];
+      for (int x = 0; x < dims[0]; ++x, offset += strides[0]) {
+        const size_t before[3] = { previous(x, 0), previous(y, 1),
+                                   previous(z, 2) };
+        const size_t after[3] = { next(x, 0), next(y, 1), next(z, 2) };
+        for (int c = 0; c < components; ++c) {
+          const T* center = in + offset + c;
+          T sum = 0;
+          for (int axis = 0; axis < 3; ++axis) {
+            double difference =
+              static_cast<double>(*center) * -2.0 +
+              (static_cast<double>(*(center - before[axis])) +
+               static_cast<double>(*(center + after[axis])));
+            T value = wrapToScalar<T>(difference, std::is_integral<T>());
+            sum = axis == 0 ? value
+                            : numpyAdd<T>(sum, value, std::is_integral<T>());
+          }
+          out[offset + c] = sum;
+        }
+      }
+    }
+  };
+  parallelFor(0, dims[2], body, nullptr, numberOfThreads);
+}
+
+template <typename T>
+void sobelMagnitude2DT(const T* in, float* out, const int dims[3],
+                       int components, int numberOfThreads)
+{
+  const std::vector<double> smooth = { 1, 2, 1 };
+  const std::vector<double> derivative = { -1, 0, 1 };
+  auto smoothing = [&](int axis) {
+    return LineFilter::correlation(dims[axis], smooth);
+  };
+  auto differencing = [&](int axis) {
+    return LineFilter::correlation(dims[axis], derivative);
+  };
+
+  // The script converts the data to float32 and calls scipy.ndimage.sobel
+  // along x and y, which differentiates along its axis and then smooths
+  // along the others in order, storing float32 after each of them.
+  const size_t n = voxelCount(dims);
+  const size_t sliceSize = static_cast<size_t>(dims[0]) * dims[1];
+  std::vector<float> input(n);
+  std::vector<float> dx(n);
+  std::vector<float> dy(n);
+  Truncate<float> convert;
+  for (int c = 0; c < components; ++c) {
+    parallelFor(0, dims[2],
+                [&](int z) {
+                  for (size_t i = z * sliceSize; i < (z + 1) * sliceSize;
+                       ++i) {
+                    input[i] = static_cast<float>(in[i * components + c]);
+                  }
+                },
+                nullptr, numberOfThreads);
+
+    filterAxis(input.data(), dx.data(), dims, 0, 1, 1, differencing(0),
+               convert, numberOfThreads);
+    filterAxis(dx.data(), dx.data(), dims, 1, 1, 1, smoothing(1), convert,
+               numberOfThreads);
+    filterAxis(dx.data(), dx.data(), dims, 2, 1, 1, smoothing(2), convert,
+               numberOfThreads);
+
+    filterAxis(input.data(), dy.data(), dims, 1, 1, 1, differencing(1),
+               convert, numberOfThreads);
+    filterAxis(dy.data(), dy.data(), dims, 0, 1, 1, smoothing(0), convert,
+               numberOfThreads);
+    filterAxis(dy.data(), dy.data(), dims, 2, 1, 1, smoothing(2), convert,
+               numberOfThreads);
+
+    auto body = [&](int z) {
+      for (size_t i = z * sliceSize; i < (z + 1) * sliceSize; ++i) {
+        out[i * components + c] = std::hypot(dx[i], dy[i]);
+      }
+    };
+    parallelFor(0, dims[2], body, nullptr, numberOfThreads);
+  }
+}
+
+template <typename T>
+void zoomT(const T* in, T* out, const int dims[3], const int outDims[3],
+           int components, int order, int numberOfThreads)
+{
+  // x is resampled into a, then y into b, then z into out. Like
+  // scipy.ndimage.zoom, only the final result is rounded to the type.
+  const int aDims[3] = { outDims[0], dims[1], dims[2] };
+  const int bDims[3] = { outDims[0], outDims[1], dims[2] };
+  std::vector<double> a(voxelCount(aDims));
+  std::vector<double> b(voxelCount(bDims));
+  auto filter = [&](int axis) {
+    return LineFilter::zoom(dims[axis], outDims[axis], order);
+  };
+  Round<double> keep;
+  Round<T> convert;
+  for (int c = 0; c < components; ++c) {
+    filterAxis(in + c, a.data(), dims, 0, components, 1, filter(0), keep,
+               numberOfThreads);
+    filterAxis(a.data(), b.data(), aDims, 1, 1, 1, filter(1), keep,
+               numberOfThreads);
+    filterAxis(b.data(), out + c, bDims, 2, 1, components, filter(2),
+               convert, numberOfThreads);
+  }
+}
+
+// A new array like scalars, with room for the given number of tuples.
+vtkSmartPointer<vtkDataArray> newArrayLike(vtkDataArray* scalars,
+                                           vtkIdType tuples)
+{
+  vtkSmartPointer<vtkDataArray> result;
+  result.TakeReference(scalars->NewInstance());
+  result->SetNumberOfComponents(scalars->GetNumberOfComponents());
+  result->SetNumberOfTuples(tuples);
+  result->SetName(scalars->GetName());
+  return result;
+}
+
+void replaceScalars(vtkImageData* image, vtkDataArray* scalars,
+                    vtkDataArray* result)
+{
+  image->GetPointData()->RemoveArray(scalars->GetName());
+  image->GetPointData()->SetScalars(result);
+}
+
+} // namespace
+
+bool gaussian(vtkImageData* image, double sigma, int numberOfThreads)
+{
+  auto scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || sigma < 0) {
+    return false;
+  }
+  if (sigma == 0) {
+    return true;
+  }
+
+  int dims[3];
+  image->GetDimensions(dims);
+  auto result = newArrayLike(scalars, scalars->GetNumberOfTuples());
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(gaussianT(
+      static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+      static_cast<VTK_TT*>(result->GetVoidPointer(0)), dims,
+      scalars->GetNumberOfComponents(), sigma, numberOfThreads));
+    default:
+      return false;
+  }
+  replaceScalars(image, scalars, result);
+  return true;
+}
+
+bool median(vtkImageData* image, int size, int numberOfThreads)
+{
+  auto scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (!scalars || size < 1) {
+    return false;
+  }
+  if (size == 1) {
+    return true;
+  }
+
+  int dims[3];
+  image->GetDimensions(dims);
+  auto result = newArrayLike(scalars, scalars->GetNumberOfTuples());
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(
+      medianT(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+              static_cast<VTK_TT*>(result->GetVoidPointer(0)), dims,
+              scalars->GetNumberOfComponents(), size, numberOfThreads));
+    default:
+      return false;
+  }
+  replaceScalars(image, scalars, result);
+  return true;
+}
+
+bool laplace(vtkImageData* image, int numberOfThreads)
+{
+  auto scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (!scalars) {
+    return false;
+  }
+
+  int dims[3];
+  image->GetDimensions(dims);
+  auto result = newArrayLike(scalars, scalars->GetNumberOfTuples());
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(
+      laplaceT(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+               static_cast<VTK_TT*>(result->GetVoidPointer(0)), dims,
+               scalars->GetNumberOfComponents(), numberOfThreads));
+    default:
+      return false;
+  }
+  replaceScalars(image, scalars, result);
+  return true;
+}
+
+bool sobelMagnitude2D(vtkImageData* image, int numberOfThreads)
+{
+  auto scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (!scalars) {
+    return false;
+  }
+
+  int dims[3];
+  image->GetDimensions(dims);
+  vtkNew<vtkFloatArray> result;
+  result->SetNumberOfComponents(scalars->GetNumberOfComponents());
+  result->SetNumberOfTuples(scalars->GetNumberOfTuples());
+  result->SetName(scalars->GetName());
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(sobelMagnitude2DT(
+      static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+      static_cast<float*>(result->GetVoidPointer(0)), dims,
+      scalars->GetNumberOfComponents(), numberOfThreads));
+    default:
+      return false;
+  }
+  replaceScalars(image, scalars, result);
+  return true;
+}
+
+int zoomLength(int n, double factor)
+{
+  // Python's round(), half to even, like tomviz.utils.zoom_shape().
+  return std::max(1, static_cast<int>(std::nearbyint(n * factor)));
+}
+
+bool zoom(vtkImageData* image, const double factors[3], int order,
+          int numberOfThreads)
+{
+  auto pointData = image ? image->GetPointData() : nullptr;
+  if (!pointData || !pointData->GetScalars() ||
+      (order != 1 && order != 3)) {
+    return false;
+  }
+
+  int dims[3];
+  int outDims[3];
+  image->GetDimensions(dims);
+  for (int i = 0; i < 3; ++i) {
+    outDims[i] = zoomLength(dims[i], factors[i]);
+  }
+
+  // Every point data array is resampled, so they all keep matching the
+  // extent.
+  auto scalars = pointData->GetScalars();
+  std::vector<vtkSmartPointer<vtkDataArray>> results;
+  vtkSmartPointer<vtkDataArray> scalarsResult;
+  for (int i = 0; i < pointData->GetNumberOfArrays(); ++i) {
+    auto array = pointData->GetArray(i);
+    if (!array) {
+      continue;
+    }
+    auto result = newArrayLike(array, voxelCount(outDims));
+    switch (array->GetDataType()) {
+      vtkTemplateMacro(
+        zoomT(static_cast<const VTK_TT*>(array->GetVoidPointer(0)),
+              static_cast<VTK_TT*>(result->GetVoidPointer(0)), dims, outDims,
+              array->GetNumberOfComponents(), order, numberOfThreads));
+      default:
+        return false;
+    }
+    if (array == scalars) {
+      scalarsResult = result;
+    } else {
+      results.push_back(result);
+    }
+  }
+
+  int extent[6];
+  image->GetExtent(extent);
+  for (int i = 0; i < 3; ++i) {
+    extent[2 * i + 1] = extent[2 * i] + outDims[i] - 1;
+  }
+  image->SetExtent(extent);
+
+  // Arrays of the same name are replaced.
+  for (auto& result : results) {
+    pointData->AddArray(result);
+  }
+  pointData->SetScalars(scalarsResult);
+  return true;
+}
+
+void zoom(const double* input, int n, double* output, int outputLength,
+          int order)
+{
+  auto filter = LineFilter::zoom(n, outputLength, order);
+  filter(input, output, 1);
+}
+} // namespace ImageFilters
+} // namespace tomviz
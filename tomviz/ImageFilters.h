@@ -0,0 +1,61 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageFilters_h
+#define tomvizImageFilters_h
+
+// Native, multithreaded versions of the scipy.ndimage filters behind the
+// GaussianFilter, MedianFilter, LaplaceFilter, GradientMagnitude2D_Sobel,
+// BinVolumeByTwo and Resample operators.
+//
+// The filters work on the active scalars of an image in their native type,
+// every component independently, and replace them with a new array of the
+// same name (the input array is only read). Separable filters run one axis at
+// a time; lines along y and z are processed in tiles of neighboring x columns
+// so every memory access is a short contiguous run. Borders are handled like
+// scipy's default "reflect" mode. The results follow the scripts' scipy calls:
+// work is done in double, filters store every axis in the output type in turn,
+// truncating integers, and zoom rounds them. Out of range integers, which
+// scipy leaves undefined, are clamped, except for laplace() which wraps them
+// like numpy. A numberOfThreads less than one uses every core.
+
+class vtkImageData;
+
+namespace tomviz {
+
+namespace ImageFilters {
+
+/// Gaussian blur with standard deviation sigma, in voxels, along every axis.
+/// The kernel is truncated at four standard deviations, like
+/// scipy.ndimage.gaussian_filter.
+bool gaussian(vtkImageData* image, double sigma, int numberOfThreads = 0);
+
+/// Median of the size x size x size window around every voxel. For even
+/// sizes the window extends one voxel further before the voxel than after it
+/// and the upper median is taken, like scipy.ndimage.median_filter.
+bool median(vtkImageData* image, int size, int numberOfThreads = 0);
+
+/// Sum of the second differences along every axis, scipy.ndimage.laplace.
+bool laplace(vtkImageData* image, int numberOfThreads = 0);
+
+/// Magnitude of the x and y Sobel derivatives (each smoothed along the other
+/// two axes, like scipy.ndimage.sobel), as float scalars.
+bool sobelMagnitude2D(vtkImageData* image, int numberOfThreads = 0);
+
+/// Resize the image by factors[i] along axis i, to round(n * factors[i])
+/// voxels, with spline interpolation of the given order (1 or 3), like
+/// scipy.ndimage.zoom. The first and last voxels of every axis stay aligned.
+/// The extent of the image is updated, its spacing is left alone.
+bool zoom(vtkImageData* image, const double factors[3], int order,
+          int numberOfThreads = 0);
+
+/// The number of samples zoom() produces from n samples.
+int zoomLength(int n, double factor);
+
+/// One dimensional version of zoom(), used for the tilt angles.
+void zoom(const double* input, int n, double* output, int outputLength,
+          int order);
+} // namespace ImageFilters
+} // namespace tomviz
+
+#endif
@@ -6,6 +6,7 @@
 #include "ui_ImageStackDialog.h"
 
 #include "LoadStackReaction.h"
+#include "TiffStackReader.h"
 #include "Utilities.h"
 
 #include <QDropEvent>
@@ -14,16 +15,6 @@
 #include <QMimeData>
 
 #include <algorithm>
-#include <chrono>
-#include <thread>
-
-#include <vtkImageData.h>
-#include <vtkNew.h>
-#include <vtkTIFFReader.h>
-
-extern "C" {
-#include "vtk_tiff.h"
-}
 
 namespace tomviz {
 
@@ -187,13 +178,9 @@ void ImageStackDialog::processFiles(const QStringList& fileNames)
   setStackType(stackType);
   setStackSummary(summary, false);
 
-  // Checking image size can take several seconds if there are thousands of
-  // images in the stack.
-  // Check the sizes automatically only for stacks smaller than maxImages
-  const auto maxImages = 1000;
-  if (summary.size() <= maxImages) {
-    checkStackSizes(summary);
-  }
+  // Only the TIFF tags are read, and the files are probed concurrently, so
+  // this is quick even for stacks of thousands of images.
+  checkStackSizes(summary);
 }
 
 void ImageStackDialog::checkStackSizes(QList<ImageInfo>& summary)
@@ -204,25 +191,17 @@ void ImageStackDialog::checkStackSizes(QList<ImageInfo>& summary)
     fileNames << summary[i].fileInfo.absoluteFilePath();
   }
 
-  const unsigned int minCores = 1;
-  const unsigned int nCores =
-    std::max(std::thread::hardware_concurrency(), minCores);
-  const unsigned int maxThreads = 4;
-  const unsigned int nThreads = std::min(nCores, maxThreads);
-  std::vector<std::thread> threads(nThreads);
-
-  for (unsigned int i = 0; i < nThreads; ++i) {
-    threads[i] = std::thread(getImageSize, fileNames, i, nThreads, &summary);
-  }
-
-  for (unsigned int i = 0; i < nThreads; ++i) {
-    threads[i].join();
+  // Only the tags of the files are read, not the images themselves.
+  auto headers = TiffStackReader::readHeaders(fileNames);
+  for (auto i = 0; i < summary.size(); ++i) {
+    summary[i].m = headers[i].width;
+    summary[i].n = headers[i].height;
   }
 
   // check consistency
   if (summary.size() > 0) {
     const auto m = summary[0].m;
-    const auto n = summary[1].n;
+    const auto n = summary[0].n;
     for (auto i = 0; i < summary.size(); ++i) {
       if (summary[i].m == m && summary[i].n == n) {
         summary[i].consistent = true;
@@ -236,24 +215,6 @@ void ImageStackDialog::checkStackSizes(QList<ImageInfo>& summary)
   setStackSummary(summary, true);
 }
 
-void ImageStackDialog::getImageSize(QStringList fileNames, int iThread,
-                                    int nThreads, QList<ImageInfo>* summary)
-{
-  TIFFSetWarningHandler(nullptr);
-  for (auto i = iThread; i < fileNames.size(); i += nThreads) {
-    uint32_t w = -1;
-    uint32_t h = -1;
-    TIFF* tif = TIFFOpen(fileNames[i].toLatin1().data(), "r");
-    if (tif) {
-      TIFFGetField(tif, TIFFTAG_IMAGEWIDTH, &w);
-      TIFFGetField(tif, TIFFTAG_IMAGELENGTH, &h);
-      TIFFClose(tif);
-    }
-    (*summary)[i].m = w;
-    (*summary)[i].n = h;
-  }
-}
-
 bool ImageStackDialog::detectVolume(QStringList fileNames,
                                     QList<ImageInfo>& summary, bool matchPrefix)
 {
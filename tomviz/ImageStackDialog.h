@@ -61,8 +61,6 @@ private:
                   bool matchPrefix = true);
   void defaultOrder(QStringList fileNames, QList<ImageInfo>& summary);
   QList<ImageInfo> initStackSummary(const QStringList& fileNames);
-  static void getImageSize(QStringList fileNames, int iThread, int nThreads,
-                           QList<ImageInfo>* summary);
   void checkStackSizes(QList<ImageInfo>& summary);
 };
 } // namespace tomviz
@@ -0,0 +1,338 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ImageTranslation.h"
+
+#include "FFTPlan.h"
+#include "ParallelUtilities.h"
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace tomviz {
+namespace ImageTranslation {
+
+namespace {
+
+typedef FFTPlan::Complex Complex;
+
+const double Pi = 3.14159265358979323846;
+
+// Columns gathered together for the transforms along y, so that every row is
+// read and written in runs of this many values.
+const int ColumnBlockSize = 16;
+
+template <typename T>
+T toScalar(double value, std::true_type)
+{
+  value = std::round(value);
+  if (value <= static_cast<double>(std::numeric_limits<T>::lowest())) {
+    return std::numeric_limits<T>::lowest();
+  }
+  if (value >= static_cast<double>(std::numeric_limits<T>::max())) {
+    return std::numeric_limits<T>::max();
+  }
+  return static_cast<T>(value);
+}
+
+template <typename T>
+T toScalar(double value, std::false_type)
+{
+  return static_cast<T>(value);
+}
+
+// Round and clamp to integer types, plain conversion otherwise.
+template <typename T>
+T toScalar(double value)
+{
+  return toScalar<T>(value, std::is_integral<T>());
+}
+
+// numpy.fft.fftfreq(n)[k]
+double frequency(int k, int n)
+{
+  return (k < (n + 1) / 2 ? k : k - n) / static_cast<double>(n);
+}
+
+bool isWholePixel(const vtkVector2d& shift)
+{
+  return shift[0] == std::floor(shift[0]) && shift[1] == std::floor(shift[1]);
+}
+
+// Moves a slice of width x height pixels of pixelSize bytes by whole pixels.
+// in and out may be the same slice.
+void shiftSlice(const char* in, char* out, int width, int height,
+                size_t pixelSize, int dx, int dy)
+{
+  const size_t rowSize = width * pixelSize;
+  // Columns [begin, end) of every row come from the input, the rest is
+  // cleared after the move so that in place the source is read first.
+  const int begin = std::max(0, std::min(width, dx));
+  const int end = std::max(0, std::min(width, width + dx));
+  // In place, rows moving down are written from the bottom up and the others
+  // from the top down, so no row is overwritten before it is read.
+  const bool bottomUp = dy > 0;
+  for (int i = 0; i < height; ++i) {
+    const int y = bottomUp ? height - 1 - i : i;
+    char* outRow = out + y * rowSize;
+    const int sourceY = y - dy;
+    if (sourceY < 0 || sourceY >= height || begin >= end) {
+      std::memset(outRow, 0, rowSize);
+      continue;
+    }
+    const char* inRow = in + sourceY * rowSize;
+    if (outRow != inRow || dx != 0) {
+      std::memmove(outRow + begin * pixelSize, inRow + (begin - dx) * pixelSize,
+                   (end - begin) * pixelSize);
+    }
+    std::memset(outRow, 0, begin * pixelSize);
+    std::memset(outRow + end * pixelSize, 0, (width - end) * pixelSize);
+  }
+}
+
+// Bilinear interpolation of a slice, in and out must be different slices.
+template <typename T>
+void linearSlice(const T* in, T* out, int width, int height, int components,
+                 const vtkVector2d& shift)
+{
+  const int ix = static_cast<int>(std::floor(shift[0]));
+  const int iy = static_cast<int>(std::floor(shift[1]));
+  const double fx = shift[0] - ix;
+  const double fy = shift[1] - iy;
+  const double wx[2] = { 1 - fx, fx };
+  const double wy[2] = { 1 - fy, fy };
+  const size_t rowLength = static_cast<size_t>(width) * components;
+
+  std::vector<double> row(rowLength);
+  for (int y = 0; y < height; ++y) {
+    std::fill(row.begin(), row.end(), 0.0);
+    for (int b = 0; b < 2; ++b) {
+      const int sourceY = y - iy - b;
+      if (wy[b] == 0 || sourceY < 0 || sourceY >= height) {
+        continue;
+      }
+      const T* inRow = in + sourceY * rowLength;
+      for (int a = 0; a < 2; ++a) {
+        const double weight = wx[a] * wy[b];
+        if (weight == 0) {
+          continue;
+        }
+        // Pixel x of the row comes from pixel x - dx of the input row.
+        const int dx = ix + a;
+        const size_t begin =
+          std::max(0, std::min(width, dx)) * static_cast<size_t>(components);
+        const size_t end = std::max(0, std::min(width, width + dx)) *
+                           static_cast<size_t>(components);
+        const T* source = inRow - static_cast<ptrdiff_t>(dx) * components;
+        for (size_t i = begin; i < end; ++i) {
+          row[i] += weight * source[i];
+        }
+      }
+    }
+    T* outRow = out + y * rowLength;
+    for (size_t i = 0; i < rowLength; ++i) {
+      outRow[i] = toScalar<T>(row[i]);
+    }
+  }
+}
+
+// Shifts a line of n values by shift with a phase ramp, plan.size() is at
+// least n plus the shift so nothing wraps around.
+void fourierLine(Complex* line, const FFTPlan& plan,
+                 const std::vector<Complex>& ramp)
+{
+  plan.forward(line);
+  for (int k = 0; k < plan.size(); ++k) {
+    line[k] *= ramp[k];
+  }
+  plan.inverse(line);
+}
+
+std::vector<Complex> phaseRamp(int n, double shift)
+{
+  std::vector<Complex> ramp(n);
+  for (int k = 0; k < n; ++k) {
+    ramp[k] =
+      std::polar(1.0f, static_cast<float>(-2 * Pi * frequency(k, n) * shift));
+  }
+  return ramp;
+}
+
+// Fourier shift of a slice. The phase ramp is separable, so the rows are
+// shifted along x and then the columns, in blocks, along y, each zero padded
+// to the size of its plan. in and out may be the same slice since each
+// component is read completely before it is written.
+template <typename T>
+void fourierSlice(const T* in, T* out, int width, int height, int components,
+                  const vtkVector2d& shift, const FFTPlan& rowPlan,
+                  const FFTPlan& columnPlan)
+{
+  const int px = rowPlan.size();
+  const int py = columnPlan.size();
+  const auto rampX = phaseRamp(px, shift[0]);
+  const auto rampY = phaseRamp(py, shift[1]);
+
+  std::vector<float> image(static_cast<size_t>(width) * height);
+  std::vector<Complex> row(px);
+  std::vector<Complex> columns(static_cast<size_t>(ColumnBlockSize) * py);
+  for (int c = 0; c < components; ++c) {
+    for (int y = 0; y < height; ++y) {
+      const T* inRow = in + static_cast<size_t>(y) * width * components + c;
+      float* imageRow = image.data() + static_cast<size_t>(y) * width;
+      if (shift[0] == 0) {
+        for (int x = 0; x < width; ++x) {
+          imageRow[x] = static_cast<float>(inRow[x * components]);
+        }
+        continue;
+      }
+      std::fill(row.begin(), row.end(), Complex(0, 0));
+      for (int x = 0; x < width; ++x) {
+        row[x] = Complex(static_cast<float>(inRow[x * components]), 0);
+      }
+      fourierLine(row.data(), rowPlan, rampX);
+      for (int x = 0; x < width; ++x) {
+        imageRow[x] = row[x].real();
+      }
+    }
+
+    for (int x0 = 0; x0 < width; x0 += ColumnBlockSize) {
+      const int block = std::min(ColumnBlockSize, width - x0);
+      std::fill(columns.begin(), columns.end(), Complex(0, 0));
+      for (int y = 0; y < height; ++y) {
+        const float* imageRow = image.data() + static_cast<size_t>(y) * width;
+        for (int b = 0; b < block; ++b) {
+          columns[static_cast<size_t>(b) * py + y] = imageRow[x0 + b];
+        }
+      }
+      if (shift[1] != 0) {
+        for (int b = 0; b < block; ++b) {
+          fourierLine(columns.data() + static_cast<size_t>(b) * py,
+                      columnPlan, rampY);
+        }
+      }
+      for (int y = 0; y < height; ++y) {
+        T* outRow = out + static_cast<size_t>(y) * width * components + c;
+        for (int b = 0; b < block; ++b) {
+          outRow[(x0 + b) * components] =
+            toScalar<T>(columns[static_cast<size_t>(b) * py + y].real());
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void translateSlice(const T* in, T* out, int width, int height,
+                    int components, const vtkVector2d& shift,
+                    Interpolation interpolation, const FFTPlan& rowPlan,
+                    const FFTPlan& columnPlan)
+{
+  const size_t sliceLength = static_cast<size_t>(width) * height * components;
+  if (interpolation == Interpolation::Nearest || isWholePixel(shift)) {
+    shiftSlice(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out),
+               width, height, components * sizeof(T),
+               static_cast<int>(std::lround(shift[0])),
+               static_cast<int>(std::lround(shift[1])));
+  } else if (interpolation == Interpolation::Linear) {
+    if (in == out) {
+      std::vector<T> source(in, in + sliceLength);
+      linearSlice(source.data(), out, width, height, components, shift);
+    } else {
+      linearSlice(in, out, width, height, components, shift);
+    }
+  } else {
+    fourierSlice(in, out, width, height, components, shift, rowPlan,
+                 columnPlan);
+  }
+}
+} // namespace
+
+bool translate(vtkImageData* image, const std::vector<vtkVector2d>& shifts,
+               Interpolation interpolation, bool inPlace,
+               const Progress& progress, int numberOfThreads)
+{
+  auto scalars = image ? image->GetPointData()->GetScalars() : nullptr;
+  if (!scalars) {
+    return false;
+  }
+
+  int dims[3];
+  image->GetDimensions(dims);
+  const int components = scalars->GetNumberOfComponents();
+  const size_t sliceLength =
+    static_cast<size_t>(dims[0]) * dims[1] * components;
+
+  // Anything beyond the size of the image moves the slice out completely,
+  // clamping keeps the pixel arithmetic in range.
+  std::vector<vtkVector2d> clamped(dims[2], vtkVector2d(0, 0));
+  double maxShift[2] = { 0, 0 };
+  for (int z = 0; z < dims[2] && z < static_cast<int>(shifts.size()); ++z) {
+    for (int j = 0; j < 2; ++j) {
+      double limit = dims[j] + 1;
+      clamped[z][j] = std::max(-limit, std::min(limit, shifts[z][j]));
+      maxShift[j] = std::max(maxShift[j], std::abs(clamped[z][j]));
+    }
+  }
+
+  // The Fourier plans are shared by every slice.
+  int rowSize = 1;
+  int columnSize = 1;
+  if (interpolation == Interpolation::Fourier) {
+    rowSize = FFTPlan::nextPowerOfTwo(
+      dims[0] + static_cast<int>(std::ceil(maxShift[0])));
+    columnSize = FFTPlan::nextPowerOfTwo(
+      dims[1] + static_cast<int>(std::ceil(maxShift[1])));
+  }
+  const FFTPlan rowPlan(rowSize);
+  const FFTPlan columnPlan(columnSize);
+
+  vtkSmartPointer<vtkDataArray> result = scalars;
+  if (!inPlace) {
+    result.TakeReference(scalars->NewInstance());
+    result->SetNumberOfComponents(components);
+    result->SetNumberOfTuples(scalars->GetNumberOfTuples());
+    result->SetName(scalars->GetName());
+  }
+
+  auto body = [&](int z) {
+    const vtkVector2d& shift = clamped[z];
+    if (inPlace && shift[0] == 0 && shift[1] == 0) {
+      return;
+    }
+    switch (scalars->GetDataType()) {
+      vtkTemplateMacro(translateSlice(
+        static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)) +
+          sliceLength * z,
+        static_cast<VTK_TT*>(result->GetVoidPointer(0)) + sliceLength * z,
+        dims[0], dims[1], components, shift, interpolation, rowPlan,
+        columnPlan));
+    }
+  };
+  std::function<bool(int, int)> report;
+  if (progress) {
+    const int numberOfSlices = dims[2];
+    report = [&progress, numberOfSlices](int completed, int) {
+      return progress(completed, numberOfSlices);
+    };
+  }
+  if (!parallelFor(0, dims[2], body, report, numberOfThreads)) {
+    return false;
+  }
+
+  if (!inPlace) {
+    image->GetPointData()->RemoveArray(scalars->GetName());
+    image->GetPointData()->SetScalars(result);
+  }
+  return true;
+}
+} // namespace ImageTranslation
+} // namespace tomviz
@@ -0,0 +1,55 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageTranslation_h
+#define tomvizImageTranslation_h
+
+// Moves every z slice of an image by its own shift along x and y, the kernel
+// of TranslateAlignOperator. Slice i moves by shifts[i], so that pixel (x, y)
+// of the result is pixel (x - shifts[i][0], y - shifts[i][1]) of the input.
+// Pixels moved in from outside the image are zero, and slices without a shift
+// are left alone. Every component of the active scalars moves together.
+//
+// Whole pixel shifts copy runs of rows with memmove and clear the rest with
+// memset, so they run at the speed of memory. Slices are processed
+// concurrently. A numberOfThreads less than one uses every core.
+
+#include <vtkVector.h>
+
+#include <functional>
+#include <vector>
+
+class vtkImageData;
+
+namespace tomviz {
+
+namespace ImageTranslation {
+
+enum class Interpolation
+{
+  // Shifts are rounded to whole pixels.
+  Nearest,
+  // Bilinear interpolation between the four nearest pixels.
+  Linear,
+  // Phase ramp applied to the transform of each slice, zero padded so the
+  // edges don't wrap around. Sharper than Linear, but rings at edges.
+  Fourier
+};
+
+// Called with the number of slices moved and the total, on the calling
+// thread. Returning false cancels the translation.
+typedef std::function<bool(int, int)> Progress;
+
+/// Moves the slices of image by shifts. The scalars are overwritten when
+/// inPlace is set, otherwise they are only read and are replaced with a new
+/// array of the same name. Integer results are rounded and clamped to the
+/// range of the type. Returns false if canceled, which may leave some slices
+/// of in place scalars moved.
+bool translate(vtkImageData* image, const std::vector<vtkVector2d>& shifts,
+               Interpolation interpolation = Interpolation::Nearest,
+               bool inPlace = false, const Progress& progress = nullptr,
+               int numberOfThreads = 0);
+} // namespace ImageTranslation
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,515 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "IterativeReconstruction.h"
+
+#include "ParallelUtilities.h"
+#include "TomographyTiltSeries.h"
+
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace tomviz {
+namespace IterativeReconstruction {
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+
+// Neighboring slices updated together, interleaved so that the innermost loops
+// run over the slices of a block with the matrix entry held in a register.
+const int SliceBlockSize = 8;
+
+struct Point
+{
+  double t;
+  double x;
+  double y;
+  bool operator<(const Point& other) const { return t < other.t; }
+};
+
+struct Entry
+{
+  int column;
+  float value;
+};
+
+double removeEpsilon(double value, double epsilon)
+{
+  return std::abs(value) < epsilon ? 0.0 : value;
+}
+
+// The intersections of the ray through (x0, y0) with direction (a, b) with the
+// pixels of an n by n grid of unit pixels centered on the origin, computed the
+// way parallelRay() does: the crossings of the grid lines are sorted along the
+// ray, and each segment between consecutive crossings is a pixel.
+void traceRay(double x0, double y0, double a, double b, int n,
+              std::vector<Point>& points, std::vector<Entry>& entries)
+{
+  const double half = 0.5 * n;
+  auto inside = [half](double v) { return v >= -half && v <= half; };
+
+  points.clear();
+  for (int k = 0; k <= n; ++k) {
+    double grid = k - half;
+    if (a != 0) {
+      double t = (grid - x0) / a;
+      double y = b * t + y0;
+      if (inside(y)) {
+        points.push_back({ t, grid, y });
+      }
+    }
+    if (b != 0) {
+      double t = (grid - y0) / b;
+      double x = a * t + x0;
+      if (inside(x)) {
+        points.push_back({ t, x, grid });
+      }
+    }
+  }
+  std::sort(points.begin(), points.end());
+
+  // Crossings of a grid corner show up twice, keep one of them.
+  size_t count = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (i + 1 < points.size() &&
+        std::abs(points[i + 1].x - points[i].x) <= 1e-8 &&
+        std::abs(points[i + 1].y - points[i].y) <= 1e-8) {
+      continue;
+    }
+    points[count++] = points[i];
+  }
+
+  for (size_t i = 0; i + 1 < count; ++i) {
+    double dx = points[i + 1].x - points[i].x;
+    double dy = points[i + 1].y - points[i].y;
+    double midX = removeEpsilon(0.5 * (points[i].x + points[i + 1].x), 1e-10);
+    double midY = removeEpsilon(0.5 * (points[i].y + points[i + 1].y), 1e-10);
+    int row = static_cast<int>(std::floor(half - midY));
+    int column = static_cast<int>(std::floor(midX + half));
+    // Rays running along the edge of the grid have no pixel on one side.
+    if (row < 0 || row >= n || column < 0 || column >= n) {
+      continue;
+    }
+    entries.push_back(
+      { row * n + column, static_cast<float>(std::sqrt(dx * dx + dy * dy)) });
+  }
+}
+
+// sinograms = A * images for a block of W interleaved slices.
+template <int W>
+void forwardBlock(const Projector& p, const float* images, float* sinograms)
+{
+  const size_t* offsets = p.rowOffsets();
+  const int* columns = p.columns();
+  const float* values = p.values();
+  for (int r = 0; r < p.numberOfRows(); ++r) {
+    float sum[W] = {};
+    for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+      const float v = values[k];
+      const float* x = images + static_cast<size_t>(columns[k]) * W;
+      for (int b = 0; b < W; ++b) {
+        sum[b] += v * x[b];
+      }
+    }
+    for (int b = 0; b < W; ++b) {
+      sinograms[static_cast<size_t>(r) * W + b] = sum[b];
+    }
+  }
+}
+
+// images += scale * A^T * sinograms for a block of W interleaved slices.
+template <int W>
+void backwardBlock(const Projector& p, const float* sinograms, float* images,
+                   float scale)
+{
+  const size_t* offsets = p.rowOffsets();
+  const int* columns = p.columns();
+  const float* values = p.values();
+  for (int r = 0; r < p.numberOfRows(); ++r) {
+    float y[W];
+    for (int b = 0; b < W; ++b) {
+      y[b] = scale * sinograms[static_cast<size_t>(r) * W + b];
+    }
+    for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+      const float v = values[k];
+      float* x = images + static_cast<size_t>(columns[k]) * W;
+      for (int b = 0; b < W; ++b) {
+        x[b] += v * y[b];
+      }
+    }
+  }
+}
+
+// The per row weights M of the SIRT update f += scale * A^T M (b - A f).
+std::vector<float> sirtRowWeights(const Projector& p, Method method)
+{
+  std::vector<float> weights(p.numberOfRows(), 1.0f);
+  if (method == Method::Landweber) {
+    return weights;
+  }
+
+  const size_t* offsets = p.rowOffsets();
+  const int* columns = p.columns();
+  const float* values = p.values();
+  const int* counts = p.columnCounts();
+  for (int r = 0; r < p.numberOfRows(); ++r) {
+    double norm = 0;
+    if (method == Method::Cimmino) {
+      norm = p.rowNorms()[r];
+    } else {
+      for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+        norm += static_cast<double>(values[k]) * values[k] * counts[columns[k]];
+      }
+    }
+    // Rays that miss the grid are left out of the update.
+    weights[r] = norm > 0 ? static_cast<float>(1.0 / norm) : 0.0f;
+  }
+  return weights;
+}
+
+// The state of one block of slices during an iteration.
+class SliceBlock
+{
+public:
+  static const int W = SliceBlockSize;
+
+  SliceBlock(const Projector& projector, const Options& options,
+             const std::vector<float>& rowWeights)
+    : m_projector(projector), m_options(options), m_rowWeights(rowWeights),
+      m_images(static_cast<size_t>(W) * projector.numberOfColumns()),
+      m_sinograms(static_cast<size_t>(W) * projector.numberOfRows())
+  {
+  }
+
+  // Gather the current estimate of the slices [first, first + count) from
+  // the volume, zero on the first iteration.
+  void load(const float* recon, int xDim, int first, int count, bool zero)
+  {
+    std::fill(m_images.begin(), m_images.end(), 0.0f);
+    if (zero) {
+      return;
+    }
+    for (int i = 0; i < m_projector.numberOfColumns(); ++i) {
+      std::copy(recon + voxel(i, xDim) + first,
+                recon + voxel(i, xDim) + first + count,
+                m_images.begin() + static_cast<size_t>(i) * W);
+    }
+  }
+
+  void store(float* recon, int xDim, int first, int count) const
+  {
+    for (int i = 0; i < m_projector.numberOfColumns(); ++i) {
+      const float* x = m_images.data() + static_cast<size_t>(i) * W;
+      float* out = recon + voxel(i, xDim) + first;
+      for (int b = 0; b < count; ++b) {
+        out[b] = m_options.positivity ? std::max(x[b], 0.0f) : x[b];
+      }
+    }
+  }
+
+  // The measured sinograms, b.
+  float* measurements() { return m_sinograms.data(); }
+
+  void update()
+  {
+    switch (m_options.method) {
+      case Method::ART:
+        updateART();
+        break;
+      case Method::SART:
+        updateSART();
+        break;
+      default:
+        updateSIRT();
+        break;
+    }
+  }
+
+private:
+  // Column i is pixel (iy, iz) = (i / n, i % n) of the slice, which sits at
+  // (iz * n + iy) * xDim + slice in the volume.
+  size_t voxel(int i, int xDim) const
+  {
+    int n = m_projector.numberOfRays();
+    return (static_cast<size_t>(i % n) * n + i / n) * xDim;
+  }
+
+  void updateSIRT()
+  {
+    std::vector<float> projections(m_sinograms.size());
+    forwardBlock<W>(m_projector, m_images.data(), projections.data());
+    for (size_t i = 0; i < projections.size(); ++i) {
+      projections[i] = (m_sinograms[i] - projections[i]) * m_rowWeights[i / W];
+    }
+    double scale = m_options.stepSize;
+    if (m_options.method == Method::Cimmino) {
+      scale /= m_projector.numberOfRows();
+    }
+    backwardBlock<W>(m_projector, projections.data(), m_images.data(),
+                     static_cast<float>(scale));
+  }
+
+  // Kaczmarz sweep, the image is updated after every row.
+  void updateART()
+  {
+    const size_t* offsets = m_projector.rowOffsets();
+    const int* columns = m_projector.columns();
+    const float* values = m_projector.values();
+    const float* norms = m_projector.rowNorms();
+    const float beta = static_cast<float>(m_options.relaxation);
+    for (int r = 0; r < m_projector.numberOfRows(); ++r) {
+      if (norms[r] <= 0) {
+        continue;
+      }
+      float a[W] = {};
+      for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+        const float v = values[k];
+        const float* x = m_images.data() + static_cast<size_t>(columns[k]) * W;
+        for (int b = 0; b < W; ++b) {
+          a[b] += v * x[b];
+        }
+      }
+      const float* measured = m_sinograms.data() + static_cast<size_t>(r) * W;
+      for (int b = 0; b < W; ++b) {
+        a[b] = beta * (measured[b] - a[b]) / norms[r];
+      }
+      for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+        const float v = values[k];
+        float* x = m_images.data() + static_cast<size_t>(columns[k]) * W;
+        for (int b = 0; b < W; ++b) {
+          x[b] += v * a[b];
+        }
+      }
+    }
+  }
+
+  // Simultaneous ART, the image is updated after every projection with the
+  // residuals of its rays, normalized by the row and column sums.
+  void updateSART()
+  {
+    const size_t* offsets = m_projector.rowOffsets();
+    const int* columns = m_projector.columns();
+    const float* values = m_projector.values();
+    const float* rowSums = m_projector.rowSums();
+    const float beta = static_cast<float>(m_options.relaxation);
+    const int n = m_projector.numberOfRays();
+    std::vector<float> corrections(m_images.size(), 0.0f);
+    std::vector<float> columnSums(m_projector.numberOfColumns(), 0.0f);
+    for (int tilt = 0; tilt < m_projector.numberOfTilts(); ++tilt) {
+      for (int r = tilt * n; r < (tilt + 1) * n; ++r) {
+        if (rowSums[r] <= 0) {
+          continue;
+        }
+        float residual[W] = {};
+        for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+          const float v = values[k];
+          const float* x =
+            m_images.data() + static_cast<size_t>(columns[k]) * W;
+          for (int b = 0; b < W; ++b) {
+            residual[b] += v * x[b];
+          }
+        }
+        const float* measured =
+          m_sinograms.data() + static_cast<size_t>(r) * W;
+        for (int b = 0; b < W; ++b) {
+          residual[b] = (measured[b] - residual[b]) / rowSums[r];
+        }
+        for (size_t k = offsets[r]; k < offsets[r + 1]; ++k) {
+          const float v = values[k];
+          float* c = corrections.data() + static_cast<size_t>(columns[k]) * W;
+          for (int b = 0; b < W; ++b) {
+            c[b] += v * residual[b];
+          }
+          columnSums[columns[k]] += v;
+        }
+      }
+
+      // Apply the corrections to the pixels this projection touched, and
+      // clear them for the next one.
+      for (size_t k = offsets[tilt * n]; k < offsets[(tilt + 1) * n]; ++k) {
+        int column = columns[k];
+        if (columnSums[column] == 0) {
+          continue;
+        }
+        const float scale = beta / columnSums[column];
+        float* c = corrections.data() + static_cast<size_t>(column) * W;
+        float* x = m_images.data() + static_cast<size_t>(column) * W;
+        for (int b = 0; b < W; ++b) {
+          x[b] += scale * c[b];
+          c[b] = 0;
+        }
+        columnSums[column] = 0;
+      }
+    }
+  }
+
+  const Projector& m_projector;
+  const Options& m_options;
+  const std::vector<float>& m_rowWeights;
+  std::vector<float> m_images;
+  std::vector<float> m_sinograms;
+};
+
+} // namespace
+
+Projector::Projector(const double* tiltAngles, int numberOfTilts,
+                     int numberOfRays, int numberOfThreads)
+  : m_numberOfTilts(numberOfTilts), m_numberOfRays(numberOfRays)
+{
+  const int n = numberOfRays;
+
+  // The projections are traced in parallel, each into its own rows.
+  std::vector<std::vector<Entry>> entries(numberOfTilts);
+  std::vector<std::vector<size_t>> rowEnds(numberOfTilts);
+  auto body = [&](int tilt) {
+    double angle = tiltAngles[tilt] * Pi / 180;
+    double a = removeEpsilon(-std::sin(angle), 1e-10);
+    double b = removeEpsilon(std::cos(angle), 1e-10);
+    std::vector<Point> points;
+    points.reserve(2 * (n + 1));
+    entries[tilt].reserve(2 * static_cast<size_t>(n) * n);
+    rowEnds[tilt].resize(n);
+    for (int ray = 0; ray < n; ++ray) {
+      double offset = ray - 0.5 * (n - 1);
+      double x0 = removeEpsilon(std::cos(angle) * offset, 1e-8);
+      double y0 = removeEpsilon(std::sin(angle) * offset, 1e-8);
+      traceRay(x0, y0, a, b, n, points, entries[tilt]);
+      rowEnds[tilt][ray] = entries[tilt].size();
+    }
+  };
+  parallelFor(0, numberOfTilts, body, nullptr, numberOfThreads);
+
+  size_t nonZeros = 0;
+  for (auto& tiltEntries : entries) {
+    nonZeros += tiltEntries.size();
+  }
+  m_rowOffsets.resize(static_cast<size_t>(numberOfRows()) + 1);
+  m_columns.resize(nonZeros);
+  m_values.resize(nonZeros);
+  m_rowNorms.resize(numberOfRows());
+  m_rowSums.resize(numberOfRows());
+  m_columnCounts.assign(numberOfColumns(), 0);
+
+  size_t k = 0;
+  m_rowOffsets[0] = 0;
+  for (int tilt = 0; tilt < numberOfTilts; ++tilt) {
+    size_t begin = 0;
+    for (int ray = 0; ray < n; ++ray) {
+      int r = tilt * n + ray;
+      double norm = 0;
+      double sum = 0;
+      for (size_t e = begin; e < rowEnds[tilt][ray]; ++e, ++k) {
+        const Entry& entry = entries[tilt][e];
+        m_columns[k] = entry.column;
+        m_values[k] = entry.value;
+        norm += static_cast<double>(entry.value) * entry.value;
+        sum += entry.value;
+        ++m_columnCounts[entry.column];
+      }
+      begin = rowEnds[tilt][ray];
+      m_rowOffsets[r + 1] = k;
+      m_rowNorms[r] = static_cast<float>(norm);
+      m_rowSums[r] = static_cast<float>(sum);
+    }
+    std::vector<Entry>().swap(entries[tilt]);
+  }
+}
+
+void Projector::forward(const float* image, float* sinogram) const
+{
+  forwardBlock<1>(*this, image, sinogram);
+}
+
+void Projector::backward(const float* sinogram, float* image) const
+{
+  std::fill(image, image + numberOfColumns(), 0.0f);
+  backwardBlock<1>(*this, sinogram, image, 1.0f);
+}
+
+bool reconstruct(vtkImageData* tiltSeries, const double* tiltAngles,
+                 float* recon, const Options& options,
+                 const Progress& progress, int numberOfThreads)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1; // number of slices
+  int yDim = extents[3] - extents[2] + 1; // number of rays
+  int zDim = extents[5] - extents[4] + 1; // number of tilts
+
+  TomographyTiltSeries::SinogramExtractor extractor(tiltSeries);
+  Projector projector(tiltAngles, zDim, yDim, numberOfThreads);
+  std::vector<float> rowWeights = sirtRowWeights(projector, options.method);
+
+  // Negative measurements are shifted by the minimum, like Recon_ART/SIRT.
+  double range[2];
+  tiltSeries->GetPointData()->GetScalars()->GetRange(range, 0);
+  float shift = range[0] < 0 ? static_cast<float>(-range[0]) : 0.0f;
+
+  int iteration = 0;
+  int numBlocks = (xDim + SliceBlockSize - 1) / SliceBlockSize;
+  auto body = [&](int block) {
+    int first = block * SliceBlockSize;
+    int count = std::min(SliceBlockSize, xDim - first);
+    SliceBlock sliceBlock(projector, options, rowWeights);
+    float* measured = sliceBlock.measurements();
+    extractor.sinograms(first, count, measured, SliceBlockSize);
+    if (shift != 0) {
+      for (int r = 0; r < projector.numberOfRows(); ++r) {
+        for (int b = 0; b < count; ++b) {
+          measured[r * SliceBlockSize + b] += shift;
+        }
+      }
+    }
+    sliceBlock.load(recon, xDim, first, count, iteration == 0);
+    sliceBlock.update();
+    sliceBlock.store(recon, xDim, first, count);
+  };
+
+  int slicesCompleted = 0;
+  std::function<bool(int, int)> blockProgress;
+  if (progress) {
+    blockProgress = [&](int, int block) {
+      int firstSlice = block * SliceBlockSize;
+      int lastSlice = std::min(firstSlice + SliceBlockSize, xDim) - 1;
+      slicesCompleted += lastSlice - firstSlice + 1;
+      return progress(slicesCompleted, lastSlice);
+    };
+  }
+
+  for (; iteration < options.iterations; ++iteration) {
+    if (!parallelFor(0, numBlocks, body, blockProgress, numberOfThreads)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool reconstruct3(vtkImageData* tiltSeries, vtkImageData* recon,
+                  const Options& options, int numberOfThreads)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1;
+  int yDim = extents[3] - extents[2] + 1;
+
+  vtkDataArray* tiltAnglesArray =
+    tiltSeries->GetFieldData()->GetArray("tilt_angles");
+  std::vector<double> tiltAngles(tiltAnglesArray->GetNumberOfTuples());
+  for (size_t i = 0; i < tiltAngles.size(); ++i) {
+    tiltAngles[i] = tiltAnglesArray->GetTuple1(i);
+  }
+
+  recon->SetExtent(0, xDim - 1, 0, yDim - 1, 0, yDim - 1);
+  recon->AllocateScalars(VTK_FLOAT, 1);
+  auto reconPtr = static_cast<float*>(recon->GetScalarPointer());
+  return reconstruct(tiltSeries, tiltAngles.data(), reconPtr, options,
+                     nullptr, numberOfThreads);
+}
+} // namespace IterativeReconstruction
+} // namespace tomviz
@@ -0,0 +1,118 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizIterativeReconstruction_h
+#define tomvizIterativeReconstruction_h
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class vtkImageData;
+
+namespace tomviz {
+
+namespace IterativeReconstruction {
+
+// The iterative methods of the Python Recon_ART and Recon_SIRT operators,
+// plus SART. The first three are the SIRT update methods, in the order of the
+// "updateMethodIndex" enumeration of Recon_SIRT.
+enum class Method
+{
+  Landweber,
+  Cimmino,
+  ComponentAveraging,
+  ART,
+  SART
+};
+
+struct Options
+{
+  Method method = Method::Landweber;
+  int iterations = 10;
+  // Step size of the SIRT updates (Landweber, Cimmino, ComponentAveraging).
+  double stepSize = 0.0001;
+  // Relaxation factor of the ART and SART updates.
+  double relaxation = 1.0;
+  // Clamp negative values to zero after every iteration.
+  bool positivity = true;
+};
+
+// The parallel beam measurement matrix of a tilt series, the C++ counterpart
+// of parallelRay() in Recon_ART.py and Recon_SIRT.py. Row tilt * numberOfRays
+// + ray holds the lengths of that ray through the pixels of a numberOfRays by
+// numberOfRays slice, and pixel (iy, iz) of the slice is column
+// iy * numberOfRays + iz, matching the slices of weightedBackProjection3.
+//
+// The matrix is stored in compressed sparse row form. It only depends on the
+// tilt angles, so one projector is built for a tilt series and shared by every
+// slice and every thread.
+class Projector
+{
+public:
+  Projector(const double* tiltAngles, int numberOfTilts, int numberOfRays,
+            int numberOfThreads = 0);
+
+  int numberOfTilts() const { return m_numberOfTilts; }
+  int numberOfRays() const { return m_numberOfRays; }
+  int numberOfRows() const { return m_numberOfTilts * m_numberOfRays; }
+  int numberOfColumns() const { return m_numberOfRays * m_numberOfRays; }
+  size_t numberOfNonZeros() const { return m_values.size(); }
+
+  // The entries of row r are [rowOffsets()[r], rowOffsets()[r + 1]).
+  const size_t* rowOffsets() const { return m_rowOffsets.data(); }
+  const int* columns() const { return m_columns.data(); }
+  const float* values() const { return m_values.data(); }
+
+  // Sum of the squared entries of each row.
+  const float* rowNorms() const { return m_rowNorms.data(); }
+  // Sum of the entries of each row.
+  const float* rowSums() const { return m_rowSums.data(); }
+  // Number of non zero entries in each column.
+  const int* columnCounts() const { return m_columnCounts.data(); }
+
+  // sinogram = A * image
+  void forward(const float* image, float* sinogram) const;
+  // image = A^T * sinogram
+  void backward(const float* sinogram, float* image) const;
+
+private:
+  int m_numberOfTilts;
+  int m_numberOfRays;
+  std::vector<size_t> m_rowOffsets;
+  std::vector<int> m_columns;
+  std::vector<float> m_values;
+  std::vector<float> m_rowNorms;
+  std::vector<float> m_rowSums;
+  std::vector<int> m_columnCounts;
+};
+
+// Progress callback of the reconstruction, invoked on the calling thread with
+// the number of slice updates completed so far, out of iterations times the
+// number of slices, and the index of the most recently updated slice. When the
+// count is a multiple of the number of slices an iteration has just finished
+// and recon holds its result. Returning false cancels the reconstruction.
+typedef std::function<bool(int, int)> Progress;
+
+// Reconstruct a tilt series, with the tilt axis along x, using an iterative
+// method. The tilt series is read in its native scalar type through a
+// TomographyTiltSeries::SinogramExtractor and, like the Python operators,
+// shifted to be non negative. Blocks of neighboring slices are distributed
+// over numberOfThreads threads (every core if less than one), and the slices
+// of a block are updated together so each matrix entry is loaded once per
+// block. The reconstruction starts from zero and is written to recon, which
+// must hold xDim * yDim * yDim floats laid out like the output of
+// TomographyReconstruction::weightedBackProjection3. Returns false if
+// canceled.
+bool reconstruct(vtkImageData* tiltSeries, const double* tiltAngles,
+                 float* recon, const Options& options,
+                 const Progress& progress = nullptr, int numberOfThreads = 0);
+
+// Convenience overload that takes the angles from the "tilt_angles" field
+// data and allocates the reconstruction in recon.
+bool reconstruct3(vtkImageData* tiltSeries, vtkImageData* recon,
+                  const Options& options, int numberOfThreads = 0);
+} // namespace IterativeReconstruction
+} // namespace tomviz
+
+#endif
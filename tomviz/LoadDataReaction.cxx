@@ -21,6 +21,7 @@
 #include "PythonUtilities.h"
 #include "RAWFileReaderDialog.h"
 #include "RecentFilesMenu.h"
+#include "TiffStackReader.h"
 #include "Utilities.h"
 #include "vtkOMETiffReader.h"
 
@@ -194,6 +195,17 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     fileName = fileNames[0];
   }
   QFileInfo info(fileName);
+
+  // Stacks of TIFF images are decoded concurrently. If that fails for any
+  // reason, they are left to ParaView's TIFF series reader.
+  vtkSmartPointer<vtkImageData> tiffStack;
+  if (TiffStackReader::isTiffStack(fileNames)) {
+    tiffStack = vtkSmartPointer<vtkImageData>::New();
+    if (!TiffStackReader::read(fileNames, tiffStack)) {
+      tiffStack = nullptr;
+    }
+  }
+
   if (info.suffix().toLower() == "tvh5") {
     // Need to specify a path inside the tvh5 file to load
     QString path = options["tvh5NodePath"].toString();
@@ -229,6 +241,11 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
         options["subsampleSettings"].toObject()["volumeBounds"].toVariant();
       emdOptions["askForSubsample"] = false;
     }
+    if (options.contains("pyramidLevel")) {
+      // Start with a coarser level of the pyramid stored with the data
+      emdOptions["pyramidLevel"] = options["pyramidLevel"].toInt();
+      emdOptions["askForSubsample"] = false;
+    }
     if (EmdFormat::read(fileName.toLatin1().data(), imageData, emdOptions)) {
       DataSource::DataSourceType type = DataSource::hasTiltAngles(imageData)
                                           ? DataSource::TiltSeries
@@ -286,6 +303,16 @@ DataSource* LoadDataReaction::loadData(const QStringList& fileNames,
     readerProperties["name"] = "OMETIFFReader";
     dataSource->setReaderProperties(readerProperties.toVariantMap());
     LoadDataReaction::dataSourceAdded(dataSource, defaultModules, child);
+  } else if (tiffStack) {
+    loadWithParaview = false;
+    dataSource = new DataSource(tiffStack);
+    // Record the stack as ParaView's reader would, so the state can be
+    // restored with either.
+    QJsonObject readerProperties;
+    readerProperties["name"] = "TIFFSeriesReader";
+    readerProperties["fileNames"] = QJsonArray::fromStringList(fileNames);
+    dataSource->setReaderProperties(readerProperties.toVariantMap());
+    LoadDataReaction::dataSourceAdded(dataSource, defaultModules, child);
   } else if (FileFormatManager::instance().pythonReaderFactory(
                info.suffix().toLower()) != nullptr) {
     loadWithParaview = false;
@@ -7,12 +7,9 @@
 #include "ImageStackDialog.h"
 #include "LoadDataReaction.h"
 #include "SetTiltAnglesOperator.h"
+#include "TiffStackReader.h"
 #include "Utilities.h"
 
-#include <vtkImageData.h>
-#include <vtkNew.h>
-#include <vtkTIFFReader.h>
-
 namespace tomviz {
 
 LoadStackReaction::LoadStackReaction(QAction* parentObject)
@@ -92,27 +89,13 @@ QStringList LoadStackReaction::summaryToFileNames(
 QList<ImageInfo> LoadStackReaction::loadTiffStack(const QStringList& fileNames)
 {
   QList<ImageInfo> summary;
-  vtkNew<vtkTIFFReader> reader;
-  int n = -1;
-  int m = -1;
-  int dims[3];
-  int i = -1;
-  bool consistent;
-  foreach (QString file, fileNames) {
-    i++;
-    consistent = true;
-    reader->SetFileName(file.toLatin1().data());
-    reader->Update();
-    reader->GetOutput()->GetDimensions(dims);
-    if (n == -1 && m == -1) {
-      n = dims[0];
-      m = dims[1];
-    } else {
-      if (n != dims[0] || m != dims[1]) {
-        consistent = false;
-      }
-    }
-    summary.push_back(ImageInfo(file, 0, dims[0], dims[1], consistent));
+  // Only the tags of each file are needed for the summary.
+  auto headers = TiffStackReader::readHeaders(fileNames);
+  for (int i = 0; i < fileNames.size(); ++i) {
+    bool consistent = headers[i].width == headers[0].width &&
+                      headers[i].height == headers[0].height;
+    summary.push_back(ImageInfo(fileNames[i], 0, headers[i].width,
+                                headers[i].height, consistent));
   }
   return summary;
 }
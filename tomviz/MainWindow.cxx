@@ -28,6 +28,7 @@
 #include "DataPropertiesPanel.h"
 #include "DataTransformMenu.h"
 #include "FileFormatManager.h"
+#include "ImageFilterReaction.h"
 #include "LoadDataReaction.h"
 #include "LoadPaletteReaction.h"
 #include "LoadStackReaction.h"
@@ -316,7 +317,9 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   QAction* reconWBPAction =
     m_ui->menuTomography->addAction("Weighted Back Projection");
   QAction* reconWBP_CAction =
-    m_ui->menuTomography->addAction("Simple Back Projection (C++)");
+    m_ui->menuTomography->addAction("Back Projection (C++)");
+  QAction* reconIterativeAction =
+    m_ui->menuTomography->addAction("Iterative Reconstruction (C++)");
   QAction* reconARTAction =
     m_ui->menuTomography->addAction("Algebraic Reconstruction Technique (ART)");
   QAction* reconSIRTAction = m_ui->menuTomography->addAction(
@@ -372,9 +375,8 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
   new AddPythonTransformReaction(normalizationAction, "Normalize Tilt Series",
                                  readInPythonScript("NormalizeTiltSeries"),
                                  false, false, false);
-  new AddPythonTransformReaction(
-    gradientMagnitude2DSobelAction, "Gradient Magnitude 2D",
-    readInPythonScript("GradientMagnitude2D_Sobel"), false, false, false);
+  new ImageFilterReaction(gradientMagnitude2DSobelAction,
+                          "GradientMagnitude2DSobel", this);
   new AddPythonTransformReaction(
     rotateAlignAction, "Tilt Axis Alignment (manual)",
     readInPythonScript("RotationAlign"), true, false, false,
@@ -387,10 +389,7 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
     autoRotateAlignShiftAction, "Auto Tilt Axis Shift Align",
     readInPythonScript("AutoTiltAxisShiftAlignment"), true);
 
-  new AddPythonTransformReaction(
-    autoAlignCCAction, "Auto Tilt Image Align (XCORR)",
-    readInPythonScript("AutoCrossCorrelationTiltImageAlignment"), false, false,
-    false, readInJSONDescription("AutoCrossCorrelationTiltImageAlignment"));
+  new AddAlignReaction(autoAlignCCAction, true);
   new AddPythonTransformReaction(
     autoAlignCOMAction, "Auto Tilt Image Align (CoM)",
     readInPythonScript("AutoCenterOfMassTiltImageAlignment"), false, false,
@@ -422,6 +421,8 @@ MainWindow::MainWindow(QWidget* parent, Qt::WindowFlags flags)
     readInJSONDescription("Recon_tomopy_gridrec"));
 
   new ReconstructionReaction(reconWBP_CAction);
+  new ReconstructionReaction(reconIterativeAction,
+                             ReconstructionReaction::Algorithm::Iterative);
 
   new AddPythonTransformReaction(
     randomShiftsAction, "Shift Tilt Series Randomly",
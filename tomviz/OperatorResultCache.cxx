@@ -0,0 +1,287 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "OperatorResultCache.h"
+
+#include "Operator.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QtConcurrent>
+
+#include <vtkFieldData.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkXMLImageDataReader.h>
+#include <vtkXMLImageDataWriter.h>
+
+namespace tomviz {
+
+OperatorResultCache::OperatorResultCache()
+{
+  m_writePool.setMaxThreadCount(1);
+}
+
+OperatorResultCache::~OperatorResultCache()
+{
+  clear();
+  // The writes in progress discard their files, as the cache is cleared.
+  m_writePool.waitForDone();
+}
+
+void OperatorResultCache::setMemoryBudget(qint64 bytes)
+{
+  QList<PendingWrite> writes;
+  {
+    QMutexLocker lock(&m_mutex);
+    m_memoryBudget = bytes;
+    writes = evict();
+  }
+  writeToDisk(writes);
+}
+
+void OperatorResultCache::setDiskBudget(qint64 bytes)
+{
+  QList<PendingWrite> writes;
+  {
+    QMutexLocker lock(&m_mutex);
+    m_diskBudget = bytes;
+    writes = evict();
+  }
+  writeToDisk(writes);
+}
+
+bool OperatorResultCache::isEnabled() const
+{
+  return m_memoryBudget > 0 || m_diskBudget > 0;
+}
+
+QList<QByteArray> OperatorResultCache::chainKeys(
+  vtkDataObject* input, const QList<Operator*>& operators, int start, int end)
+{
+  QList<QByteArray> keys;
+  if (input == nullptr) {
+    return keys;
+  }
+
+  // The input is identified by the object and its modification time, each
+  // operator by its serialized parameters.
+  QByteArray chain = QString("%1:%2")
+                       .arg(reinterpret_cast<quintptr>(input))
+                       .arg(input->GetMTime())
+                       .toLatin1();
+  for (int i = start; i < end; ++i) {
+    auto json = operators[i]->serialize();
+    // The child data sources (and their modules) and the id don't affect the
+    // output of the operator.
+    json.remove("dataSources");
+    json.remove("id");
+    chain += QJsonDocument(json).toJson(QJsonDocument::Compact);
+    keys.append(QCryptographicHash::hash(chain, QCryptographicHash::Sha1));
+  }
+
+  return keys;
+}
+
+vtkSmartPointer<vtkImageData> OperatorResultCache::find(const QByteArray& key)
+{
+  QString fileName;
+  QSharedPointer<QTemporaryDir> directory;
+  {
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+      return nullptr;
+    }
+    it->lastUsed = ++m_clock;
+    if (it->data) {
+      return it->data;
+    }
+    fileName = it->fileName;
+    directory = m_directory;
+  }
+
+  vtkNew<vtkXMLImageDataReader> reader;
+  reader->SetFileName(fileName.toLocal8Bit().data());
+  reader->Update();
+  vtkSmartPointer<vtkImageData> data = reader->GetOutput();
+  if (data == nullptr || data->GetNumberOfPoints() == 0) {
+    // The file is gone or unreadable, forget about it.
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->fileName == fileName) {
+      QFile::remove(fileName);
+      m_entries.erase(it);
+    }
+    return nullptr;
+  }
+
+  return data;
+}
+
+void OperatorResultCache::insert(const QByteArray& key, vtkDataObject* data)
+{
+  auto image = vtkImageData::SafeDownCast(data);
+  if (image == nullptr) {
+    return;
+  }
+
+  qint64 size = static_cast<qint64>(image->GetActualMemorySize()) * 1024;
+  Entry entry;
+  // The arrays are shared rather than copied, the worker copies them before
+  // an operator modifies them in place. The field data is small and often
+  // edited in place, so it is always copied.
+  entry.data = vtkSmartPointer<vtkImageData>::New();
+  entry.data->ShallowCopy(image);
+  entry.data->GetFieldData()->DeepCopy(image->GetFieldData());
+  entry.size = size;
+
+  QList<PendingWrite> writes;
+  {
+    QMutexLocker lock(&m_mutex);
+    if (m_entries.contains(key) ||
+        (size > m_memoryBudget && size > m_diskBudget)) {
+      return;
+    }
+    entry.lastUsed = ++m_clock;
+    m_entries[key] = entry;
+    writes = evict();
+  }
+  writeToDisk(writes);
+}
+
+void OperatorResultCache::clear()
+{
+  QMutexLocker lock(&m_mutex);
+  m_entries.clear();
+  m_directory.reset();
+}
+
+QList<OperatorResultCache::PendingWrite> OperatorResultCache::evict()
+{
+  QList<PendingWrite> writes;
+  while (memoryUsed() > m_memoryBudget) {
+    auto oldest = m_entries.end();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+      if (it->data && !it->writing &&
+          (oldest == m_entries.end() || it->lastUsed < oldest->lastUsed)) {
+        oldest = it;
+      }
+    }
+    if (oldest->size <= m_diskBudget) {
+      oldest->writing = true;
+      writes.append({ oldest.key(), oldest->data });
+    } else {
+      m_entries.erase(oldest);
+    }
+  }
+
+  // Entries still being written count against the disk budget, dropping one
+  // discards its file once it is written.
+  while (diskUsed() > m_diskBudget) {
+    auto oldest = m_entries.end();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+      if ((!it->data || it->writing) &&
+          (oldest == m_entries.end() || it->lastUsed < oldest->lastUsed)) {
+        oldest = it;
+      }
+    }
+    if (!oldest->writing) {
+      QFile::remove(oldest->fileName);
+    }
+    m_entries.erase(oldest);
+  }
+
+  return writes;
+}
+
+qint64 OperatorResultCache::memoryUsed() const
+{
+  qint64 used = 0;
+  foreach (const Entry& entry, m_entries) {
+    if (entry.data && !entry.writing) {
+      used += entry.size;
+    }
+  }
+  return used;
+}
+
+qint64 OperatorResultCache::diskUsed() const
+{
+  qint64 used = 0;
+  foreach (const Entry& entry, m_entries) {
+    if (!entry.data || entry.writing) {
+      used += entry.size;
+    }
+  }
+  return used;
+}
+
+void OperatorResultCache::writeToDisk(const QList<PendingWrite>& writes)
+{
+  if (writes.isEmpty()) {
+    return;
+  }
+
+  QtConcurrent::run(&m_writePool, [this, writes]() { write(writes); });
+}
+
+void OperatorResultCache::write(const QList<PendingWrite>& writes)
+{
+  QSharedPointer<QTemporaryDir> directory;
+  int firstFile;
+  {
+    QMutexLocker lock(&m_mutex);
+    if (m_directory.isNull()) {
+      m_directory.reset(new QTemporaryDir());
+    }
+    directory = m_directory;
+    firstFile = m_fileCount;
+    m_fileCount += writes.size();
+  }
+
+  for (int i = 0; i < writes.size(); ++i) {
+    // Raw appended data, without compression, is the fastest to write and
+    // read back.
+    QString fileName;
+    if (directory->isValid()) {
+      fileName = QDir(directory->path())
+                   .filePath(QString("result%1.vti").arg(firstFile + i));
+      vtkNew<vtkXMLImageDataWriter> writer;
+      writer->SetFileName(fileName.toLocal8Bit().data());
+      writer->SetInputData(writes[i].data);
+      writer->SetDataModeToAppended();
+      writer->EncodeAppendedDataOff();
+      writer->SetCompressorTypeToNone();
+      if (writer->Write() != 1) {
+        QFile::remove(fileName);
+        fileName.clear();
+      }
+    }
+
+    // The entry may have been dropped, or the cache cleared, meanwhile.
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.find(writes[i].key);
+    bool current = it != m_entries.end() && it->writing &&
+                   it->data == writes[i].data && directory == m_directory;
+    if (!current) {
+      if (!fileName.isEmpty()) {
+        QFile::remove(fileName);
+      }
+      continue;
+    }
+    if (fileName.isEmpty()) {
+      m_entries.erase(it);
+      continue;
+    }
+    it->fileName = fileName;
+    it->data = nullptr;
+    it->writing = false;
+  }
+}
+
+} // namespace tomviz
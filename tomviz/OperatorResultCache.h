@@ -0,0 +1,108 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizOperatorResultCache_h
+#define tomvizOperatorResultCache_h
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QThreadPool>
+
+#include <vtkSmartPointer.h>
+
+class vtkDataObject;
+class vtkImageData;
+
+namespace tomviz {
+class Operator;
+
+///
+/// Keeps copies of the data produced by operators in a pipeline so that, when
+/// an operator is modified, execution can resume from the output of the
+/// operator before it rather than rerunning the whole chain. Results are keyed
+/// on the input data and the serialized operators that produced them, so any
+/// change upstream naturally misses the cache.
+///
+/// Results are held in memory up to a budget, the least recently used ones are
+/// then moved to disk up to a second budget, and dropped after that. Results
+/// are inserted from the pipeline's worker thread, everything else happens on
+/// the GUI thread. Files are written and read without holding the lock, so
+/// neither thread waits on the other's disk access.
+///
+class OperatorResultCache
+{
+public:
+  OperatorResultCache();
+  ~OperatorResultCache();
+
+  /// Budgets in bytes, a budget of zero disables that level of the cache.
+  void setMemoryBudget(qint64 bytes);
+  void setDiskBudget(qint64 bytes);
+  bool isEnabled() const;
+
+  /// Returns the keys for the outputs of operators[start], operators[start +
+  /// 1], ... when the chain is applied to input. Must be called on the GUI
+  /// thread as it serializes the operators.
+  static QList<QByteArray> chainKeys(vtkDataObject* input,
+                                     const QList<Operator*>& operators,
+                                     int start, int end);
+
+  /// Returns the cached result for key, or nullptr. The result is shared with
+  /// the cache and must be copied before it is modified.
+  vtkSmartPointer<vtkImageData> find(const QByteArray& key);
+
+  /// Stores a shallow copy of data under key, if it fits in the budgets. The
+  /// point data arrays are shared with data and must not be modified after
+  /// this, PipelineWorker copies arrays referenced elsewhere before an
+  /// operator modifies them in place.
+  void insert(const QByteArray& key, vtkDataObject* data);
+
+  void clear();
+
+private:
+  struct Entry
+  {
+    vtkSmartPointer<vtkImageData> data;
+    QString fileName;
+    qint64 size = 0;
+    quint64 lastUsed = 0;
+    /// Being written to disk, data is kept until the file is complete.
+    bool writing = false;
+  };
+
+  struct PendingWrite
+  {
+    QByteArray key;
+    vtkSmartPointer<vtkImageData> data;
+  };
+
+  /// Drop the least recently used entries, or mark them to be moved to disk,
+  /// until the cache is within its budgets. Called with m_mutex locked, the
+  /// returned entries are then passed to writeToDisk() once it is unlocked.
+  QList<PendingWrite> evict();
+  qint64 memoryUsed() const;
+  qint64 diskUsed() const;
+  /// Queues the writes on m_writePool, the entries keep their data until then.
+  void writeToDisk(const QList<PendingWrite>& writes);
+  void write(const QList<PendingWrite>& writes);
+
+  QMutex m_mutex;
+  QMap<QByteArray, Entry> m_entries;
+  /// Shared with any write or read in progress, so the files aren't removed
+  /// under them when the cache is cleared.
+  QSharedPointer<QTemporaryDir> m_directory;
+  qint64 m_memoryBudget = 0;
+  qint64 m_diskBudget = 0;
+  quint64 m_clock = 0;
+  int m_fileCount = 0;
+  /// A single thread, so spilled results are written one at a time.
+  QThreadPool m_writePool;
+};
+
+} // namespace tomviz
+
+#endif
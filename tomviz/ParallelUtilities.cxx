@@ -0,0 +1,93 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ParallelUtilities.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace tomviz {
+
+int parallelThreadCount(int numberOfThreads)
+{
+  if (numberOfThreads > 0) {
+    return numberOfThreads;
+  }
+  return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+}
+
+bool parallelFor(int begin, int end, const std::function<void(int)>& body,
+                 const std::function<bool(int, int)>& progress,
+                 int numberOfThreads)
+{
+  if (end <= begin) {
+    return true;
+  }
+
+  int nThreads = std::min(parallelThreadCount(numberOfThreads), end - begin);
+  std::atomic<int> next(begin);
+  std::atomic<bool> stop(false);
+
+  // Completed indices are queued so the calling thread can report them.
+  std::mutex mutex;
+  std::condition_variable completedCondition;
+  std::queue<int> completed;
+  int finishedWorkers = 0;
+
+  auto worker = [&]() {
+    while (!stop) {
+      int i = next++;
+      if (i >= end) {
+        break;
+      }
+      body(i);
+      std::lock_guard<std::mutex> lock(mutex);
+      completed.push(i);
+      completedCondition.notify_one();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    ++finishedWorkers;
+    completedCondition.notify_one();
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(nThreads);
+  for (int i = 0; i < nThreads; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  int numberCompleted = 0;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (finishedWorkers < nThreads || !completed.empty()) {
+      completedCondition.wait(lock, [&]() {
+        return !completed.empty() || finishedWorkers == nThreads;
+      });
+      while (!completed.empty()) {
+        int index = completed.front();
+        completed.pop();
+        ++numberCompleted;
+        if (progress && !stop) {
+          // Don't hold the lock while the caller does its reporting.
+          lock.unlock();
+          if (!progress(numberCompleted, index)) {
+            stop = true;
+          }
+          lock.lock();
+        }
+      }
+    }
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return !stop && numberCompleted == end - begin;
+}
+} // namespace tomviz
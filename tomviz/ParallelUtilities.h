@@ -0,0 +1,31 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizParallelUtilities_h
+#define tomvizParallelUtilities_h
+
+// Small helpers for spreading CPU bound loops over a pool of threads.
+
+#include <functional>
+
+namespace tomviz {
+
+/// Returns the number of worker threads to use when a caller requests
+/// numberOfThreads. Values less than one select one thread per core.
+int parallelThreadCount(int numberOfThreads = 0);
+
+/// Calls body(i) for each i in [begin, end) on a pool of worker threads.
+/// Indices are handed out one at a time, so work items of uneven cost balance
+/// themselves; each index should therefore represent a reasonably large chunk
+/// of work (a slice, a block of rows, ...).
+///
+/// While the workers run, the calling thread invokes progress (if set) each
+/// time an index completes, passing the number of completed indices and the
+/// index that just completed. If progress returns false no further indices are
+/// started. Returns true if every index was processed.
+bool parallelFor(int begin, int end, const std::function<void(int)>& body,
+                 const std::function<bool(int, int)>& progress = nullptr,
+                 int numberOfThreads = 0);
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,287 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "PermuteAxes.h"
+
+#include "ParallelUtilities.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tomviz {
+
+namespace {
+
+// Tiles are TileSize x TileSize elements, small enough that the rows a tile
+// reads from stay in the cache while the tile is written out.
+const int TileSize = 32;
+
+// Moves elements of a size known at compile time, so that the copies turn
+// into plain loads and stores.
+template <size_t N>
+struct FixedElement
+{
+  size_t size() const { return N; }
+  void copy(char* dst, const char* src) const { std::memcpy(dst, src, N); }
+  void swap(char* a, char* b) const
+  {
+    char tmp[N];
+    std::memcpy(tmp, a, N);
+    std::memcpy(a, b, N);
+    std::memcpy(b, tmp, N);
+  }
+};
+
+// Moves elements of any other size.
+struct Element
+{
+  size_t bytes;
+
+  size_t size() const { return bytes; }
+  void copy(char* dst, const char* src) const
+  {
+    std::memcpy(dst, src, bytes);
+  }
+  void swap(char* a, char* b) const { std::swap_ranges(a, a + bytes, b); }
+};
+
+struct Layout
+{
+  int outDims[3];
+  // The strides, in elements, of the input and output along each output axis.
+  size_t inStrides[3];
+  size_t outStrides[3];
+};
+
+void strides(const int dims[3], size_t result[3])
+{
+  result[0] = 1;
+  result[1] = static_cast<size_t>(dims[0]);
+  result[2] = static_cast<size_t>(dims[0]) * dims[1];
+}
+
+Layout layout(const int dims[3], const int axes[3])
+{
+  size_t inStrides[3];
+  strides(dims, inStrides);
+  Layout l;
+  for (int i = 0; i < 3; ++i) {
+    l.outDims[i] = dims[axes[i]];
+    l.inStrides[i] = inStrides[axes[i]];
+  }
+  strides(l.outDims, l.outStrides);
+  return l;
+}
+
+template <typename E>
+void permuteTiled(const char* in, char* out, const Layout& l, const E& e,
+                  int numberOfThreads)
+{
+  const int* od = l.outDims;
+  size_t is[3], os[3];
+  for (int i = 0; i < 3; ++i) {
+    is[i] = l.inStrides[i] * e.size();
+    os[i] = l.outStrides[i] * e.size();
+  }
+
+  if (l.inStrides[0] == 1) {
+    // The fastest axis stays put, so whole rows are copied.
+    size_t rowBytes = od[0] * e.size();
+    auto body = [&](int k) {
+      for (int j = 0; j < od[1]; ++j) {
+        std::memcpy(out + k * os[2] + j * os[1], in + k * is[2] + j * is[1],
+                    rowBytes);
+      }
+    };
+    parallelFor(0, od[2], body, nullptr, numberOfThreads);
+    return;
+  }
+
+  // Output axis p is the fastest axis of the input. The (0, p) plane is
+  // permuted a tile at a time, so that both the reads along p and the writes
+  // along 0 are contiguous within a tile. The threads share out the third
+  // axis, q, and the tiles along p.
+  int p = l.inStrides[1] == 1 ? 1 : 2;
+  int q = 3 - p;
+  int tilesP = (od[p] + TileSize - 1) / TileSize;
+  auto body = [&](int index) {
+    size_t c = index / tilesP;
+    int pBegin = (index % tilesP) * TileSize;
+    int pEnd = std::min(pBegin + TileSize, od[p]);
+    const char* inPlane = in + c * is[q];
+    char* outPlane = out + c * os[q];
+    for (int iBegin = 0; iBegin < od[0]; iBegin += TileSize) {
+      int iEnd = std::min(iBegin + TileSize, od[0]);
+      for (int pp = pBegin; pp < pEnd; ++pp) {
+        const char* src = inPlane + pp * is[p];
+        char* dst = outPlane + pp * os[p];
+        for (int i = iBegin; i < iEnd; ++i) {
+          e.copy(dst + i * os[0], src + i * is[0]);
+        }
+      }
+    }
+  };
+  parallelFor(0, od[q] * tilesP, body, nullptr, numberOfThreads);
+}
+
+// Swap axes a and b, which have the same length, in place. Tiles above the
+// diagonal of the (a, b) plane are exchanged with their mirror images below
+// it, and the planes along the third axis are independent of each other.
+template <typename E>
+void swapTiled(char* data, const int dims[3], int a, int b, const E& e,
+               int numberOfThreads)
+{
+  size_t s[3];
+  strides(dims, s);
+  int c = 3 - a - b;
+  int n = dims[a];
+  int tiles = (n + TileSize - 1) / TileSize;
+  size_t sa = s[a] * e.size();
+  size_t sb = s[b] * e.size();
+  size_t sc = s[c] * e.size();
+
+  auto body = [&](int index) {
+    char* plane = data + (index / tiles) * sc;
+    int ti = index % tiles;
+    int iBegin = ti * TileSize;
+    int iEnd = std::min(iBegin + TileSize, n);
+    for (int jBegin = iBegin; jBegin < n; jBegin += TileSize) {
+      int jEnd = std::min(jBegin + TileSize, n);
+      for (int i = iBegin; i < iEnd; ++i) {
+        for (int j = std::max(jBegin, i + 1); j < jEnd; ++j) {
+          e.swap(plane + i * sa + j * sb, plane + j * sa + i * sb);
+        }
+      }
+    }
+  };
+  parallelFor(0, dims[c] * tiles, body, nullptr, numberOfThreads);
+}
+
+// Calls f with the element mover for elementSize.
+template <typename Functor>
+void dispatch(size_t elementSize, const Functor& f)
+{
+  switch (elementSize) {
+    case 1:
+      f(FixedElement<1>());
+      break;
+    case 2:
+      f(FixedElement<2>());
+      break;
+    case 4:
+      f(FixedElement<4>());
+      break;
+    case 8:
+      f(FixedElement<8>());
+      break;
+    case 12:
+      f(FixedElement<12>());
+      break;
+    case 16:
+      f(FixedElement<16>());
+      break;
+    default:
+      f(Element{ elementSize });
+      break;
+  }
+}
+
+struct Permute
+{
+  const char* in;
+  char* out;
+  Layout l;
+  int numberOfThreads;
+
+  template <typename E>
+  void operator()(const E& e) const
+  {
+    permuteTiled(in, out, l, e, numberOfThreads);
+  }
+};
+
+struct Swap
+{
+  char* data;
+  const int* dims;
+  int a;
+  int b;
+  int numberOfThreads;
+
+  template <typename E>
+  void operator()(const E& e) const
+  {
+    swapTiled(data, dims, a, b, e, numberOfThreads);
+  }
+};
+
+} // namespace
+
+void permuteAxes(const void* in, void* out, const int dims[3],
+                 const int axes[3], size_t elementSize, int numberOfThreads)
+{
+  Permute permute = { static_cast<const char*>(in), static_cast<char*>(out),
+                      layout(dims, axes), numberOfThreads };
+  dispatch(elementSize, permute);
+}
+
+bool canPermuteAxesInPlace(const int dims[3], const int axes[3])
+{
+  int moved = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (axes[i] != i) {
+      if (dims[i] != dims[axes[i]]) {
+        return false;
+      }
+      ++moved;
+    }
+  }
+  // Moving two axes is a swap, cycles of all three axes aren't done in place.
+  return moved != 3;
+}
+
+bool permuteAxesInPlace(void* data, const int dims[3], const int axes[3],
+                        size_t elementSize, int numberOfThreads)
+{
+  if (!canPermuteAxesInPlace(dims, axes)) {
+    return false;
+  }
+
+  for (int a = 0; a < 3; ++a) {
+    if (axes[a] > a) {
+      Swap swap = { static_cast<char*>(data), dims, a, axes[a],
+                    numberOfThreads };
+      dispatch(elementSize, swap);
+      break;
+    }
+  }
+  return true;
+}
+
+void reverseAxes(const void* in, void* out, const int dims[3],
+                 size_t elementSize, int numberOfThreads)
+{
+  const int axes[3] = { 2, 1, 0 };
+  permuteAxes(in, out, dims, axes, elementSize, numberOfThreads);
+}
+
+void permuteAxesNaive(const void* in, void* out, const int dims[3],
+                      const int axes[3], size_t elementSize)
+{
+  Layout l = layout(dims, axes);
+  auto src = static_cast<const char*>(in);
+  auto dst = static_cast<char*>(out);
+  size_t outIndex = 0;
+  for (int k = 0; k < l.outDims[2]; ++k) {
+    for (int j = 0; j < l.outDims[1]; ++j) {
+      for (int i = 0; i < l.outDims[0]; ++i) {
+        size_t inIndex =
+          k * l.inStrides[2] + j * l.inStrides[1] + i * l.inStrides[0];
+        std::memcpy(dst + outIndex * elementSize, src + inIndex * elementSize,
+                    elementSize);
+        ++outIndex;
+      }
+    }
+  }
+}
+} // namespace tomviz
@@ -0,0 +1,48 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizPermuteAxes_h
+#define tomvizPermuteAxes_h
+
+// Cache-blocked, multithreaded permutation of the axes of 3D arrays, used for
+// the Fortran/C reordering of volumes and for axis transposes.
+//
+// Arrays are described by their dimensions with the fastest varying axis
+// first, so a Fortran ordered vtkImageData has dims { x, y, z }, and the same
+// volume in C order has dims { z, y, x }. Axis i of the output is axis
+// axes[i] of the input, so the output has dims { dims[axes[0]],
+// dims[axes[1]], dims[axes[2]] }. Elements are elementSize bytes, which
+// covers multi-component tuples as well as scalars.
+
+#include <cstddef>
+
+namespace tomviz {
+
+/// Permute the axes of in, writing to out, which must not overlap in. The
+/// work is done in tiles that fit in the cache, spread over numberOfThreads
+/// threads (one per core if less than one).
+void permuteAxes(const void* in, void* out, const int dims[3],
+                 const int axes[3], size_t elementSize,
+                 int numberOfThreads = 0);
+
+/// Whether permuteAxesInPlace() can handle the permutation: either nothing
+/// moves, or two axes of the same length are swapped.
+bool canPermuteAxesInPlace(const int dims[3], const int axes[3]);
+
+/// Permute the axes of data in place, without a second buffer. Returns false,
+/// leaving data untouched, if canPermuteAxesInPlace() is false.
+bool permuteAxesInPlace(void* data, const int dims[3], const int axes[3],
+                        size_t elementSize, int numberOfThreads = 0);
+
+/// Reverse the order of the axes of an array with the given Fortran
+/// dimensions, going from Fortran to C order (or, with the dims reversed,
+/// from C to Fortran order).
+void reverseAxes(const void* in, void* out, const int dims[3],
+                 size_t elementSize, int numberOfThreads = 0);
+
+/// The straightforward loop over the output, for reference.
+void permuteAxesNaive(const void* in, void* out, const int dims[3],
+                      const int axes[3], size_t elementSize);
+} // namespace tomviz
+
+#endif
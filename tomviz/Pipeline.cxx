@@ -11,6 +11,7 @@
 #include "ExternalPythonExecutor.h"
 #include "ModuleManager.h"
 #include "Operator.h"
+#include "OperatorResultCache.h"
 #include "ThreadedExecutor.h"
 #include "Utilities.h"
 
@@ -71,6 +72,16 @@ QString PipelineSettings::externalPythonExecutablePath()
   return m_settings->value("pipeline/external.executable").toString();
 }
 
+int PipelineSettings::resultCacheMemory()
+{
+  return m_settings->value("pipeline/cache.memory", 0).toInt();
+}
+
+int PipelineSettings::resultCacheDisk()
+{
+  return m_settings->value("pipeline/cache.disk", 0).toInt();
+}
+
 void PipelineSettings::setDockerImage(const QString& image)
 {
   m_settings->setValue("pipeline/docker.image", image);
@@ -92,7 +103,18 @@ void PipelineSettings::setExternalPythonExecutablePath(
   m_settings->setValue("pipeline/external.executable", executable);
 }
 
-Pipeline::Pipeline(DataSource* dataSource, QObject* parent) : QObject(parent)
+void PipelineSettings::setResultCacheMemory(int mebibytes)
+{
+  m_settings->setValue("pipeline/cache.memory", mebibytes);
+}
+
+void PipelineSettings::setResultCacheDisk(int mebibytes)
+{
+  m_settings->setValue("pipeline/cache.disk", mebibytes);
+}
+
+Pipeline::Pipeline(DataSource* dataSource, QObject* parent)
+  : QObject(parent), m_resultCache(new OperatorResultCache)
 {
   m_data = dataSource;
   m_data->setParent(this);
@@ -102,6 +124,7 @@ Pipeline::Pipeline(DataSource* dataSource, QObject* parent) : QObject(parent)
   PipelineSettings settings;
   auto executor = settings.executionMode();
   setExecutionMode(executor);
+  updateResultCacheBudgets();
 }
 
 Pipeline::~Pipeline() = default;
@@ -579,6 +602,14 @@ DataSource* Pipeline::transformedDataSource(DataSource* ds)
   return ds;
 }
 
+void Pipeline::updateResultCacheBudgets()
+{
+  PipelineSettings settings;
+  const qint64 mebibyte = 1024 * 1024;
+  m_resultCache->setMemoryBudget(settings.resultCacheMemory() * mebibyte);
+  m_resultCache->setDiskBudget(settings.resultCacheDisk() * mebibyte);
+}
+
 void Pipeline::setExecutionMode(ExecutionMode executor)
 {
   m_executionMode = executor;
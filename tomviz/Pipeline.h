@@ -15,6 +15,7 @@
 #include <QProcess>
 #include <QScopedPointer>
 #include <QSettings>
+#include <QSharedPointer>
 #include <QTemporaryDir>
 #include <QThreadPool>
 #include <QTimer>
@@ -29,6 +30,7 @@ class pqSettings;
 namespace tomviz {
 class DataSource;
 class Operator;
+class OperatorResultCache;
 class Pipeline;
 class PipelineExecutor;
 
@@ -90,6 +92,14 @@ public:
   ExecutionMode executionMode() { return m_executionMode; };
   PipelineExecutor* executor() { return m_executor.data(); };
 
+  /// Cache of operator outputs used to resume execution part way through the
+  /// pipeline. Executors hold on to it while they run, so it outlives the
+  /// pipeline if a worker is still inserting results.
+  QSharedPointer<OperatorResultCache> resultCache() { return m_resultCache; }
+
+  /// Apply the result cache budgets from the pipeline settings.
+  void updateResultCacheBudgets();
+
   static Future* emptyFuture();
 
 public slots:
@@ -143,6 +153,7 @@ private:
   bool m_paused = false;
   bool m_operatorsDeleted = false;
   QScopedPointer<PipelineExecutor> m_executor;
+  QSharedPointer<OperatorResultCache> m_resultCache;
   ExecutionMode m_executionMode = Threaded;
   int m_editingOperators = 0;
 };
@@ -189,6 +200,10 @@ public:
   bool dockerPull();
   bool dockerRemove();
   QString externalPythonExecutablePath();
+  /// Budgets for the operator result cache, in MiB. They default to 0, the
+  /// cache is only used once a budget is set in the settings dialog.
+  int resultCacheMemory();
+  int resultCacheDisk();
 
   void setExecutionMode(Pipeline::ExecutionMode executor);
   void setExecutionMode(const QString& executor);
@@ -196,6 +211,8 @@ public:
   void setDockerPull(bool pull);
   void setDockerRemove(bool remove);
   void setExternalPythonExecutablePath(const QString& executable);
+  void setResultCacheMemory(int mebibytes);
+  void setResultCacheDisk(int mebibytes);
 
 private:
   pqSettings* m_settings;
@@ -14,6 +14,7 @@
 #include "PipelineExecutor.h"
 #include "PipelineWorker.h"
 #include "ProgressDialog.h"
+#include "SharedVolumeFormat.h"
 #include "Utilities.h"
 
 #include <QDir>
@@ -65,6 +66,26 @@ ExternalPipelineFuture::ExternalPipelineFuture(QList<Operator*> operators,
 {
 }
 
+// Read data handed back by the executor, as an EMD file or a shared volume.
+static bool readExecutorData(const QString& path, vtkImageData* image)
+{
+  if (path.endsWith(SharedVolumeFormat::EXTENSION)) {
+    // The executor writes an EMD file next to it instead when there isn't
+    // room for the shared volume.
+    QFileInfo info(path);
+    QString emdPath = info.dir().filePath(info.completeBaseName() + ".emd");
+    if (info.exists() || !QFileInfo::exists(emdPath)) {
+      return SharedVolumeFormat::read(path.toStdString(), image);
+    }
+    QVariantMap options = { { "askForSubsample", false } };
+    return EmdFormat::read(emdPath.toLatin1().data(), image, options);
+  }
+
+  // Make sure we don't ask the user about subsampling
+  QVariantMap options = { { "askForSubsample", false } };
+  return EmdFormat::read(path.toLatin1().data(), image, options);
+}
+
 const char* ExternalPipelineExecutor::ORIGINAL_FILENAME = "original";
 const char* ExternalPipelineExecutor::TRANSFORM_FILENAME = "transformed.emd";
 const char* ExternalPipelineExecutor::STATE_FILENAME = "state.tvsm";
@@ -79,7 +100,22 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
     end = operators.size();
   }
 
-  m_temporaryDir.reset(new QTemporaryDir());
+  // Volumes with dark and white fields go through DataExchange files.
+  auto imageData = vtkImageData::SafeDownCast(data);
+  auto* dataSource = pipeline()->dataSource();
+  m_sharedMemory = useSharedMemory() &&
+                   !(dataSource->darkData() && dataSource->whiteData()) &&
+                   SharedVolumeFormat::canWrite(imageData);
+
+  // Shared volumes go on a memory backed file system if there is room for the
+  // data to go both ways, they are still mapped from a regular file if not.
+  QString dirTemplate;
+  if (m_sharedMemory) {
+    dirTemplate = SharedVolumeFormat::sharedTemporaryDirTemplate(
+      2 * SharedVolumeFormat::sizeInBytes(imageData));
+  }
+  m_temporaryDir.reset(dirTemplate.isEmpty() ? new QTemporaryDir()
+                                             : new QTemporaryDir(dirTemplate));
   if (!m_temporaryDir->isValid()) {
     displayError("Directory Error", "Unable to create temporary directory.");
     return Pipeline::emptyFuture();
@@ -114,11 +150,21 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
   stateFile.write(QJsonDocument(state).toJson());
   stateFile.close();
 
-  // Write data to EMD or DataExchange
+  // Write data to EMD or DataExchange. The file is only used to hand the data
+  // over, so don't spend time compressing it or building a pyramid.
+  QVariantMap writeOptions;
+  writeOptions["chunk"] = false;
+  writeOptions["pyramid"] = false;
   auto dataFilePath = QDir(workingDir()).filePath(origFileName);
-  if (origFileName.endsWith("emd")) {
-    auto imageData = vtkImageData::SafeDownCast(data);
-    if (!EmdFormat::write(dataFilePath.toLatin1().data(), imageData)) {
+  if (m_sharedMemory) {
+    if (!SharedVolumeFormat::write(dataFilePath.toStdString(), imageData)) {
+      displayError("Write Error",
+                   QString("Unable to share data at: %1").arg(dataFilePath));
+      return Pipeline::emptyFuture();
+    }
+  } else if (origFileName.endsWith("emd")) {
+    if (!EmdFormat::write(dataFilePath.toLatin1().data(), imageData,
+                          writeOptions)) {
       displayError("Write Error",
                    QString("Unable to write data at: %1").arg(dataFilePath));
       return Pipeline::emptyFuture();
@@ -126,7 +172,7 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
   } else {
     DataExchangeFormat dxfFile;
     if (!dxfFile.write(dataFilePath.toLatin1().data(),
-        pipeline()->dataSource())) {
+        pipeline()->dataSource(), writeOptions)) {
       displayError("Write Error",
                    QString("Unable to write data at: %1").arg(dataFilePath));
       return Pipeline::emptyFuture();
@@ -170,15 +216,12 @@ Pipeline::Future* ExternalPipelineExecutor::execute(vtkDataObject* data,
   connect(m_progressReader.data(), &ProgressReader::pipelineFinished, this,
           [this, future]() {
             auto transformedFilePath =
-              QDir(workingDir()).filePath(TRANSFORM_FILENAME);
+              QDir(workingDir()).filePath(transformFileName());
             vtkSmartPointer<vtkDataObject> transformedData =
               vtkImageData::New();
             vtkImageData* transformedImageData =
               vtkImageData::SafeDownCast(transformedData.Get());
-            // Make sure we don't ask the user about subsampling
-            QVariantMap options = { { "askForSubsample", false } };
-            if (EmdFormat::read(transformedFilePath.toLatin1().data(),
-                                transformedImageData, options)) {
+            if (readExecutorData(transformedFilePath, transformedImageData)) {
               future->setResult(transformedImageData);
             } else {
               displayError("Read Error",
@@ -224,7 +267,7 @@ QStringList ExternalPipelineExecutor::executorArgs(int start)
 {
   auto baseDir = QDir(executorWorkingDir());
   auto stateFilePath = baseDir.filePath(STATE_FILENAME);
-  auto outputPath = baseDir.filePath(TRANSFORM_FILENAME);
+  auto outputPath = baseDir.filePath(transformFileName());
   auto progressPath = baseDir.filePath(PROGRESS_PATH);
 
   QStringList args;
@@ -266,16 +309,15 @@ void ExternalPipelineExecutor::operatorFinished(Operator* op)
   if (operatorPath.exists()) {
     QMap<QString, vtkSmartPointer<vtkDataObject>> childOutput;
 
-    // We are looking for EMD files
+    // We are looking for EMD files or shared volumes
+    QStringList filters = { "*.emd",
+                            QString("*") + SharedVolumeFormat::EXTENSION };
     foreach (const QFileInfo& fileInfo,
-             operatorPath.entryInfoList(QDir::Files)) {
+             operatorPath.entryInfoList(filters, QDir::Files)) {
 
       auto name = fileInfo.baseName();
       vtkNew<vtkImageData> childData;
-      // Make sure we don't ask the user about subsampling
-      QVariantMap options = { { "askForSubsample", false } };
-      if (EmdFormat::read(fileInfo.filePath().toLatin1().data(), childData,
-                          options)) {
+      if (readExecutorData(fileInfo.filePath(), childData)) {
         childOutput[name] = childData;
         emit pipeline()->finished();
       } else {
@@ -337,8 +379,17 @@ void ExternalPipelineExecutor::reset()
   m_temporaryDir.reset(nullptr);
 }
 
+bool ExternalPipelineExecutor::useSharedMemory()
+{
+  return false;
+}
+
 QString ExternalPipelineExecutor::originalFileName()
 {
+  if (m_sharedMemory) {
+    return ORIGINAL_FILENAME + QString(SharedVolumeFormat::EXTENSION);
+  }
+
   QString ext = ".emd";
   auto* dataSource = pipeline()->dataSource();
   if (dataSource->darkData() && dataSource->whiteData()) {
@@ -349,6 +400,16 @@ QString ExternalPipelineExecutor::originalFileName()
   return ORIGINAL_FILENAME + ext;
 }
 
+QString ExternalPipelineExecutor::transformFileName()
+{
+  if (m_sharedMemory) {
+    return QFileInfo(TRANSFORM_FILENAME).completeBaseName() +
+           SharedVolumeFormat::EXTENSION;
+  }
+
+  return TRANSFORM_FILENAME;
+}
+
 ProgressReader::ProgressReader(const QString& path,
                                const QList<Operator*>& operators)
   : m_path(path), m_operators(operators)
@@ -419,12 +480,17 @@ vtkSmartPointer<vtkDataObject> ProgressReader::readProgressData(
 
   auto hostPath = QFileInfo(m_path).absoluteDir().filePath(path);
 
-  // Make sure we don't ask the user about subsampling
-  QVariantMap options = { { "askForSubsample", false } };
-  if (!EmdFormat::read(hostPath.toLatin1().data(), data, options)) {
+  if (!readExecutorData(hostPath, data)) {
     qCritical() << QString("Unable to load progress data at: %1").arg(path);
   }
 
+  // Removing the files tells the executor that it can send the next update.
+  if (hostPath.endsWith(SharedVolumeFormat::EXTENSION)) {
+    SharedVolumeFormat::remove(hostPath.toStdString());
+  } else {
+    QFile::remove(hostPath);
+  }
+
   return data;
 }
 
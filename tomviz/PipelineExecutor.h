@@ -83,13 +83,19 @@ protected:
   virtual void pipelineStarted();
   virtual void reset();
 
+  // Whether the executor can map files in the working directory, so the data
+  // can be handed over through shared memory rather than HDF5 files.
+  virtual bool useSharedMemory();
+
   QString originalFileName();
+  QString transformFileName();
   void displayError(const QString& title, const QString& msg);
   QStringList executorArgs(int start);
 
   QScopedPointer<QTemporaryDir> m_temporaryDir;
   QScopedPointer<ProgressReader> m_progressReader;
   QString m_progressMode;
+  bool m_sharedMemory = false;
 };
 
 class ProgressReader : public QObject
@@ -82,6 +82,12 @@ PipelineSettingsDialog::PipelineSettingsDialog(QWidget* parent)
     }
 
     writeSettings();
+
+    foreach (Pipeline* pipeline, PipelineManager::instance().pipelines()) {
+      if (pipeline) {
+        pipeline->updateResultCacheBudgets();
+      }
+    }
   });
 
   connect(m_ui->buttonBox, &QDialogButtonBox::helpRequested,
@@ -137,6 +143,9 @@ void PipelineSettingsDialog::readSettings()
   if (!pythonExecutable.isEmpty()) {
     m_ui->externalLineEdit->setText(pythonExecutable);
   }
+
+  m_ui->cacheMemorySpinBox->setValue(pipelineSettings.resultCacheMemory());
+  m_ui->cacheDiskSpinBox->setValue(pipelineSettings.resultCacheDisk());
 }
 
 void PipelineSettingsDialog::writeSettings()
@@ -170,6 +179,8 @@ void PipelineSettingsDialog::writeSettings()
   pipelineSettings.setDockerRemove(m_ui->removeContainersCheckBox->isChecked());
   pipelineSettings.setExternalPythonExecutablePath(
     m_ui->externalLineEdit->text());
+  pipelineSettings.setResultCacheMemory(m_ui->cacheMemorySpinBox->value());
+  pipelineSettings.setResultCacheDisk(m_ui->cacheDiskSpinBox->value());
 }
 
 void PipelineSettingsDialog::showEvent(QShowEvent* event)
@@ -227,6 +227,7 @@ void PipelineView::contextMenuEvent(QContextMenuEvent* e)
   QAction* showInterfaceAction = nullptr;
   QAction* exportTableResultAction = nullptr;
   QAction* reloadAndResampleAction = nullptr;
+  QAction* refineResolutionAction = nullptr;
   bool allowReExecute = false;
   CloneDataReaction* cloneReaction;
 
@@ -256,6 +257,14 @@ void PipelineView::contextMenuEvent(QContextMenuEvent* e)
         reloadAndResampleAction = contextMenu.addAction("Reload and Resample");
       }
 
+      if (dataSource->resolutionLevel() > 0) {
+        // With a pipeline, go straight to the full resolution data so the
+        // pipeline is only re-run once.
+        refineResolutionAction = contextMenu.addAction(
+          dataSource->operators().isEmpty() ? "Refine Resolution"
+                                            : "Load Full Resolution");
+      }
+
       // Add option to re-execute the pipeline is we have a canceled operator
       // in our pipeline.
       foreach (Operator* op, dataSource->operators()) {
@@ -408,6 +417,11 @@ void PipelineView::contextMenuEvent(QContextMenuEvent* e)
     exportTableAsJson(vtkTable::SafeDownCast(result->dataObject()));
   } else if (selectedItem == reloadAndResampleAction) {
     dataSource->reloadAndResample();
+  } else if (selectedItem == refineResolutionAction) {
+    int level = dataSource->operators().isEmpty()
+                  ? dataSource->resolutionLevel() - 1
+                  : 0;
+    dataSource->loadResolutionLevel(level);
   }
 }
 
@@ -10,16 +10,64 @@
 #include <QThreadPool>
 #include <QTimer>
 
-#include <vtkDataObject.h>
+#include <vtkAbstractArray.h>
+#include <vtkDataSet.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 
 namespace tomviz {
 
+namespace {
+
+// Replace the point data arrays that data shares with shared, or that are
+// referenced from anywhere else (e.g. results kept by the OperatorResultCache),
+// by deep copies, so they can be modified without affecting anyone else.
+void detachSharedArrays(vtkDataObject* data, vtkDataObject* shared)
+{
+  auto dataSet = vtkDataSet::SafeDownCast(data);
+  if (dataSet == nullptr) {
+    return;
+  }
+
+  auto pointData = dataSet->GetPointData();
+  auto sharedSet = vtkDataSet::SafeDownCast(shared);
+  auto sharedPointData = sharedSet ? sharedSet->GetPointData() : nullptr;
+  for (int i = 0; i < pointData->GetNumberOfArrays(); ++i) {
+    auto array = pointData->GetAbstractArray(i);
+    // The point data holds one reference.
+    bool isShared = array->GetReferenceCount() > 1;
+    for (int j = 0; !isShared && sharedPointData &&
+                    j < sharedPointData->GetNumberOfArrays();
+         ++j) {
+      isShared = sharedPointData->GetAbstractArray(j) == array;
+    }
+    if (!isShared) {
+      continue;
+    }
+    if (array->GetName() == nullptr) {
+      // Unnamed arrays can't be replaced individually, copy the lot.
+      vtkNew<vtkPointData> copy;
+      copy->DeepCopy(pointData);
+      pointData->ShallowCopy(copy);
+      return;
+    }
+    vtkSmartPointer<vtkAbstractArray> copy;
+    copy.TakeReference(array->NewInstance());
+    copy->DeepCopy(array);
+    // Replaces the array with the same name, keeping its attribute role.
+    pointData->AddArray(copy);
+  }
+}
+} // namespace
+
 class PipelineWorker::RunnableOperator : public QObject, public QRunnable
 {
   Q_OBJECT
 
 public:
   RunnableOperator(Operator* op, vtkDataObject* input,
+                   const OperatorCompleted& completed, vtkDataObject* shared,
                    QObject* parent = nullptr);
 
   /// Returns the data the operator operates on
@@ -35,6 +83,8 @@ signals:
 private:
   Operator* m_operator;
   vtkDataObject* m_data;
+  OperatorCompleted m_completed;
+  vtkDataObject* m_shared;
   Q_DISABLE_COPY(RunnableOperator)
 };
 
@@ -51,7 +101,8 @@ class PipelineWorker::Run : public QObject
   };
 
 public:
-  Run(vtkDataObject* data, QList<Operator*> operators);
+  Run(vtkDataObject* data, QList<Operator*> operators,
+      const OperatorCompleted& completed, vtkDataObject* shared);
 
   /// Clear all Operators from the queue and attempts to cancel the
   /// running Operator.
@@ -91,22 +142,33 @@ private:
   QQueue<RunnableOperator*> m_runnableOperators;
   QList<RunnableOperator*> m_complete;
   QList<Operator*> m_operators;
+  OperatorCompleted m_completed;
+  vtkSmartPointer<vtkDataObject> m_shared;
   State m_state = State::CREATED;
 };
 
 #include "PipelineWorker.moc"
 
-PipelineWorker::RunnableOperator::RunnableOperator(Operator* op,
-                                                   vtkDataObject* data,
-                                                   QObject* parent)
-  : QObject(parent), m_operator(op), m_data(data)
+PipelineWorker::RunnableOperator::RunnableOperator(
+  Operator* op, vtkDataObject* data, const OperatorCompleted& completed,
+  vtkDataObject* shared, QObject* parent)
+  : QObject(parent), m_operator(op), m_data(data), m_completed(completed),
+    m_shared(shared)
 {
   setAutoDelete(false);
 }
 
 void PipelineWorker::RunnableOperator::run()
 {
+  if (m_operator->modifiesDataInPlace()) {
+    detachSharedArrays(m_data, m_shared);
+  }
   TransformResult result = m_operator->transform(m_data);
+  // Give the caller a chance to look at the data before the next operator
+  // modifies it.
+  if (result == TransformResult::Complete && m_completed) {
+    m_completed(m_operator, m_data);
+  }
   emit complete(result);
 }
 
@@ -132,12 +194,15 @@ PipelineWorker::ConfigureThreadPool::ConfigureThreadPool()
   QThreadPool::globalInstance()->setMaxThreadCount(threads);
 }
 
-PipelineWorker::Run::Run(vtkDataObject* data, QList<Operator*> operators)
-  : m_data(data)
+PipelineWorker::Run::Run(vtkDataObject* data, QList<Operator*> operators,
+                         const OperatorCompleted& completed,
+                         vtkDataObject* shared)
+  : m_data(data), m_completed(completed), m_shared(shared)
 {
   m_operators = operators;
   foreach (auto op, operators) {
-    m_runnableOperators.enqueue(new RunnableOperator(op, m_data, this));
+    m_runnableOperators.enqueue(
+      new RunnableOperator(op, m_data, m_completed, m_shared, this));
   }
 }
 
@@ -240,7 +305,8 @@ bool PipelineWorker::Run::addOperator(Operator* op)
     return false;
   }
 
-  m_runnableOperators.enqueue(new RunnableOperator(op, m_data, this));
+  m_runnableOperators.enqueue(
+    new RunnableOperator(op, m_data, m_completed, m_shared, this));
 
   return true;
 }
@@ -258,15 +324,16 @@ PipelineWorker::Future* PipelineWorker::run(vtkDataObject* data, Operator* op)
   return run(data, ops);
 }
 
-PipelineWorker::Future* PipelineWorker::run(vtkDataObject* data,
-                                            QList<Operator*> operators)
+PipelineWorker::Future* PipelineWorker::run(
+  vtkDataObject* data, QList<Operator*> operators,
+  const OperatorCompleted& completed, vtkDataObject* shared)
 {
   // Set all the operators in the queued state
   foreach (Operator* op, operators) {
     op->resetState();
   }
 
-  Run* run = new Run(data, operators);
+  Run* run = new Run(data, operators, completed, shared);
 
   return run->start();
 }
@@ -8,6 +8,8 @@
 #include <QObject>
 #include <QRunnable>
 
+#include <functional>
+
 class vtkDataObject;
 
 namespace tomviz {
@@ -22,9 +24,21 @@ class PipelineWorker : public QObject
 
 public:
   class Future;
+  /// Called on the worker thread each time an operator completes
+  /// successfully, with the data as the operator left it. It may keep
+  /// references to the point data arrays, they are copied before the next
+  /// operator that modifies its data in place.
+  typedef std::function<void(Operator*, vtkDataObject*)> OperatorCompleted;
+
   PipelineWorker(QObject* parent = nullptr);
   Future* run(vtkDataObject* data, Operator* op);
-  Future* run(vtkDataObject* data, QList<Operator*> ops);
+  /// If data shares point data arrays with shared (e.g. it is a shallow copy),
+  /// or anything else holds a reference to them, the shared arrays are copied
+  /// before an operator that modifies its data in place runs, so shared is
+  /// never written to.
+  Future* run(vtkDataObject* data, QList<Operator*> ops,
+              const OperatorCompleted& completed = nullptr,
+              vtkDataObject* shared = nullptr);
 
 private:
   class RunnableOperator;
@@ -0,0 +1,178 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ReconstructionPreview.h"
+
+#include "DataSource.h"
+#include "TomographyReconstruction.h"
+#include "TomographyTiltSeries.h"
+
+#include <vtkImageData.h>
+
+Q_DECLARE_METATYPE(vtkSmartPointer<vtkImageData>)
+
+namespace tomviz {
+
+ReconstructionPreview::ReconstructionPreview(vtkImageData* tiltSeries,
+                                             QObject* p)
+  : QObject(p), m_tiltSeries(tiltSeries)
+{
+  qRegisterMetaType<vtkSmartPointer<vtkImageData>>();
+
+  auto angles = DataSource::getTiltAngles(tiltSeries);
+  m_tiltAngles.assign(angles.begin(), angles.end());
+
+  m_worker = std::thread(&ReconstructionPreview::run, this);
+}
+
+ReconstructionPreview::~ReconstructionPreview()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+  m_condition.notify_one();
+  m_worker.join();
+}
+
+int ReconstructionPreview::request(int index, int slice, double axisPosition,
+                                   int tiltAxis)
+{
+  int id;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index >= static_cast<int>(m_requests.size())) {
+      m_requests.resize(index + 1);
+    }
+    Request& request = m_requests[index];
+    request.id = id = ++m_nextId;
+    request.slice = slice;
+    request.axisPosition = axisPosition;
+    request.tiltAxis = tiltAxis;
+    request.pending = true;
+    request.coarseDone = false;
+  }
+  m_condition.notify_one();
+  return id;
+}
+
+void ReconstructionPreview::cancel()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& request : m_requests) {
+    // A new id makes the running reconstruction stop at its next check.
+    request.id = ++m_nextId;
+    request.pending = false;
+  }
+}
+
+bool ReconstructionPreview::superseded(int index, int id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_quit || m_requests[index].id != id;
+}
+
+void ReconstructionPreview::run()
+{
+  while (true) {
+    int index = -1;
+    Request request;
+    {
+      // The coarse previews of every pending request come first, so all the
+      // views follow the controls before any of them is refined.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!m_quit && index < 0) {
+        for (int i = 0; i < static_cast<int>(m_requests.size()); ++i) {
+          const Request& candidate = m_requests[i];
+          if (candidate.pending && (index < 0 || !candidate.coarseDone)) {
+            index = i;
+            if (!candidate.coarseDone) {
+              break;
+            }
+          }
+        }
+        if (index < 0) {
+          m_condition.wait(lock);
+        }
+      }
+      if (m_quit) {
+        return;
+      }
+      request = m_requests[index];
+    }
+
+    // The cache is only rebuilt when the tilt axis changes, releasing the old
+    // one first since each holds a copy of the whole tilt series.
+    if (!m_cache || m_cache->tiltAxis() != request.tiltAxis) {
+      m_cache.reset();
+      m_cache.reset(new TomographyTiltSeries::SinogramCache(
+        m_tiltSeries, request.tiltAxis, 0, [this]() {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          return m_quit;
+        }));
+      if (m_cache->empty()) {
+        // The copy is only canceled when quitting.
+        m_cache.reset();
+        return;
+      }
+    }
+
+    bool refined = request.coarseDone;
+    int fullSize = m_cache->numberOfRays();
+    bool hasTiltAngles =
+      static_cast<int>(m_tiltAngles.size()) >= m_cache->numberOfTilts();
+    vtkSmartPointer<vtkImageData> image;
+    if (hasTiltAngles && (refined || fullSize > CoarseSize)) {
+      image = reconstruct(index, request, refined ? fullSize : CoarseSize);
+      if (!image) {
+        continue;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      Request& current = m_requests[index];
+      if (current.id != request.id) {
+        continue;
+      }
+      if (refined) {
+        current.pending = false;
+      } else {
+        current.coarseDone = true;
+      }
+    }
+    if (image) {
+      emit previewReady(index, request.id, image, refined);
+    }
+  }
+}
+
+vtkSmartPointer<vtkImageData> ReconstructionPreview::reconstruct(
+  int index, const Request& request, int Nray)
+{
+  int numberOfTilts = m_cache->numberOfTilts();
+  std::vector<float> sinogram(static_cast<size_t>(Nray) * numberOfTilts);
+  m_cache->interpolate(request.slice, sinogram.data(), Nray,
+                       request.axisPosition);
+
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(0, Nray - 1, 0, Nray - 1, 0, 0);
+  // Coarse previews cover the same area as the full resolution ones.
+  int fullSize = m_cache->numberOfRays();
+  double spacing = Nray > 1 ? (fullSize - 1.0) / (Nray - 1) : 1.0;
+  image->SetSpacing(spacing, spacing, 1);
+  image->AllocateScalars(VTK_FLOAT, 1);
+
+  int id = request.id;
+  auto progress = [this, index, id](int, int) {
+    return !superseded(index, id);
+  };
+  if (!TomographyReconstruction::parallelBackProjection2(
+        sinogram.data(), m_tiltAngles.data(),
+        static_cast<float*>(image->GetScalarPointer()), numberOfTilts, Nray,
+        progress)) {
+    return nullptr;
+  }
+  return image;
+}
+} // namespace tomviz
@@ -0,0 +1,93 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizReconstructionPreview_h
+#define tomvizReconstructionPreview_h
+
+#include <QObject>
+
+#include <vtkSmartPointer.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class vtkImageData;
+
+namespace tomviz {
+
+namespace TomographyTiltSeries {
+class SinogramCache;
+}
+
+/// Reconstructs single slices of a tilt series on a background thread, for
+/// previewing the tilt axis while it is being adjusted. The tilt series is
+/// converted to float sinograms once, on the worker thread, and every preview
+/// after that reads its sinogram straight from the cache.
+///
+/// Each preview has its own slot. A new request for a slot supersedes the
+/// previous one: if that is still being reconstructed it is abandoned, so
+/// only the latest settings are ever computed while a control is dragged.
+/// Every request is answered with a coarse preview first, then with the
+/// reconstruction at the full resolution of the tilt series.
+class ReconstructionPreview : public QObject
+{
+  Q_OBJECT
+
+public:
+  ReconstructionPreview(vtkImageData* tiltSeries, QObject* parent = nullptr);
+  ~ReconstructionPreview() override;
+
+  /// Edge length of the coarse previews.
+  static const int CoarseSize = 128;
+
+  /// Requests a reconstruction of slice for preview index. axisPosition is the
+  /// position of the rotation axis relative to the center of the rays, and
+  /// tiltAxis is 0 if the tilt axis is X and 1 if it is Y. Returns the id
+  /// reported with the results of this request.
+  int request(int index, int slice, double axisPosition, int tiltAxis);
+
+  /// Drops the pending and running requests.
+  void cancel();
+
+signals:
+  /// Emitted from the worker thread with a reconstruction for request
+  /// requestId of preview index. The coarse preview has refined set to false
+  /// and its spacing scaled so that it covers the same bounds as the full
+  /// resolution one. Small tilt series only produce the refined result.
+  void previewReady(int index, int requestId,
+                    vtkSmartPointer<vtkImageData> image, bool refined);
+
+private:
+  struct Request
+  {
+    int id = 0;
+    int slice = 0;
+    double axisPosition = 0;
+    int tiltAxis = 0;
+    bool pending = false;
+    bool coarseDone = false;
+  };
+
+  void run();
+  bool superseded(int index, int id);
+  vtkSmartPointer<vtkImageData> reconstruct(int index, const Request& request,
+                                            int Nray);
+
+  vtkSmartPointer<vtkImageData> m_tiltSeries;
+  std::vector<double> m_tiltAngles;
+  // Only used by the worker thread.
+  std::unique_ptr<TomographyTiltSeries::SinogramCache> m_cache;
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::vector<Request> m_requests;
+  int m_nextId = 0;
+  bool m_quit = false;
+  std::thread m_worker;
+};
+} // namespace tomviz
+
+#endif
@@ -5,11 +5,14 @@
 
 #include "ActiveObjects.h"
 #include "DataSource.h"
+#include "EditOperatorDialog.h"
 #include "Pipeline.h"
+#include "Utilities.h"
 
 #include <vtkSMSourceProxy.h>
 #include <vtkTrivialProducer.h>
 
+#include "IterativeReconstructionOperator.h"
 #include "ReconstructionOperator.h"
 
 #include <QDebug>
@@ -17,8 +20,9 @@
 
 namespace tomviz {
 
-ReconstructionReaction::ReconstructionReaction(QAction* parentObject)
-  : Reaction(parentObject)
+ReconstructionReaction::ReconstructionReaction(QAction* parentObject,
+                                               Algorithm algorithm)
+  : Reaction(parentObject), m_algorithm(algorithm)
 {
 }
 
@@ -30,7 +34,16 @@ void ReconstructionReaction::recon(DataSource* input)
     return;
   }
 
-  Operator* op = new ReconstructionOperator(input);
-  input->addOperator(op);
+  // Let the user pick the parameters before the operator is added.
+  Operator* op = nullptr;
+  if (m_algorithm == Algorithm::Iterative) {
+    op = new IterativeReconstructionOperator(input);
+  } else {
+    op = new ReconstructionOperator(input);
+  }
+  auto dialog = new EditOperatorDialog(op, input, true, tomviz::mainWidget());
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+  dialog->show();
+  connect(op, SIGNAL(destroyed()), dialog, SLOT(reject()));
 }
 } // namespace tomviz
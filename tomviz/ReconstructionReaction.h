@@ -14,7 +14,15 @@ class ReconstructionReaction : public Reaction
   Q_OBJECT
 
 public:
-  ReconstructionReaction(QAction* parent);
+  /// The native reconstructions the reaction can add.
+  enum class Algorithm
+  {
+    BackProjection,
+    Iterative
+  };
+
+  ReconstructionReaction(QAction* parent,
+                         Algorithm algorithm = Algorithm::BackProjection);
 
   void recon(DataSource* input = NULL);
 
@@ -22,6 +30,7 @@ protected:
   void onTriggered() { recon(); }
 
 private:
+  Algorithm m_algorithm;
   Q_DISABLE_COPY(ReconstructionReaction)
 };
 } // namespace tomviz
@@ -9,7 +9,8 @@
 #include "DataSource.h"
 #include "LoadDataReaction.h"
 #include "PresetDialog.h"
-#include "TomographyReconstruction.h"
+#include "ReconstructionPreview.h"
+#include "TiltAxisSearch.h"
 #include "TomographyTiltSeries.h"
 #include "Utilities.h"
 
@@ -46,6 +47,7 @@
 #include "ui_RotateAlignWidget.h"
 
 #include <QDoubleSpinBox>
+#include <QFutureWatcher>
 #include <QGridLayout>
 #include <QHBoxLayout>
 #include <QKeyEvent>
@@ -56,11 +58,11 @@
 #include <QSpinBox>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <QtConcurrent>
 
 #include <algorithm>
 #include <array>
-
-#define PI 3.14159265359
+#include <atomic>
 
 namespace tomviz {
 
@@ -84,6 +86,13 @@ public:
   vtkSmartPointer<vtkSMProxy> ReconColorMap[3];
   bool m_reconSliceDirty[3];
   QTimer m_updateSlicesTimer;
+  QScopedPointer<ReconstructionPreview> m_preview;
+  // The latest preview requested for each reconstruction view, older results
+  // that were already on their way are dropped.
+  int m_previewRequest[3] = { 0, 0, 0 };
+  QFutureWatcher<bool> m_searchWatcher;
+  TiltAxisSearch::Result m_searchResult;
+  std::atomic<bool> m_searchCanceled{ false };
 
   int m_projectionNum;
   int m_shiftRotation;
@@ -96,7 +105,9 @@ public:
   RAWInternal()
   {
     m_reconSliceDirty[0] = m_reconSliceDirty[1] = m_reconSliceDirty[2] = true;
-    m_updateSlicesTimer.setInterval(500);
+    // Previews are computed in the background and superseded by newer
+    // requests, so this only gathers the changes of a single edit.
+    m_updateSlicesTimer.setInterval(50);
     m_updateSlicesTimer.setSingleShot(true);
     QObject::connect(&m_updateSlicesTimer, &QTimer::timeout,
                      [this]() { this->updateDirtyReconSlices(); });
@@ -106,12 +117,33 @@ public:
   {
     tomviz::setupRenderer(this->mainRenderer, this->mainSliceMapper,
                           this->axesActor);
-    tomviz::setupRenderer(this->reconRenderer[0],
-                          this->reconSliceMapper[0]);
-    tomviz::setupRenderer(this->reconRenderer[1],
-                          this->reconSliceMapper[1]);
-    tomviz::setupRenderer(this->reconRenderer[2],
-                          this->reconSliceMapper[2]);
+    this->setupReconCameras();
+  }
+
+  void setupReconCameras()
+  {
+    for (int i = 0; i < 3; ++i) {
+      tomviz::setupRenderer(this->reconRenderer[i], this->reconSliceMapper[i]);
+    }
+  }
+
+  // Shows empty reconstructions of the full preview size until the first
+  // previews arrive, so that the cameras can be set up.
+  void resetReconImages()
+  {
+    int dims[3];
+    m_image->GetDimensions(dims);
+    int size = dims[m_orientation == 0 ? 1 : 0];
+    for (int i = 0; i < 3; ++i) {
+      this->reconImage[i]->Initialize();
+      this->reconImage[i]->SetSpacing(1, 1, 1);
+      this->reconImage[i]->SetExtent(0, size - 1, 0, size - 1, 0, 0);
+      this->reconImage[i]->AllocateScalars(VTK_FLOAT, 1);
+      this->reconImage[i]->GetPointData()->GetScalars()->Fill(0);
+      this->reconSliceMapper[i]->SetInputData(this->reconImage[i].GetPointer());
+      this->reconSliceMapper[i]->SetSliceNumber(0);
+      this->reconSliceMapper[i]->Update();
+    }
   }
 
   void setupColorMaps()
@@ -205,56 +237,47 @@ public:
   {
     vtkImageData* imageData = m_image;
     if (imageData) {
-      int extent[6];
-      imageData->GetExtent(extent);
-      int dims[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1,
-                      extent[5] - extent[4] + 1 };
+      int dims[3];
+      imageData->GetDimensions(dims);
 
       int sliceNumbers[] = { m_slice0, m_slice1, m_slice2 };
       int sliceNum = sliceNumbers[i];
 
-      int Nray = 256; // Size of 2D reconstruction. Fixed for all tilt series
-      std::vector<float> sinogram(Nray * dims[2]);
-      // Approximate in-plance rotation as a shift in y-direction
-      double shift =
-        this->m_shiftRotation +
-        sin(-this->m_tiltRotation * PI / 180) * (sliceNum - dims[0] / 2);
-
-      TomographyTiltSeries::getSinogram(
-        imageData, sliceNum, &sinogram[0], Nray, shift,
-        m_orientation); // Get a sinogram from tilt series
-
-      this->reconImage[i]->SetExtent(0, Nray - 1, 0, Nray - 1, 0, 0);
-      this->reconImage[i]->AllocateScalars(VTK_FLOAT, 1);
-      vtkDataArray* reconArray =
-        this->reconImage[i]->GetPointData()->GetScalars();
-      float* reconPtr = static_cast<float*>(reconArray->GetVoidPointer(0));
-
-      vtkDataArray* tiltAnglesArray =
-        imageData->GetFieldData()->GetArray("tilt_angles");
-      double* tiltAngles =
-        static_cast<double*>(tiltAnglesArray->GetVoidPointer(0));
-
-      TomographyReconstruction::unweightedBackProjection2(
-        &sinogram[0], tiltAngles, reconPtr, dims[2], Nray);
-      this->reconSliceMapper[i]->SetInputData(this->reconImage[i].GetPointer());
-      this->reconSliceMapper[i]->SetSliceNumber(0);
-      this->reconSliceMapper[i]->Update();
-
-      double range[2];
-      reconArray->GetRange(range);
-      vtkSMTransferFunctionProxy::RescaleTransferFunction(
-        this->ReconColorMap[i], range);
-      this->reconSlice[i]->GetProperty()->SetLookupTable(
-        vtkScalarsToColors::SafeDownCast(
-          this->ReconColorMap[i]->GetClientSideObject()));
+      // Approximate in-plane rotation as a shift along the rays
+      double shift = TiltAxisSearch::axisPosition(
+        this->m_shiftRotation, this->m_tiltRotation, sliceNum,
+        dims[m_orientation]);
 
-      tomviz::QVTKGLWidget* sliceView[] = { this->Ui.sliceView_1,
-                                            this->Ui.sliceView_2,
-                                            this->Ui.sliceView_3 };
+      m_previewRequest[i] =
+        m_preview->request(i, sliceNum, shift, m_orientation);
+    }
+  }
 
-      sliceView[i]->renderWindow()->Render();
+  void showReconSlice(int i, int requestId, vtkImageData* image)
+  {
+    if (requestId != m_previewRequest[i]) {
+      return;
     }
+
+    // The coarse preview is replaced by the full resolution one in place, it
+    // covers the same bounds so the camera is left alone.
+    this->reconImage[i]->ShallowCopy(image);
+    this->reconSliceMapper[i]->SetSliceNumber(0);
+    this->reconSliceMapper[i]->Update();
+
+    double range[2];
+    this->reconImage[i]->GetPointData()->GetScalars()->GetRange(range);
+    vtkSMTransferFunctionProxy::RescaleTransferFunction(this->ReconColorMap[i],
+                                                        range);
+    this->reconSlice[i]->GetProperty()->SetLookupTable(
+      vtkScalarsToColors::SafeDownCast(
+        this->ReconColorMap[i]->GetClientSideObject()));
+
+    tomviz::QVTKGLWidget* sliceView[] = { this->Ui.sliceView_1,
+                                          this->Ui.sliceView_2,
+                                          this->Ui.sliceView_3 };
+
+    sliceView[i]->renderWindow()->Render();
   }
 
   void updateSliceLines()
@@ -315,6 +338,7 @@ RotateAlignWidget::RotateAlignWidget(Operator* op,
   : CustomPythonOperatorWidget(p), Internals(new RAWInternal)
 {
   this->Internals->m_image = image;
+  this->Internals->m_preview.reset(new ReconstructionPreview(image));
   this->Internals->Ui.setupUi(this);
 
   this->Internals->readSettings();
@@ -436,6 +460,19 @@ RotateAlignWidget::RotateAlignWidget(Operator* op,
                    [this](int val) { this->onOrientationChanged(val); });
   this->Internals->Ui.orientation->installEventFilter(this);
 
+  QObject::connect(this->Internals->Ui.findTiltAxis, &QPushButton::clicked,
+                   this, &RotateAlignWidget::findTiltAxis);
+  QObject::connect(&this->Internals->m_searchWatcher,
+                   &QFutureWatcherBase::finished, this,
+                   &RotateAlignWidget::findTiltAxisFinished);
+  QObject::connect(this, &RotateAlignWidget::tiltAxisSearchProgress, this,
+                   [this](int completed, int total) {
+                     this->Internals->Ui.findTiltAxisStatus->setText(
+                       QString("Scored %1 of %2 candidates")
+                         .arg(completed)
+                         .arg(total));
+                   });
+
   //  this->connect(this->Internals->Ui.pushButton, SIGNAL(pressed()),
   //                SLOT(onFinalReconButtonPressed()));
 
@@ -484,13 +521,21 @@ RotateAlignWidget::RotateAlignWidget(Operator* op,
 
   // We have to do this here since we need the output to exist so the camera
   // can be initialized below
-  this->Internals->updateReconSlice(0);
-  this->Internals->updateReconSlice(1);
-  this->Internals->updateReconSlice(2);
+  this->Internals->resetReconImages();
 
   this->Internals->setupCameras();
   this->Internals->setupRotationAxisLine();
 
+  QObject::connect(this->Internals->m_preview.data(),
+                   &ReconstructionPreview::previewReady, this,
+                   [this](int index, int requestId,
+                          vtkSmartPointer<vtkImageData> preview) {
+                     this->Internals->showReconSlice(index, requestId, preview);
+                   });
+  this->Internals->updateReconSlice(0);
+  this->Internals->updateReconSlice(1);
+  this->Internals->updateReconSlice(2);
+
   updateWidgets();
 }
 
@@ -500,7 +545,12 @@ CustomPythonOperatorWidget* RotateAlignWidget::New(
   return new RotateAlignWidget(op, data, p);
 }
 
-RotateAlignWidget::~RotateAlignWidget() {}
+RotateAlignWidget::~RotateAlignWidget()
+{
+  // The search reports its progress through this widget.
+  this->Internals->m_searchCanceled = true;
+  this->Internals->m_searchWatcher.waitForFinished();
+}
 
 void RotateAlignWidget::getValues(QMap<QString, QVariant>& map)
 {
@@ -611,8 +661,12 @@ void RotateAlignWidget::onOrientationChanged(int val)
   this->updateControls();
   this->Internals->updateSliceLines();
   this->Internals->moveRotationAxisLine();
+  // The size of the reconstructions follows the tilt axis
+  this->Internals->resetReconImages();
+  this->Internals->setupReconCameras();
   for (int i = 0; i < 3; ++i)
     this->Internals->updateReconSlice(i);
+  updateWidgets();
 }
 
 void RotateAlignWidget::onReconSliceChanged(int idx, int val)
@@ -785,4 +839,81 @@ void RotateAlignWidget::updateControls()
 }
 
 void RotateAlignWidget::onFinalReconButtonPressed() {}
+
+void RotateAlignWidget::findTiltAxis()
+{
+  if (this->Internals->m_searchWatcher.isRunning()) {
+    this->Internals->m_searchCanceled = true;
+    return;
+  }
+
+  vtkSmartPointer<vtkImageData> image = this->Internals->m_image;
+  int tiltAxis = this->Internals->m_orientation;
+  auto tiltAngles = DataSource::getTiltAngles(image);
+  int dims[3];
+  image->GetDimensions(dims);
+  if (tiltAngles.size() < dims[2]) {
+    this->Internals->Ui.findTiltAxisStatus->setText("No tilt angles");
+    return;
+  }
+
+  // The shift range grows with the projections, the grid stays the same and
+  // is refined down to whole pixels and half degrees.
+  TiltAxisSearch::Options options;
+  int numberOfRays = dims[tiltAxis == 0 ? 1 : 0];
+  options.shiftRange = std::max(20, numberOfRays / 8);
+  options.shiftStep = options.shiftRange / 5;
+  while (options.shiftStep / (1 << options.refinements) > 1) {
+    ++options.refinements;
+  }
+
+  this->Internals->m_searchCanceled = false;
+  this->Internals->Ui.findTiltAxis->setText("Cancel");
+  this->Internals->Ui.orientation->setEnabled(false);
+  this->Internals->Ui.findTiltAxisStatus->setText("Reading sinograms...");
+  auto future = QtConcurrent::run([this, image, tiltAxis, tiltAngles,
+                                   options]() {
+    // Only the slices that are reconstructed are copied, a full cache would
+    // be a second copy of the tilt series.
+    auto slices = TiltAxisSearch::representativeSlices(
+      TomographyTiltSeries::sliceIntensities(image, tiltAxis),
+      options.numberOfSlices);
+    TomographyTiltSeries::SinogramCache sinograms(
+      image, tiltAxis, slices, 0,
+      [this]() { return this->Internals->m_searchCanceled.load(); });
+    if (sinograms.empty()) {
+      return false;
+    }
+    auto progress = [this](int completed, int total) {
+      emit tiltAxisSearchProgress(completed, total);
+      return !this->Internals->m_searchCanceled;
+    };
+    std::vector<double> angles(tiltAngles.begin(), tiltAngles.end());
+    return TiltAxisSearch::search(sinograms, angles.data(), options,
+                                  this->Internals->m_searchResult, progress);
+  });
+  this->Internals->m_searchWatcher.setFuture(future);
+}
+
+void RotateAlignWidget::findTiltAxisFinished()
+{
+  this->Internals->Ui.findTiltAxis->setText("Find Tilt Axis");
+  this->Internals->Ui.orientation->setEnabled(true);
+  if (!this->Internals->m_searchWatcher.result()) {
+    this->Internals->Ui.findTiltAxisStatus->setText("Search canceled");
+    return;
+  }
+
+  // The operator shifts by whole pixels.
+  const auto& result = this->Internals->m_searchResult;
+  this->Internals->m_shiftRotation =
+    static_cast<int>(std::lround(result.shift));
+  this->Internals->m_tiltRotation = result.angle;
+  updateControls();
+  onRotationAxisChanged();
+  this->Internals->Ui.findTiltAxisStatus->setText(
+    QString("Found shift %1, rotation %2")
+      .arg(this->Internals->m_shiftRotation)
+      .arg(result.angle));
+}
 } // namespace tomviz
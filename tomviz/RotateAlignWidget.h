@@ -35,6 +35,7 @@ public slots:
 
 signals:
   void creatingAlignedData();
+  void tiltAxisSearchProgress(int completed, int total);
 
 protected slots:
   void onProjectionNumberChanged(int);
@@ -48,6 +49,9 @@ protected slots:
 
   void onFinalReconButtonPressed();
 
+  void findTiltAxis();
+  void findTiltAxisFinished();
+
   void showChangeColorMapDialog0() { this->showChangeColorMapDialog(0); }
   void showChangeColorMapDialog1() { this->showChangeColorMapDialog(1); }
   void showChangeColorMapDialog2() { this->showChangeColorMapDialog(2); }
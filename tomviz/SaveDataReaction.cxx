@@ -36,14 +36,63 @@
 
 #include <cassert>
 
+#include <QCheckBox>
 #include <QDebug>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QMessageBox>
 #include <QRegularExpression>
 #include <QStringList>
+#include <QVBoxLayout>
 
 namespace tomviz {
 
+namespace {
+
+// Ask for the layout of the volume in an EMD or HDF5 file. Returns false if
+// the user cancels.
+bool askForHdf5Options(const QString& suffix, QVariantMap& options)
+{
+  QDialog dialog(tomviz::mainWidget());
+  dialog.setWindowTitle("Save Options");
+  QVBoxLayout layout;
+  dialog.setLayout(&layout);
+
+  QCheckBox compress("Compress the data");
+  compress.setToolTip(
+    "Store the volume in compressed chunks of whole slices. The file is "
+    "smaller, but slower to write, and tools that map the data set directly "
+    "can't read it.");
+  layout.addWidget(&compress);
+
+  // Only EMD files store a pyramid.
+  QCheckBox pyramid("Store reduced resolution levels");
+  pyramid.setToolTip(
+    "Store copies of large volumes downsampled by 2, 4, ... so that they can "
+    "be opened at a coarse resolution first and refined later.");
+  pyramid.setVisible(suffix == "emd");
+  layout.addWidget(&pyramid);
+
+  QDialogButtonBox buttons(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  layout.addWidget(&buttons);
+  QObject::connect(&buttons, &QDialogButtonBox::accepted, &dialog,
+                   &QDialog::accept);
+  QObject::connect(&buttons, &QDialogButtonBox::rejected, &dialog,
+                   &QDialog::reject);
+
+  if (!dialog.exec()) {
+    return false;
+  }
+
+  options["chunk"] = compress.isChecked();
+  options["pyramid"] = pyramid.isChecked();
+  return true;
+}
+
+} // namespace
+
 SaveDataReaction::SaveDataReaction(QAction* parentObject)
   : pqReaction(parentObject)
 {
@@ -101,11 +150,18 @@ void SaveDataReaction::onTriggered()
     if (!hasExtension) {
       filename = QString("%1%2").arg(filename, extensions[0]);
     }
-    saveData(filename);
+    QVariantMap options;
+    QString suffix = QFileInfo(filename).suffix();
+    if ((suffix == "emd" || suffix == "h5") &&
+        !askForHdf5Options(suffix, options)) {
+      return;
+    }
+    saveData(filename, options);
   }
 }
 
-bool SaveDataReaction::saveData(const QString& filename)
+bool SaveDataReaction::saveData(const QString& filename,
+                                const QVariantMap& options)
 {
   auto server = pqActiveObjects::instance().activeServer();
   auto source = ActiveObjects::instance().activeDataSource();
@@ -126,9 +182,19 @@ bool SaveDataReaction::saveData(const QString& filename)
     return false;
   }
 
+  // Data read from a coarse level of a pyramid, or derived from it, would
+  // replace the full resolution data.
+  if (!result && source->resolutionLevel() > 0) {
+    QMessageBox::warning(
+      tomviz::mainWidget(), "Reduced Resolution",
+      "The data was loaded at a reduced resolution. Load the full resolution "
+      "data before saving it.");
+    return false;
+  }
+
   QFileInfo info(filename);
   if (info.suffix() == "emd") {
-    if (!EmdFormat::write(filename.toLatin1().data(), source)) {
+    if (!EmdFormat::write(filename.toLatin1().data(), source, options)) {
       qCritical() << "Failed to write out data.";
       return false;
     } else {
@@ -137,7 +203,7 @@ bool SaveDataReaction::saveData(const QString& filename)
     }
   } else if (info.suffix() == "h5") {
     DataExchangeFormat writer;
-    if (!writer.write(filename.toLatin1().data(), source)) {
+    if (!writer.write(filename.toLatin1().data(), source, options)) {
       qCritical() << "Failed to write out data.";
       return false;
     } else {
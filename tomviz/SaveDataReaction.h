@@ -6,6 +6,8 @@
 
 #include <pqReaction.h>
 
+#include <QVariantMap>
+
 namespace tomviz {
 class DataSource;
 class PythonWriterFactory;
@@ -19,8 +21,10 @@ class SaveDataReaction : public pqReaction
 public:
   SaveDataReaction(QAction* parentAction);
 
-  /// Save the file
-  bool saveData(const QString& filename);
+  /// Save the file. The options are passed on to the EMD and HDF5 writers,
+  /// see GenericHDF5Format::writeVolume().
+  bool saveData(const QString& filename,
+                const QVariantMap& options = QVariantMap());
 
 protected:
   /// Called when the data changes to enable/disable the menu item
@@ -0,0 +1,373 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "SharedVolumeFormat.h"
+
+#include "DataSource.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStorageInfo>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace tomviz {
+
+namespace {
+
+const int Version = 1;
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+const char ByteOrder = '<';
+#else
+const char ByteOrder = '>';
+#endif
+
+// The numpy type string (without the byte order) of a VTK type.
+QString numpyType(int vtkType)
+{
+  switch (vtkType) {
+    case VTK_SIGNED_CHAR:
+      return "i1";
+    case VTK_UNSIGNED_CHAR:
+      return "u1";
+    case VTK_SHORT:
+      return "i2";
+    case VTK_UNSIGNED_SHORT:
+      return "u2";
+    case VTK_INT:
+      return "i4";
+    case VTK_UNSIGNED_INT:
+      return "u4";
+    case VTK_LONG_LONG:
+      return "i8";
+    case VTK_UNSIGNED_LONG_LONG:
+      return "u8";
+    case VTK_LONG:
+      return QString("i%1").arg(sizeof(long));
+    case VTK_UNSIGNED_LONG:
+      return QString("u%1").arg(sizeof(unsigned long));
+    case VTK_ID_TYPE:
+      return QString("i%1").arg(sizeof(vtkIdType));
+    case VTK_FLOAT:
+      return "f4";
+    case VTK_DOUBLE:
+      return "f8";
+  }
+  return QString();
+}
+
+int vtkType(QString name)
+{
+  // Only native byte order is mapped, "|" marks single bytes.
+  if (name.startsWith(ByteOrder) || name.startsWith('|') ||
+      name.startsWith('=')) {
+    name.remove(0, 1);
+  }
+
+  const int types[] = { VTK_SIGNED_CHAR, VTK_UNSIGNED_CHAR,
+                        VTK_SHORT,       VTK_UNSIGNED_SHORT,
+                        VTK_INT,         VTK_UNSIGNED_INT,
+                        VTK_LONG_LONG,   VTK_UNSIGNED_LONG_LONG,
+                        VTK_FLOAT,       VTK_DOUBLE };
+  for (int type : types) {
+    if (numpyType(type) == name) {
+      return type;
+    }
+  }
+  return -1;
+}
+
+qint64 arrayBytes(vtkDataArray* array)
+{
+  return static_cast<qint64>(array->GetNumberOfValues()) *
+         array->GetDataTypeSize();
+}
+
+// Copy size bytes between data and the file, through a mapping of the file.
+bool copyMapped(QFile& file, void* data, qint64 size, bool toFile)
+{
+  if (size == 0) {
+    return true;
+  }
+
+  auto* mapped = file.map(0, size);
+  if (!mapped) {
+    qCritical() << "Unable to map" << file.fileName() << file.errorString();
+    return false;
+  }
+  if (toFile) {
+    std::memcpy(mapped, data, size);
+  } else {
+    std::memcpy(data, mapped, size);
+  }
+  file.unmap(mapped);
+  return true;
+}
+
+#if defined(Q_OS_UNIX)
+// The files mapped as the memory of arrays, by address. They are unmapped when
+// the array frees its memory. The files may be removed while they are mapped.
+std::mutex mappingsMutex;
+std::map<void*, QFile*> mappings;
+
+void unmapArray(void* data)
+{
+  QFile* file = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mappingsMutex);
+    auto it = mappings.find(data);
+    if (it == mappings.end()) {
+      return;
+    }
+    file = it->second;
+    mappings.erase(it);
+  }
+  file->unmap(static_cast<uchar*>(data));
+  delete file;
+}
+
+// Map the file copy on write as the memory of array, instead of copying it.
+bool mapArray(const QString& fileName, vtkDataArray* array, vtkIdType values)
+{
+  qint64 size = static_cast<qint64>(values) * array->GetDataTypeSize();
+  auto* file = new QFile(fileName);
+  uchar* mapped = nullptr;
+  if (size > 0 && file->open(QIODevice::ReadOnly) && file->size() >= size) {
+    mapped = file->map(0, size, QFileDevice::MapPrivateOption);
+  }
+  if (!mapped) {
+    delete file;
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mappingsMutex);
+    mappings[mapped] = file;
+  }
+  array->SetNumberOfComponents(1);
+  array->SetVoidArray(mapped, values, 0, VTK_DATA_ARRAY_USER_DEFINED);
+  array->SetArrayFreeFunction(unmapArray);
+  return true;
+}
+#endif
+
+} // namespace
+
+const char* SharedVolumeFormat::EXTENSION = ".tvshm";
+
+bool SharedVolumeFormat::canWrite(vtkImageData* image)
+{
+  if (!image || !image->GetPointData()->GetScalars()) {
+    return false;
+  }
+
+  auto* pd = image->GetPointData();
+  for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+    auto* array = pd->GetArray(i);
+    if (!array || !array->GetName() || array->GetNumberOfComponents() != 1 ||
+        numpyType(array->GetDataType()).isEmpty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+qint64 SharedVolumeFormat::sizeInBytes(vtkImageData* image)
+{
+  qint64 bytes = 0;
+  auto* pd = image->GetPointData();
+  for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+    bytes += arrayBytes(pd->GetArray(i));
+  }
+  return bytes;
+}
+
+QString SharedVolumeFormat::sharedTemporaryDirTemplate(qint64 bytes)
+{
+#if defined(Q_OS_LINUX)
+  // Writing through a mapping past the space left on a tmpfs raises SIGBUS,
+  // so the input has to fit. The executor checks the room left for its output
+  // itself, and falls back to an EMD file.
+  QStorageInfo storage("/dev/shm");
+  if (storage.isValid() && storage.isReady() && !storage.isReadOnly() &&
+      storage.bytesAvailable() > bytes) {
+    return QDir("/dev/shm").filePath("tomviz-XXXXXX");
+  }
+#else
+  Q_UNUSED(bytes)
+#endif
+  return QString();
+}
+
+bool SharedVolumeFormat::write(const std::string& fileName,
+                               vtkImageData* image)
+{
+  if (!canWrite(image)) {
+    qCritical() << "Unable to share the arrays of the image";
+    return false;
+  }
+
+  QFileInfo info(QString::fromStdString(fileName));
+  auto* pd = image->GetPointData();
+  QJsonArray arrays;
+  for (int i = 0; i < pd->GetNumberOfArrays(); ++i) {
+    auto* array = pd->GetArray(i);
+    auto rawName = QString("%1_%2.raw").arg(info.completeBaseName()).arg(i);
+    QFile raw(info.dir().filePath(rawName));
+    qint64 size = arrayBytes(array);
+    if (!raw.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+        !raw.resize(size) ||
+        !copyMapped(raw, array->GetVoidPointer(0), size, true)) {
+      qCritical() << "Unable to write" << raw.fileName();
+      return false;
+    }
+
+    QJsonObject arrayObj;
+    arrayObj["name"] = array->GetName();
+    arrayObj["dtype"] =
+      (array->GetDataTypeSize() == 1 ? QString('|') : QString(ByteOrder)) +
+      numpyType(array->GetDataType());
+    arrayObj["file"] = rawName;
+    arrays.append(arrayObj);
+  }
+
+  int dims[3];
+  double spacing[3];
+  image->GetDimensions(dims);
+  image->GetSpacing(spacing);
+
+  QJsonObject descriptor;
+  descriptor["version"] = Version;
+  descriptor["dimensions"] = QJsonArray({ dims[0], dims[1], dims[2] });
+  descriptor["spacing"] = QJsonArray({ spacing[0], spacing[1], spacing[2] });
+  descriptor["activeScalars"] = pd->GetScalars()->GetName();
+  descriptor["arrays"] = arrays;
+  if (DataSource::hasTiltAngles(image)) {
+    QJsonArray angles;
+    foreach (double angle, DataSource::getTiltAngles(image)) {
+      angles.append(angle);
+    }
+    descriptor["tiltAngles"] = angles;
+  }
+
+  QFile file(info.filePath());
+  if (!file.open(QIODevice::WriteOnly)) {
+    qCritical() << "Unable to write" << file.fileName();
+    return false;
+  }
+  file.write(QJsonDocument(descriptor).toJson());
+  return true;
+}
+
+bool SharedVolumeFormat::read(const std::string& fileName, vtkImageData* image)
+{
+  QFileInfo info(QString::fromStdString(fileName));
+  QFile file(info.filePath());
+  if (!file.open(QIODevice::ReadOnly)) {
+    qCritical() << "Unable to read" << file.fileName();
+    return false;
+  }
+
+  auto descriptor = QJsonDocument::fromJson(file.readAll()).object();
+  if (descriptor["version"].toInt() != Version) {
+    qCritical() << "Unsupported shared volume" << file.fileName();
+    return false;
+  }
+
+  auto dimsArray = descriptor["dimensions"].toArray();
+  auto spacingArray = descriptor["spacing"].toArray();
+  if (dimsArray.size() != 3) {
+    qCritical() << "Invalid dimensions in" << file.fileName();
+    return false;
+  }
+  int dims[3];
+  double spacing[3] = { 1.0, 1.0, 1.0 };
+  for (int i = 0; i < 3; ++i) {
+    dims[i] = dimsArray[i].toInt();
+    if (spacingArray.size() == 3) {
+      spacing[i] = spacingArray[i].toDouble();
+    }
+  }
+
+  image->Initialize();
+  image->SetDimensions(dims);
+  image->SetSpacing(spacing);
+  vtkIdType values = static_cast<vtkIdType>(dims[0]) * dims[1] * dims[2];
+  foreach (const QJsonValue& value, descriptor["arrays"].toArray()) {
+    auto arrayObj = value.toObject();
+    int type = vtkType(arrayObj["dtype"].toString());
+    if (type < 0) {
+      qCritical() << "Unsupported data type" << arrayObj["dtype"].toString();
+      return false;
+    }
+
+    vtkSmartPointer<vtkDataArray> array;
+    array.TakeReference(vtkDataArray::CreateDataArray(type));
+    array->SetName(arrayObj["name"].toString().toUtf8().data());
+    auto rawName = info.dir().filePath(arrayObj["file"].toString());
+
+#if defined(Q_OS_UNIX)
+    // The pages are shared with the file until the array is modified.
+    if (mapArray(rawName, array, values)) {
+      image->GetPointData()->AddArray(array);
+      continue;
+    }
+#endif
+
+    array->SetNumberOfTuples(values);
+    qint64 size = static_cast<qint64>(values) * array->GetDataTypeSize();
+    QFile raw(rawName);
+    if (!raw.open(QIODevice::ReadOnly) || raw.size() < size ||
+        !copyMapped(raw, array->GetVoidPointer(0), size, false)) {
+      qCritical() << "Unable to read" << raw.fileName();
+      return false;
+    }
+    image->GetPointData()->AddArray(array);
+  }
+
+  auto active = descriptor["activeScalars"].toString().toUtf8();
+  image->GetPointData()->SetActiveScalars(active.data());
+  if (!image->GetPointData()->GetScalars()) {
+    qCritical() << "No active scalars in" << file.fileName();
+    return false;
+  }
+
+  if (descriptor.contains("tiltAngles")) {
+    QVector<double> angles;
+    foreach (const QJsonValue& angle, descriptor["tiltAngles"].toArray()) {
+      angles.append(angle.toDouble());
+    }
+    DataSource::setTiltAngles(image, angles);
+    DataSource::setType(image, DataSource::TiltSeries);
+  }
+
+  return true;
+}
+
+void SharedVolumeFormat::remove(const std::string& fileName)
+{
+  QFileInfo info(QString::fromStdString(fileName));
+  QFile file(info.filePath());
+  if (file.open(QIODevice::ReadOnly)) {
+    auto descriptor = QJsonDocument::fromJson(file.readAll()).object();
+    foreach (const QJsonValue& value, descriptor["arrays"].toArray()) {
+      QFile::remove(info.dir().filePath(value.toObject()["file"].toString()));
+    }
+    file.close();
+  }
+  file.remove();
+}
+} // namespace tomviz
@@ -0,0 +1,49 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizSharedVolumeFormat_h
+#define tomvizSharedVolumeFormat_h
+
+#include <string>
+
+#include <QString>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/// Hands volumes over to and from the external Python executor through
+/// memory mapped files. Each array is stored raw, in the Fortran order VTK
+/// uses, so that both sides can map it without decoding or reordering it. A
+/// small JSON descriptor (with the .tvshm extension) lists the arrays, with
+/// their data types and files, along with the dimensions, spacing and tilt
+/// angles of the volume. When the files live on a memory backed file system,
+/// such as /dev/shm on Linux, the data never touches the disk. On Unix the
+/// arrays read back are mapped copy on write rather than copied, and the files
+/// may be removed while the arrays are in use.
+class SharedVolumeFormat
+{
+public:
+  static const char* EXTENSION;
+
+  /// Whether image can be handed over, every array needs a single component
+  /// of a type numpy understands.
+  static bool canWrite(vtkImageData* image);
+
+  /// The number of bytes the arrays of image take up.
+  static qint64 sizeInBytes(vtkImageData* image);
+
+  /// A template for a QTemporaryDir on a memory backed file system with room
+  /// for bytes, or an empty string if there isn't one.
+  static QString sharedTemporaryDirTemplate(qint64 bytes);
+
+  /// Write the descriptor to fileName, and each array to a file next to it.
+  static bool write(const std::string& fileName, vtkImageData* image);
+  static bool read(const std::string& fileName, vtkImageData* image);
+
+  /// Remove the descriptor and the files of the arrays it lists.
+  static void remove(const std::string& fileName);
+};
+} // namespace tomviz
+
+#endif // tomvizSharedVolumeFormat_h
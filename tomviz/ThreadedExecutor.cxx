@@ -3,6 +3,11 @@
 
 #include "ThreadedExecutor.h"
 
+#include "Operator.h"
+#include "OperatorResultCache.h"
+
+#include <vtkFieldData.h>
+
 namespace tomviz {
 
 class PipelineFutureThreadedInternal : public Pipeline::Future
@@ -47,7 +52,6 @@ Pipeline::Future* ThreadPipelineExecutor::execute(vtkDataObject* data,
   if (end == -1) {
     end = operators.size();
   }
-  operators = operators.mid(start, end - start);
 
   // Cancel any running operators. TODO in the future we should be able to add
   // operators to end of a running pipeline.
@@ -55,19 +59,73 @@ Pipeline::Future* ThreadPipelineExecutor::execute(vtkDataObject* data,
     m_future->cancel();
   }
 
-  auto copy = data->NewInstance();
-  copy->DeepCopy(data);
+  // Resume from the output of the last operator that has a cached result.
+  auto cache = pipeline()->resultCache();
+  QMap<Operator*, QByteArray> keys;
+  QList<Operator*> cachedOperators;
+  vtkDataObject* input = data;
+  vtkSmartPointer<vtkImageData> cachedInput;
+  if (cache->isEnabled()) {
+    auto chainKeys =
+      OperatorResultCache::chainKeys(data, operators, start, end);
+    for (int i = chainKeys.size() - 1; i >= 0; --i) {
+      cachedInput = cache->find(chainKeys[i]);
+      if (cachedInput) {
+        input = cachedInput;
+        cachedOperators = operators.mid(start, i + 1);
+        start += i + 1;
+        chainKeys = chainKeys.mid(i + 1);
+        break;
+      }
+    }
+    for (int i = 0; i < chainKeys.size(); ++i) {
+      keys[operators[start + i]] = chainKeys[i];
+    }
+  }
+  operators = operators.mid(start, end - start);
+
+  // The operators that produced the cached result don't need to run again,
+  // but may have been edited back to parameters they were run with before.
+  foreach (Operator* op, cachedOperators) {
+    if (op->isModified() || op->state() != OperatorState::Complete) {
+      op->setComplete();
+      emit op->transformingDone(TransformResult::Complete);
+    }
+  }
+
+  auto copy = input->NewInstance();
 
   if (operators.isEmpty()) {
-    emit pipeline()->finished();
-    auto future = new Pipeline::Future();
+    copy->DeepCopy(input);
+    // If everything came from the cache the result still has to flow to the
+    // operators' outputs, so report them as the ones that ran.
+    if (cachedOperators.isEmpty()) {
+      emit pipeline()->finished();
+    }
+    auto future = new Pipeline::Future(cachedOperators);
     future->setResult(vtkImageData::SafeDownCast(copy));
     copy->FastDelete();
     QTimer::singleShot(0, [future] { emit future->finished(); });
     return future;
   }
 
-  m_future = m_worker->run(copy, operators);
+  PipelineWorker::OperatorCompleted completed = nullptr;
+  if (!keys.isEmpty()) {
+    // Holds a reference to the cache, which the worker may still insert into
+    // after the pipeline is gone.
+    completed = [cache, keys](Operator* op, vtkDataObject* result) {
+      if (keys.contains(op)) {
+        cache->insert(keys.value(op), result);
+      }
+    };
+  }
+  // Rather than copying the input up front, share its arrays. The worker
+  // copies them before the first operator that modifies its data in place, so
+  // a pipeline of operators that produce new arrays never copies them. The
+  // field data is small and often edited in place, so it is always copied.
+  copy->ShallowCopy(input);
+  copy->GetFieldData()->DeepCopy(input->GetFieldData());
+  m_future = m_worker->run(copy, operators, completed, input);
   auto future = new PipelineFutureThreadedInternal(
     vtkImageData::SafeDownCast(copy), operators, m_future.data(), this);
   copy->FastDelete();
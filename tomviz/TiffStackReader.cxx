@@ -0,0 +1,135 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "TiffStackReader.h"
+
+#include "ParallelUtilities.h"
+#include "TiffUtilities.h"
+
+#include <QDebug>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace tomviz {
+
+namespace {
+
+TiffStackReader::Header toHeader(const TiffImageInfo& info)
+{
+  TiffStackReader::Header header;
+  header.width = info.width;
+  header.height = info.height;
+  header.components = info.components;
+  header.scalarType = info.scalarType;
+  return header;
+}
+
+TiffStackReader::Header readFileHeader(const QString& fileName)
+{
+  TiffStackReader::Header header;
+  TIFF* tiff = TIFFOpen(fileName.toLocal8Bit().data(), "r");
+  if (tiff) {
+    header = toHeader(readTiffImageInfo(tiff));
+    TIFFClose(tiff);
+  }
+  return header;
+}
+
+} // namespace
+
+TiffStackReader::Header TiffStackReader::readHeader(const QString& fileName)
+{
+  TiffWarningsSilencer silencer;
+  return readFileHeader(fileName);
+}
+
+QVector<TiffStackReader::Header> TiffStackReader::readHeaders(
+  const QStringList& fileNames)
+{
+  TiffWarningsSilencer silencer;
+  QVector<Header> headers(fileNames.size());
+  parallelFor(0, fileNames.size(),
+              [&](int i) { headers[i] = readFileHeader(fileNames[i]); });
+  return headers;
+}
+
+bool TiffStackReader::isTiffStack(const QStringList& fileNames)
+{
+  if (fileNames.size() < 2) {
+    return false;
+  }
+
+  foreach (const QString& fileName, fileNames) {
+    auto name = fileName.toLower();
+    if (!(name.endsWith(".tif") || name.endsWith(".tiff")) ||
+        name.endsWith(".ome.tif")) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool TiffStackReader::read(const QStringList& fileNames, vtkImageData* image)
+{
+  if (fileNames.isEmpty() || !image) {
+    return false;
+  }
+
+  TiffWarningsSilencer silencer;
+  Header header = readFileHeader(fileNames[0]);
+  if (header.width <= 0 || header.height <= 0) {
+    qCritical() << "Unable to read the TIFF image" << fileNames[0];
+    return false;
+  } else if (!header.isValid()) {
+    // Palette, white-is-zero and other layouts are left to the TIFF series
+    // reader.
+    return false;
+  }
+
+  // Every file is decoded straight into its slice of the volume, so nothing
+  // is copied after the fact.
+  image->SetDimensions(header.width, header.height, fileNames.size());
+  image->AllocateScalars(header.scalarType, header.components);
+  auto scalars = image->GetPointData()->GetScalars();
+  size_t pixelBytes =
+    static_cast<size_t>(header.components) * scalars->GetDataTypeSize();
+  size_t sliceBytes = pixelBytes * header.width * header.height;
+  auto* data = static_cast<char*>(scalars->GetVoidPointer(0));
+
+  std::atomic<int> failed(-1);
+  auto body = [&](int i) {
+    // The rows are flipped, so that the first row of the image ends up at the
+    // top of the slice.
+    char* slice = data + i * sliceBytes;
+    size_t rowBytes = pixelBytes * header.width;
+    auto row = [&](unsigned int r) {
+      return slice + (header.height - 1 - r) * rowBytes;
+    };
+    TIFF* tiff = TIFFOpen(fileNames[i].toLocal8Bit().data(), "r");
+    bool ok = false;
+    if (tiff) {
+      auto info = readTiffImageInfo(tiff);
+      ok = toHeader(info) == header && readTiffImage(tiff, info, row);
+      TIFFClose(tiff);
+    }
+    if (!ok) {
+      failed = i;
+    }
+  };
+  auto progress = [&](int, int) { return failed < 0; };
+  if (!parallelFor(0, fileNames.size(), body, progress)) {
+    int i = failed;
+    qCritical() << "Unable to read" << fileNames[std::max(i, 0)]
+                << "as a slice of the TIFF stack";
+    return false;
+  }
+
+  image->Modified();
+  return true;
+}
+} // namespace tomviz
@@ -0,0 +1,55 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizTiffStackReader_h
+#define tomvizTiffStackReader_h
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/// Reads a stack of single image TIFF files, one file per z-slice, into a
+/// volume. The files are decoded concurrently, each straight into its slice of
+/// the preallocated volume. The slices match what vtkTIFFReader produces, with
+/// the first row of each image at the top.
+class TiffStackReader
+{
+public:
+  /// What the tags of a TIFF file say about its image.
+  struct Header
+  {
+    int width = -1;
+    int height = -1;
+    int components = 0;
+    int scalarType = -1;
+
+    bool isValid() const { return width > 0 && height > 0 && scalarType >= 0; }
+    bool operator==(const Header& other) const
+    {
+      return width == other.width && height == other.height &&
+             components == other.components && scalarType == other.scalarType;
+    }
+    bool operator!=(const Header& other) const { return !(*this == other); }
+  };
+
+  /// Read only the tags of the file, none of the image data is decoded.
+  static Header readHeader(const QString& fileName);
+
+  /// Read the headers of all the files, concurrently.
+  static QVector<Header> readHeaders(const QStringList& fileNames);
+
+  /// Whether the files look like a stack of TIFF images.
+  static bool isTiffStack(const QStringList& fileNames);
+
+  /// Read the stack into image. Returns false if a file can't be read, if the
+  /// images don't all have the same size and type, or if their layout isn't
+  /// supported, see TiffImageInfo.
+  static bool read(const QStringList& fileNames, vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif
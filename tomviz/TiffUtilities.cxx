@@ -0,0 +1,151 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "TiffUtilities.h"
+
+#include <QByteArray>
+
+#include <vtkType.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tomviz {
+
+namespace {
+
+int tiffScalarType(unsigned short bitsPerSample, unsigned short sampleFormat)
+{
+  if (sampleFormat == SAMPLEFORMAT_IEEEFP) {
+    switch (bitsPerSample) {
+      case 32:
+        return VTK_FLOAT;
+      case 64:
+        return VTK_DOUBLE;
+    }
+  } else if (sampleFormat == SAMPLEFORMAT_INT) {
+    switch (bitsPerSample) {
+      case 8:
+        return VTK_SIGNED_CHAR;
+      case 16:
+        return VTK_SHORT;
+      case 32:
+        return VTK_INT;
+    }
+  } else if (sampleFormat == SAMPLEFORMAT_UINT) {
+    switch (bitsPerSample) {
+      case 8:
+        return VTK_UNSIGNED_CHAR;
+      case 16:
+        return VTK_UNSIGNED_SHORT;
+      case 32:
+        return VTK_UNSIGNED_INT;
+    }
+  }
+  return -1;
+}
+
+bool readTiles(TIFF* tiff, const TiffImageInfo& info,
+               const std::function<char*(unsigned int)>& row)
+{
+  unsigned int tileWidth = 0, tileHeight = 0;
+  TIFFGetField(tiff, TIFFTAG_TILEWIDTH, &tileWidth);
+  TIFFGetField(tiff, TIFFTAG_TILELENGTH, &tileHeight);
+  if (tileWidth == 0 || tileHeight == 0) {
+    return false;
+  }
+
+  unsigned int width = info.width;
+  unsigned int height = info.height;
+  size_t pixelBytes = info.pixelBytes();
+  QByteArray tile(static_cast<int>(TIFFTileSize(tiff)), Qt::Uninitialized);
+  for (unsigned int y = 0; y < height; y += tileHeight) {
+    for (unsigned int x = 0; x < width; x += tileWidth) {
+      if (TIFFReadTile(tiff, tile.data(), x, y, 0, 0) < 0) {
+        return false;
+      }
+      // Tiles on the right and bottom edges overhang the image.
+      unsigned int columns = std::min(tileWidth, width - x);
+      unsigned int rows = std::min(tileHeight, height - y);
+      for (unsigned int r = 0; r < rows; ++r) {
+        std::memcpy(row(y + r) + x * pixelBytes,
+                    tile.constData() + r * tileWidth * pixelBytes,
+                    columns * pixelBytes);
+      }
+    }
+  }
+  return true;
+}
+
+bool readScanlines(TIFF* tiff, const TiffImageInfo& info,
+                   const std::function<char*(unsigned int)>& row)
+{
+  // Scanlines are read in order, which works for any compression.
+  size_t rowBytes = info.width * info.pixelBytes();
+  QByteArray line(static_cast<int>(TIFFScanlineSize(tiff)),
+                  Qt::Uninitialized);
+  if (static_cast<size_t>(line.size()) < rowBytes) {
+    return false;
+  }
+  for (unsigned int r = 0; r < static_cast<unsigned int>(info.height); ++r) {
+    if (TIFFReadScanline(tiff, line.data(), r, 0) <= 0) {
+      return false;
+    }
+    std::memcpy(row(r), line.constData(), rowBytes);
+  }
+  return true;
+}
+
+} // namespace
+
+TiffImageInfo readTiffImageInfo(TIFF* tiff)
+{
+  unsigned int width = 0, height = 0;
+  unsigned short samplesPerPixel = 1, bitsPerSample = 8;
+  unsigned short sampleFormat = SAMPLEFORMAT_UINT;
+  unsigned short planarConfig = PLANARCONFIG_CONTIG;
+  unsigned short photometric = PHOTOMETRIC_MINISBLACK;
+  TIFFGetField(tiff, TIFFTAG_IMAGEWIDTH, &width);
+  TIFFGetField(tiff, TIFFTAG_IMAGELENGTH, &height);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLESPERPIXEL, &samplesPerPixel);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_BITSPERSAMPLE, &bitsPerSample);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_SAMPLEFORMAT, &sampleFormat);
+  TIFFGetFieldDefaulted(tiff, TIFFTAG_PLANARCONFIG, &planarConfig);
+  TIFFGetField(tiff, TIFFTAG_PHOTOMETRIC, &photometric);
+
+  TiffImageInfo info;
+  info.width = static_cast<int>(width);
+  info.height = static_cast<int>(height);
+  info.components = samplesPerPixel;
+  info.bytesPerSample = bitsPerSample / 8;
+  // Palette indices and inverted grayscale need their values mapped, and
+  // separate planes interleaved, so they are left to vtkTIFFReader.
+  bool plain = planarConfig == PLANARCONFIG_CONTIG || samplesPerPixel == 1;
+  if (plain && photometric != PHOTOMETRIC_PALETTE &&
+      photometric != PHOTOMETRIC_MINISWHITE) {
+    info.scalarType = tiffScalarType(bitsPerSample, sampleFormat);
+  }
+  return info;
+}
+
+bool readTiffImage(TIFF* tiff, const TiffImageInfo& info,
+                   const std::function<char*(unsigned int)>& row)
+{
+  if (!info.isValid()) {
+    return false;
+  }
+  return TIFFIsTiled(tiff) ? readTiles(tiff, info, row)
+                           : readScanlines(tiff, info, row);
+}
+
+TiffWarningsSilencer::TiffWarningsSilencer()
+  : m_previous(TIFFSetWarningHandler(nullptr))
+{
+}
+
+TiffWarningsSilencer::~TiffWarningsSilencer()
+{
+  TIFFSetWarningHandler(m_previous);
+}
+
+} // namespace tomviz
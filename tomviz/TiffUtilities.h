@@ -0,0 +1,58 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizTiffUtilities_h
+#define tomvizTiffUtilities_h
+
+#include <cstddef>
+#include <functional>
+
+extern "C" {
+#include "vtk_tiff.h"
+}
+
+namespace tomviz {
+
+/// What the tags of the current directory of a TIFF say about its image.
+struct TiffImageInfo
+{
+  int width = 0;
+  int height = 0;
+  int components = 0;
+  int bytesPerSample = 0;
+  /// The VTK type of the samples, or -1 if the samples can't be copied as
+  /// they are: separate planes, palette and white-is-zero images, or sample
+  /// types with no VTK equivalent.
+  int scalarType = -1;
+
+  bool isValid() const { return width > 0 && height > 0 && scalarType >= 0; }
+  size_t pixelBytes() const
+  {
+    return static_cast<size_t>(components) * bytesPerSample;
+  }
+};
+
+/// Read the tags of the current directory, none of the image is decoded.
+TiffImageInfo readTiffImageInfo(TIFF* tiff);
+
+/// Decode the image of the current directory, tiled or in strips. row(r)
+/// returns where row r of the image is copied to, width * pixelBytes() bytes.
+bool readTiffImage(TIFF* tiff, const TiffImageInfo& info,
+                   const std::function<char*(unsigned int)>& row);
+
+/// Silences the libtiff warnings, about unknown tags and the like, while it is
+/// in scope. The handler is global to libtiff, so the previous one is put back
+/// when it goes out of scope.
+class TiffWarningsSilencer
+{
+public:
+  TiffWarningsSilencer();
+  ~TiffWarningsSilencer();
+
+private:
+  TIFFErrorHandler m_previous;
+};
+
+} // namespace tomviz
+
+#endif
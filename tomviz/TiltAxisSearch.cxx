@@ -0,0 +1,170 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "TiltAxisSearch.h"
+
+#include "ParallelUtilities.h"
+#include "TomographyReconstruction.h"
+#include "TomographyTiltSeries.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tomviz {
+namespace TiltAxisSearch {
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+
+// Values from center - range to center + range in steps, center alone if
+// there is nothing to search.
+std::vector<double> grid(double center, double range, double step)
+{
+  std::vector<double> values;
+  int n = range > 0 && step > 0 ? static_cast<int>(range / step + 1e-9) : 0;
+  for (int i = -n; i <= n; ++i) {
+    values.push_back(center + i * step);
+  }
+  return values;
+}
+
+// N * sum(x^4) / sum(x^2)^2 over the N pixels of an image, large when the
+// intensity is concentrated in few pixels. Variance can't be used: with the
+// ramp filter the energy of a reconstruction barely depends on the tilt axis.
+double sharpness(const std::vector<float>& image)
+{
+  double sumOfSquares = 0;
+  double sumOfFourthPowers = 0;
+  for (float value : image) {
+    double square = static_cast<double>(value) * value;
+    sumOfSquares += square;
+    sumOfFourthPowers += square * square;
+  }
+  if (sumOfSquares <= 0) {
+    return 0;
+  }
+  return image.size() * sumOfFourthPowers / (sumOfSquares * sumOfSquares);
+}
+} // namespace
+
+double axisPosition(double shift, double angle, int slice, int numberOfSlices)
+{
+  return shift + std::sin(-angle * Pi / 180) * (slice - numberOfSlices / 2);
+}
+
+std::vector<int> representativeSlices(const std::vector<double>& intensities,
+                                      int count)
+{
+  // Dim slices are mostly background, which scores the same for every
+  // candidate. Only the brighter half is used, like the Python operator.
+  const int numberOfSlices = static_cast<int>(intensities.size());
+  if (numberOfSlices == 0) {
+    return std::vector<int>();
+  }
+  std::vector<int> bright(numberOfSlices);
+  for (int slice = 0; slice < numberOfSlices; ++slice) {
+    bright[slice] = slice;
+  }
+  std::stable_sort(bright.begin(), bright.end(), [&intensities](int a, int b) {
+    return intensities[a] > intensities[b];
+  });
+  bright.resize(std::max(1, (numberOfSlices + 1) / 2));
+
+  // The rotation is found from how the shift changes along the tilt axis, so
+  // the slices are spread as far apart as possible.
+  std::sort(bright.begin(), bright.end());
+  count = std::min(std::max(count, 1), static_cast<int>(bright.size()));
+  std::vector<int> slices;
+  for (int i = 0; i < count; ++i) {
+    slices.push_back(bright[(2 * i + 1) * bright.size() / (2 * count)]);
+  }
+  return slices;
+}
+
+double score(const TomographyTiltSeries::SinogramCache& sinograms,
+             const double* tiltAngles, const std::vector<int>& slices,
+             double shift, double angle, int reconstructionSize)
+{
+  using TomographyReconstruction::FilterType;
+  const int numOfTilts = sinograms.numberOfTilts();
+  const int numOfRays = std::min(sinograms.numberOfRays(), reconstructionSize);
+  std::vector<float> sinogram(static_cast<size_t>(numOfRays) * numOfTilts);
+  std::vector<float> recon(static_cast<size_t>(numOfRays) * numOfRays);
+  double total = 0;
+  for (int slice : slices) {
+    sinograms.interpolate(
+      slice, sinogram.data(), numOfRays,
+      axisPosition(shift, angle, slice, sinograms.numberOfSlices()));
+    // Without the ramp filter every candidate is blurred, a misaligned axis
+    // mostly shows up as doubled edges and arcs.
+    TomographyReconstruction::filterSinogram(sinogram.data(), numOfTilts,
+                                             numOfRays, FilterType::Ramp);
+    TomographyReconstruction::parallelBackProjection2(
+      sinogram.data(), tiltAngles, recon.data(), numOfTilts, numOfRays,
+      nullptr, 1);
+    total += sharpness(recon);
+  }
+  return slices.empty() ? 0 : total / slices.size();
+}
+
+bool search(const TomographyTiltSeries::SinogramCache& sinograms,
+            const double* tiltAngles, const Options& options, Result& result,
+            const Progress& progress, int numberOfThreads)
+{
+  const auto& slices = sinograms.slices();
+  const bool searchShift = options.shiftRange > 0 && options.shiftStep > 0;
+  const bool searchAngle = options.angleRange > 0 && options.angleStep > 0;
+
+  // Each refinement searches one previous step either side of the best
+  // candidate, in half steps.
+  auto shifts = grid(0, options.shiftRange, options.shiftStep);
+  auto angles = grid(0, options.angleRange, options.angleStep);
+  int refinedCandidates = (searchShift ? 5 : 1) * (searchAngle ? 5 : 1);
+  int total = static_cast<int>(shifts.size() * angles.size()) +
+              std::max(options.refinements, 0) * refinedCandidates;
+
+  int completed = 0;
+  std::function<bool(int, int)> report;
+  if (progress) {
+    report = [&](int, int) { return progress(++completed, total); };
+  }
+
+  Result best;
+  best.score = -std::numeric_limits<double>::infinity();
+  double shiftStep = options.shiftStep;
+  double angleStep = options.angleStep;
+  for (int stage = 0; stage <= options.refinements; ++stage) {
+    if (stage > 0) {
+      shifts = grid(best.shift, searchShift ? shiftStep : 0, shiftStep / 2);
+      angles = grid(best.angle, searchAngle ? angleStep : 0, angleStep / 2);
+      shiftStep /= 2;
+      angleStep /= 2;
+    }
+
+    const int numberOfShifts = static_cast<int>(shifts.size());
+    std::vector<double> scores(shifts.size() * angles.size());
+    auto body = [&](int i) {
+      scores[i] =
+        score(sinograms, tiltAngles, slices, shifts[i % numberOfShifts],
+              angles[i / numberOfShifts], options.reconstructionSize);
+    };
+    if (!parallelFor(0, static_cast<int>(scores.size()), body, report,
+                     numberOfThreads)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < scores.size(); ++i) {
+      if (scores[i] > best.score) {
+        best.shift = shifts[i % numberOfShifts];
+        best.angle = angles[i / numberOfShifts];
+        best.score = scores[i];
+      }
+    }
+  }
+  result = best;
+  return true;
+}
+} // namespace TiltAxisSearch
+} // namespace tomviz
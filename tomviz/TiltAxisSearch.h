@@ -0,0 +1,85 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizTiltAxisSearch_h
+#define tomvizTiltAxisSearch_h
+
+#include <functional>
+#include <vector>
+
+namespace tomviz {
+
+namespace TomographyTiltSeries {
+class SinogramCache;
+}
+
+namespace TiltAxisSearch {
+
+// Finds the shift and rotation of the tilt axis by reconstructing a few
+// slices for a grid of candidates and keeping the sharpest. The grid is then
+// refined around the best candidate. It replaces the by-eye search of
+// RotateAlignWidget and the serial loops of AutoTiltAxisShiftAlignment.py.
+//
+// The tilt axis model is the one of RotateAlignWidget: the rotation is
+// approximated by shifting the sinogram of each slice along its rays, see
+// axisPosition().
+
+struct Options
+{
+  // Number of slices reconstructed for every candidate, see
+  // representativeSlices().
+  int numberOfSlices = 5;
+  // Shifts searched, in pixels either side of the center of the rays.
+  double shiftRange = 20;
+  double shiftStep = 4;
+  // Rotations searched, in degrees either side of zero.
+  double angleRange = 10;
+  double angleStep = 2;
+  // Number of times the grid is refined around the best candidate. Each
+  // refinement halves the steps.
+  int refinements = 2;
+  // Number of rays of the candidate reconstructions. Larger tilt series are
+  // resampled, which keeps the cost of a candidate bounded.
+  int reconstructionSize = 256;
+};
+
+struct Result
+{
+  double shift = 0;
+  double angle = 0;
+  double score = 0;
+};
+
+// The position of the rotation axis for a slice, relative to the center of
+// the rays, given the shift and rotation in degrees of the tilt axis.
+double axisPosition(double shift, double angle, int slice,
+                    int numberOfSlices);
+
+// Picks count slices spread along the tilt axis, among the brighter half of
+// the slices, from the intensity of every slice. See
+// TomographyTiltSeries::sliceIntensities().
+std::vector<int> representativeSlices(const std::vector<double>& intensities,
+                                      int count);
+
+// The sharpness of the reconstructions of slices with the given tilt axis,
+// higher is sharper. This is the fourth moment of the ramp filtered back
+// projections normalized by their variance, which doesn't depend on the
+// brightness of the slices, averaged over the slices.
+double score(const TomographyTiltSeries::SinogramCache& sinograms,
+             const double* tiltAngles, const std::vector<int>& slices,
+             double shift, double angle, int reconstructionSize);
+
+// Called with the number of candidates scored and the total, on the calling
+// thread. Returning false cancels the search.
+typedef std::function<bool(int, int)> Progress;
+
+// Searches for the tilt axis, reconstructing the slices held by sinograms for
+// every candidate. Only the representativeSlices() need to be cached. The
+// candidates of each grid are scored concurrently. Returns false if canceled.
+bool search(const TomographyTiltSeries::SinogramCache& sinograms,
+            const double* tiltAngles, const Options& options, Result& result,
+            const Progress& progress = nullptr, int numberOfThreads = 0);
+} // namespace TiltAxisSearch
+} // namespace tomviz
+
+#endif
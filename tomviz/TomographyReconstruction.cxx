@@ -2,6 +2,8 @@
    It is released under the 3-Clause BSD License, see "LICENSE". */
 
 #include "TomographyReconstruction.h"
+#include "FFTPlan.h"
+#include "ParallelUtilities.h"
 #include "TomographyTiltSeries.h"
 #include <math.h>
 
@@ -9,25 +11,243 @@
 #include "vtkFieldData.h"
 #include "vtkImageData.h"
 #define PI 3.14159265359
-#include "vtkFloatArray.h"
 #include "vtkPointData.h"
-#include "vtkSmartPointer.h"
 
 #include <QDebug>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 namespace {
 
-// Conversion code
-template <typename T>
-vtkSmartPointer<vtkFloatArray> convertToFloatT(T* data, int len)
+// Fourier weighting of sinogram rows. The rows are zero padded to at least
+// twice their length so the filtering is a linear, not circular, convolution.
+class SinogramFilter
+{
+public:
+  SinogramFilter(tomviz::TomographyReconstruction::FilterType type,
+                 int numOfRays)
+    : m_numOfRays(numOfRays),
+      m_plan(tomviz::FFTPlan::nextPowerOfTwo(2 * numOfRays)),
+      m_response(m_plan.size())
+  {
+    using tomviz::TomographyReconstruction::FilterType;
+    const int size = m_plan.size();
+
+    // The ramp is built from its band limited spatial kernel rather than
+    // sampling |f| directly, which avoids a DC offset in the reconstruction.
+    std::vector<tomviz::FFTPlan::Complex> kernel(size);
+    kernel[0] = 0.25f;
+    for (int n = 1; n < size / 2; n += 2) {
+      float value = static_cast<float>(-1.0 / ((PI * n) * (PI * n)));
+      kernel[n] = value;
+      kernel[size - n] = value;
+    }
+    m_plan.forward(kernel.data());
+
+    // The windows are the ones of makeFilter() in Recon_WBP.py, which
+    // apodizes the ramp 2|f| with omega = 2 pi f. Its cosine window is the
+    // cosine of the ramp itself.
+    for (int k = 0; k <= size / 2; ++k) {
+      double f = static_cast<double>(k) / size; // cycles per pixel
+      double omega = 2 * PI * f;
+      double window = 1.0;
+      if (k > 0) {
+        switch (type) {
+          case FilterType::SheppLogan:
+            window = sin(omega) / omega;
+            break;
+          case FilterType::Cosine:
+            window = cos(2 * f);
+            break;
+          case FilterType::Hamming:
+            window = 0.54 + 0.46 * cos(omega / 2);
+            break;
+          case FilterType::Hann:
+            window = (1 + cos(omega / 2)) / 2;
+            break;
+          default:
+            break;
+        }
+      }
+      // The response is kept exactly even, so that two real rows can be
+      // filtered together as the real and imaginary parts of one transform.
+      float value = static_cast<float>(2 * kernel[k].real() * window);
+      m_response[k] = value;
+      m_response[(size - k) % size] = value;
+    }
+  }
+
+  const std::vector<float>& response() const { return m_response; }
+
+  // Filters two rows at once, a and b may be strided and b may be null.
+  void filterPair(float* a, float* b, int stride,
+                  std::vector<tomviz::FFTPlan::Complex>& scratch) const
+  {
+    scratch.assign(m_plan.size(), tomviz::FFTPlan::Complex(0, 0));
+    for (int r = 0; r < m_numOfRays; ++r) {
+      scratch[r] = tomviz::FFTPlan::Complex(a[r * stride],
+                                            b ? b[r * stride] : 0.0f);
+    }
+    m_plan.forward(scratch.data());
+    for (int k = 0; k < m_plan.size(); ++k) {
+      scratch[k] *= m_response[k];
+    }
+    m_plan.inverse(scratch.data());
+    for (int r = 0; r < m_numOfRays; ++r) {
+      a[r * stride] = scratch[r].real();
+      if (b) {
+        b[r * stride] = scratch[r].imag();
+      }
+    }
+  }
+
+private:
+  int m_numOfRays;
+  tomviz::FFTPlan m_plan;
+  std::vector<float> m_response;
+};
+
+// Number of neighboring x-slices back projected together. The tilt series and
+// the reconstruction are both contiguous along x, so a block of slices is read
+// and written as short contiguous runs and the innermost loop vectorizes.
+const int SliceBlockSize = 8;
+
+// Edge length of the square y-z tiles the reconstruction is accumulated in.
+// A tile of a slice block (32 x 32 x 8 floats) stays resident in cache for all
+// tilts, and only touches a narrow band of rays per tilt.
+const int TileSize = 32;
+
+// Geometry shared by every slice of a parallel back projection.
+struct BackProjectionTables
+{
+  BackProjectionTables(const double* tiltAngles, int numOfTilts, int numOfRays,
+                       int numberOfThreads)
+    : yCos(static_cast<size_t>(numOfTilts) * numOfRays),
+      zSin(static_cast<size_t>(numOfTilts) * numOfRays),
+      zBegin(static_cast<size_t>(numOfTilts) * numOfRays),
+      zEnd(static_cast<size_t>(numOfTilts) * numOfRays)
+  {
+    auto buildTilt = [&](int tt) {
+      double angle = tiltAngles[tt] * PI / 180;
+      double c = cos(angle);
+      double s = sin(angle);
+      size_t offset = static_cast<size_t>(tt) * numOfRays;
+      for (int i = 0; i < numOfRays; ++i) {
+        double coord = i + 0.5 - ((double)numOfRays) / 2.0;
+        yCos[offset + i] = coord * c;
+        zSin[offset + i] = coord * s;
+      }
+      // The ray coordinate is monotonic in z, so the pixels that fall inside
+      // the projection form a single contiguous range for each row.
+      for (int iy = 0; iy < numOfRays; ++iy) {
+        int first = numOfRays;
+        int last = -1;
+        for (int iz = 0; iz < numOfRays; ++iz) {
+          double t = yCos[offset + iy] + zSin[offset + iz];
+          if (t >= -numOfRays / 2 && t <= numOfRays / 2) {
+            int rayIndex = floor((t + numOfRays / 2));
+            if (rayIndex >= 0 && rayIndex <= numOfRays - 2) {
+              first = std::min(first, iz);
+              last = iz;
+            }
+          }
+        }
+        zBegin[offset + iy] = first;
+        zEnd[offset + iy] = last + 1;
+      }
+    };
+    tomviz::parallelFor(0, numOfTilts, buildTilt, nullptr, numberOfThreads);
+  }
+
+  // y * cos(angle) and z * sin(angle) for each tilt and pixel coordinate.
+  std::vector<double> yCos;
+  std::vector<double> zSin;
+  // Range [zBegin, zEnd) of pixels in each row that a tilt contributes to.
+  std::vector<int> zBegin;
+  std::vector<int> zEnd;
+};
+
+// Back projects the block of slices starting at firstSlice directly into the
+// strided reconstruction volume.
+void backProjectSliceBlock(
+  const tomviz::TomographyTiltSeries::SinogramExtractor& tiltSeries,
+  const BackProjectionTables& tables, const SinogramFilter* filter,
+  float* recon, int xDim, int yDim, int zDim, int firstSlice)
 {
-  vtkSmartPointer<vtkFloatArray> array = vtkSmartPointer<vtkFloatArray>::New();
-  array->SetNumberOfTuples(len);
-  float* f = static_cast<float*>(array->GetVoidPointer(0));
-  for (int i = 0; i < len; ++i) {
-    f[i] = (float)data[i];
+  const int B = SliceBlockSize;
+  const int numOfRays = yDim;
+  const int numOfTilts = zDim;
+  const int halfRays = numOfRays / 2;
+  const int blockSlices = std::min(B, xDim - firstSlice);
+  const size_t sliceSize = static_cast<size_t>(xDim) * yDim;
+
+  // Gather the sinograms of the block interleaved by slice, padding the
+  // trailing slices of a partial block with zeros.
+  std::vector<float> sinograms(static_cast<size_t>(numOfTilts) * numOfRays * B,
+                               0.0f);
+  tiltSeries.sinograms(firstSlice, blockSlices, sinograms.data(), B);
+
+  if (filter) {
+    std::vector<tomviz::FFTPlan::Complex> scratch;
+    for (int tt = 0; tt < numOfTilts; ++tt) {
+      float* rows = &sinograms[static_cast<size_t>(tt) * numOfRays * B];
+      for (int b = 0; b < blockSlices; b += 2) {
+        float* next = b + 1 < blockSlices ? rows + b + 1 : nullptr;
+        filter->filterPair(rows + b, next, B, scratch);
+      }
+    }
+  }
+
+  std::vector<float> tile(TileSize * TileSize * B);
+  float normalizationFactor = PI / double(2 * numOfTilts);
+  for (int y0 = 0; y0 < numOfRays; y0 += TileSize) {
+    int y1 = std::min(y0 + TileSize, numOfRays);
+    for (int z0 = 0; z0 < numOfRays; z0 += TileSize) {
+      int z1 = std::min(z0 + TileSize, numOfRays);
+      std::fill(tile.begin(), tile.end(), 0.0f);
+
+      for (int tt = 0; tt < numOfTilts; ++tt) {
+        size_t offset = static_cast<size_t>(tt) * numOfRays;
+        const float* sino = &sinograms[offset * B];
+        const double* zSin = &tables.zSin[offset];
+        for (int iy = y0; iy < y1; ++iy) {
+          int begin = std::max(tables.zBegin[offset + iy], z0);
+          int end = std::min(tables.zEnd[offset + iy], z1);
+          if (begin >= end) {
+            continue;
+          }
+          double yCos = tables.yCos[offset + iy];
+          float* acc = &tile[((iy - y0) * TileSize + (begin - z0)) * B];
+          for (int iz = begin; iz < end; ++iz, acc += B) {
+            double t = yCos + zSin[iz];
+            // t + halfRays is non-negative inside [begin, end), so truncation
+            // is the floor used by the reference implementation.
+            int rayIndex = static_cast<int>(t + halfRays);
+            float w = static_cast<float>(t - double(rayIndex - halfRays));
+            const float* q1 = sino + static_cast<size_t>(rayIndex) * B;
+            const float* q2 = q1 + B;
+            for (int b = 0; b < B; ++b) {
+              acc[b] += q1[b] + w * (q2[b] - q1[b]);
+            }
+          }
+        }
+      }
+
+      // Write the finished tile to the output, normalizing as we go.
+      for (int iy = y0; iy < y1; ++iy) {
+        for (int iz = z0; iz < z1; ++iz) {
+          const float* acc = &tile[((iy - y0) * TileSize + (iz - z0)) * B];
+          float* out = recon + iz * sliceSize +
+                       static_cast<size_t>(iy) * xDim + firstSlice;
+          for (int b = 0; b < blockSlices; ++b) {
+            out[b] = acc[b] * normalizationFactor;
+          }
+        }
+      }
+    }
   }
-  return array;
 }
 } // namespace
 
@@ -36,7 +256,8 @@ namespace tomviz {
 namespace TomographyReconstruction {
 
 // 3D Weighted Back Projection reconstruction
-void weightedBackProjection3(vtkImageData* tiltSeries, vtkImageData* recon)
+void weightedBackProjection3(vtkImageData* tiltSeries, vtkImageData* recon,
+                             FilterType filter)
 {
   int extents[6];
   tiltSeries->GetExtent(extents);
@@ -65,6 +286,7 @@ void weightedBackProjection3(vtkImageData* tiltSeries, vtkImageData* recon)
   {
     // Get sinogram
     TomographyTiltSeries::getSinogram(tiltSeries, s, sinogram);
+    filterSinogram(sinogram, zDim, yDim, filter);
     // 2D back projection
     TomographyReconstruction::unweightedBackProjection2(sinogram, tiltAngles,
                                                         recon2d, zDim, yDim);
@@ -80,6 +302,154 @@ void weightedBackProjection3(vtkImageData* tiltSeries, vtkImageData* recon)
   delete[] sinogram;
 }
 
+void filterSinogram(float* sinogram, int numOfTilts, int numOfRays,
+                    FilterType filter)
+{
+  if (filter == FilterType::None) {
+    return;
+  }
+  SinogramFilter sinogramFilter(filter, numOfRays);
+  std::vector<FFTPlan::Complex> scratch;
+  for (int tt = 0; tt < numOfTilts; tt += 2) {
+    float* b =
+      tt + 1 < numOfTilts ? sinogram + (tt + 1) * numOfRays : nullptr;
+    sinogramFilter.filterPair(sinogram + tt * numOfRays, b, 1, scratch);
+  }
+}
+
+std::vector<float> filterResponse(FilterType filter, int numOfRays)
+{
+  if (filter == FilterType::None) {
+    return std::vector<float>(FFTPlan::nextPowerOfTwo(2 * numOfRays), 1.0f);
+  }
+  return SinogramFilter(filter, numOfRays).response();
+}
+
+void parallelWeightedBackProjection3(vtkImageData* tiltSeries,
+                                     vtkImageData* recon, FilterType filter,
+                                     int numberOfThreads)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1; // number of slices
+  int yDim = extents[3] - extents[2] + 1; // number of rays
+
+  // Get tilt angles
+  vtkDataArray* tiltAnglesArray =
+    tiltSeries->GetFieldData()->GetArray("tilt_angles");
+  double* tiltAngles = static_cast<double*>(tiltAnglesArray->GetVoidPointer(0));
+
+  // Creating the output volume and getting a pointer to it
+  int outputSize[3] = { xDim, yDim, yDim };
+  recon->SetExtent(0, outputSize[0] - 1, 0, outputSize[1] - 1, 0,
+                   outputSize[2] - 1);
+  recon->AllocateScalars(VTK_FLOAT, 1);
+  float* reconPtr = static_cast<float*>(recon->GetScalarPointer());
+
+  parallelBackProjection3(tiltSeries, tiltAngles, reconPtr, filter, nullptr,
+                          numberOfThreads);
+}
+
+bool parallelBackProjection3(vtkImageData* tiltSeries, const double* tiltAngles,
+                             float* recon, FilterType filter,
+                             const BackProjectionProgress& progress,
+                             int numberOfThreads)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1; // number of slices
+  int yDim = extents[3] - extents[2] + 1; // number of rays
+  int zDim = extents[5] - extents[4] + 1; // number of tilts
+
+  // The tilt series is read in its native type, a block at a time.
+  TomographyTiltSeries::SinogramExtractor extractor(tiltSeries);
+
+  BackProjectionTables tables(tiltAngles, zDim, yDim, numberOfThreads);
+  std::unique_ptr<SinogramFilter> sinogramFilter;
+  if (filter != FilterType::None) {
+    sinogramFilter.reset(new SinogramFilter(filter, yDim));
+  }
+
+  int numBlocks = (xDim + SliceBlockSize - 1) / SliceBlockSize;
+  auto body = [&](int block) {
+    backProjectSliceBlock(extractor, tables, sinogramFilter.get(), recon,
+                          xDim, yDim, zDim, block * SliceBlockSize);
+  };
+
+  int slicesCompleted = 0;
+  std::function<bool(int, int)> blockProgress;
+  if (progress) {
+    blockProgress = [&](int, int block) {
+      int firstSlice = block * SliceBlockSize;
+      int lastSlice = std::min(firstSlice + SliceBlockSize, xDim) - 1;
+      slicesCompleted += lastSlice - firstSlice + 1;
+      return progress(slicesCompleted, lastSlice);
+    };
+  }
+
+  return parallelFor(0, numBlocks, body, blockProgress, numberOfThreads);
+}
+
+bool parallelBackProjection2(const float* sinogram, const double* tiltAngles,
+                             float* recon, int numOfTilts, int numOfRays,
+                             const BackProjectionProgress& progress,
+                             int numberOfThreads)
+{
+  std::vector<double> cosines(numOfTilts);
+  std::vector<double> sines(numOfTilts);
+  for (int tt = 0; tt < numOfTilts; ++tt) {
+    double angle = tiltAngles[tt] * PI / 180;
+    cosines[tt] = cos(angle);
+    sines[tt] = sin(angle);
+  }
+
+  const int halfRays = numOfRays / 2;
+  const double center = numOfRays / 2.0;
+  const double normalizationFactor = PI / double(2 * numOfTilts);
+  int numBlocks = (numOfRays + TileSize - 1) / TileSize;
+  auto body = [&](int block) {
+    int y0 = block * TileSize;
+    int y1 = std::min(y0 + TileSize, numOfRays);
+    float* rows = recon + static_cast<size_t>(y0) * numOfRays;
+    float* rowsEnd = recon + static_cast<size_t>(y1) * numOfRays;
+    std::fill(rows, rowsEnd, 0.0f);
+    // The tilts are accumulated in the same order as the serial version.
+    for (int tt = 0; tt < numOfTilts; ++tt) {
+      const float* sino = sinogram + static_cast<size_t>(tt) * numOfRays;
+      for (int iy = y0; iy < y1; ++iy) {
+        double yCos = (iy + 0.5 - center) * cosines[tt];
+        float* row = recon + static_cast<size_t>(iy) * numOfRays;
+        for (int iz = 0; iz < numOfRays; ++iz) {
+          double t = yCos + (iz + 0.5 - center) * sines[tt];
+          if (t >= -halfRays && t <= halfRays) {
+            int rayIndex = floor(t + halfRays);
+            if (rayIndex >= 0 && rayIndex <= numOfRays - 2) {
+              double q1 = sino[rayIndex];
+              double q2 = sino[rayIndex + 1];
+              row[iz] += q1 + (t - double(rayIndex - halfRays)) * (q2 - q1);
+            }
+          }
+        }
+      }
+    }
+    for (float* value = rows; value != rowsEnd; ++value) {
+      *value *= normalizationFactor;
+    }
+  };
+
+  int rowsCompleted = 0;
+  std::function<bool(int, int)> blockProgress;
+  if (progress) {
+    blockProgress = [&](int, int block) {
+      int lastRow = std::min((block + 1) * TileSize, numOfRays) - 1;
+      rowsCompleted += lastRow - block * TileSize + 1;
+      return progress(rowsCompleted, lastRow);
+    };
+  }
+
+  return parallelFor(0, numBlocks, body, blockProgress, numberOfThreads);
+}
+
 // 2D WBP recon
 void unweightedBackProjection2(float* sinogram, double* tiltAngles,
                                float* image, int numOfTilts, int numOfRays)
@@ -7,15 +7,42 @@
 #include <pqReaction.h>
 #include <vtkImageData.h>
 
+#include <functional>
+#include <vector>
+
 namespace tomviz {
 class DataSource;
 
 namespace TomographyReconstruction {
 
+// Fourier weighting applied to each projection before back projection. None
+// gives the unweighted back projection, the others are the ramp filter alone
+// or apodized by a window. The order matches the "filter" enumeration of the
+// Python Recon_WBP operator.
+enum class FilterType
+{
+  None,
+  Ramp,
+  SheppLogan,
+  Cosine,
+  Hamming,
+  Hann
+};
+
 // This takes an image tiltSeries and a vtkImageData in which to place the
 // output (recon)
-void weightedBackProjection3(vtkImageData* tiltSeries,
-                             vtkImageData* recon); // 3D WBP recon
+void weightedBackProjection3(
+  vtkImageData* tiltSeries, vtkImageData* recon,
+  FilterType filter = FilterType::None); // 3D WBP recon
+
+// Applies the Fourier weighting filter to each of the numOfTilts rows of a
+// sinogram (as produced by TomographyTiltSeries::getSinogram) in place.
+void filterSinogram(float* sinogram, int numOfTilts, int numOfRays,
+                    FilterType filter);
+
+// The weights filterSinogram() multiplies the Fourier transform of the zero
+// padded rows by, at frequency k / size cycles per pixel for k < size.
+std::vector<float> filterResponse(FilterType filter, int numOfRays);
 
 // This function takes a y-z slice (sinogram) and the tilt angles as input and
 // creates a slice throught the reconstruction space.  The numOfTilts parameter
@@ -29,6 +56,47 @@ void weightedBackProjection3(vtkImageData* tiltSeries,
 void unweightedBackProjection2(float* sinogram, double* tiltAngles,
                                float* recon, int numOfTilts,
                                int numOfRays); // 2D WBP recon
+
+// Progress callback for the parallel back projection. It is invoked on the
+// calling thread with the number of slices completed so far and the index of
+// the most recently completed slice. Returning false cancels the
+// reconstruction.
+typedef std::function<bool(int, int)> BackProjectionProgress;
+
+// Multithreaded equivalent of weightedBackProjection3. Blocks of neighboring
+// x-slices are distributed over a pool of worker threads. Each block is back
+// projected tile by tile straight into the strided output volume, using
+// per-tilt trig and ray-index tables that are computed once for all slices.
+// When a filter is selected the sinogram rows of a block are filtered two at
+// a time with one complex FFT, using a single FFT plan shared by all slices.
+// A numberOfThreads less than one uses every core.
+//
+// weightedBackProjection3/unweightedBackProjection2 remain the serial
+// reference implementation.
+void parallelWeightedBackProjection3(vtkImageData* tiltSeries,
+                                     vtkImageData* recon,
+                                     FilterType filter = FilterType::None,
+                                     int numberOfThreads = 0);
+
+// Lower level entry point of the parallel engine. The tilt series is read in
+// its native scalar type, a block of slices at a time, through a
+// TomographyTiltSeries::SinogramExtractor. The reconstruction is written to
+// recon, which must hold xDim * yDim * yDim floats laid out like the output
+// of weightedBackProjection3. Returns false if canceled.
+bool parallelBackProjection3(vtkImageData* tiltSeries, const double* tiltAngles,
+                             float* recon, FilterType filter = FilterType::None,
+                             const BackProjectionProgress& progress = nullptr,
+                             int numberOfThreads = 0);
+
+// Multithreaded equivalent of unweightedBackProjection2, for reconstructing
+// single slices interactively. Blocks of rows of the reconstruction are
+// distributed over the worker threads. The progress callback is passed the
+// number of rows completed and the index of the last row of the block that
+// just completed. Returns false if canceled.
+bool parallelBackProjection2(const float* sinogram, const double* tiltAngles,
+                             float* recon, int numOfTilts, int numOfRays,
+                             const BackProjectionProgress& progress = nullptr,
+                             int numberOfThreads = 0);
 } // namespace TomographyReconstruction
 } // namespace tomviz
 
@@ -7,37 +7,157 @@
 #include "vtkImageData.h"
 #include <math.h>
 #define PI 3.14159265359
-#include "vtkFloatArray.h"
 #include "vtkPointData.h"
-#include "vtkSmartPointer.h"
 
-#include <QDebug>
+#include "ParallelUtilities.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace {
 
-// conversion code
 template <typename T>
-vtkSmartPointer<vtkFloatArray> convertToFloatT(T* data, int len)
+void extractSinograms(const T* data, const int dims[3], int firstSlice,
+                      int count, float* sinograms, int stride)
 {
-  vtkSmartPointer<vtkFloatArray> array = vtkSmartPointer<vtkFloatArray>::New();
-  array->SetNumberOfTuples(len);
-  float* f = static_cast<float*>(array->GetVoidPointer(0));
-  for (int i = 0; i < len; ++i) {
-    f[i] = (float)data[i];
+  const size_t xDim = dims[0];
+  for (int t = 0; t < dims[2]; ++t) { // Loop through tilts (z-direction)
+    for (int r = 0; r < dims[1]; ++r) { // Loop through rays (y-direction)
+      const T* src = data + (static_cast<size_t>(t) * dims[1] + r) * xDim +
+                     firstSlice;
+      float* dst = sinograms + (static_cast<size_t>(t) * dims[1] + r) * stride;
+      for (int i = 0; i < count; ++i) {
+        dst[i] = static_cast<float>(src[i]);
+      }
+    }
   }
-  return array;
 }
 
-vtkSmartPointer<vtkFloatArray> convertToFloat(vtkImageData* image)
+// Resamples the rays of every tilt to Nray rays of width
+// numberOfRays / Nray, centered on the rotation axis at axisPosition. ray(z, r)
+// returns ray r of tilt z, for r in [0, numberOfRays).
+template <typename RayFunction>
+void resampleRays(const RayFunction& ray, int numberOfRays, int zDim,
+                  float* sinogram, int Nray, double axisPosition)
 {
-  vtkDataArray* scalars = image->GetPointData()->GetScalars();
-  int len = scalars->GetNumberOfTuples();
-  vtkSmartPointer<vtkFloatArray> array;
-  switch (scalars->GetDataType()) {
-    vtkTemplateMacro(array = convertToFloatT(
-                       static_cast<VTK_TT*>(scalars->GetVoidPointer(0)), len););
+  double rayWidth = (double)numberOfRays / (double)Nray;
+  std::vector<float> weight1(Nray); // Store weights for linear interpolation
+  std::vector<float> weight2(Nray); // Store weights for linear interpolation
+  std::vector<int> index1(Nray);    // Store indices for linear interpolation
+  std::vector<int> index2(Nray);    // Store indices for linear interpolation
+  for (int r = 0; r < Nray; ++r) {
+    double rayCoord = (double)(r - Nray / 2) * rayWidth + axisPosition;
+    index1[r] = floor(rayCoord) + numberOfRays / 2;
+    index2[r] = index1[r] + 1;
+    weight2[r] = rayCoord - floor(rayCoord);
+    weight1[r] = 1 - weight2[r];
+  }
+
+  for (int z = 0; z < zDim; ++z) // Loop through tilts (z-direction)
+  {
+    for (int r = 0; r < Nray; ++r) // Loop through rays (y-direction)
+    {
+      sinogram[z * Nray + r] = 0;
+      if (index1[r] >= 0 && index1[r] < numberOfRays) {
+        sinogram[z * Nray + r] += ray(z, index1[r]) * weight1[r];
+      }
+      if (index2[r] >= 0 && index2[r] < numberOfRays) {
+        sinogram[z * Nray + r] += ray(z, index2[r]) * weight2[r];
+      }
+    }
+  }
+}
+
+template <typename T>
+void interpolateSinogram(const T* dataPtr, int xDim, int yDim, int zDim,
+                         int sliceNumber, float* sinogram, int Nray,
+                         double axisPosition, int tiltAxis)
+{
+  // Note that the meaning of x and y flip if the tiltAxis is flipped
+  const size_t tiltSize = static_cast<size_t>(xDim) * yDim;
+  if (tiltAxis == 0) {
+    auto ray = [=](int z, int r) {
+      return dataPtr[z * tiltSize + static_cast<size_t>(r) * xDim +
+                     sliceNumber];
+    };
+    resampleRays(ray, yDim, zDim, sinogram, Nray, axisPosition);
+  } else {
+    auto ray = [=](int z, int r) {
+      return dataPtr[z * tiltSize + static_cast<size_t>(sliceNumber) * xDim +
+                     r];
+    };
+    resampleRays(ray, xDim, zDim, sinogram, Nray, axisPosition);
+  }
+}
+
+// Copies tilt z of a tilt series into the sinograms of count slices, laid out
+// as sinograms[(i * zDim + z) * numberOfRays + ray] for slices[i].
+template <typename T>
+void cacheTilt(const T* dataPtr, const int dims[3], int z, int tiltAxis,
+               const int* slices, int count, float* sinograms)
+{
+  const int xDim = dims[0];
+  const int yDim = dims[1];
+  const int zDim = dims[2];
+  const T* tilt = dataPtr + static_cast<size_t>(z) * xDim * yDim;
+  if (tiltAxis == 0) {
+    // Slices along x, rays along y
+    for (int y = 0; y < yDim; ++y) {
+      const T* row = tilt + static_cast<size_t>(y) * xDim;
+      for (int i = 0; i < count; ++i) {
+        sinograms[(static_cast<size_t>(i) * zDim + z) * yDim + y] =
+          static_cast<float>(row[slices[i]]);
+      }
+    }
+  } else {
+    // Slices along y, rays along x
+    for (int i = 0; i < count; ++i) {
+      const T* row = tilt + static_cast<size_t>(slices[i]) * xDim;
+      float* out = sinograms + (static_cast<size_t>(i) * zDim + z) * xDim;
+      for (int x = 0; x < xDim; ++x) {
+        out[x] = static_cast<float>(row[x]);
+      }
+    }
+  }
+}
+
+template <typename T>
+void averageTilts(const T* dataPtr, int xDim, int yDim, int zDim,
+                  float* average)
+{
+  const size_t sliceSize = static_cast<size_t>(xDim) * yDim;
+  std::fill(average, average + sliceSize, 0.0f);
+  for (int z = 0; z < zDim; ++z) {
+    const T* tilt = dataPtr + z * sliceSize;
+    for (size_t i = 0; i < sliceSize; ++i) {
+      average[i] += tilt[i];
+    }
+  }
+  for (size_t i = 0; i < sliceSize; ++i) { // Normalize
+    average[i] /= zDim;
+  }
+}
+
+template <typename T>
+void sumSlices(const T* dataPtr, int xDim, int yDim, int zDim, int tiltAxis,
+               double* sums)
+{
+  for (int z = 0; z < zDim; ++z) {
+    for (int y = 0; y < yDim; ++y) {
+      const T* row = dataPtr + (static_cast<size_t>(z) * yDim + y) * xDim;
+      if (tiltAxis == 0) {
+        for (int x = 0; x < xDim; ++x) {
+          sums[x] += row[x];
+        }
+      } else {
+        double sum = 0;
+        for (int x = 0; x < xDim; ++x) {
+          sum += row[x];
+        }
+        sums[y] += sum;
+      }
+    }
   }
-  return array;
 }
 } // end of namespace
 
@@ -45,30 +165,122 @@ namespace tomviz {
 
 namespace TomographyTiltSeries {
 
-void getSinogram(vtkImageData* tiltSeries, int sliceNumber, float* sinogram)
+SinogramExtractor::SinogramExtractor(vtkImageData* tiltSeries)
 {
   int extents[6];
   tiltSeries->GetExtent(extents);
-  int xDim = extents[1] - extents[0] + 1; // Number of slices
-  int yDim = extents[3] - extents[2] + 1; // Number of rays
-  int zDim = extents[5] - extents[4] + 1; // Number of tilts
+  m_dims[0] = extents[1] - extents[0] + 1; // Number of slices
+  m_dims[1] = extents[3] - extents[2] + 1; // Number of rays
+  m_dims[2] = extents[5] - extents[4] + 1; // Number of tilts
 
-  // Convert tiltSeries type to float
-  vtkSmartPointer<vtkFloatArray> dataAsFloats = convertToFloat(tiltSeries);
-  float* dataPtr = static_cast<float*>(dataAsFloats->GetVoidPointer(
-    0)); // Get pointer to tilt series (of type float)
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  m_data = scalars->GetVoidPointer(0);
+  m_dataType = scalars->GetDataType();
+}
 
-  // Extract sinograms from tilt series. Make a deep copy
-  for (int t = 0; t < zDim; ++t) // Loop through tilts (z-direction)
-  {
-    for (int r = 0; r < yDim; ++r) // Loop through rays (y-direction)
-    {
-      sinogram[t * yDim + r] =
-        dataPtr[t * xDim * yDim + r * xDim + sliceNumber];
+void SinogramExtractor::sinogram(int slice, float* sinogram) const
+{
+  sinograms(slice, 1, sinogram, 1);
+}
+
+void SinogramExtractor::sinograms(int firstSlice, int count, float* sinograms,
+                                  int stride) const
+{
+  switch (m_dataType) {
+    vtkTemplateMacro(extractSinograms(static_cast<const VTK_TT*>(m_data),
+                                      m_dims, firstSlice, count, sinograms,
+                                      stride));
+  }
+}
+
+SinogramCache::SinogramCache(vtkImageData* tiltSeries, int tiltAxis,
+                             int numberOfThreads,
+                             const std::function<bool()>& canceled)
+  : m_tiltAxis(tiltAxis)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int numberOfSlices = tiltAxis == 0 ? extents[1] - extents[0] + 1
+                                     : extents[3] - extents[2] + 1;
+  m_slices.resize(numberOfSlices);
+  for (int slice = 0; slice < numberOfSlices; ++slice) {
+    m_slices[slice] = slice;
+  }
+  copy(tiltSeries, numberOfThreads, canceled);
+}
+
+SinogramCache::SinogramCache(vtkImageData* tiltSeries, int tiltAxis,
+                             const std::vector<int>& slices,
+                             int numberOfThreads,
+                             const std::function<bool()>& canceled)
+  : m_slices(slices), m_tiltAxis(tiltAxis)
+{
+  copy(tiltSeries, numberOfThreads, canceled);
+}
+
+void SinogramCache::copy(vtkImageData* tiltSeries, int numberOfThreads,
+                         const std::function<bool()>& canceled)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int dims[3] = { extents[1] - extents[0] + 1, extents[3] - extents[2] + 1,
+                  extents[5] - extents[4] + 1 };
+  m_dims[0] = m_tiltAxis == 0 ? dims[0] : dims[1]; // Number of slices
+  m_dims[1] = m_tiltAxis == 0 ? dims[1] : dims[0]; // Number of rays
+  m_dims[2] = dims[2];                             // Number of tilts
+  m_index.assign(m_dims[0], -1);
+  for (size_t i = 0; i < m_slices.size(); ++i) {
+    m_index[m_slices[i]] = static_cast<int>(i);
+  }
+  m_data.resize(m_slices.size() * m_dims[1] * m_dims[2]);
+
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  void* data = scalars->GetVoidPointer(0);
+  int dataType = scalars->GetDataType();
+  int tiltAxis = m_tiltAxis;
+  const int* slices = m_slices.data();
+  int count = static_cast<int>(m_slices.size());
+  float* sinograms = m_data.data();
+  auto body = [=](int z) {
+    switch (dataType) {
+      vtkTemplateMacro(cacheTilt(static_cast<const VTK_TT*>(data), dims, z,
+                                 tiltAxis, slices, count, sinograms));
     }
+  };
+  std::function<bool(int, int)> progress;
+  if (canceled) {
+    progress = [&canceled](int, int) { return !canceled(); };
+  }
+  if (!parallelFor(0, dims[2], body, progress, numberOfThreads)) {
+    std::vector<float>().swap(m_data);
+    m_slices.clear();
+    m_index.clear();
+    m_dims[0] = m_dims[1] = m_dims[2] = 0;
   }
 }
 
+const float* SinogramCache::sinogram(int slice) const
+{
+  return m_data.data() +
+         static_cast<size_t>(m_index[slice]) * m_dims[2] * m_dims[1];
+}
+
+void SinogramCache::interpolate(int slice, float* sinogram, int Nray,
+                                double axisPosition) const
+{
+  const float* cached = this->sinogram(slice);
+  const int numberOfRays = m_dims[1];
+  auto ray = [cached, numberOfRays](int z, int r) {
+    return cached[static_cast<size_t>(z) * numberOfRays + r];
+  };
+  resampleRays(ray, numberOfRays, m_dims[2], sinogram, Nray, axisPosition);
+}
+
+void getSinogram(vtkImageData* tiltSeries, int sliceNumber, float* sinogram)
+{
+  SinogramExtractor(tiltSeries).sinogram(sliceNumber, sinogram);
+}
+
 // Extract sinograms from tilt series
 void getSinogram(vtkImageData* tiltSeries, int sliceNumber, float* sinogram,
                  int Nray, double axisPosition, int tiltAxis)
@@ -79,55 +291,12 @@ void getSinogram(vtkImageData* tiltSeries, int sliceNumber, float* sinogram,
   int yDim = extents[3] - extents[2] + 1; // number of rays in tilt series
   int zDim = extents[5] - extents[4] + 1; // number of tilts
 
-  // Note that the meaning of x and y flip if the tiltAxis is flipped
-  int tiltAxDim;
-  if (tiltAxis == 0)
-    tiltAxDim = yDim;
-  else
-    tiltAxDim = xDim;
-
-  // Convert tiltSeries type to float
-  vtkSmartPointer<vtkFloatArray> dataAsFloats = convertToFloat(tiltSeries);
-  float* dataPtr = static_cast<float*>(dataAsFloats->GetVoidPointer(
-    0)); // Get pointer to tilt series (of type float)
-
-  double rayWidth = (double)tiltAxDim / (double)Nray;
-  std::vector<float> weight1(Nray); // Store weights for linear interpolation
-  std::vector<float> weight2(Nray); // Store weights for linear interpolation
-  std::vector<int> index1(Nray);    // Store indices for linear interpolation
-  std::vector<int> index2(Nray);    // Store indices for linear interpolation
-
-  // Extract sinograms from tilt series. Make a deep copy
-  for (int z = 0; z < zDim; ++z) // Loop through tilts (z-direction)
-  {
-    for (int r = 0; r < Nray; ++r) // Loop through rays (y-direction)
-    {
-      if (z == 0) { // Initialize weights and indicies
-        double rayCoord = (double)(r - Nray / 2) * rayWidth + axisPosition;
-        index1[r] = floor(rayCoord) + tiltAxDim / 2;
-        index2[r] = index1[r] + 1;
-        weight1[r] = fabs(rayCoord - floor(rayCoord));
-        weight2[r] = 1 - weight1[r];
-      }
-      sinogram[z * Nray + r] = 0;
-      size_t dataInd;
-      if (index1[r] >= 0 && index1[r] < tiltAxDim) {
-        if (tiltAxis == 0)
-          dataInd = z * xDim * yDim + index1[r] * xDim + sliceNumber;
-        else
-          dataInd = z * xDim * yDim + sliceNumber * xDim + index1[r];
-
-        sinogram[z * Nray + r] += dataPtr[dataInd] * weight1[r];
-      }
-      if (index2[r] >= 0 && index2[r] < tiltAxDim) {
-        if (tiltAxis == 0)
-          dataInd = z * xDim * yDim + index2[r] * xDim + sliceNumber;
-        else
-          dataInd = z * xDim * yDim + sliceNumber * xDim + index2[r];
-
-        sinogram[z * Nray + r] += dataPtr[dataInd] * weight2[r];
-      }
-    }
+  // Interpolate straight from the native scalar type
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(interpolateSinogram(
+      static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)), xDim, yDim,
+      zDim, sliceNumber, sinogram, Nray, axisPosition, tiltAxis));
   }
 }
 
@@ -139,24 +308,30 @@ void averageTiltSeries(vtkImageData* tiltSeries, float* average)
   int yDim = extents[3] - extents[2] + 1; // Number of rays in tilt series
   int zDim = extents[5] - extents[4] + 1; // Number of tilts
 
-  // Convert tiltSeries type to float
-  vtkSmartPointer<vtkFloatArray> dataAsFloats = convertToFloat(tiltSeries);
-  float* dataPtr = static_cast<float*>(dataAsFloats->GetVoidPointer(
-    0)); // Get pointer to tilt series (of type float)
-
-  for (int z = 0; z < zDim; ++z) {
-    for (int y = 0; y < yDim; ++y) {
-      for (int x = 0; x < xDim; ++x) {
-        if (z == 0)
-          average[y * xDim + x] = 0;
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(
+      averageTilts(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)),
+                   xDim, yDim, zDim, average));
+  }
+}
 
-        average[y * xDim + x] += dataPtr[z * xDim * yDim + y * xDim + x];
+std::vector<double> sliceIntensities(vtkImageData* tiltSeries, int tiltAxis)
+{
+  int extents[6];
+  tiltSeries->GetExtent(extents);
+  int xDim = extents[1] - extents[0] + 1;
+  int yDim = extents[3] - extents[2] + 1;
+  int zDim = extents[5] - extents[4] + 1; // Number of tilts
 
-        if (z == zDim - 1) // Normalize
-          average[y * xDim + x] /= zDim;
-      }
-    }
+  std::vector<double> sums(tiltAxis == 0 ? xDim : yDim, 0.0);
+  vtkDataArray* scalars = tiltSeries->GetPointData()->GetScalars();
+  switch (scalars->GetDataType()) {
+    vtkTemplateMacro(
+      sumSlices(static_cast<const VTK_TT*>(scalars->GetVoidPointer(0)), xDim,
+                yDim, zDim, tiltAxis, sums.data()));
   }
+  return sums;
 }
 
 } // end of namespace TomographyTiltSeries
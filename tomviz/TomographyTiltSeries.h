@@ -7,12 +7,103 @@
 #include "pqReaction.h"
 #include "vtkImageData.h"
 
+#include <functional>
+#include <vector>
+
 namespace tomviz {
 
 class DataSource;
 
 namespace TomographyTiltSeries {
 
+/// Reads sinograms out of a tilt series without converting the whole series to
+/// float. The scalars are accessed in their native type and only the requested
+/// values are converted. Neighboring slices are adjacent in memory, so
+/// extracting a batch of slices at once turns the strided single slice reads
+/// into short contiguous runs. The extractor holds a raw pointer to the
+/// scalars, the tilt series must outlive it and not be reallocated.
+class SinogramExtractor
+{
+public:
+  explicit SinogramExtractor(vtkImageData* tiltSeries);
+
+  int numberOfSlices() const { return m_dims[0]; }
+  int numberOfRays() const { return m_dims[1]; }
+  int numberOfTilts() const { return m_dims[2]; }
+
+  /// Extract the sinogram of one slice, laid out as
+  /// sinogram[tilt * numberOfRays() + ray] like getSinogram().
+  void sinogram(int slice, float* sinogram) const;
+
+  /// Extract the sinograms of count neighboring slices starting at
+  /// firstSlice, interleaved by slice:
+  /// sinograms[(tilt * numberOfRays() + ray) * stride + i] for i < count.
+  /// stride must be at least count, entries from count to stride are left
+  /// untouched.
+  void sinograms(int firstSlice, int count, float* sinograms,
+                 int stride) const;
+
+private:
+  void* m_data = nullptr;
+  int m_dataType = 0;
+  int m_dims[3] = { 0, 0, 0 };
+};
+
+/// A float copy of a tilt series laid out sinogram by sinogram, so that the
+/// sinogram of any slice is one contiguous block. Meant for interactive tools
+/// that read the sinograms of arbitrary slices over and over, at the cost of
+/// one float per voxel. Tools that only need a few slices can cache just
+/// those. The copy is made when the cache is constructed, the tilt series may
+/// change afterwards.
+class SinogramCache
+{
+public:
+  /// tiltAxis is 0 if the tilt axis is X, and 1 if the tilt axis is Y, like
+  /// for getSinogram(). The copy is spread over numberOfThreads threads, less
+  /// than one uses every core. canceled is polled as tilts are copied, if it
+  /// returns true the copy stops and the cache is left empty().
+  SinogramCache(vtkImageData* tiltSeries, int tiltAxis,
+                int numberOfThreads = 0,
+                const std::function<bool()>& canceled = nullptr);
+
+  /// Only copy the sinograms of the given slices.
+  SinogramCache(vtkImageData* tiltSeries, int tiltAxis,
+                const std::vector<int>& slices, int numberOfThreads = 0,
+                const std::function<bool()>& canceled = nullptr);
+
+  /// Whether the cache holds no sinograms, because the copy was canceled.
+  bool empty() const { return m_data.empty(); }
+
+  int tiltAxis() const { return m_tiltAxis; }
+  /// The number of slices of the tilt series, cached or not.
+  int numberOfSlices() const { return m_dims[0]; }
+  int numberOfRays() const { return m_dims[1]; }
+  int numberOfTilts() const { return m_dims[2]; }
+
+  /// The slices whose sinograms were copied, in the order given.
+  const std::vector<int>& slices() const { return m_slices; }
+
+  /// The sinogram of one of the cached slices, laid out as
+  /// sinogram[tilt * numberOfRays() + ray].
+  const float* sinogram(int slice) const;
+
+  /// Same as getSinogram(tiltSeries, slice, sinogram, Nray, axisPosition,
+  /// tiltAxis()).
+  void interpolate(int slice, float* sinogram, int Nray,
+                   double axisPosition = 0) const;
+
+private:
+  void copy(vtkImageData* tiltSeries, int numberOfThreads,
+            const std::function<bool()>& canceled);
+
+  std::vector<float> m_data;
+  std::vector<int> m_slices;
+  // The position of each slice of the tilt series in m_slices, or -1.
+  std::vector<int> m_index;
+  int m_tiltAxis = 0;
+  int m_dims[3] = { 0, 0, 0 };
+};
+
 /// Extract sinogram from tilt series. This takes as input an image and a slice
 /// number.  If the input image has dimensions [x, y, z] the slice number must
 /// be in the interval [0,y-1].  The output is stored in the sinogram pointer,
@@ -34,6 +125,10 @@ void getSinogram(vtkImageData* tiltSeries, int, float* sinogram, int Nray,
 
 void averageTiltSeries(vtkImageData* tiltSeries,
                        float* average); // Average all tilts
+
+/// The sum of every value of each slice, in one pass over the tilt series.
+/// "tiltAxis" is 0 if the tilt axis is X, and 1 if the tilt axis is Y
+std::vector<double> sliceIntensities(vtkImageData* tiltSeries, int tiltAxis);
 } // namespace TomographyTiltSeries
 } // namespace tomviz
 
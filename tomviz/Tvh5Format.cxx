@@ -28,12 +28,12 @@ using std::endl;
 
 namespace tomviz {
 
-bool Tvh5Format::write(const std::string& fileName)
+bool Tvh5Format::write(const std::string& fileName, const QVariantMap& options)
 {
   // First, write the standard EMD file
   DataSource* source = ActiveObjects::instance().activeDataSource();
 
-  if (!EmdFormat::write(fileName, source)) {
+  if (!EmdFormat::write(fileName, source, options)) {
     cerr << "Failed to write the standard EMD node" << endl;
     return false;
   }
@@ -80,7 +80,7 @@ bool Tvh5Format::write(const std::string& fileName)
     writer.createGroup(group);
 
     // Write the data here
-    if (!EmdFormat::writeNode(writer, group, ds->imageData())) {
+    if (!EmdFormat::writeNode(writer, group, ds->imageData(), options)) {
       cerr << "Failed to write data source: " << id << endl;
       return false;
     }
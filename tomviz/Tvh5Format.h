@@ -6,6 +6,8 @@
 
 #include <string>
 
+#include <QVariantMap>
+
 class QJsonObject;
 
 namespace h5 {
@@ -20,7 +22,9 @@ class Operator;
 class Tvh5Format
 {
 public:
-  static bool write(const std::string& fileName);
+  // See GenericHDF5Format::writeVolume() for the options
+  static bool write(const std::string& fileName,
+                    const QVariantMap& options = QVariantMap());
   static bool read(const std::string& fileName);
 
 private:
@@ -0,0 +1,236 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "VolumePyramid.h"
+
+#include "DataSource.h"
+#include "GenericHDF5Format.h"
+#include "ParallelUtilities.h"
+
+#include <h5cpp/h5readwrite.h>
+
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+
+namespace tomviz {
+
+namespace {
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, T>::type average(
+  double sum, int count)
+{
+  return static_cast<T>(std::floor(sum / count + 0.5));
+}
+
+template <typename T>
+typename std::enable_if<!std::is_integral<T>::value, T>::type average(
+  double sum, int count)
+{
+  return static_cast<T>(sum / count);
+}
+
+template <typename T>
+void downsampleBlocks(const T* in, const int inDims[3], T* out,
+                      const int outDims[3], int components)
+{
+  size_t inRow = static_cast<size_t>(inDims[0]) * components;
+  size_t inSlice = inRow * inDims[1];
+
+  // Each output slice only reads two input slices, so slices are independent.
+  auto body = [&](int k) {
+    int k1 = std::min(2 * k + 2, inDims[2]);
+    T* outSlice = out + static_cast<size_t>(k) * outDims[1] * outDims[0] *
+                          components;
+    for (int j = 0; j < outDims[1]; ++j) {
+      int j1 = std::min(2 * j + 2, inDims[1]);
+      for (int i = 0; i < outDims[0]; ++i) {
+        int i1 = std::min(2 * i + 2, inDims[0]);
+        int count = (k1 - 2 * k) * (j1 - 2 * j) * (i1 - 2 * i);
+        for (int c = 0; c < components; ++c) {
+          double sum = 0.0;
+          for (int kk = 2 * k; kk < k1; ++kk) {
+            for (int jj = 2 * j; jj < j1; ++jj) {
+              const T* row = in + kk * inSlice + jj * inRow;
+              for (int ii = 2 * i; ii < i1; ++ii) {
+                sum += row[ii * components + c];
+              }
+            }
+          }
+          outSlice[(static_cast<size_t>(j) * outDims[0] + i) * components +
+                   c] = average<T>(sum, count);
+        }
+      }
+    }
+  };
+  parallelFor(0, outDims[2], body);
+}
+
+// Move the spacing and origin of an image from one level to another. The
+// samples of a level sit at the centers of the blocks they average.
+void rescale(vtkImageData* image, int fromLevel, int toLevel)
+{
+  double spacing[3];
+  double origin[3];
+  image->GetSpacing(spacing);
+  image->GetOrigin(origin);
+  double from = std::pow(2.0, fromLevel);
+  double to = std::pow(2.0, toLevel);
+  for (int i = 0; i < 3; ++i) {
+    double fullSpacing = spacing[i] / from;
+    double fullOrigin = origin[i] - (from - 1.0) / 2.0 * fullSpacing;
+    spacing[i] = fullSpacing * to;
+    origin[i] = fullOrigin + (to - 1.0) / 2.0 * fullSpacing;
+  }
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+}
+
+} // namespace
+
+bool VolumePyramid::shouldWrite(vtkImageData* image,
+                                const QVariantMap& options)
+{
+  if (!image || DataSource::hasTiltAngles(image) ||
+      image->GetPointData()->GetNumberOfArrays() != 1) {
+    // Tilt series aren't downsampled along their angles, and extra scalars
+    // would need pyramids of their own.
+    return false;
+  }
+
+  if (!options.value("pyramid", false).toBool()) {
+    return false;
+  }
+
+  // Smaller volumes are already quick to display.
+  int dims[3];
+  image->GetDimensions(dims);
+  return *std::max_element(dims, dims + 3) > CoarsestDimension;
+}
+
+bool VolumePyramid::write(h5::H5ReadWrite& writer, const std::string& path,
+                          const std::string& name, vtkImageData* image,
+                          const QVariantMap& options)
+{
+  std::string dataPath = path + "/" + name;
+  std::string group = dataPath + "_pyramid";
+  if (!writer.createGroup(group)) {
+    std::cerr << "Failed to create the pyramid group " << group << "\n";
+    return false;
+  }
+
+  // Each level is built from the one before it, so only one downsampled
+  // level is held in memory at a time.
+  vtkSmartPointer<vtkImageData> level = image;
+  int dims[3];
+  level->GetDimensions(dims);
+  for (int i = 1; *std::max_element(dims, dims + 3) > CoarsestDimension;
+       ++i) {
+    level = downsample(level);
+    level->GetDimensions(dims);
+    std::string levelName = "level" + std::to_string(i);
+    if (!GenericHDF5Format::writeReorderedVolume(writer, group, levelName,
+                                                 level, options)) {
+      std::cerr << "Failed to write level " << i << " of the pyramid\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int VolumePyramid::numberOfLevels(h5::H5ReadWrite& reader,
+                                  const std::string& dataPath)
+{
+  int levels = 1;
+  while (reader.isDataSet(levelPath(dataPath, levels))) {
+    ++levels;
+  }
+  return levels;
+}
+
+std::string VolumePyramid::levelPath(const std::string& dataPath, int level)
+{
+  if (level == 0) {
+    return dataPath;
+  }
+  return dataPath + "_pyramid/level" + std::to_string(level);
+}
+
+bool VolumePyramid::readLevel(h5::H5ReadWrite& reader,
+                              const std::string& dataPath, int level,
+                              vtkImageData* image)
+{
+  if (level < 0 || level >= numberOfLevels(reader, dataPath)) {
+    return false;
+  }
+
+  vtkNew<vtkImageData> levelImage;
+  QVariantMap options = { { "askForSubsample", false } };
+  if (!GenericHDF5Format::readVolume(reader, levelPath(dataPath, level),
+                                     levelImage, options)) {
+    return false;
+  }
+  GenericHDF5Format::reorderData(levelImage, ReorderMode::CToFortran);
+
+  // Swap in the new scalars, keeping the name and everything in the field
+  // data of the image.
+  auto scalars = levelImage->GetPointData()->GetScalars();
+  auto previous = image->GetPointData()->GetScalars();
+  if (previous && previous->GetName()) {
+    scalars->SetName(previous->GetName());
+  }
+  image->SetDimensions(levelImage->GetDimensions());
+  image->GetPointData()->Initialize();
+  image->GetPointData()->SetScalars(scalars);
+
+  rescale(image, DataSource::resolutionLevel(image), level);
+  DataSource::setResolutionLevel(image, level);
+  DataSource::setHdf5Source(image, QString::fromStdString(reader.fileName()),
+                            QString::fromStdString(dataPath));
+  image->Modified();
+  return true;
+}
+
+void VolumePyramid::scaleToLevel(vtkImageData* image, int level)
+{
+  rescale(image, 0, level);
+  DataSource::setResolutionLevel(image, level);
+}
+
+vtkSmartPointer<vtkImageData> VolumePyramid::downsample(vtkImageData* image)
+{
+  int inDims[3];
+  image->GetDimensions(inDims);
+  int outDims[3];
+  for (int i = 0; i < 3; ++i) {
+    outDims[i] = (inDims[i] + 1) / 2;
+  }
+
+  auto in = image->GetPointData()->GetScalars();
+  auto output = vtkSmartPointer<vtkImageData>::New();
+  output->SetDimensions(outDims);
+  output->SetSpacing(image->GetSpacing());
+  output->SetOrigin(image->GetOrigin());
+  output->AllocateScalars(in->GetDataType(), in->GetNumberOfComponents());
+  auto out = output->GetPointData()->GetScalars();
+  out->SetName(in->GetName());
+
+  switch (in->GetDataType()) {
+    vtkTemplateMacro(downsampleBlocks(
+      static_cast<const VTK_TT*>(in->GetVoidPointer(0)), inDims,
+      static_cast<VTK_TT*>(out->GetVoidPointer(0)), outDims,
+      in->GetNumberOfComponents()));
+  }
+
+  rescale(output, 0, 1);
+  return output;
+}
+} // namespace tomviz
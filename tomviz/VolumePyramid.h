@@ -0,0 +1,72 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizVolumePyramid_h
+#define tomvizVolumePyramid_h
+
+#include <string>
+
+#include <QVariantMap>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace h5 {
+class H5ReadWrite;
+}
+
+namespace tomviz {
+
+///
+/// A multiresolution pyramid stored next to a volume in an HDF5 file. Level n
+/// is the volume downsampled by 2^n along each axis, by averaging blocks of
+/// voxels rather than decimating, so coarse levels don't alias. For a data
+/// set at "/path/data" the levels are "/path/data_pyramid/level1",
+/// "/path/data_pyramid/level2", ... and are stored in the same C ordering as
+/// the volume itself. Levels are written until the volume fits in a cube of
+/// CoarsestDimension voxels, which is small enough to display immediately.
+///
+class VolumePyramid
+{
+public:
+  static const int CoarsestDimension = 256;
+
+  /// Whether a pyramid should be written for the image. Pyramids are only
+  /// written when the "pyramid" option (bool, default false) is set, for
+  /// volumes with a single array that are larger than CoarsestDimension.
+  static bool shouldWrite(vtkImageData* image,
+                          const QVariantMap& options = QVariantMap());
+
+  /// Write the levels of the pyramid for the Fortran ordered image, whose full
+  /// resolution data set is path/name. The options are passed on to
+  /// GenericHDF5Format::writeVolume().
+  static bool write(h5::H5ReadWrite& writer, const std::string& path,
+                    const std::string& name, vtkImageData* image,
+                    const QVariantMap& options = QVariantMap());
+
+  /// The number of levels stored for the data set, including the full
+  /// resolution data itself, so 1 if there is no pyramid.
+  static int numberOfLevels(h5::H5ReadWrite& reader,
+                            const std::string& dataPath);
+
+  /// The path of the given level of the data set's pyramid.
+  static std::string levelPath(const std::string& dataPath, int level);
+
+  /// Replace the scalars of image, which holds some level of the data set,
+  /// with the given level. The spacing and origin of the image are adjusted
+  /// to match, and its field data is kept.
+  static bool readLevel(h5::H5ReadWrite& reader, const std::string& dataPath,
+                        int level, vtkImageData* image);
+
+  /// Scale the spacing and origin of a full resolution image to those of the
+  /// given level.
+  static void scaleToLevel(vtkImageData* image, int level);
+
+  /// Downsample the Fortran ordered image by two along each axis by averaging
+  /// blocks of 2x2x2 voxels. Odd trailing voxels are averaged on their own.
+  static vtkSmartPointer<vtkImageData> downsample(vtkImageData* image);
+};
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,227 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "FrameDecoder.h"
+
+#include "TiffUtilities.h"
+
+#include <QJsonArray>
+#include <QMap>
+
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace tomviz {
+
+namespace {
+
+void setError(QString* error, const QString& message)
+{
+  if (error) {
+    *error = message;
+  }
+}
+
+/// The TIFF being decoded, libtiff reads it through the callbacks below.
+struct MemoryTiff
+{
+  const char* data;
+  toff_t size;
+  toff_t position;
+};
+
+tsize_t tiffRead(thandle_t handle, tdata_t buffer, tsize_t size)
+{
+  auto tiff = static_cast<MemoryTiff*>(handle);
+  toff_t available =
+    tiff->position < tiff->size ? tiff->size - tiff->position : 0;
+  toff_t n = std::min(static_cast<toff_t>(size), available);
+  std::memcpy(buffer, tiff->data + tiff->position, n);
+  tiff->position += n;
+  return static_cast<tsize_t>(n);
+}
+
+tsize_t tiffWrite(thandle_t, tdata_t, tsize_t)
+{
+  return 0;
+}
+
+toff_t tiffSeek(thandle_t handle, toff_t offset, int whence)
+{
+  auto tiff = static_cast<MemoryTiff*>(handle);
+  switch (whence) {
+    case SEEK_SET:
+      tiff->position = offset;
+      break;
+    case SEEK_CUR:
+      tiff->position += offset;
+      break;
+    case SEEK_END:
+      tiff->position = tiff->size + offset;
+      break;
+  }
+  return tiff->position;
+}
+
+int tiffClose(thandle_t)
+{
+  return 0;
+}
+
+toff_t tiffSize(thandle_t handle)
+{
+  return static_cast<MemoryTiff*>(handle)->size;
+}
+
+int tiffMap(thandle_t handle, tdata_t* base, toff_t* size)
+{
+  // The whole file is already in memory, let libtiff use it directly.
+  auto tiff = static_cast<MemoryTiff*>(handle);
+  *base = const_cast<char*>(tiff->data);
+  *size = tiff->size;
+  return 1;
+}
+
+void tiffUnmap(thandle_t, tdata_t, toff_t)
+{
+}
+
+/// Allocates a single slice image, the caller fills in the rows.
+vtkSmartPointer<vtkImageData> newFrame(int width, int height, int scalarType,
+                                       int components)
+{
+  auto image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(width, height, 1);
+  image->AllocateScalars(scalarType, components);
+  return image;
+}
+
+/// Pointer to the start of the row of the image holding row of the frame,
+/// the first row of a frame is the top of the image.
+char* imageRow(vtkImageData* image, int row)
+{
+  int dims[3];
+  image->GetDimensions(dims);
+  auto scalars = image->GetPointData()->GetScalars();
+  auto rowBytes = static_cast<size_t>(dims[0]) *
+                  scalars->GetNumberOfComponents() *
+                  scalars->GetDataTypeSize();
+  return static_cast<char*>(scalars->GetVoidPointer(0)) +
+         static_cast<size_t>(dims[1] - 1 - row) * rowBytes;
+}
+
+int rawScalarType(QString dtype)
+{
+  // Strip the numpy byte order character, only native data is supported.
+  if (dtype.startsWith('<') || dtype.startsWith('=') || dtype.startsWith('|')) {
+    dtype = dtype.mid(1);
+  } else if (dtype.startsWith('>')) {
+    return VTK_VOID;
+  }
+
+  static const QMap<QString, int> types = {
+    { "int8", VTK_SIGNED_CHAR },     { "i1", VTK_SIGNED_CHAR },
+    { "uint8", VTK_UNSIGNED_CHAR },  { "u1", VTK_UNSIGNED_CHAR },
+    { "int16", VTK_SHORT },          { "i2", VTK_SHORT },
+    { "uint16", VTK_UNSIGNED_SHORT }, { "u2", VTK_UNSIGNED_SHORT },
+    { "int32", VTK_INT },            { "i4", VTK_INT },
+    { "uint32", VTK_UNSIGNED_INT },  { "u4", VTK_UNSIGNED_INT },
+    { "int64", VTK_TYPE_INT64 },     { "i8", VTK_TYPE_INT64 },
+    { "uint64", VTK_TYPE_UINT64 },   { "u8", VTK_TYPE_UINT64 },
+    { "float32", VTK_FLOAT },        { "f4", VTK_FLOAT },
+    { "float64", VTK_DOUBLE },       { "f8", VTK_DOUBLE }
+  };
+  return types.value(dtype, VTK_VOID);
+}
+
+} // namespace
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decode(const QString& mimeType,
+                                                   const QByteArray& data,
+                                                   const QJsonObject& meta,
+                                                   QString* error)
+{
+  // Ignore any parameters, e.g. "image/tiff; name=frame.tiff".
+  auto type = mimeType.section(';', 0, 0).trimmed();
+  if (type == "image/tiff") {
+    return decodeTiff(data, error);
+  } else if (type == "application/octet-stream") {
+    return decodeRaw(data, meta, error);
+  }
+
+  setError(error, QString("Unsupported mime type: %1").arg(mimeType));
+  return nullptr;
+}
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decodeTiff(const QByteArray& data,
+                                                       QString* error)
+{
+  MemoryTiff memory = { data.constData(), static_cast<toff_t>(data.size()),
+                        0 };
+  TIFF* tiff = TIFFClientOpen("frame", "r", &memory, tiffRead, tiffWrite,
+                              tiffSeek, tiffClose, tiffSize, tiffMap,
+                              tiffUnmap);
+  if (!tiff) {
+    setError(error, "The frame is not a valid TIFF.");
+    return nullptr;
+  }
+
+  auto info = readTiffImageInfo(tiff);
+  if (!info.isValid()) {
+    TIFFClose(tiff);
+    setError(error, "The layout of the TIFF frame is not supported.");
+    return nullptr;
+  }
+
+  auto image =
+    newFrame(info.width, info.height, info.scalarType, info.components);
+  bool ok = readTiffImage(tiff, info, [&image](unsigned int row) {
+    return imageRow(image, row);
+  });
+  TIFFClose(tiff);
+
+  if (!ok) {
+    setError(error, "Failed to read the TIFF frame.");
+    return nullptr;
+  }
+  return image;
+}
+
+vtkSmartPointer<vtkImageData> FrameDecoder::decodeRaw(const QByteArray& data,
+                                                      const QJsonObject& meta,
+                                                      QString* error)
+{
+  auto shape = meta["shape"].toArray();
+  int scalarType = rawScalarType(meta["dtype"].toString());
+  if (shape.size() < 2 || shape.size() > 3 || scalarType == VTK_VOID) {
+    setError(error, "Raw frames need a 2D shape and a supported dtype.");
+    return nullptr;
+  }
+
+  int height = shape[0].toInt();
+  int width = shape[1].toInt();
+  int components = shape.size() == 3 ? shape[2].toInt() : 1;
+  if (width <= 0 || height <= 0 || components <= 0) {
+    setError(error, "Invalid shape for the raw frame.");
+    return nullptr;
+  }
+
+  auto image = newFrame(width, height, scalarType, components);
+  auto scalars = image->GetPointData()->GetScalars();
+  size_t rowBytes = static_cast<size_t>(width) * components *
+                    scalars->GetDataTypeSize();
+  if (static_cast<size_t>(data.size()) != rowBytes * height) {
+    setError(error, "The size of the raw frame doesn't match its shape.");
+    return nullptr;
+  }
+
+  for (int row = 0; row < height; ++row) {
+    std::memcpy(imageRow(image, row), data.constData() + row * rowBytes,
+                rowBytes);
+  }
+  return image;
+}
+} // namespace tomviz
@@ -0,0 +1,45 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizFrameDecoder_h
+#define tomvizFrameDecoder_h
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+#include <vtkSmartPointer.h>
+
+class vtkImageData;
+
+namespace tomviz {
+
+/// Decodes the frames received from an acquisition server straight from the
+/// bytes of the reply, without a round trip through a file. The frames are
+/// returned as a single z-slice with the first row of the frame at the top,
+/// matching what vtkTIFFReader produces for the same frame.
+class FrameDecoder
+{
+public:
+  /// Decode a frame of the given mime type, image/tiff or
+  /// application/octet-stream. Returns nullptr, and sets error if not null,
+  /// when the frame can't be decoded.
+  static vtkSmartPointer<vtkImageData> decode(const QString& mimeType,
+                                              const QByteArray& data,
+                                              const QJsonObject& meta,
+                                              QString* error = nullptr);
+
+  /// Decode the first image of a TIFF file held in memory.
+  static vtkSmartPointer<vtkImageData> decodeTiff(const QByteArray& data,
+                                                  QString* error = nullptr);
+
+  /// Decode a raw frame, the layout is described in meta by "shape", the
+  /// rows and columns, and "dtype", a numpy style type such as "uint16" or
+  /// "<f4". The values are in row major order and native byte order.
+  static vtkSmartPointer<vtkImageData> decodeRaw(const QByteArray& data,
+                                                 const QJsonObject& meta,
+                                                 QString* error = nullptr);
+};
+} // namespace tomviz
+
+#endif
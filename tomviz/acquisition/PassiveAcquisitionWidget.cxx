@@ -8,6 +8,7 @@
 #include "AcquisitionClient.h"
 #include "ActiveObjects.h"
 #include "ConnectionDialog.h"
+#include "FrameDecoder.h"
 #include "InterfaceBuilder.h"
 #include "StartServerDialog.h"
 
@@ -29,7 +30,6 @@
 #include <vtkRenderWindow.h>
 #include <vtkRenderer.h>
 #include <vtkScalarsToColors.h>
-#include <vtkTIFFReader.h>
 
 #include <QBuffer>
 #include <QCloseEvent>
@@ -48,6 +48,7 @@
 #include <QTabWidget>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <QtConcurrent>
 
 namespace tomviz {
 
@@ -137,6 +138,8 @@ void PassiveAcquisitionWidget::readSettings()
   if (!watchPath.isEmpty()) {
     m_ui->watchPathLineEdit->setText(watchPath);
   }
+  m_ui->saveFramesCheckBox->setChecked(
+    settings->value("passive.saveFrames", false).toBool());
 
   settings->endGroup();
 }
@@ -147,6 +150,8 @@ void PassiveAcquisitionWidget::writeSettings()
   settings->beginGroup("acquisition");
   settings->setValue("passive.geometry", geometry());
   settings->setValue("watchPath", m_ui->watchPathLineEdit->text());
+  settings->setValue("passive.saveFrames",
+                     m_ui->saveFramesCheckBox->isChecked());
   settings->endGroup();
 }
 
@@ -204,37 +209,23 @@ void PassiveAcquisitionWidget::connectToServer(bool startServer)
 }
 
 void PassiveAcquisitionWidget::imageReady(QString mimeType, QByteArray result,
-                                          float angle, bool hasAngle)
+                                          QJsonObject meta, float angle,
+                                          bool hasAngle)
 {
-  if (mimeType != "image/tiff") {
-    qDebug() << "image/tiff is the only supported mime type right now.\n"
-             << mimeType << "\n";
+  // Frames are decoded straight from memory, writing them out is optional
+  // and happens in the background.
+  QString error;
+  auto image = FrameDecoder::decode(mimeType, result, meta, &error);
+  if (!image) {
+    qWarning() << "Failed to decode the acquired frame:" << error;
     return;
   }
+  m_imageData = image;
 
-  QDir dir(QDir::homePath() + "/tomviz-data");
-  if (!dir.exists()) {
-    dir.mkpath(dir.path());
+  if (m_ui->saveFramesCheckBox->isChecked()) {
+    saveFrame(mimeType, result, angle);
   }
-
-  QString path = "/tomviz_";
-
-  if (angle > 0.0) {
-    path.append('+');
-  }
-  path.append(QString::number(angle, 'g', 2));
-  path.append(".tiff");
-
-  QFile file(dir.path() + path);
-  file.open(QIODevice::WriteOnly);
-  file.write(result);
-  qDebug() << "Data file:" << file.fileName();
-  file.close();
-
-  vtkNew<vtkTIFFReader> reader;
-  reader->SetFileName(file.fileName().toLatin1());
-  reader->Update();
-  m_imageData = reader->GetOutput();
+  ++m_frameCount;
 
   // If we haven't added it, add our live data source to the pipeline.
   if (!m_dataSource) {
@@ -275,6 +266,31 @@ void PassiveAcquisitionWidget::displayError(const QString& errorMessage)
                        QMessageBox::Ok);
 }
 
+void PassiveAcquisitionWidget::saveFrame(const QString& mimeType,
+                                         const QByteArray& frame, float angle)
+{
+  // The frame count keeps angles that format the same from overwriting each
+  // other.
+  QString extension =
+    mimeType.startsWith("image/tiff") ? QString("tiff") : QString("raw");
+  QString fileName = QString("tomviz_%1_%2%3.%4")
+                       .arg(m_frameCount, 4, 10, QChar('0'))
+                       .arg(angle > 0.0 ? QString("+") : QString())
+                       .arg(angle, 0, 'g', 6)
+                       .arg(extension);
+
+  QtConcurrent::run([fileName, frame]() {
+    QDir dir(QDir::homePath() + "/tomviz-data");
+    if (!dir.exists()) {
+      dir.mkpath(dir.path());
+    }
+    QFile file(dir.filePath(fileName));
+    if (!file.open(QIODevice::WriteOnly) || file.write(frame) != frame.size()) {
+      qWarning() << "Failed to save the acquired frame to" << file.fileName();
+    }
+  });
+}
+
 QString PassiveAcquisitionWidget::url() const
 {
   auto connection = m_ui->connectionsWidget->selectedConnection();
@@ -301,7 +317,8 @@ void PassiveAcquisitionWidget::watchSource()
                           angle = meta["angle"].toString().toFloat();
                           hasAngle = true;
                         }
-                        imageReady(mimeType, result, angle, hasAngle);
+                        imageReady(mimeType, result, meta, angle,
+                                   hasAngle);
                       }
                     });
             connect(request, &AcquisitionClientRequest::error, this,
@@ -8,6 +8,7 @@
 
 #include "MatchInfo.h"
 
+#include <QJsonObject>
 #include <QLabel>
 #include <QPointer>
 #include <QScopedPointer>
@@ -51,8 +52,8 @@ protected:
 private slots:
   void connectToServer(bool startServer = true);
 
-  void imageReady(QString mimeType, QByteArray result, float angle = 0,
-                  bool hasAngle = false);
+  void imageReady(QString mimeType, QByteArray result, QJsonObject meta,
+                  float angle = 0, bool hasAngle = false);
 
   void onError(const QString& errorMessage, const QJsonValue& errorData);
   void watchSource();
@@ -87,6 +88,7 @@ private:
   QPointer<QWidget> m_connectParamsWidget;
   QPointer<QTimer> m_watchTimer;
   int m_retryCount = 5;
+  int m_frameCount = 0;
   QProcess* m_serverProcess = nullptr;
 
   QString url() const;
@@ -97,6 +99,7 @@ private:
   void startLocalServer();
   void displayError(const QString& errorMessage);
   void stopWatching();
+  void saveFrame(const QString& mimeType, const QByteArray& frame, float angle);
   void validateTestFileName();
 
   void setupTestTable();
@@ -167,13 +167,15 @@ public:
     return H5Awrite(attributeId, typeId, value) >= 0;
   }
 
-  bool writeData(const string& path, const string& name,
-                 const std::vector<int>& dims, const void* data,
-                 hid_t dataTypeId, hid_t memTypeId)
+  // Returns the id of the new data set, which the caller must close, or a
+  // negative value on failure.
+  hid_t createDataSet(const string& path, const string& name,
+                      const std::vector<int>& dims, hid_t dataTypeId,
+                      const WriteOptions& options)
   {
     if (!fileIsValid()) {
       cerr << "File is invalid\n";
-      return false;
+      return H5I_INVALID_HID;
     }
 
     std::vector<hsize_t> h5dim;
@@ -183,11 +185,27 @@ public:
     hid_t groupId = H5Gopen(m_fileId, path.c_str(), H5P_DEFAULT);
     hid_t dataSpaceId =
       H5Screate_simple(static_cast<int>(dims.size()), &h5dim[0], nullptr);
-    hid_t dataId = H5Dcreate(groupId, name.c_str(), dataTypeId, dataSpaceId,
-                             H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    hid_t createId = createProperties(dims, dataTypeId, options);
 
     HIDCloser groupCloser(groupId, H5Gclose);
     HIDCloser spaceCloser(dataSpaceId, H5Sclose);
+    HIDCloser createCloser(createId,
+                           createId == H5P_DEFAULT ? nullptr : H5Pclose);
+
+    return H5Dcreate(groupId, name.c_str(), dataTypeId, dataSpaceId,
+                     H5P_DEFAULT, createId, H5P_DEFAULT);
+  }
+
+  bool writeData(const string& path, const string& name,
+                 const std::vector<int>& dims, const void* data,
+                 hid_t dataTypeId, hid_t memTypeId,
+                 const WriteOptions& options = WriteOptions())
+  {
+    hid_t dataId = createDataSet(path, name, dims, dataTypeId, options);
+    if (dataId < 0) {
+      return false;
+    }
+
     HIDCloser dataCloser(dataId, H5Dclose);
 
     hid_t status =
@@ -196,6 +214,93 @@ public:
     return status >= 0;
   }
 
+  bool writeHyperslab(const string& path, hid_t memTypeId, const void* data,
+                      size_t* start, size_t* counts)
+  {
+    hid_t dataSetId = H5Dopen(m_fileId, path.c_str(), H5P_DEFAULT);
+    if (dataSetId < 0) {
+      cerr << "Failed to get dataSetId\n";
+      return false;
+    }
+
+    // Automatically close upon leaving scope
+    HIDCloser dataSetCloser(dataSetId, H5Dclose);
+
+    hid_t dataSpaceId = H5Dget_space(dataSetId);
+    if (dataSpaceId < 0) {
+      cerr << "Failed to get dataSpaceId\n";
+      return false;
+    }
+
+    HIDCloser dataSpaceCloser(dataSpaceId, H5Sclose);
+
+    int ndims = H5Sget_simple_extent_ndims(dataSpaceId);
+    vector<hsize_t> startVector(start, start + ndims);
+    vector<hsize_t> countsVector(counts, counts + ndims);
+    H5Sselect_hyperslab(dataSpaceId, H5S_SELECT_SET, startVector.data(),
+                        nullptr, countsVector.data(), nullptr);
+
+    hid_t memSpace = H5Screate_simple(ndims, countsVector.data(), nullptr);
+    HIDCloser memSpaceCloser(memSpace, H5Sclose);
+
+    return H5Dwrite(dataSetId, memTypeId, memSpace, dataSpaceId, H5P_DEFAULT,
+                    data) >= 0;
+  }
+
+  // Returns the data set creation properties for the options, H5P_DEFAULT
+  // for a contiguous data set.
+  hid_t createProperties(const std::vector<int>& dims, hid_t dataTypeId,
+                         const WriteOptions& options)
+  {
+    bool filtered = options.shuffle || options.deflateLevel > 0 ||
+                    options.filterId >= 0;
+    if (options.chunkDimensions.empty() && !filtered) {
+      return H5P_DEFAULT;
+    }
+
+    // Chunks can't be empty, so neither can the data.
+    if (dims.empty() ||
+        std::find(dims.begin(), dims.end(), 0) != dims.end()) {
+      return H5P_DEFAULT;
+    }
+
+    auto chunks = options.chunkDimensions;
+    if (chunks.size() != dims.size()) {
+      chunks = H5ReadWrite::sliceChunkDimensions(dims, H5Tget_size(dataTypeId));
+    }
+    std::vector<hsize_t> h5chunks;
+    for (size_t i = 0; i < dims.size(); ++i) {
+      h5chunks.push_back(
+        static_cast<hsize_t>(std::max(1, std::min(chunks[i], dims[i]))));
+    }
+
+    hid_t createId = H5Pcreate(H5P_DATASET_CREATE);
+    H5Pset_chunk(createId, static_cast<int>(h5chunks.size()), &h5chunks[0]);
+    if (options.shuffle) {
+      H5Pset_shuffle(createId);
+    }
+
+    bool deflate = options.deflateLevel > 0;
+    if (options.filterId >= 0) {
+      auto filter = static_cast<H5Z_filter_t>(options.filterId);
+      if (H5Zfilter_avail(filter) > 0) {
+        // Optional, so that chunks the filter can't compress are kept as is.
+        H5Pset_filter(createId, filter, H5Z_FLAG_OPTIONAL,
+                      options.filterValues.size(),
+                      options.filterValues.data());
+        deflate = false;
+      } else {
+        cerr << "Warning: HDF5 filter " << options.filterId
+             << " is not available\n";
+      }
+    }
+    if (deflate) {
+      H5Pset_deflate(createId, std::min(options.deflateLevel, 9));
+    }
+
+    return createId;
+  }
+
   vector<int> getDimensions(const string& path)
   {
     vector<int> result;
@@ -799,6 +904,28 @@ bool H5ReadWrite::writeData(const string& path, const string& name,
 bool H5ReadWrite::writeData(const string& path, const string& name,
                             const vector<int>& dims, const DataType& type,
                             const void* data)
+{
+  return writeData(path, name, dims, type, data, WriteOptions());
+}
+
+bool H5ReadWrite::writeData(const string& path, const string& name,
+                            const vector<int>& dims, const DataType& type,
+                            const void* data, const WriteOptions& options)
+{
+  auto it = DataTypeToH5DataType.find(type);
+  auto memIt = DataTypeToH5MemType.find(type);
+  if (it == DataTypeToH5DataType.end() || memIt == DataTypeToH5MemType.end()) {
+    cerr << "Failed to get H5 types for " << dataTypeToString(type) << "\n";
+    return false;
+  }
+
+  return m_impl->writeData(path, name, dims, data, it->second, memIt->second,
+                           options);
+}
+
+bool H5ReadWrite::createDataSet(const string& path, const string& name,
+                                const vector<int>& dims, const DataType& type,
+                                const WriteOptions& options)
 {
   auto it = DataTypeToH5DataType.find(type);
   if (it == DataTypeToH5DataType.end()) {
@@ -806,17 +933,48 @@ bool H5ReadWrite::writeData(const string& path, const string& name,
     return false;
   }
 
-  hid_t dataTypeId = it->second;
+  hid_t dataId = m_impl->createDataSet(path, name, dims, it->second, options);
+  HIDCloser dataCloser(dataId, H5Dclose);
+  return dataId >= 0;
+}
 
+bool H5ReadWrite::writeHyperslab(const string& path, const DataType& type,
+                                 const void* data, size_t* start,
+                                 size_t* counts)
+{
   auto memIt = DataTypeToH5MemType.find(type);
   if (memIt == DataTypeToH5MemType.end()) {
     cerr << "Failed to get H5 mem type for " << dataTypeToString(type) << "\n";
     return false;
   }
 
-  hid_t memTypeId = memIt->second;
+  if (!m_impl->writeHyperslab(path, memIt->second, data, start, counts)) {
+    cerr << "Failed to write the hyperslab to " << path << "\n";
+    return false;
+  }
 
-  return m_impl->writeData(path, name, dims, data, dataTypeId, memTypeId);
+  return true;
+}
+
+vector<int> H5ReadWrite::sliceChunkDimensions(const vector<int>& dims,
+                                              size_t elementSize,
+                                              size_t chunkBytes)
+{
+  // Start from the whole data set and, from the slowest dimension on, cut
+  // each dimension down until the chunk fits.
+  vector<int> chunks = dims;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    size_t bytes = elementSize;
+    for (size_t j = i + 1; j < chunks.size(); ++j) {
+      bytes *= std::max(chunks[j], 1);
+    }
+    size_t count = std::max(bytes > 0 ? chunkBytes / bytes : 0, size_t(1));
+    if (count >= static_cast<size_t>(chunks[i])) {
+      break;
+    }
+    chunks[i] = static_cast<int>(count);
+  }
+  return chunks;
 }
 
 template <typename T>
@@ -253,6 +253,98 @@ public:
                  const std::vector<int>& dimensions, const DataType& type,
                  const void* data);
 
+  /**
+   * Options for the creation of data sets. The default options create a
+   * contiguous data set without any filters.
+   */
+  struct WriteOptions
+  {
+    /**
+     * The dimensions of the chunks, in the same order as the dimensions of
+     * the data. Leave empty for a contiguous data set. Filters need a
+     * chunked data set, so chunks are chosen with sliceChunkDimensions() if
+     * filters are requested without them.
+     */
+    std::vector<int> chunkDimensions;
+
+    /** Apply the shuffle filter, which helps the compression of numbers. */
+    bool shuffle = false;
+
+    /** The deflate (gzip) level from 1 to 9, or 0 for no deflate. */
+    int deflateLevel = 0;
+
+    /**
+     * A registered HDF5 filter to compress with, e.g. 32001 for Blosc, or
+     * -1 for none. If the filter is available it is used in place of
+     * deflate, otherwise deflate is used.
+     */
+    int filterId = -1;
+
+    /** The client data values for the registered filter. */
+    std::vector<unsigned int> filterValues;
+  };
+
+  /**
+   * Write data to a specified path, creating the data set with @p options.
+   * @param path The path where the data will be written.
+   * @param name The name of the data.
+   * @param dimensions The dimensions of the data.
+   * @param type The type of data to write.
+   * @param data The data to write.
+   * @param options The chunking and filters of the new data set.
+   * @return True on success, false on failure.
+   */
+  bool writeData(const std::string& path, const std::string& name,
+                 const std::vector<int>& dimensions, const DataType& type,
+                 const void* data, const WriteOptions& options);
+
+  /**
+   * Create a data set without writing to it, so that it can be written a
+   * piece at a time with writeHyperslab(). This allows volumes to be
+   * written without holding all of the data, or a reordered copy of it, in
+   * memory at once.
+   * @param path The path where the data set will be created.
+   * @param name The name of the data set.
+   * @param dimensions The dimensions of the data set.
+   * @param type The type of the data set.
+   * @param options The chunking and filters of the new data set.
+   * @return True on success, false on failure.
+   */
+  bool createDataSet(const std::string& path, const std::string& name,
+                     const std::vector<int>& dimensions, const DataType& type,
+                     const WriteOptions& options);
+
+  /**
+   * Write a block of data into part of an existing data set. The block is
+   * tightly packed, with the dimensions given by @p counts. When the data
+   * set is chunked, writing whole chunks avoids HDF5 having to read back
+   * and re-compress the chunks that are only partly written.
+   * @param path The path to the data set.
+   * @param type The type of the data to write.
+   * @param data The data to write.
+   * @param start The start of the block in the data set, one value per
+   *              dimension of the data set.
+   * @param counts The size of the block, one value per dimension of the
+   *               data set.
+   * @return True on success, false on failure.
+   */
+  bool writeHyperslab(const std::string& path, const DataType& type,
+                      const void* data, size_t* start, size_t* counts);
+
+  /**
+   * Choose chunk dimensions for data that is read a slice at a time along
+   * its first (slowest) dimension. Chunks hold whole slices, or whole rows
+   * of a slice when a slice is larger than @p chunkBytes, so reading a
+   * slice never has to decompress data outside of it.
+   * @param dimensions The dimensions of the data.
+   * @param elementSize The size of a single element in bytes.
+   * @param chunkBytes The approximate maximum size of a chunk in bytes.
+   * @return The chunk dimensions.
+   */
+  static std::vector<int> sliceChunkDimensions(
+    const std::vector<int>& dimensions, size_t elementSize,
+    size_t chunkBytes = 1 << 20);
+
   /**
    * Set an attribute on a specified path.
    * @param path The path where the attribute will be written.
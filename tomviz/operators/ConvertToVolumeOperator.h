@@ -23,6 +23,7 @@ public:
   QString label() const override { return m_label; }
   QIcon icon() const override;
   Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
 
 protected:
   bool applyTransform(vtkDataObject* data) override;
@@ -0,0 +1,386 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "ImageFilterOperators.h"
+
+#include "DataSource.h"
+#include "EditOperatorWidget.h"
+#include "ImageFilters.h"
+#include "Utilities.h"
+
+#include <vtkImageData.h>
+
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPointer>
+#include <QSpinBox>
+
+namespace {
+
+class GaussianFilterWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  GaussianFilterWidget(tomviz::GaussianFilterOperator* source, QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    m_sigma = new QDoubleSpinBox(this);
+    m_sigma->setRange(0, 1000);
+    m_sigma->setSingleStep(0.5);
+    m_sigma->setValue(source->sigma());
+
+    auto* layout = new QFormLayout(this);
+    layout->addRow(new QLabel("Apply an isotropic Gaussian filter to 3D "
+                              "volume. The standard deviation (sigma) can be "
+                              "specified below:",
+                              this));
+    layout->addRow("Sigma:", m_sigma);
+    setLayout(layout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    if (m_operator) {
+      m_operator->setSigma(m_sigma->value());
+    }
+  }
+
+private:
+  QPointer<tomviz::GaussianFilterOperator> m_operator;
+  QDoubleSpinBox* m_sigma;
+};
+
+class MedianFilterWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  MedianFilterWidget(tomviz::MedianFilterOperator* source, QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    m_size = new QSpinBox(this);
+    m_size->setRange(1, 100);
+    m_size->setValue(source->size());
+
+    auto* layout = new QFormLayout(this);
+    layout->addRow(new QLabel("Apply an isotropic median filter. The window "
+                              "size can be specified below:",
+                              this));
+    layout->addRow("Size:", m_size);
+    setLayout(layout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    if (m_operator) {
+      m_operator->setSize(m_size->value());
+    }
+  }
+
+private:
+  QPointer<tomviz::MedianFilterOperator> m_operator;
+  QSpinBox* m_size;
+};
+
+class ResampleWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  ResampleWidget(tomviz::ResampleOperator* source, QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    auto* factorLayout = new QHBoxLayout;
+    const char* axes[3] = { "X:", "Y:", "Z:" };
+    for (int i = 0; i < 3; ++i) {
+      m_factor[i] = new QDoubleSpinBox(this);
+      m_factor[i]->setDecimals(2);
+      m_factor[i]->setRange(0.01, 100);
+      m_factor[i]->setSingleStep(0.1);
+      m_factor[i]->setValue(source->resamplingFactor()[i]);
+      factorLayout->addWidget(new QLabel(axes[i], this));
+      factorLayout->addWidget(m_factor[i]);
+    }
+
+    auto* layout = new QFormLayout(this);
+    layout->addRow(new QLabel("Rescale the voxel spacing according to a "
+                              "resampling factor.",
+                              this));
+    layout->addRow("Factor:", factorLayout);
+    setLayout(layout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    if (m_operator) {
+      double factor[3];
+      for (int i = 0; i < 3; ++i) {
+        factor[i] = m_factor[i]->value();
+      }
+      m_operator->setResamplingFactor(factor);
+    }
+  }
+
+private:
+  QPointer<tomviz::ResampleOperator> m_operator;
+  QDoubleSpinBox* m_factor[3];
+};
+
+// Resample the tilt angles of a tilt series along with its images, like the
+// Python operators did.
+void zoomTiltAngles(vtkImageData* image, double factor)
+{
+  if (!tomviz::DataSource::hasTiltAngles(image)) {
+    return;
+  }
+  auto angles = tomviz::DataSource::getTiltAngles(image);
+  QVector<double> result(
+    tomviz::ImageFilters::zoomLength(angles.size(), factor));
+  tomviz::ImageFilters::zoom(angles.data(), angles.size(), result.data(),
+                             result.size(), 3);
+  tomviz::DataSource::setTiltAngles(image, result);
+}
+
+// The external executors only run Python operators, so the state also
+// carries the built-in script the operator replaces.
+QJsonObject withPythonScript(QJsonObject json, const QString& label,
+                             const QString& scriptName)
+{
+  json["label"] = label;
+  json["script"] = tomviz::readInPythonScript(scriptName);
+  return json;
+}
+} // namespace
+
+#include "ImageFilterOperators.moc"
+
+namespace tomviz {
+
+GaussianFilterOperator::GaussianFilterOperator(QObject* p) : Operator(p) {}
+
+QIcon GaussianFilterOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* GaussianFilterOperator::clone() const
+{
+  auto* other = new GaussianFilterOperator();
+  other->setSigma(m_sigma);
+  return other;
+}
+
+QJsonObject GaussianFilterOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  QJsonObject arguments;
+  arguments["sigma"] = m_sigma;
+  json["arguments"] = arguments;
+  return withPythonScript(json, label(), "GaussianFilter");
+}
+
+bool GaussianFilterOperator::deserialize(const QJsonObject& json)
+{
+  auto arguments = json["arguments"].toObject();
+  if (arguments.contains("sigma")) {
+    m_sigma = arguments["sigma"].toDouble();
+  }
+  return true;
+}
+
+EditOperatorWidget* GaussianFilterOperator::getEditorContents(QWidget* p)
+{
+  return new GaussianFilterWidget(this, p);
+}
+
+bool GaussianFilterOperator::applyTransform(vtkDataObject* data)
+{
+  return ImageFilters::gaussian(vtkImageData::SafeDownCast(data), m_sigma);
+}
+
+MedianFilterOperator::MedianFilterOperator(QObject* p) : Operator(p) {}
+
+QIcon MedianFilterOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* MedianFilterOperator::clone() const
+{
+  auto* other = new MedianFilterOperator();
+  other->setSize(m_size);
+  return other;
+}
+
+QJsonObject MedianFilterOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  QJsonObject arguments;
+  arguments["size"] = m_size;
+  json["arguments"] = arguments;
+  return withPythonScript(json, label(), "MedianFilter");
+}
+
+bool MedianFilterOperator::deserialize(const QJsonObject& json)
+{
+  auto arguments = json["arguments"].toObject();
+  if (arguments.contains("size")) {
+    m_size = arguments["size"].toInt();
+  }
+  return true;
+}
+
+EditOperatorWidget* MedianFilterOperator::getEditorContents(QWidget* p)
+{
+  return new MedianFilterWidget(this, p);
+}
+
+bool MedianFilterOperator::applyTransform(vtkDataObject* data)
+{
+  return ImageFilters::median(vtkImageData::SafeDownCast(data), m_size);
+}
+
+LaplaceFilterOperator::LaplaceFilterOperator(QObject* p) : Operator(p) {}
+
+QIcon LaplaceFilterOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* LaplaceFilterOperator::clone() const
+{
+  return new LaplaceFilterOperator();
+}
+
+QJsonObject LaplaceFilterOperator::serialize() const
+{
+  return withPythonScript(Operator::serialize(), label(), "LaplaceFilter");
+}
+
+bool LaplaceFilterOperator::applyTransform(vtkDataObject* data)
+{
+  return ImageFilters::laplace(vtkImageData::SafeDownCast(data));
+}
+
+GradientMagnitude2DSobelOperator::GradientMagnitude2DSobelOperator(
+  QObject* p)
+  : Operator(p)
+{
+}
+
+QIcon GradientMagnitude2DSobelOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* GradientMagnitude2DSobelOperator::clone() const
+{
+  return new GradientMagnitude2DSobelOperator();
+}
+
+QJsonObject GradientMagnitude2DSobelOperator::serialize() const
+{
+  return withPythonScript(Operator::serialize(), label(), "GradientMagnitude2D_Sobel");
+}
+
+bool GradientMagnitude2DSobelOperator::applyTransform(vtkDataObject* data)
+{
+  return ImageFilters::sobelMagnitude2D(vtkImageData::SafeDownCast(data));
+}
+
+BinVolumeByTwoOperator::BinVolumeByTwoOperator(QObject* p) : Operator(p) {}
+
+QIcon BinVolumeByTwoOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* BinVolumeByTwoOperator::clone() const
+{
+  return new BinVolumeByTwoOperator();
+}
+
+QJsonObject BinVolumeByTwoOperator::serialize() const
+{
+  return withPythonScript(Operator::serialize(), label(), "BinVolumeByTwo");
+}
+
+bool BinVolumeByTwoOperator::applyTransform(vtkDataObject* data)
+{
+  auto imageData = vtkImageData::SafeDownCast(data);
+  double factors[3] = { 0.5, 0.5, 0.5 };
+  if (!ImageFilters::zoom(imageData, factors, 1)) {
+    return false;
+  }
+  zoomTiltAngles(imageData, factors[2]);
+  return true;
+}
+
+ResampleOperator::ResampleOperator(QObject* p) : Operator(p) {}
+
+QIcon ResampleOperator::icon() const
+{
+  return QIcon();
+}
+
+Operator* ResampleOperator::clone() const
+{
+  auto* other = new ResampleOperator();
+  other->setResamplingFactor(m_resamplingFactor);
+  return other;
+}
+
+void ResampleOperator::setResamplingFactor(const double factor[3])
+{
+  for (int i = 0; i < 3; ++i) {
+    m_resamplingFactor[i] = factor[i];
+  }
+}
+
+QJsonObject ResampleOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  QJsonArray factor;
+  for (int i = 0; i < 3; ++i) {
+    factor.append(m_resamplingFactor[i]);
+  }
+  QJsonObject arguments;
+  arguments["resampling_factor"] = factor;
+  json["arguments"] = arguments;
+  return withPythonScript(json, label(), "Resample");
+}
+
+bool ResampleOperator::deserialize(const QJsonObject& json)
+{
+  auto arguments = json["arguments"].toObject();
+  auto factor = arguments["resampling_factor"].toArray();
+  if (factor.size() == 3) {
+    for (int i = 0; i < 3; ++i) {
+      m_resamplingFactor[i] = factor[i].toDouble();
+    }
+  }
+  return true;
+}
+
+EditOperatorWidget* ResampleOperator::getEditorContents(QWidget* p)
+{
+  return new ResampleWidget(this, p);
+}
+
+bool ResampleOperator::applyTransform(vtkDataObject* data)
+{
+  auto imageData = vtkImageData::SafeDownCast(data);
+  if (!ImageFilters::zoom(imageData, m_resamplingFactor, 3)) {
+    return false;
+  }
+  if (m_resamplingFactor[2] != 1) {
+    zoomTiltAngles(imageData, m_resamplingFactor[2]);
+  }
+  return true;
+}
+} // namespace tomviz
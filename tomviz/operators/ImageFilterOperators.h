@@ -0,0 +1,171 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizImageFilterOperators_h
+#define tomvizImageFilterOperators_h
+
+#include "Operator.h"
+
+// Native versions of the GaussianFilter, MedianFilter, LaplaceFilter,
+// GradientMagnitude2D_Sobel, BinVolumeByTwo and Resample Python operators.
+// Their parameters are serialized under "arguments" with the names the Python
+// scripts use, along with the script itself, so the external executors can
+// run the Python version.
+
+namespace tomviz {
+
+class GaussianFilterOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  GaussianFilterOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Gaussian Blur"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  EditOperatorWidget* getEditorContents(QWidget* parent) override;
+  bool hasCustomUI() const override { return true; }
+
+  void setSigma(double sigma) { m_sigma = sigma; }
+  double sigma() const { return m_sigma; }
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  double m_sigma = 2.0;
+
+  Q_DISABLE_COPY(GaussianFilterOperator)
+};
+
+class MedianFilterOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  MedianFilterOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Median Filter"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  EditOperatorWidget* getEditorContents(QWidget* parent) override;
+  bool hasCustomUI() const override { return true; }
+
+  void setSize(int size) { m_size = size; }
+  int size() const { return m_size; }
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  int m_size = 2;
+
+  Q_DISABLE_COPY(MedianFilterOperator)
+};
+
+class LaplaceFilterOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  LaplaceFilterOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Laplace Sharpen"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  Q_DISABLE_COPY(LaplaceFilterOperator)
+};
+
+class GradientMagnitude2DSobelOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  GradientMagnitude2DSobelOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Gradient Magnitude 2D"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  Q_DISABLE_COPY(GradientMagnitude2DSobelOperator)
+};
+
+class BinVolumeByTwoOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  BinVolumeByTwoOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Bin Volume x2"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  Q_DISABLE_COPY(BinVolumeByTwoOperator)
+};
+
+class ResampleOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  ResampleOperator(QObject* parent = nullptr);
+
+  QString label() const override { return "Resample"; }
+  QIcon icon() const override;
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  EditOperatorWidget* getEditorContents(QWidget* parent) override;
+  bool hasCustomUI() const override { return true; }
+
+  void setResamplingFactor(const double factor[3]);
+  const double* resamplingFactor() const { return m_resamplingFactor; }
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+private:
+  double m_resamplingFactor[3] = { 1, 1, 1 };
+
+  Q_DISABLE_COPY(ResampleOperator)
+};
+} // namespace tomviz
+
+#endif
@@ -0,0 +1,300 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "IterativeReconstructionOperator.h"
+
+#include "DataSource.h"
+#include "EditOperatorWidget.h"
+#include "Pipeline.h"
+#include "ReconstructionWidget.h"
+
+#include "vtkDataArray.h"
+#include "vtkFieldData.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkPointData.h"
+#include "vtkTrivialProducer.h"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QJsonObject>
+#include <QPointer>
+#include <QSpinBox>
+
+#include <algorithm>
+
+namespace {
+
+class IterativeReconstructionWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  IterativeReconstructionWidget(tomviz::IterativeReconstructionOperator* source,
+                                QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    using Method = tomviz::IterativeReconstructionOperator::Method;
+    const auto& options = source->options();
+
+    // This will ensure the combo box indexing matches that of the enum...
+    m_methodCombo = new QComboBox(this);
+    m_methodCombo->insertItem(static_cast<int>(Method::Landweber),
+                              "SIRT (Landweber)");
+    m_methodCombo->insertItem(static_cast<int>(Method::Cimmino),
+                              "SIRT (Cimmino)");
+    m_methodCombo->insertItem(static_cast<int>(Method::ComponentAveraging),
+                              "SIRT (Component Averaging)");
+    m_methodCombo->insertItem(static_cast<int>(Method::ART), "ART");
+    m_methodCombo->insertItem(static_cast<int>(Method::SART), "SART");
+    m_methodCombo->setCurrentIndex(static_cast<int>(options.method));
+
+    m_iterations = new QSpinBox(this);
+    m_iterations->setRange(1, 10000);
+    m_iterations->setValue(options.iterations);
+
+    m_stepSize = new QDoubleSpinBox(this);
+    m_stepSize->setDecimals(5);
+    m_stepSize->setSingleStep(0.0001);
+    m_stepSize->setRange(0, 1e6);
+    m_stepSize->setValue(options.stepSize);
+
+    m_relaxation = new QDoubleSpinBox(this);
+    m_relaxation->setDecimals(3);
+    m_relaxation->setSingleStep(0.1);
+    m_relaxation->setRange(0, 2);
+    m_relaxation->setValue(options.relaxation);
+
+    m_positivity = new QCheckBox("Positivity constraint", this);
+    m_positivity->setChecked(options.positivity);
+
+    auto* layout = new QFormLayout(this);
+    layout->addRow("Method:", m_methodCombo);
+    layout->addRow("Number of iterations:", m_iterations);
+    layout->addRow("Update step size (SIRT):", m_stepSize);
+    layout->addRow("Relaxation (ART, SART):", m_relaxation);
+    layout->addRow(m_positivity);
+
+    auto updateEnabled = [this]() {
+      bool sirt = m_methodCombo->currentIndex() < static_cast<int>(Method::ART);
+      m_stepSize->setEnabled(sirt);
+      m_relaxation->setEnabled(!sirt);
+    };
+    connect(m_methodCombo,
+            static_cast<void (QComboBox::*)(int)>(
+              &QComboBox::currentIndexChanged),
+            this, updateEnabled);
+    updateEnabled();
+
+    setLayout(layout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    // The combo box and enum indices should match
+    using Method = tomviz::IterativeReconstructionOperator::Method;
+    if (m_operator) {
+      auto options = m_operator->options();
+      options.method = static_cast<Method>(m_methodCombo->currentIndex());
+      options.iterations = m_iterations->value();
+      options.stepSize = m_stepSize->value();
+      options.relaxation = m_relaxation->value();
+      options.positivity = m_positivity->isChecked();
+      m_operator->setOptions(options);
+    }
+  }
+
+private:
+  QPointer<tomviz::IterativeReconstructionOperator> m_operator;
+  QComboBox* m_methodCombo;
+  QSpinBox* m_iterations;
+  QDoubleSpinBox* m_stepSize;
+  QDoubleSpinBox* m_relaxation;
+  QCheckBox* m_positivity;
+};
+} // namespace
+
+#include "IterativeReconstructionOperator.moc"
+
+namespace tomviz {
+IterativeReconstructionOperator::IterativeReconstructionOperator(
+  DataSource* source, QObject* p)
+  : Operator(p), m_dataSource(source)
+{
+  qRegisterMetaType<std::vector<float>>();
+  auto t = source->producer();
+  auto imageData = vtkImageData::SafeDownCast(t->GetOutputDataObject(0));
+  imageData->GetExtent(m_extent);
+  setSupportsCancel(true);
+  updateProgressSteps();
+  setHasChildDataSource(true);
+  connect(
+    this,
+    static_cast<void (Operator::*)(const QString&,
+                                   vtkSmartPointer<vtkDataObject>)>(
+      &Operator::newChildDataSource),
+    this,
+    [this](const QString& label, vtkSmartPointer<vtkDataObject> childData) {
+      this->createNewChildDataSource(label, childData, DataSource::Volume,
+                                     DataSource::PersistenceState::Transient);
+    });
+}
+
+QIcon IterativeReconstructionOperator::icon() const
+{
+  return QIcon(":/pqWidgets/Icons/pqExtractGrid24.png");
+}
+
+Operator* IterativeReconstructionOperator::clone() const
+{
+  auto* other = new IterativeReconstructionOperator(m_dataSource);
+  other->setOptions(m_options);
+  return other;
+}
+
+EditOperatorWidget* IterativeReconstructionOperator::getEditorContents(
+  QWidget* p)
+{
+  return new IterativeReconstructionWidget(this, p);
+}
+
+QJsonObject IterativeReconstructionOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  json["method"] = static_cast<int>(m_options.method);
+  json["iterations"] = m_options.iterations;
+  json["stepSize"] = m_options.stepSize;
+  json["relaxation"] = m_options.relaxation;
+  json["positivity"] = m_options.positivity;
+  return json;
+}
+
+bool IterativeReconstructionOperator::deserialize(const QJsonObject& json)
+{
+  if (json.contains("method")) {
+    // Unknown methods, e.g. from a newer version, fall back to the default.
+    int method = json["method"].toInt();
+    m_options.method = method >= static_cast<int>(Method::Landweber) &&
+                           method <= static_cast<int>(Method::SART)
+                         ? static_cast<Method>(method)
+                         : Options().method;
+  }
+  if (json.contains("iterations")) {
+    m_options.iterations = json["iterations"].toInt();
+  }
+  if (json.contains("stepSize")) {
+    m_options.stepSize = json["stepSize"].toDouble();
+  }
+  if (json.contains("relaxation")) {
+    m_options.relaxation = json["relaxation"].toDouble();
+  }
+  if (json.contains("positivity")) {
+    m_options.positivity = json["positivity"].toBool();
+  }
+  updateProgressSteps();
+  return true;
+}
+
+QWidget* IterativeReconstructionOperator::getCustomProgressWidget(
+  QWidget* p) const
+{
+  DataSource* source = m_dataSource;
+  if (source && source->pipeline()) {
+    // Use the transformed data source for the reconstruction widget
+    source = source->pipeline()->transformedDataSource();
+  }
+
+  ReconstructionWidget* widget = new ReconstructionWidget(source, p);
+  // The widget follows the slices of the current iteration.
+  int numXSlices = m_extent[1] - m_extent[0] + 1;
+  QObject::connect(this, &Operator::progressStepChanged, widget,
+                   [widget, numXSlices](int step) {
+                     widget->updateProgress(step % numXSlices);
+                   });
+  QObject::connect(this, &IterativeReconstructionOperator::intermediateResults,
+                   widget, &ReconstructionWidget::updateIntermediateResults);
+  return widget;
+}
+
+void IterativeReconstructionOperator::updateProgressSteps()
+{
+  setTotalProgressSteps((m_extent[1] - m_extent[0] + 1) *
+                        m_options.iterations);
+}
+
+bool IterativeReconstructionOperator::applyTransform(vtkDataObject* dataObject)
+{
+  vtkSmartPointer<vtkImageData> imageData =
+    vtkImageData::SafeDownCast(dataObject);
+  if (!imageData) {
+    return false;
+  }
+  // Extent changing shouldn't matter, but update so that correct number of
+  // steps can be reported.
+  imageData->GetExtent(m_extent);
+  updateProgressSteps();
+
+  int numXSlices = m_extent[1] - m_extent[0] + 1;
+  int numYSlices = m_extent[3] - m_extent[2] + 1;
+  int numZSlices = m_extent[5] - m_extent[4] + 1;
+  QVector<double> tiltAngles;
+
+  vtkFieldData* fd = dataObject->GetFieldData();
+  vtkDataArray* tiltAnglesVTKArray = fd->GetArray("tilt_angles");
+  if (tiltAnglesVTKArray) {
+    tiltAngles.resize(tiltAnglesVTKArray->GetNumberOfTuples());
+    for (int i = 0; i < tiltAngles.size(); ++i) {
+      tiltAngles[i] = tiltAnglesVTKArray->GetTuple1(i);
+    }
+  }
+
+  if (tiltAngles.size() < numZSlices) {
+    qDebug() << "Incorrect number of tilt angles. There are"
+             << tiltAngles.size() << "and there should be" << numZSlices
+             << ".\n";
+    return false;
+  }
+
+  vtkNew<vtkImageData> reconstructionImage;
+  int extent2[6] = { m_extent[0], m_extent[1], m_extent[2],
+                     m_extent[3], m_extent[2], m_extent[3] };
+  reconstructionImage->SetExtent(extent2);
+  reconstructionImage->AllocateScalars(VTK_FLOAT, 1);
+  vtkDataArray* darray = reconstructionImage->GetPointData()->GetScalars();
+  darray->SetName("scalars");
+  float* reconstruction = static_cast<float*>(darray->GetVoidPointer(0));
+
+  // Slices are updated in parallel, progress is reported here on the
+  // operator's thread as they complete.
+  std::vector<float> reconstructionPtr(numYSlices * numYSlices);
+  size_t sliceSize = static_cast<size_t>(numYSlices) * numXSlices;
+  auto progress = [&](int completed, int slice) {
+    QCoreApplication::processEvents();
+    int iteration = std::min((completed - 1) / numXSlices + 1,
+                             m_options.iterations);
+    setProgressMessage(QString("Iteration %1 of %2")
+                         .arg(iteration)
+                         .arg(m_options.iterations));
+    for (int j = 0; j < numYSlices; ++j) {
+      for (int k = 0; k < numYSlices; ++k) {
+        reconstructionPtr[k * numYSlices + j] =
+          reconstruction[j * sliceSize + k * numXSlices + slice];
+      }
+    }
+    emit intermediateResults(reconstructionPtr);
+    setProgressStep(completed - 1);
+    return !isCanceled();
+  };
+  IterativeReconstruction::reconstruct(imageData, tiltAngles.data(),
+                                       reconstruction, m_options, progress);
+  if (isCanceled()) {
+    return false;
+  }
+  emit newChildDataSource("Reconstruction", reconstructionImage);
+  return true;
+}
+} // namespace tomviz
@@ -0,0 +1,62 @@
+/* This source file is part of the Tomviz project, https://tomviz.org/.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef tomvizIterativeReconstructionOperator_h
+#define tomvizIterativeReconstructionOperator_h
+
+#include "IterativeReconstruction.h"
+#include "Operator.h"
+
+namespace tomviz {
+class DataSource;
+
+/// Native ART/SART/SIRT reconstruction of a tilt series, see
+/// IterativeReconstruction::reconstruct().
+class IterativeReconstructionOperator : public Operator
+{
+  Q_OBJECT
+
+public:
+  IterativeReconstructionOperator(DataSource* source,
+                                  QObject* parent = nullptr);
+
+  QString label() const override { return "Iterative Reconstruction"; }
+
+  QIcon icon() const override;
+
+  Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
+
+  QWidget* getCustomProgressWidget(QWidget*) const override;
+
+  EditOperatorWidget* getEditorContents(QWidget* parent) override;
+  bool hasCustomUI() const override { return true; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  using Method = IterativeReconstruction::Method;
+  using Options = IterativeReconstruction::Options;
+
+  void setOptions(const Options& options) { m_options = options; }
+  const Options& options() const { return m_options; }
+
+protected:
+  bool applyTransform(vtkDataObject* data) override;
+
+signals:
+  /// Emitted as slices are updated, with the most recently updated slice of
+  /// the reconstruction, to display intermediate results.
+  void intermediateResults(std::vector<float> resultSlice);
+
+private:
+  void updateProgressSteps();
+
+  DataSource* m_dataSource;
+  int m_extent[6];
+  Options m_options;
+  Q_DISABLE_COPY(IterativeReconstructionOperator)
+};
+} // namespace tomviz
+
+#endif
@@ -145,6 +145,13 @@ public:
   /// can be set by the setSupportsCancel(bool) method by subclasses.
   bool supportsCancelingMidTransform() const { return m_supportsCancel; }
 
+  /// Returns true if applyTransform may write into the point data arrays of
+  /// the data it is given. Operators that only read the arrays and replace
+  /// them with new ones (or only change field data) should return false; the
+  /// pipeline can then give them data sharing its arrays with the input rather
+  /// than a private deep copy.
+  virtual bool modifiesDataInPlace() const { return true; }
+
   /// Return the total number of progress updates (assuming each update
   /// increments the progress from 0 to some maximum.  If the operator doesn't
   /// support incremental progress updates, leave value set to zero
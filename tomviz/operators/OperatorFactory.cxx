@@ -7,6 +7,8 @@
 #include "ConvertToFloatOperator.h"
 #include "ConvertToVolumeOperator.h"
 #include "CropOperator.h"
+#include "ImageFilterOperators.h"
+#include "IterativeReconstructionOperator.h"
 #include "OperatorPython.h"
 #include "ReconstructionOperator.h"
 #include "SetTiltAnglesOperator.h"
@@ -34,11 +36,18 @@ QList<QString> OperatorFactory::operatorTypes()
 {
   QList<QString> reply;
   reply << "ArrayWrangler"
+        << "BinVolumeByTwo"
         << "ConvertToFloat"
         << "ConvertToVolume"
         << "Crop"
+        << "CxxIterativeReconstruction"
         << "CxxReconstruction"
+        << "GaussianFilter"
+        << "GradientMagnitude2DSobel"
+        << "LaplaceFilter"
+        << "MedianFilter"
         << "Python"
+        << "Resample"
         << "SetTiltAngles"
         << "Snapshot"
         << "TranslateAlign"
@@ -73,6 +82,8 @@ Operator* OperatorFactory::createOperator(const QString& type, DataSource* ds)
     op = new CropOperator(ds);
   } else if (type == "CxxReconstruction") {
     op = new ReconstructionOperator(ds);
+  } else if (type == "CxxIterativeReconstruction") {
+    op = new IterativeReconstructionOperator(ds);
   } else if (type == "SetTiltAngles") {
     op = new SetTiltAnglesOperator(ds);
   } else if (type == "TranslateAlign") {
@@ -81,6 +92,18 @@ Operator* OperatorFactory::createOperator(const QString& type, DataSource* ds)
     op = new TransposeDataOperator(ds);
   } else if (type == "Snapshot") {
     op = new SnapshotOperator(ds);
+  } else if (type == "GaussianFilter") {
+    op = new GaussianFilterOperator(ds);
+  } else if (type == "MedianFilter") {
+    op = new MedianFilterOperator(ds);
+  } else if (type == "LaplaceFilter") {
+    op = new LaplaceFilterOperator(ds);
+  } else if (type == "GradientMagnitude2DSobel") {
+    op = new GradientMagnitude2DSobelOperator(ds);
+  } else if (type == "BinVolumeByTwo") {
+    op = new BinVolumeByTwoOperator(ds);
+  } else if (type == "Resample") {
+    op = new ResampleOperator(ds);
   }
   return op;
 }
@@ -105,6 +128,9 @@ const char* OperatorFactory::operatorType(const Operator* op)
   if (qobject_cast<const ReconstructionOperator*>(op)) {
     return "CxxReconstruction";
   }
+  if (qobject_cast<const IterativeReconstructionOperator*>(op)) {
+    return "CxxIterativeReconstruction";
+  }
   if (qobject_cast<const SetTiltAnglesOperator*>(op)) {
     return "SetTiltAngles";
   }
@@ -117,6 +143,24 @@ const char* OperatorFactory::operatorType(const Operator* op)
   if (qobject_cast<const SnapshotOperator*>(op)) {
     return "Snapshot";
   }
+  if (qobject_cast<const GaussianFilterOperator*>(op)) {
+    return "GaussianFilter";
+  }
+  if (qobject_cast<const MedianFilterOperator*>(op)) {
+    return "MedianFilter";
+  }
+  if (qobject_cast<const LaplaceFilterOperator*>(op)) {
+    return "LaplaceFilter";
+  }
+  if (qobject_cast<const GradientMagnitude2DSobelOperator*>(op)) {
+    return "GradientMagnitude2DSobel";
+  }
+  if (qobject_cast<const BinVolumeByTwoOperator*>(op)) {
+    return "BinVolumeByTwo";
+  }
+  if (qobject_cast<const ResampleOperator*>(op)) {
+    return "Resample";
+  }
   return nullptr;
 }
 
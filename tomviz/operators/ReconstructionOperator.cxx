@@ -4,6 +4,7 @@
 #include "ReconstructionOperator.h"
 
 #include "DataSource.h"
+#include "EditOperatorWidget.h"
 #include "Pipeline.h"
 #include "ReconstructionWidget.h"
 #include "TomographyReconstruction.h"
@@ -19,8 +20,69 @@
 #include "vtkSMSourceProxy.h"
 #include "vtkTrivialProducer.h"
 
+#include <QComboBox>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QHBoxLayout>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPointer>
+
+namespace {
+
+class ReconstructionFilterWidget : public tomviz::EditOperatorWidget
+{
+  Q_OBJECT
+
+public:
+  ReconstructionFilterWidget(tomviz::ReconstructionOperator* source,
+                             QWidget* p)
+    : tomviz::EditOperatorWidget(p), m_operator(source)
+  {
+    auto* filterLabel = new QLabel("Fourier Weighting Filter:", this);
+    filterLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+
+    m_filterCombo = new QComboBox(this);
+    using FilterType = tomviz::ReconstructionOperator::FilterType;
+    // This will ensure the combo box indexing matches that of the enum...
+    m_filterCombo->insertItem(static_cast<int>(FilterType::None),
+                              "None (Unweighted)");
+    m_filterCombo->insertItem(static_cast<int>(FilterType::Ramp), "Ramp");
+    m_filterCombo->insertItem(static_cast<int>(FilterType::SheppLogan),
+                              "Shepp-Logan");
+    m_filterCombo->insertItem(static_cast<int>(FilterType::Cosine), "Cosine");
+    m_filterCombo->insertItem(static_cast<int>(FilterType::Hamming),
+                              "Hamming");
+    m_filterCombo->insertItem(static_cast<int>(FilterType::Hann), "Hann");
+    m_filterCombo->setCurrentIndex(static_cast<int>(source->filter()));
+
+    auto* vBoxLayout = new QVBoxLayout(this);
+    auto* filterHBoxLayout = new QHBoxLayout;
+    filterHBoxLayout->addWidget(filterLabel);
+    filterHBoxLayout->addWidget(m_filterCombo);
+    vBoxLayout->addLayout(filterHBoxLayout);
+    vBoxLayout->addStretch();
+
+    setLayout(vBoxLayout);
+  }
+
+  void applyChangesToOperator() override
+  {
+    // The combo box and enum indices should match
+    using FilterType = tomviz::ReconstructionOperator::FilterType;
+    if (m_operator) {
+      m_operator->setFilter(
+        static_cast<FilterType>(m_filterCombo->currentIndex()));
+    }
+  }
+
+private:
+  QPointer<tomviz::ReconstructionOperator> m_operator;
+  QComboBox* m_filterCombo;
+};
+} // namespace
+
+#include "ReconstructionOperator.moc"
 
 namespace tomviz {
 ReconstructionOperator::ReconstructionOperator(DataSource* source, QObject* p)
@@ -56,7 +118,34 @@ QIcon ReconstructionOperator::icon() const
 
 Operator* ReconstructionOperator::clone() const
 {
-  return new ReconstructionOperator(m_dataSource);
+  auto* other = new ReconstructionOperator(m_dataSource);
+  other->setFilter(m_filter);
+  return other;
+}
+
+EditOperatorWidget* ReconstructionOperator::getEditorContents(QWidget* p)
+{
+  return new ReconstructionFilterWidget(this, p);
+}
+
+QJsonObject ReconstructionOperator::serialize() const
+{
+  auto json = Operator::serialize();
+  json["filter"] = static_cast<int>(m_filter);
+  return json;
+}
+
+bool ReconstructionOperator::deserialize(const QJsonObject& json)
+{
+  if (json.contains("filter")) {
+    // Unknown filters, e.g. from a newer version, fall back to none.
+    int filter = json["filter"].toInt();
+    m_filter = filter >= static_cast<int>(FilterType::None) &&
+                   filter <= static_cast<int>(FilterType::Hann)
+                 ? static_cast<FilterType>(filter)
+                 : FilterType::None;
+  }
+  return true;
 }
 
 QWidget* ReconstructionOperator::getCustomProgressWidget(QWidget* p) const
@@ -96,7 +185,6 @@ bool ReconstructionOperator::applyTransform(vtkDataObject* dataObject)
   int numXSlices = dataExtent[1] - dataExtent[0] + 1;
   int numYSlices = dataExtent[3] - dataExtent[2] + 1;
   int numZSlices = dataExtent[5] - dataExtent[4] + 1;
-  std::vector<float> sinogramPtr(numYSlices * numZSlices);
   std::vector<float> reconstructionPtr(numYSlices * numYSlices);
   QVector<double> tiltAngles;
 
@@ -126,21 +214,24 @@ bool ReconstructionOperator::applyTransform(vtkDataObject* dataObject)
 
   // TODO: talk to Dave Lonie about how to do this in new data array API
   float* reconstruction = (float*)darray->GetVoidPointer(0);
-  for (int i = 0; i < numXSlices && !isCanceled(); ++i) {
+
+  // Slices are reconstructed in parallel, progress is reported here on the
+  // operator's thread as they complete.
+  size_t sliceSize = static_cast<size_t>(numYSlices) * numXSlices;
+  auto progress = [&](int completed, int slice) {
     QCoreApplication::processEvents();
-    TomographyTiltSeries::getSinogram(imageData, i, &sinogramPtr[0]);
-    TomographyReconstruction::unweightedBackProjection2(
-      &sinogramPtr[0], tiltAngles.data(), &reconstructionPtr[0], numZSlices,
-      numYSlices);
     for (int j = 0; j < numYSlices; ++j) {
       for (int k = 0; k < numYSlices; ++k) {
-        reconstruction[j * (numYSlices * numXSlices) + k * numXSlices + i] =
-          reconstructionPtr[k * numYSlices + j];
+        reconstructionPtr[k * numYSlices + j] =
+          reconstruction[j * sliceSize + k * numXSlices + slice];
       }
     }
     emit intermediateResults(reconstructionPtr);
-    setProgressStep(i);
-  }
+    setProgressStep(completed - 1);
+    return !isCanceled();
+  };
+  TomographyReconstruction::parallelBackProjection3(
+    imageData, tiltAngles.data(), reconstruction, m_filter, progress);
   if (isCanceled()) {
     return false;
   }
@@ -5,6 +5,7 @@
 #define tomvizReconstructionOperator_h
 
 #include "Operator.h"
+#include "TomographyReconstruction.h"
 
 namespace tomviz {
 class DataSource;
@@ -21,9 +22,23 @@ public:
   QIcon icon() const override;
 
   Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
 
   QWidget* getCustomProgressWidget(QWidget*) const override;
 
+  EditOperatorWidget* getEditorContents(QWidget* parent) override;
+  bool hasCustomUI() const override { return true; }
+
+  QJsonObject serialize() const override;
+  bool deserialize(const QJsonObject& json) override;
+
+  using FilterType = TomographyReconstruction::FilterType;
+
+  /// The Fourier weighting applied to the projections, FilterType::None gives
+  /// the unweighted back projection.
+  void setFilter(FilterType filter) { m_filter = filter; }
+  FilterType filter() const { return m_filter; }
+
 protected:
   bool applyTransform(vtkDataObject* data) override;
 
@@ -36,6 +51,7 @@ signals:
 private:
   DataSource* m_dataSource;
   int m_extent[6];
+  FilterType m_filter = FilterType::None;
   Q_DISABLE_COPY(ReconstructionOperator)
 };
 } // namespace tomviz
@@ -20,6 +20,7 @@ public:
   QString label() const override { return "Set Tilt Angles"; }
   QIcon icon() const override;
   Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
   QJsonObject serialize() const override;
   bool deserialize(const QJsonObject& json) override;
   EditOperatorWidget* getEditorContentsWithData(
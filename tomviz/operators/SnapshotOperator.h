@@ -21,6 +21,7 @@ public:
   QIcon icon() const override;
 
   Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
 
   QJsonObject serialize() const override;
   bool deserialize(const QJsonObject& json) override;
@@ -7,69 +7,19 @@
 #include "DataSource.h"
 #include "OperatorResult.h"
 
+#include "vtkDataArray.h"
+#include "vtkDoubleArray.h"
 #include "vtkImageData.h"
 #include "vtkIntArray.h"
 #include "vtkNew.h"
+#include "vtkSmartPointer.h"
 #include "vtkTable.h"
 
 #include <QJsonArray>
 
 namespace {
 
-// We are assuming an image that begins at 0, 0, 0.
-vtkIdType imageIndex(const vtkVector3i& incs, const vtkVector3i& pos)
-{
-  return pos[0] * incs[0] + pos[1] * incs[1] + pos[2] * incs[2];
-}
-
-template <typename T>
-void applyImageOffsets(T* in, T* out, vtkImageData* image,
-                       const QVector<vtkVector2i>& offsets)
-{
-  // We know that the input and output images are the same size, with the
-  // supplied offsets applied to each slice. Copy the pixels, applying offsets.
-  int* extents = image->GetExtent();
-  vtkVector3i extent(extents[1] - extents[0] + 1, extents[3] - extents[2] + 1,
-                     extents[5] - extents[4] + 1);
-  vtkVector3i incs(1, 1 * extent[0], 1 * extent[0] * extent[1]);
-
-  // Zero out our output array, we should do this more intelligently in future.
-  T* ptr = out;
-  for (int i = 0; i < extent[0] * extent[1] * extent[2]; ++i) {
-    *ptr++ = 0;
-  }
-
-  // We need to go slice by slice, applying the pixel offsets to the new image.
-  for (int i = 0; i < extent[2]; ++i) {
-    vtkVector2i offset = offsets[i];
-    int idx = imageIndex(incs, vtkVector3i(0, 0, i));
-    T* inPtr = in + idx;
-    T* outPtr = out + idx;
-    for (int y = 0; y < extent[1]; ++y) {
-      if (y + offset[1] >= extent[1]) {
-        break;
-      } else if (y + offset[1] < 0) {
-        inPtr += incs[1];
-        outPtr += incs[1];
-        continue;
-      }
-      for (int x = 0; x < extent[0]; ++x) {
-        if (x + offset[0] >= extent[0]) {
-          inPtr += offset[0];
-          outPtr += offset[0];
-          break;
-        } else if (x + offset[0] < 0) {
-          ++inPtr;
-          ++outPtr;
-          continue;
-        }
-        *(outPtr + offset[0] + incs[1] * offset[1]) = *inPtr;
-        ++inPtr;
-        ++outPtr;
-      }
-    }
-  }
-}
+const char* interpolationNames[] = { "nearest", "linear", "fourier" };
 } // namespace
 
 namespace tomviz {
@@ -77,6 +27,7 @@ TranslateAlignOperator::TranslateAlignOperator(DataSource* ds, QObject* p)
   : Operator(p), dataSource(ds)
 {
   initializeResults();
+  setSupportsCancel(true);
 }
 
 QIcon TranslateAlignOperator::icon() const
@@ -94,45 +45,80 @@ void TranslateAlignOperator::initializeResults()
   setResult(0, table);
 }
 
+std::vector<vtkVector2d> TranslateAlignOperator::shifts() const
+{
+  std::vector<vtkVector2d> result;
+  for (int i = 0; i < offsets.size(); ++i) {
+    vtkVector2d shift(offsets[i][0], offsets[i][1]);
+    if (m_interpolation != ImageTranslation::Interpolation::Nearest &&
+        i < m_subpixelOffsets.size()) {
+      shift[0] += m_subpixelOffsets[i][0];
+      shift[1] += m_subpixelOffsets[i][1];
+    }
+    result.push_back(shift);
+  }
+  return result;
+}
+
 bool TranslateAlignOperator::applyTransform(vtkDataObject* data)
 {
-  vtkNew<vtkImageData> outImage;
-  vtkImageData* inImage = vtkImageData::SafeDownCast(data);
-  assert(inImage);
-  outImage->DeepCopy(data);
-  switch (inImage->GetScalarType()) {
-    vtkTemplateMacro(
-      applyImageOffsets(reinterpret_cast<VTK_TT*>(inImage->GetScalarPointer()),
-                        reinterpret_cast<VTK_TT*>(outImage->GetScalarPointer()),
-                        inImage, offsets));
+  vtkImageData* image = vtkImageData::SafeDownCast(data);
+  if (!image) {
+    return false;
+  }
+  int dims[3];
+  image->GetDimensions(dims);
+  setTotalProgressSteps(dims[2]);
+
+  // The input arrays may be shared with the previous data, so the slices are
+  // moved into a new scalars array, which costs no more than moving them in
+  // place.
+  auto progress = [this](int completed, int) {
+    setProgressStep(completed);
+    return !isCanceled();
+  };
+  auto alignment = shifts();
+  if (!ImageTranslation::translate(image, alignment, m_interpolation, false,
+                                   progress)) {
+    return false;
   }
-  offsetsToResult();
-  data->ShallowCopy(outImage);
+  offsetsToResult(alignment);
   return true;
 }
 
 Operator* TranslateAlignOperator::clone() const
 {
   TranslateAlignOperator* op = new TranslateAlignOperator(this->dataSource);
+  op->setSubpixelOffsets(m_subpixelOffsets);
+  op->setInterpolation(m_interpolation);
   op->setAlignOffsets(this->offsets);
   return op;
 }
 
-void TranslateAlignOperator::offsetsToResult()
+void TranslateAlignOperator::offsetsToResult(
+  const std::vector<vtkVector2d>& alignment)
 {
-  vtkNew<vtkIntArray> arrX;
+  // Whole pixel offsets stay integers.
+  vtkSmartPointer<vtkDataArray> arrX;
+  vtkSmartPointer<vtkDataArray> arrY;
+  if (m_interpolation == ImageTranslation::Interpolation::Nearest) {
+    arrX = vtkSmartPointer<vtkIntArray>::New();
+    arrY = vtkSmartPointer<vtkIntArray>::New();
+  } else {
+    arrX = vtkSmartPointer<vtkDoubleArray>::New();
+    arrY = vtkSmartPointer<vtkDoubleArray>::New();
+  }
   arrX->SetName("X Offset");
-  vtkNew<vtkIntArray> arrY;
   arrY->SetName("Y Offset");
 
   vtkNew<vtkTable> table;
   table->AddColumn(arrX);
   table->AddColumn(arrY);
-  table->SetNumberOfRows(offsets.size());
+  table->SetNumberOfRows(alignment.size());
 
-  for (int i = 0; i < offsets.size(); ++i) {
-    table->SetValue(i, 0, offsets[i][0]);
-    table->SetValue(i, 1, offsets[i][1]);
+  for (size_t i = 0; i < alignment.size(); ++i) {
+    arrX->SetTuple1(i, alignment[i][0]);
+    arrY->SetTuple1(i, alignment[i][1]);
   }
   setResult(0, table);
 }
@@ -155,6 +141,16 @@ QJsonObject TranslateAlignOperator::serialize() const
     json["draftOffsets"] = draftOffsetArray;
   }
 
+  if (m_subpixelOffsets.size() > 0) {
+    QJsonArray subpixelOffsetArray;
+    foreach (auto offset, m_subpixelOffsets) {
+      subpixelOffsetArray << offset[0] << offset[1];
+    }
+    json["subpixelOffsets"] = subpixelOffsetArray;
+  }
+  json["interpolation"] =
+    interpolationNames[static_cast<int>(m_interpolation)];
+
   return json;
 }
 
@@ -178,6 +174,23 @@ bool TranslateAlignOperator::deserialize(const QJsonObject& json)
     }
   }
 
+  if (json.contains("subpixelOffsets") && json["subpixelOffsets"].isArray()) {
+    auto subpixelOffsetArray = json["subpixelOffsets"].toArray();
+    m_subpixelOffsets.resize(subpixelOffsetArray.size() / 2);
+    for (int i = 0; i < subpixelOffsetArray.size() / 2; ++i) {
+      m_subpixelOffsets[i][0] = subpixelOffsetArray[2 * i].toDouble();
+      m_subpixelOffsets[i][1] = subpixelOffsetArray[2 * i + 1].toDouble();
+    }
+  }
+
+  m_interpolation = ImageTranslation::Interpolation::Nearest;
+  auto interpolation = json["interpolation"].toString();
+  for (int i = 0; i < 3; ++i) {
+    if (interpolation == interpolationNames[i]) {
+      m_interpolation = static_cast<ImageTranslation::Interpolation>(i);
+    }
+  }
+
   return true;
 }
 
@@ -4,6 +4,7 @@
 #ifndef tomvizTranslateAlignOperator_h
 #define tomvizTranslateAlignOperator_h
 
+#include "ImageTranslation.h"
 #include "Operator.h"
 
 #include "vtkVector.h"
@@ -25,6 +26,7 @@ public:
   QString label() const override { return "Translation Align"; }
   QIcon icon() const override;
   Operator* clone() const override;
+  bool modifiesDataInPlace() const override { return false; }
 
   QJsonObject serialize() const override;
   bool deserialize(const QJsonObject& json) override;
@@ -40,19 +42,50 @@ public:
     return m_draftOffsets;
   }
 
+  /// Fractions of a pixel added to the offsets when the interpolation isn't
+  /// Nearest, as found by cross-correlation. Set them, and the interpolation,
+  /// before the offsets since only setAlignOffsets() reruns the operator.
+  void setSubpixelOffsets(const QVector<vtkVector2d>& offsets)
+  {
+    m_subpixelOffsets = offsets;
+  }
+  const QVector<vtkVector2d>& getSubpixelOffsets() const
+  {
+    return m_subpixelOffsets;
+  }
+
+  void setInterpolation(ImageTranslation::Interpolation interpolation)
+  {
+    m_interpolation = interpolation;
+  }
+  ImageTranslation::Interpolation interpolation() const
+  {
+    return m_interpolation;
+  }
+
   DataSource* getDataSource() const { return this->dataSource; }
 
+  /// Have the editor compute the offsets by cross-correlation as soon as it is
+  /// shown. This is not serialized.
+  void setAlignOnEdit(bool align) { m_alignOnEdit = align; }
+  bool alignOnEdit() const { return m_alignOnEdit; }
+
   bool hasCustomUI() const override { return true; }
 
 protected:
   bool applyTransform(vtkDataObject* data) override;
-  void offsetsToResult();
+  void offsetsToResult(const std::vector<vtkVector2d>& alignment);
   void initializeResults();
+  std::vector<vtkVector2d> shifts() const;
 
 private:
   QVector<vtkVector2i> offsets;
   QVector<vtkVector2i> m_draftOffsets;
+  QVector<vtkVector2d> m_subpixelOffsets;
+  ImageTranslation::Interpolation m_interpolation =
+    ImageTranslation::Interpolation::Nearest;
   const QPointer<DataSource> dataSource;
+  bool m_alignOnEdit = false;
 };
 } // namespace tomviz
 
@@ -4,6 +4,7 @@
 #include "TransposeDataOperator.h"
 
 #include "EditOperatorWidget.h"
+#include "PermuteAxes.h"
 
 #include <vtkFloatArray.h>
 #include <vtkImageData.h>
@@ -17,6 +18,8 @@
 #include <QHBoxLayout>
 #include <QLabel>
 
+#include <utility>
+
 namespace {
 
 class TransposeDataWidget : public tomviz::EditOperatorWidget
@@ -69,36 +72,6 @@ private:
 
 #include "TransposeDataOperator.moc"
 
-namespace {
-
-template <typename T>
-void ReorderArrayC(T* in, T* out, int dim[3])
-{
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(i * dim[1] + j) * dim[2] + k] =
-          in[static_cast<size_t>(k * dim[1] + j) * dim[0] + i];
-      }
-    }
-  }
-}
-
-template <typename T>
-void ReorderArrayF(T* in, T* out, int dim[3])
-{
-  for (int i = 0; i < dim[0]; ++i) {
-    for (int j = 0; j < dim[1]; ++j) {
-      for (int k = 0; k < dim[2]; ++k) {
-        out[static_cast<size_t>(k * dim[1] + j) * dim[0] + i] =
-          in[static_cast<size_t>(i * dim[1] + j) * dim[2] + k];
-      }
-    }
-  }
-}
-
-}
-
 namespace tomviz {
 
 TransposeDataOperator::TransposeDataOperator(QObject* p) : Operator(p)
@@ -135,30 +108,24 @@ bool TransposeDataOperator::applyTransform(vtkDataObject* data)
   outputArray->SetName(scalars->GetName());
 
   auto outPtr = outputArray->GetVoidPointer(0);
+  size_t elementSize =
+    static_cast<size_t>(scalars->GetNumberOfComponents()) *
+    scalars->GetDataTypeSize();
 
+  // Both transposes reverse the axes, starting from x as the fastest axis when
+  // going to C order, and from z when going to Fortran order.
+  int inDims[3] = { dim[0], dim[1], dim[2] };
   switch (m_transposeType) {
     case TransposeType::C:
-      switch (scalars->GetDataType()) {
-      vtkTemplateMacro(ReorderArrayC(
-        reinterpret_cast<VTK_TT*>(dataPtr), reinterpret_cast<VTK_TT*>(outPtr),
-        dim));
-      default:
-        qDebug() << "TransposeType: Unknown data type";
-      }
       break;
     case TransposeType::Fortran:
-      switch (scalars->GetDataType()) {
-      vtkTemplateMacro(ReorderArrayF(
-        reinterpret_cast<VTK_TT*>(dataPtr), reinterpret_cast<VTK_TT*>(outPtr),
-        dim));
-      default:
-        qDebug() << "TransposeType: Unknown data type";
-      }
+      std::swap(inDims[0], inDims[2]);
       break;
     default:
       qDebug() << "Error in" << __FUNCTION__ << ": unknown transpose type!";
       return false;
   }
+  reverseAxes(dataPtr, outPtr, inDims, elementSize);
 
   imageData->GetPointData()->RemoveArray(scalars->GetName());
   imageData->GetPointData()->SetScalars(outputArray);
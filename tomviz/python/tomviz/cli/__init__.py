@@ -54,8 +54,16 @@ def _extract_pipeline(state):
 @click.option('-i', '--operator-index',
               help='The operator to start at.',
               type=int, default=0)
+@click.option('--progress-data-interval',
+              help='The minimum time in seconds between progress data'
+              ' updates.', type=float, default=0.5)
+@click.option('--progress-preview-size',
+              help='Downsample progress data to at most this many samples'
+              ' along each axis, 0 sends it at full resolution.',
+              type=int, default=0)
 def main(data_path, state_file_path, output_file_path, progress_method,
-         socket_path, operator_index):
+         socket_path, operator_index, progress_data_interval,
+         progress_preview_size):
 
     # Extract the pipeline
     with open(state_file_path) as fp:
@@ -87,7 +95,7 @@ def main(data_path, state_file_path, output_file_path, progress_method,
             raise Exception('Data source path does not exist: %s'
                             % data_path)
 
-    exts = ['.emd', '.h5', '.hdf5']
+    exts = ['.emd', '.h5', '.hdf5', executor.SHARED_VOLUME_EXTENSION]
     data_path = Path(data_path)
     # Do we have multiple files to operate on
     if data_path.is_dir():
@@ -104,7 +112,8 @@ def main(data_path, state_file_path, output_file_path, progress_method,
     else:
         if data_path.suffix.lower() not in exts:
             raise Exception(
-                'Unsupported data source format, only HDF5 formats supported.')
+                'Unsupported data source format, only HDF5 formats and shared'
+                ' volumes are supported.')
         data_file_paths = [data_path]
         output_file_paths = [output_file_path]
 
@@ -119,4 +128,5 @@ def main(data_path, state_file_path, output_file_path, progress_method,
         logger.info('Executing pipeline on %s' % data_file_path)
         executor.execute(operators, operator_index, data_file_path,
                          output_file_path, progress_method, socket_path,
-                         read_options)
+                         read_options, progress_data_interval,
+                         progress_preview_size)
@@ -12,6 +12,8 @@ import stat
 import json
 import six
 import errno
+import shutil
+import time
 
 from tqdm import tqdm
 
@@ -33,6 +35,10 @@ ANGLE_UNITS = [b'[deg]', b'[rad]']
 
 Dim = collections.namedtuple('Dim', 'path values name units')
 
+# Volumes handed over through memory mapped files, see SharedVolumeFormat.h
+SHARED_VOLUME_EXTENSION = '.tvshm'
+SHARED_VOLUME_VERSION = 1
+
 
 class ProgressBase(object):
     def started(self, op=None):
@@ -201,6 +207,14 @@ class JsonProgress(ProgressBase, metaclass=abc.ABCMeta):
 
         self._message = msg
 
+    # The minimum time, in seconds, between two progress data updates
+    data_interval = 0.5
+    # Progress data is downsampled to at most this many samples along each
+    # axis, 0 sends it at full resolution
+    preview_size = 0
+    _pending_data = None
+    _data_sent_at = None
+
     @property
     def data(self):
         return self._data
@@ -208,19 +222,45 @@ class JsonProgress(ProgressBase, metaclass=abc.ABCMeta):
     @data.setter
     def data(self, value):
         """
-        Updates the progress of the the operator.
+        Updates the progress of the the operator. Updates that come in faster
+        than the application can take them are dropped, only the latest one is
+        kept until it can be sent.
 
         :param data The current progress data value.
         :type value: numpy.ndarray
         """
-        path = self.write_to_file(value)
+        self._data = value
+        self._pending_data = value
+        self._send_data()
+
+    def _send_data(self, force=False):
+        if self._pending_data is None:
+            return
+
+        now = time.monotonic()
+        if not force:
+            if self._data_in_flight():
+                return
+            if self._data_sent_at is not None and \
+                    now - self._data_sent_at < self.data_interval:
+                return
+
+        data = _preview(self._pending_data, self.preview_size)
+        path = self.write_to_file(data)
         msg = {
             'type': 'progress.data',
             'operator': self._operator_index,
             'value': path
         }
         self.write(msg)
-        self._data = value
+        self._pending_data = None
+        self._data_sent_at = now
+
+    def _data_in_flight(self):
+        """
+        Whether the application is still loading the last progress data.
+        """
+        return False
 
     def __enter__(self):
         return self
@@ -241,6 +281,10 @@ class JsonProgress(ProgressBase, metaclass=abc.ABCMeta):
 
     def finished(self, op=None):
         super(JsonProgress, self).started(op)
+        # Make sure the application gets the last of the progress data
+        if op is not None:
+            self._send_data(force=True)
+
         msg = {
             'type': 'finished'
         }
@@ -252,13 +296,49 @@ class JsonProgress(ProgressBase, metaclass=abc.ABCMeta):
 
 
 class WriteToFileMixin(object):
+    # Set when the data is handed back to the application as shared volumes
+    shared_volumes = False
+    _data_path = None
+
     def write_to_file(self, dataobject):
-        filename = '%d.emd' % self._sequence_number
+        extension = SHARED_VOLUME_EXTENSION if self.shared_volumes else '.emd'
+        filename = '%d%s' % (self._sequence_number, extension)
         path = os.path.join(os.path.dirname(self._path), filename)
-        _write_emd(path, dataobject)
+        path = _write_data(path, dataobject)
         self._sequence_number += 1
+        self._data_path = path
 
-        return filename
+        return os.path.basename(path)
+
+    def _data_in_flight(self):
+        # The application removes the files once it has loaded them
+        return self._data_path is not None and os.path.exists(self._data_path)
+
+
+def _preview(dataset, size):
+    """
+    Subsample the dataset so it has at most size samples along each axis.
+    """
+    if not size:
+        return dataset
+
+    shape = dataset.active_scalars.shape
+    stride = -(-max(shape) // size)
+    if stride <= 1:
+        return dataset
+
+    arrays = {name: array[::stride, ::stride, ::stride]
+              for (name, array) in dataset.arrays.items()}
+    preview = Dataset(arrays, dataset.active_name)
+    spacing = dataset.spacing
+    if spacing is None:
+        spacing = [1.0] * 3
+    preview.spacing = [float(x) * stride for x in spacing]
+    if dataset.tilt_angles is not None:
+        preview.tilt_angles = dataset.tilt_angles[::stride]
+        preview.tilt_axis = dataset.tilt_axis
+
+    return preview
 
 
 class LocalSocketProgress(WriteToFileMixin, JsonProgress):
@@ -323,16 +403,24 @@ class FilesProgress(WriteToFileMixin, JsonProgress):
         return filename
 
 
-def _progress(progress_method, progress_path):
+def _progress(progress_method, progress_path, data_interval=None,
+              preview_size=None):
     if progress_method == 'tqdm':
         return TqdmProgress()
     elif progress_method == 'socket':
-        return LocalSocketProgress(progress_path)
+        progress = LocalSocketProgress(progress_path)
     elif progress_method == 'files':
-        return FilesProgress(progress_path)
+        progress = FilesProgress(progress_path)
     else:
         raise Exception('Unrecognized progress method: %s' % progress_method)
 
+    if data_interval is not None:
+        progress.data_interval = data_interval
+    if preview_size is not None:
+        progress.preview_size = preview_size
+
+    return progress
+
 
 class OperatorWrapper(object):
     canceled = False
@@ -558,6 +646,139 @@ def _write_emd(path, dataset, dims=None):
         tomviz_scalars[active_name] = h5py.SoftLink('/data/tomography/data')
 
 
+def _is_shared_volume(path):
+    return path is not None and \
+        str(path).lower().endswith(SHARED_VOLUME_EXTENSION)
+
+
+def _read_shared_volume(path):
+    with open(path) as f:
+        descriptor = json.load(f)
+
+    if descriptor.get('version') != SHARED_VOLUME_VERSION:
+        raise Exception('Unsupported shared volume: %s' % path)
+
+    # The arrays are already in the Fortran order VTK uses, so they are
+    # mapped as they are. Mapping them copy on write lets operators modify
+    # them in place without touching the files.
+    directory = os.path.dirname(str(path))
+    shape = tuple(descriptor['dimensions'])
+    active_name = descriptor['activeScalars']
+    arrays = []
+    for array in descriptor['arrays']:
+        data = np.memmap(os.path.join(directory, array['file']),
+                         dtype=np.dtype(array['dtype']), mode='c',
+                         shape=shape, order='F')
+        arrays.append((array['name'], np.asarray(data)))
+
+    # The first is the active array
+    arrays.sort(key=lambda x: x[0] != active_name)
+
+    output = {
+        'arrays': arrays,
+        'spacing': [float(x) for x in descriptor.get('spacing', [1.0] * 3)],
+        'tilt_axis': None
+    }
+
+    if 'tiltAngles' in descriptor:
+        output['tilt_angles'] = np.array(descriptor['tiltAngles'],
+                                         dtype=np.float64)
+        output['tilt_axis'] = 2
+
+    return output
+
+
+def _free_bytes(directory):
+    return shutil.disk_usage(directory).free
+
+
+def _write_shared_volume(path, dataset):
+    """
+    Write the dataset as a shared volume. Returns False, without writing
+    anything, if there isn't room for it.
+    """
+    directory = os.path.dirname(str(path))
+    base = os.path.splitext(os.path.basename(str(path)))[0]
+
+    active_name = dataset.active_name
+    names = [active_name] + [name for name in dataset.arrays
+                             if name != active_name]
+    shape = None
+    arrays = []
+    for name in names:
+        array = np.asarray(dataset.arrays[name])
+        # Stick to types VTK has
+        if array.dtype == np.float16:
+            array = array.astype(np.float32)
+        elif array.dtype == np.bool_:
+            array = array.astype(np.uint8)
+
+        if shape is None:
+            shape = array.shape
+        if array.ndim != 3 or array.shape != shape:
+            raise Exception('Array \'%s\' doesn\'t match the volume' % name)
+
+        arrays.append((name, array))
+
+    # Writing through a mapping past the space left on the file system, a
+    # tmpfs in particular, raises SIGBUS. The output of an operator can be far
+    # larger than its input, so check against what is actually written.
+    if sum(array.nbytes for (_, array) in arrays) >= _free_bytes(directory):
+        return False
+
+    descriptor_arrays = []
+    for i, (name, array) in enumerate(arrays):
+        filename = '%s_%d.raw' % (base, i)
+        mapped = np.memmap(os.path.join(directory, filename),
+                           dtype=array.dtype, mode='w+', shape=shape,
+                           order='F')
+        mapped[...] = array
+        mapped.flush()
+        del mapped
+
+        descriptor_arrays.append({
+            'name': name,
+            'dtype': array.dtype.str,
+            'file': filename
+        })
+
+    spacing = dataset.spacing
+    if spacing is None:
+        spacing = [1.0] * 3
+
+    descriptor = {
+        'version': SHARED_VOLUME_VERSION,
+        'dimensions': [int(x) for x in shape],
+        'spacing': [float(x) for x in spacing],
+        'activeScalars': active_name,
+        'arrays': descriptor_arrays
+    }
+    if dataset.tilt_angles is not None:
+        descriptor['tiltAngles'] = [float(x) for x in dataset.tilt_angles]
+
+    with open(path, 'w') as f:
+        json.dump(descriptor, f)
+
+    return True
+
+
+def _write_data(path, dataset, dims=None):
+    """
+    Write the dataset to path, and return the path it was written to. Shared
+    volumes that don't fit are written as an EMD file next to them, which the
+    application looks for.
+    """
+    if _is_shared_volume(path):
+        if _write_shared_volume(path, dataset):
+            return path
+
+        path = '%s.emd' % os.path.splitext(str(path))[0]
+        logger.info('Not enough room for a shared volume, writing %s' % path)
+
+    _write_emd(path, dataset, dims)
+    return path
+
+
 def _read_data_exchange(path, options=None):
     with h5py.File(path, 'r') as f:
         g = f['/exchange']
@@ -663,9 +884,12 @@ def _load_transform_functions(operators):
             transform_functions.append((operator['type'], None, angles))
             continue
 
+        # Native operators that replace a built-in Python operator, such as
+        # GaussianFilter or Resample, carry its script and run it here.
         if 'script' not in operator:
             raise Exception(
-                'No script property found. C++ operator are not supported.')
+                'No script property found. The \'%s\' C++ operator is not '
+                'supported.' % operator['type'])
 
         operator_script = operator['script']
         operator_label = operator['label']
@@ -704,15 +928,22 @@ def _write_child_data(result, operator_index, output_file_path, dims):
             else:
                 raise
 
-        # Now write out the data
-        child_data_path = os.path.join(operator_path, '%s.emd' % label)
-        _write_emd(child_data_path, dataobject, dims)
+        # Now write out the data, the same way as the transformed data
+        extension = '.emd'
+        if _is_shared_volume(output_file_path):
+            extension = SHARED_VOLUME_EXTENSION
+        child_data_path = os.path.join(operator_path,
+                                       '%s%s' % (label, extension))
+        _write_data(child_data_path, dataobject, dims)
 
 
 def execute(operators, start_at, data_file_path, output_file_path,
-            progress_method, progress_path, read_options=None):
+            progress_method, progress_path, read_options=None,
+            progress_data_interval=None, progress_preview_size=None):
 
-    if _is_data_exchange(data_file_path):
+    if _is_shared_volume(data_file_path):
+        output = _read_shared_volume(data_file_path)
+    elif _is_data_exchange(data_file_path):
         output = _read_data_exchange(data_file_path, read_options)
     else:
         # Assume it is emd
@@ -738,10 +969,15 @@ def execute(operators, start_at, data_file_path, output_file_path,
     if dims is not None:
         # Convert to native type, as is required by itk
         data.spacing = [float(d.values[1] - d.values[0]) for d in dims]
+    if 'spacing' in output:
+        data.spacing = output['spacing']
 
     operators = operators[start_at:]
     transforms = _load_transform_functions(operators)
-    with _progress(progress_method, progress_path) as progress:
+    with _progress(progress_method, progress_path, progress_data_interval,
+                   progress_preview_size) as progress:
+        if isinstance(progress, WriteToFileMixin):
+            progress.shared_volumes = _is_shared_volume(output_file_path)
         progress.started()
         operator_index = start_at
         for (label, transform, arguments) in transforms:
@@ -766,10 +1002,10 @@ def execute(operators, start_at, data_file_path, output_file_path,
                 os.path.splitext(os.path.basename(data_file_path))[0]
 
         if result is None:
-            _write_emd(output_file_path, data, dims)
+            _write_data(output_file_path, data, dims)
         else:
             [(_, child_data)] = result.items()
-            _write_emd(output_file_path, child_data, dims)
+            _write_data(output_file_path, child_data, dims)
         logger.info('Write complete.')
         progress.finished()
 
@@ -3,6 +3,8 @@
 
 #include "vtkOMETiffReader.h"
 
+#include "ParallelUtilities.h"
+
 #include "vtkDataArray.h"
 #include "vtkErrorCode.h"
 #include "vtkFieldData.h"
@@ -18,6 +20,9 @@
 #include <sys/stat.h>
 #include <string>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 extern "C" {
 #include "vtk_tiff.h"
@@ -133,6 +138,84 @@ bool ReadTemplatedImage(T* out, Flip flip,
   }
   return true;
 }
+
+// Decode the current page of a tiff into a tightly packed slice, a strip or a
+// tile at a time. Strips are decoded straight into the slice, and flipped in
+// place if needed, tiles go through a single tile sized buffer.
+bool ReadPage(TIFF* image, unsigned char* slice, unsigned int width,
+              unsigned int height, size_t pixelSize, bool flip)
+{
+  // Every page has to have the layout of the first one.
+  unsigned int pageWidth = 0;
+  unsigned int pageHeight = 0;
+  TIFFGetField(image, TIFFTAG_IMAGEWIDTH, &pageWidth);
+  TIFFGetField(image, TIFFTAG_IMAGELENGTH, &pageHeight);
+  const size_t rowBytes = width * pixelSize;
+  if (pageWidth != width || pageHeight != height ||
+      static_cast<size_t>(TIFFScanlineSize(image)) != rowBytes)
+  {
+    return false;
+  }
+
+  if (TIFFIsTiled(image))
+  {
+    unsigned int tileWidth = 0;
+    unsigned int tileHeight = 0;
+    TIFFGetField(image, TIFFTAG_TILEWIDTH, &tileWidth);
+    TIFFGetField(image, TIFFTAG_TILELENGTH, &tileHeight);
+    if (tileWidth == 0 || tileHeight == 0)
+    {
+      return false;
+    }
+
+    std::vector<unsigned char> tile(TIFFTileSize(image));
+    for (unsigned int y = 0; y < height; y += tileHeight)
+    {
+      for (unsigned int x = 0; x < width; x += tileWidth)
+      {
+        if (TIFFReadEncodedTile(image, TIFFComputeTile(image, x, y, 0, 0),
+                                tile.data(), tile.size()) < 0)
+        {
+          return false;
+        }
+        // Tiles on the right and bottom edges overhang the image.
+        const unsigned int columns = std::min(tileWidth, width - x);
+        const unsigned int rows = std::min(tileHeight, height - y);
+        for (unsigned int r = 0; r < rows; ++r)
+        {
+          const unsigned int row = flip ? height - (y + r) - 1 : y + r;
+          memcpy(slice + row * rowBytes + x * pixelSize,
+                 tile.data() + r * tileWidth * pixelSize, columns * pixelSize);
+        }
+      }
+    }
+    return true;
+  }
+
+  unsigned int rowsPerStrip = height;
+  TIFFGetFieldDefaulted(image, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+  rowsPerStrip = std::max(std::min(rowsPerStrip, height), 1u);
+  for (unsigned int first = 0; first < height; first += rowsPerStrip)
+  {
+    const unsigned int rows = std::min(rowsPerStrip, height - first);
+    unsigned char* block =
+      slice + (flip ? height - first - rows : first) * rowBytes;
+    if (TIFFReadEncodedStrip(image, TIFFComputeStrip(image, first, 0), block,
+                             rows * rowBytes) < 0)
+    {
+      return false;
+    }
+    if (flip)
+    {
+      for (unsigned int r = 0; r < rows / 2; ++r)
+      {
+        std::swap_ranges(block + r * rowBytes, block + (r + 1) * rowBytes,
+                         block + (rows - r - 1) * rowBytes);
+      }
+    }
+  }
+  return true;
+}
 }
 
 //-------------------------------------------------------------------------
@@ -820,10 +903,102 @@ void vtkOMETiffReader::Initialize()
   this->ImageFormat = vtkOMETiffReader::NOFORMAT;
 }
 
+//-------------------------------------------------------------------------
+bool vtkOMETiffReader::ReadPagesInParallel(void* buffer, int scalarSize)
+{
+  vtkOMETiffReaderInternal* internal = this->InternalImage;
+  const unsigned int width = internal->OmeSizeX;
+  const unsigned int height = internal->OmeSizeY;
+  const unsigned int npages = internal->OmeSizeZ;
+
+  // Only grayscale pages, whose samples are copied as they are, qualify.
+  if (!internal->CanRead() || internal->SamplesPerPixel != 1 ||
+      internal->BitsPerSample != 8 * scalarSize ||
+      internal->Width != width || internal->Height != height ||
+      this->GetFormat() != vtkOMETiffReader::GRAYSCALE ||
+      internal->Photometrics != PHOTOMETRIC_MINISBLACK)
+  {
+    return false;
+  }
+
+  // Find the directories holding the slices, skipping any thumbnails. The
+  // workers jump straight to a slice with its directory offset.
+  std::vector<toff_t> offsets;
+  do
+  {
+    unsigned int subfiletype = 0;
+    if (internal->SubFiles > 0 &&
+        TIFFGetField(internal->Image, TIFFTAG_SUBFILETYPE, &subfiletype) &&
+        subfiletype != 0)
+    {
+      continue;
+    }
+    offsets.push_back(TIFFCurrentDirOffset(internal->Image));
+  } while (offsets.size() < npages && TIFFReadDirectory(internal->Image));
+  TIFFSetDirectory(internal->Image, 0);
+  if (offsets.size() != npages)
+  {
+    return false;
+  }
+
+  // libtiff handles can't be shared between threads, each worker takes a
+  // handle from the pool, opening a new one if there are none left.
+  std::mutex mutex;
+  std::vector<TIFF*> handles;
+  std::atomic<bool> failed(false);
+  const size_t sliceBytes = static_cast<size_t>(width) * height * scalarSize;
+  const bool flip = internal->Orientation != ORIENTATION_TOPLEFT;
+  unsigned char* volume = static_cast<unsigned char*>(buffer);
+  auto body = [&](int slice) {
+    TIFF* image = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!handles.empty())
+      {
+        image = handles.back();
+        handles.pop_back();
+      }
+    }
+    if (!image)
+    {
+      image = TIFFOpen(this->InternalFileName, "r");
+    }
+    if (!image || !TIFFSetSubDirectory(image, offsets[slice]) ||
+        !ReadPage(image, volume + slice * sliceBytes, width, height,
+                  scalarSize, flip))
+    {
+      failed = true;
+    }
+    if (image)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      handles.push_back(image);
+    }
+  };
+  auto progress = [&](int completed, int) {
+    this->UpdateProgress(static_cast<double>(completed) / npages);
+    return !failed && !this->GetAbortExecute();
+  };
+  tomviz::parallelFor(0, npages, body, progress);
+
+  for (auto image : handles)
+  {
+    TIFFClose(image);
+  }
+  return !failed;
+}
+
 //-------------------------------------------------------------------------
 template<typename T>
 void vtkOMETiffReader::ReadVolume(T* buffer)
 {
+  // Plain grayscale pages are decoded concurrently, anything else is read
+  // a scanline at a time below.
+  if (this->ReadPagesInParallel(buffer, sizeof(T)))
+  {
+    return;
+  }
+
   int width  = this->InternalImage->OmeSizeX;
   int height = this->InternalImage->OmeSizeY;
   int samplesPerPixel = this->InternalImage->SamplesPerPixel;
@@ -89,6 +89,14 @@ private:
   template<typename T>
   void ReadVolume(T* buffer);
 
+  /**
+   * Reads the pages of a multi-page grayscale tiff concurrently, with one
+   * TIFF handle per worker, decoding whole strips or tiles rather than
+   * scanlines. Returns false if the layout of the pages isn't supported, in
+   * which case the pages have to be read by ReadVolume().
+   */
+  bool ReadPagesInParallel(void* buffer, int scalarSize);
+
   /**
    * Reads 3D data from tiled tiff
    */